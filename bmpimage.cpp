@@ -0,0 +1,94 @@
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define BMP_USE_SSSE3
+#endif
+
+#include "bmpimage.hpp"
+
+static unsigned int readLE32(const unsigned char * p){
+	return (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static unsigned int readLE16(const unsigned char * p){
+	return (unsigned int)p[0] | ((unsigned int)p[1] << 8);
+}
+
+bool parseBMP(const unsigned char * data, size_t size, BMPImage & image){
+	// File header (14 bytes) followed by at least a BITMAPINFOHEADER (40 bytes)
+	if (size < 54 || data[0] != 'B' || data[1] != 'M')
+		return false;
+
+	unsigned int dataPos    = readLE32(data + 0x0A);
+	unsigned int headerSize = readLE32(data + 0x0E);
+	int width               = (int)readLE32(data + 0x12);
+	int height              = (int)readLE32(data + 0x16);
+	unsigned int planes     = readLE16(data + 0x1A);
+	unsigned int bpp        = readLE16(data + 0x1C);
+	unsigned int compression = readLE32(data + 0x1E);
+
+	if (headerSize < 40 || planes != 1)
+		return false;
+	// BI_RGB only; 32 bit files written with BI_BITFIELDS use the default BGRA masks in practice
+	if (!(compression == 0 || (compression == 3 && bpp == 32)))
+		return false;
+	if (bpp != 24 && bpp != 32)
+		return false;
+	if (width <= 0 || height == 0 || height == (int)0x80000000)
+		return false;
+
+	image.width = (unsigned int)width;
+	image.height = (unsigned int)(height < 0 ? -height : height);
+	image.bytesPerPixel = bpp / 8;
+	image.rowPitch = (image.width * image.bytesPerPixel + 3) & ~3u;
+	image.topDown = height < 0;
+
+	// Some files leave dataPos at 0; the pixels then follow the headers directly
+	if (dataPos == 0)
+		dataPos = 14 + headerSize;
+	if (dataPos > size || (size - dataPos) / image.rowPitch < image.height)
+		return false;
+
+	image.pixels = data + dataPos;
+	return true;
+}
+
+// Swizzles one row of BGR or BGRA pixels into RGBA with opaque alpha where needed.
+static void swizzleRowToRGBA(const unsigned char * src, unsigned char * dst, unsigned int width, unsigned int bytesPerPixel){
+	unsigned int x = 0;
+#ifdef BMP_USE_SSSE3
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	if (bytesPerPixel == 3) {
+		// 4 pixels (12 bytes) per step; the 16 byte load must stay inside the row, hence the +6
+		const __m128i mask = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+		for (; x + 6 <= width; x += 4) {
+			__m128i bgr = _mm_loadu_si128((const __m128i *)(src + x * 3));
+			__m128i rgba = _mm_or_si128(_mm_shuffle_epi8(bgr, mask), alpha);
+			_mm_storeu_si128((__m128i *)(dst + x * 4), rgba);
+		}
+	}
+	else {
+		const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		for (; x + 4 <= width; x += 4) {
+			__m128i bgra = _mm_loadu_si128((const __m128i *)(src + x * 4));
+			_mm_storeu_si128((__m128i *)(dst + x * 4), _mm_shuffle_epi8(bgra, mask));
+		}
+	}
+#endif
+	for (; x < width; x++) {
+		const unsigned char * s = src + x * bytesPerPixel;
+		unsigned char * d = dst + x * 4;
+		d[0] = s[2];
+		d[1] = s[1];
+		d[2] = s[0];
+		d[3] = bytesPerPixel == 4 ? s[3] : 255;
+	}
+}
+
+void convertBMPToRGBA(const BMPImage & image, unsigned char * rgba){
+	for (unsigned int y = 0; y < image.height; y++) {
+		// GL expects the bottom row first
+		unsigned int srcRow = image.topDown ? image.height - 1 - y : y;
+		swizzleRowToRGBA(image.pixels + (size_t)srcRow * image.rowPitch, rgba + (size_t)y * image.width * 4,
+			image.width, image.bytesPerPixel);
+	}
+}
@@ -0,0 +1,23 @@
+#ifndef BMPIMAGE_HPP
+#define BMPIMAGE_HPP
+
+#include <stddef.h>
+
+// Header fields of an uncompressed 24 or 32 bit BMP, pointing into the file data.
+struct BMPImage {
+	const unsigned char * pixels; // first stored row (bottom row unless topDown)
+	unsigned int width;
+	unsigned int height;
+	unsigned int bytesPerPixel;   // 3 (BGR) or 4 (BGRA)
+	unsigned int rowPitch;        // stored row size, padded to 4 bytes
+	bool topDown;                 // negative height in the header
+};
+
+// Validates the header against the file size. Returns false for anything we can't upload as is.
+bool parseBMP(const unsigned char * data, size_t size, BMPImage & image);
+
+// Expands BGR/BGRA rows to tightly packed RGBA and flips them to GL's bottom-up order.
+// rgba must hold width * height * 4 bytes.
+void convertBMPToRGBA(const BMPImage & image, unsigned char * rgba);
+
+#endif
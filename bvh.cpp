@@ -0,0 +1,320 @@
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+#include "bvh.hpp"
+
+#define BVH_BINS 12
+#define BVH_NO_NODE 0xffffffffu
+
+static void grow(Aabb & box, const Aabb & other){
+	box.min = glm::min(box.min, other.min);
+	box.max = glm::max(box.max, other.max);
+}
+
+// Half the surface area, which is all the heuristic compares
+static float halfArea(const Aabb & box){
+	glm::vec3 size = box.max - box.min;
+	return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+Aabb transformAabb(const glm::vec3 & min, const glm::vec3 & max, const glm::mat4 & model){
+	// Center moves with the matrix; each world half extent sums the absolute columns
+	glm::vec3 center = (min + max) * 0.5f;
+	glm::vec3 extent = (max - min) * 0.5f;
+	glm::vec3 worldCenter(model * glm::vec4(center, 1.0f));
+	glm::vec3 worldExtent = glm::abs(glm::vec3(model[0])) * extent.x + glm::abs(glm::vec3(model[1])) * extent.y
+		+ glm::abs(glm::vec3(model[2])) * extent.z;
+	Aabb box;
+	box.min = worldCenter - worldExtent;
+	box.max = worldCenter + worldExtent;
+	return box;
+}
+
+void frustumPlanes(const glm::mat4 & viewProjection, glm::vec4 planes[6]){
+	// -w <= x, y, z <= w, from the rows of the view-projection
+	glm::vec4 w(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+	for (int i = 0; i < 3; i++) {
+		glm::vec4 row(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+		planes[2 * i] = w + row;
+		planes[2 * i + 1] = w - row;
+	}
+	for (int i = 0; i < 6; i++)
+		planes[i] = planes[i] * (1.0f / glm::length(glm::vec3(planes[i])));
+}
+
+bool rayHitsAabb(const glm::vec3 & origin, const glm::vec3 & inverseDirection, const Aabb & box, float maxDistance,
+	float & distance){
+	float enter = 0.0f, leave = maxDistance;
+	for (int axis = 0; axis < 3; axis++) {
+		float first = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+		float last = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+		if (first > last)
+			std::swap(first, last);
+		// A ray parallel to the slab gives NaN when the origin is on its plane; the comparisons
+		// below then keep the other axes' interval, as touching counts as inside
+		if (first > enter)
+			enter = first;
+		if (last < leave)
+			leave = last;
+		if (enter > leave)
+			return false;
+	}
+	distance = enter;
+	return true;
+}
+
+Bvh::Bvh()
+	: visited(0), treeDepth(0){
+}
+
+void Bvh::build(const Aabb * bounds, size_t count){
+	nodes.clear();
+	treeDepth = 0;
+	objectOrder.resize(count);
+	objectLeaf.assign(count, 0);
+	objectBounds.assign(bounds, bounds + count);
+	dirtyMark.clear();
+	if (count == 0)
+		return;
+	std::vector<glm::vec3> centers(count);
+	for (size_t i = 0; i < count; i++) {
+		objectOrder[i] = (uint32_t)i;
+		centers[i] = (bounds[i].min + bounds[i].max) * 0.5f;
+	}
+	// A binary tree with leaves of at least one object has fewer than 2 count nodes
+	nodes.reserve(2 * count);
+	buildNode(&objectBounds[0], &centers[0], 0, (uint32_t)count, BVH_NO_NODE, 1);
+	dirtyMark.assign(nodes.size(), 0);
+}
+
+uint32_t Bvh::buildNode(const Aabb * bounds, const glm::vec3 * centers, uint32_t first, uint32_t count, uint32_t parent,
+	int level){
+	uint32_t index = (uint32_t)nodes.size();
+	nodes.push_back(Node());
+	Aabb box = bounds[objectOrder[first]];
+	Aabb centerBox = { centers[objectOrder[first]], centers[objectOrder[first]] };
+	for (uint32_t i = first + 1; i < first + count; i++) {
+		grow(box, bounds[objectOrder[i]]);
+		centerBox.min = glm::min(centerBox.min, centers[objectOrder[i]]);
+		centerBox.max = glm::max(centerBox.max, centers[objectOrder[i]]);
+	}
+	Node & node = nodes[index];
+	node.bounds = box;
+	node.first = first;
+	node.count = count;
+	node.right = 0;
+	node.parent = parent;
+	if (level > treeDepth)
+		treeDepth = level;
+	if (count <= BVH_LEAF_SIZE) {
+		for (uint32_t i = first; i < first + count; i++)
+			objectLeaf[objectOrder[i]] = index;
+		return index;
+	}
+
+	// Binned SAH: drop the centers into bins along each axis and take the bin boundary with the
+	// least left area * left count + right area * right count
+	int bestAxis = -1, bestSplit = 0;
+	float bestCost = FLT_MAX;
+	for (int axis = 0; axis < 3; axis++) {
+		float extent = centerBox.max[axis] - centerBox.min[axis];
+		if (extent <= 0.0f)
+			continue;
+		float toBin = BVH_BINS / extent;
+		Aabb binBoxes[BVH_BINS];
+		uint32_t binCounts[BVH_BINS] = { 0 };
+		for (uint32_t i = first; i < first + count; i++) {
+			uint32_t object = objectOrder[i];
+			int bin = std::min((int)((centers[object][axis] - centerBox.min[axis]) * toBin), BVH_BINS - 1);
+			if (binCounts[bin]++ == 0)
+				binBoxes[bin] = bounds[object];
+			else
+				grow(binBoxes[bin], bounds[object]);
+		}
+		// Right to left sums first, then sweep left to right
+		float rightCosts[BVH_BINS];
+		Aabb sweep;
+		uint32_t sweepCount = 0;
+		for (int bin = BVH_BINS - 1; bin > 0; bin--) {
+			if (binCounts[bin] > 0) {
+				if (sweepCount == 0)
+					sweep = binBoxes[bin];
+				else
+					grow(sweep, binBoxes[bin]);
+				sweepCount += binCounts[bin];
+			}
+			rightCosts[bin] = sweepCount > 0 ? halfArea(sweep) * sweepCount : 0.0f;
+		}
+		sweepCount = 0;
+		for (int bin = 0; bin < BVH_BINS - 1; bin++) {
+			if (binCounts[bin] > 0) {
+				if (sweepCount == 0)
+					sweep = binBoxes[bin];
+				else
+					grow(sweep, binBoxes[bin]);
+				sweepCount += binCounts[bin];
+			}
+			if (sweepCount == 0 || sweepCount == count)
+				continue;
+			float cost = halfArea(sweep) * sweepCount + rightCosts[bin + 1];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = bin + 1;
+			}
+		}
+	}
+
+	uint32_t middle = first + count / 2;
+	if (bestAxis >= 0) {
+		float low = centerBox.min[bestAxis];
+		float toBin = BVH_BINS / (centerBox.max[bestAxis] - low);
+		uint32_t * split = std::partition(&objectOrder[first], &objectOrder[first] + count, [&](uint32_t object) {
+			return std::min((int)((centers[object][bestAxis] - low) * toBin), BVH_BINS - 1) < bestSplit;
+		});
+		middle = (uint32_t)(split - &objectOrder[0]);
+	}
+	// Every center in the same spot (or one side empty): halve the range as it is
+	if (middle == first || middle == first + count)
+		middle = first + count / 2;
+
+	buildNode(bounds, centers, first, middle - first, index, level + 1);
+	uint32_t right = buildNode(bounds, centers, middle, first + count - middle, index, level + 1);
+	nodes[index].right = right;
+	return index;
+}
+
+void Bvh::updateNode(uint32_t index){
+	Node & node = nodes[index];
+	if (node.right == 0) {
+		node.bounds = objectBounds[objectOrder[node.first]];
+		for (uint32_t i = node.first + 1; i < node.first + node.count; i++)
+			grow(node.bounds, objectBounds[objectOrder[i]]);
+	} else {
+		node.bounds = nodes[index + 1].bounds;
+		grow(node.bounds, nodes[node.right].bounds);
+	}
+}
+
+void Bvh::refit(const Aabb * bounds, const uint32_t * objects, size_t count){
+	// Mark the paths to the root; a marked node's ancestors are marked already
+	dirty.clear();
+	for (size_t i = 0; i < count; i++) {
+		objectBounds[objects[i]] = bounds[objects[i]];
+		for (uint32_t node = objectLeaf[objects[i]]; node != BVH_NO_NODE && !dirtyMark[node]; node = nodes[node].parent) {
+			dirtyMark[node] = 1;
+			dirty.push_back(node);
+		}
+	}
+	// Children come after their parents, so going down the indices updates them first
+	std::sort(dirty.begin(), dirty.end());
+	for (size_t i = dirty.size(); i-- > 0;) {
+		updateNode(dirty[i]);
+		dirtyMark[dirty[i]] = 0;
+	}
+}
+
+void Bvh::cull(const glm::vec4 planes[6], std::vector<uint32_t> & visible) const{
+	visited = 0;
+	if (nodes.empty())
+		return;
+	stack.clear();
+	StackEntry root = { 0, 0x3f, 0.0f };
+	stack.push_back(root);
+	while (!stack.empty()) {
+		StackEntry entry = stack.back();
+		stack.pop_back();
+		const Node & node = nodes[entry.node];
+		visited++;
+
+		uint32_t inside = entry.planes;
+		bool outside = false;
+		for (int i = 0; i < 6 && !outside; i++) {
+			if (!(entry.planes & (1u << i)))
+				continue;
+			const glm::vec4 & plane = planes[i];
+			// The corners furthest along and against the plane normal
+			glm::vec3 positive(plane.x >= 0.0f ? node.bounds.max.x : node.bounds.min.x,
+				plane.y >= 0.0f ? node.bounds.max.y : node.bounds.min.y, plane.z >= 0.0f ? node.bounds.max.z : node.bounds.min.z);
+			glm::vec3 negative(plane.x >= 0.0f ? node.bounds.min.x : node.bounds.max.x,
+				plane.y >= 0.0f ? node.bounds.min.y : node.bounds.max.y, plane.z >= 0.0f ? node.bounds.min.z : node.bounds.max.z);
+			if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+				outside = true;
+			else if (glm::dot(glm::vec3(plane), negative) + plane.w >= 0.0f)
+				inside &= ~(1u << i);
+		}
+		if (outside)
+			continue;
+		if (inside == 0 || node.right == 0) {
+			visible.insert(visible.end(), &objectOrder[node.first], &objectOrder[node.first] + node.count);
+			continue;
+		}
+		StackEntry right = { node.right, inside, 0.0f };
+		StackEntry left = { entry.node + 1, inside, 0.0f };
+		stack.push_back(right);
+		stack.push_back(left);
+	}
+}
+
+int Bvh::raycast(const glm::vec3 & origin, const glm::vec3 & direction, float maxDistance, const BvhRayTest & test,
+	float & distance) const{
+	visited = 0;
+	if (nodes.empty())
+		return -1;
+	glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	int best = -1;
+	float bestDistance = maxDistance;
+	float enter;
+	if (!rayHitsAabb(origin, inverseDirection, nodes[0].bounds, bestDistance, enter))
+		return -1;
+	stack.clear();
+	StackEntry root = { 0, 0, enter };
+	stack.push_back(root);
+	while (!stack.empty()) {
+		StackEntry entry = stack.back();
+		stack.pop_back();
+		// Something nearer was hit since this node was pushed
+		if (entry.distance > bestDistance)
+			continue;
+		const Node & node = nodes[entry.node];
+		visited++;
+
+		if (node.right == 0) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				uint32_t object = objectOrder[i];
+				// The leaf's box was hit, not necessarily the object's
+				float hit;
+				if (!rayHitsAabb(origin, inverseDirection, objectBounds[object], bestDistance, hit))
+					continue;
+				if (test) {
+					if (!test(object, bestDistance, hit) || hit > bestDistance)
+						continue;
+				}
+				best = (int)object;
+				bestDistance = hit;
+			}
+			continue;
+		}
+
+		uint32_t children[2] = { entry.node + 1, node.right };
+		float hits[2];
+		bool hit[2];
+		for (int i = 0; i < 2; i++)
+			hit[i] = rayHitsAabb(origin, inverseDirection, nodes[children[i]].bounds, bestDistance, hits[i]);
+		// The nearer child goes on top
+		int nearer = hit[0] && (!hit[1] || hits[0] <= hits[1]) ? 0 : 1;
+		int farther = 1 - nearer;
+		if (hit[farther]) {
+			StackEntry next = { children[farther], 0, hits[farther] };
+			stack.push_back(next);
+		}
+		if (hit[nearer]) {
+			StackEntry next = { children[nearer], 0, hits[nearer] };
+			stack.push_back(next);
+		}
+	}
+	if (best >= 0)
+		distance = bestDistance;
+	return best;
+}
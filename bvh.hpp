@@ -0,0 +1,94 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Bounding volume hierarchy over axis-aligned boxes, for frustum culling and ray picking with a
+// cost that grows with the log of the object count instead of linearly. GL-free.
+//
+// build() splits the objects top-down with a binned surface area heuristic into a binary tree
+// whose leaves hold up to BVH_LEAF_SIZE objects. Nodes are stored depth first, so every node's
+// objects are one contiguous range of objectOrder and children always come after their parent.
+// When objects move, refit() recomputes only the boxes on the paths from their leaves to the
+// root and keeps the tree; the tree only gets worse as things move, so build() again when the
+// set of objects or the static layout changes.
+
+#define BVH_LEAF_SIZE 4
+
+struct Aabb {
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+// The world box around a model space box
+Aabb transformAabb(const glm::vec3 & min, const glm::vec3 & max, const glm::mat4 & model);
+// Frustum planes of a view-projection, normals pointing inward and normalized, so
+// dot(plane.xyz, p) + plane.w is the distance of p inside the plane
+void frustumPlanes(const glm::mat4 & viewProjection, glm::vec4 planes[6]);
+// Slab test. true if the ray (inverseDirection = 1 / direction) enters the box before
+// maxDistance, with the entry distance (0 when the origin is inside)
+bool rayHitsAabb(const glm::vec3 & origin, const glm::vec3 & inverseDirection, const Aabb & box, float maxDistance,
+	float & distance);
+
+// Precise test of one object for raycast: true with the hit distance if the ray hits it before
+// maxDistance
+typedef std::function<bool(uint32_t object, float maxDistance, float & distance)> BvhRayTest;
+
+class Bvh {
+public:
+	Bvh();
+
+	// Replaces the tree with one over bounds[0, count)
+	void build(const Aabb * bounds, size_t count);
+	// objects[0, count) moved to bounds[object]; updates their leaves and every ancestor
+	void refit(const Aabb * bounds, const uint32_t * objects, size_t count);
+
+	// Appends the objects whose boxes touch the frustum to visible, in tree order. Subtrees fully
+	// inside are appended without testing their nodes.
+	void cull(const glm::vec4 planes[6], std::vector<uint32_t> & visible) const;
+	// Nearest object along the ray whose box is hit before maxDistance and for which test (if
+	// given) reports a hit, nearer children first so far ones are skipped; -1 if none.
+	int raycast(const glm::vec3 & origin, const glm::vec3 & direction, float maxDistance, const BvhRayTest & test,
+		float & distance) const;
+
+	size_t objectCount() const { return objectOrder.size(); }
+	size_t nodeCount() const { return nodes.size(); }
+	int depth() const { return treeDepth; }
+	// Nodes the last cull or raycast looked at
+	size_t lastVisited() const { return visited; }
+
+private:
+	struct Node {
+		Aabb bounds;
+		uint32_t first;  // objects of the subtree: objectOrder[first, first + count)
+		uint32_t count;
+		uint32_t right;  // second child; the first is the next node. 0 for leaves
+		uint32_t parent;
+	};
+
+	uint32_t buildNode(const Aabb * bounds, const glm::vec3 * centers, uint32_t first, uint32_t count, uint32_t parent,
+		int level);
+	void updateNode(uint32_t node);
+
+	std::vector<Node> nodes;
+	std::vector<uint32_t> objectOrder;
+	std::vector<uint32_t> objectLeaf;
+	std::vector<Aabb> objectBounds;
+	std::vector<uint32_t> dirty;        // scratch for refit
+	std::vector<uint8_t> dirtyMark;
+	struct StackEntry {
+		uint32_t node;
+		uint32_t planes;  // cull: planes the node isn't known to be inside of
+		float distance;   // raycast: where the ray enters the node
+	};
+	mutable std::vector<StackEntry> stack;
+	mutable size_t visited;
+	int treeDepth;
+};
+
+#endif
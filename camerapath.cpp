@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "camerapath.hpp"
+
+#define CAMERA_PATH_VERSION 1
+
+bool CameraPath::load(const char * path){
+	FILE * file = fopen(path, "r");
+	if (file == NULL) {
+		printf("Could not open camera path %s\n", path);
+		return false;
+	}
+
+	std::vector<CameraKeyframe> loaded;
+	bool sawHeader = false, ok = true;
+	char line[256];
+	int lineNumber = 0;
+	while (ok && fgets(line, sizeof(line), file) != NULL) {
+		lineNumber++;
+		if (line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0')
+			continue;
+
+		if (!sawHeader) {
+			int version = 0;
+			ok = sscanf(line, "camerapath %d", &version) == 1 && version == CAMERA_PATH_VERSION;
+			sawHeader = true;
+			continue;
+		}
+
+		CameraKeyframe key;
+		ok = sscanf(line, "%f %f %f %f %f %f %f %f", &key.time, &key.eye.x, &key.eye.y, &key.eye.z,
+			&key.target.x, &key.target.y, &key.target.z, &key.fov) == 8
+			&& (loaded.empty() || key.time > loaded.back().time);
+		if (ok)
+			loaded.push_back(key);
+	}
+	fclose(file);
+
+	if (!ok || loaded.empty()) {
+		printf("%s is not a valid camera path (line %d)\n", path, lineNumber);
+		return false;
+	}
+	keyframes.swap(loaded);
+	return true;
+}
+
+bool CameraPath::save(const char * path) const{
+	FILE * file = fopen(path, "w");
+	if (file == NULL) {
+		printf("Could not write camera path %s\n", path);
+		return false;
+	}
+	fprintf(file, "camerapath %d\n", CAMERA_PATH_VERSION);
+	fprintf(file, "# time  eye.x eye.y eye.z  target.x target.y target.z  fov\n");
+	for (size_t i = 0; i < keyframes.size(); i++) {
+		const CameraKeyframe & key = keyframes[i];
+		fprintf(file, "%.3f  %.4f %.4f %.4f  %.4f %.4f %.4f  %.2f\n", key.time, key.eye.x, key.eye.y, key.eye.z,
+			key.target.x, key.target.y, key.target.z, key.fov);
+	}
+	return fclose(file) == 0;
+}
+
+void CameraPath::addKeyframe(const CameraKeyframe & keyframe){
+	if (!keyframes.empty() && keyframe.time <= keyframes.back().time)
+		return;
+	keyframes.push_back(keyframe);
+}
+
+float CameraPath::duration() const{
+	return keyframes.empty() ? 0.0f : keyframes.back().time - keyframes.front().time;
+}
+
+// Cubic Hermite segment from p1 to p2 with Catmull-Rom tangents. The neighbours' times are used
+// for the tangents, so unevenly spaced keys don't overshoot.
+static glm::vec3 catmullRom(const CameraKeyframe * k0, const CameraKeyframe & k1, const CameraKeyframe & k2,
+	const CameraKeyframe * k3, const glm::vec3 CameraKeyframe::* member, float s){
+	float segment = k2.time - k1.time;
+	const glm::vec3 & p1 = k1.*member;
+	const glm::vec3 & p2 = k2.*member;
+	glm::vec3 m1 = k0 != NULL ? (p2 - k0->*member) * (segment / (k2.time - k0->time)) : p2 - p1;
+	glm::vec3 m2 = k3 != NULL ? (k3->*member - p1) * (segment / (k3->time - k1.time)) : p2 - p1;
+
+	float s2 = s * s, s3 = s2 * s;
+	return p1 * (2.0f * s3 - 3.0f * s2 + 1.0f) + m1 * (s3 - 2.0f * s2 + s)
+		+ p2 * (-2.0f * s3 + 3.0f * s2) + m2 * (s3 - s2);
+}
+
+CameraKeyframe CameraPath::sample(float time) const{
+	if (keyframes.empty()) {
+		CameraKeyframe key = { time, glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f, 0.0f, 0.0f), 45.0f };
+		return key;
+	}
+	if (time <= keyframes.front().time)
+		return keyframes.front();
+	if (time >= keyframes.back().time)
+		return keyframes.back();
+
+	size_t i = 1;
+	while (keyframes[i].time < time)
+		i++;
+	const CameraKeyframe & k1 = keyframes[i - 1];
+	const CameraKeyframe & k2 = keyframes[i];
+	const CameraKeyframe * k0 = i >= 2 ? &keyframes[i - 2] : NULL;
+	const CameraKeyframe * k3 = i + 1 < keyframes.size() ? &keyframes[i + 1] : NULL;
+	float s = (time - k1.time) / (k2.time - k1.time);
+
+	CameraKeyframe key;
+	key.time = time;
+	key.eye = catmullRom(k0, k1, k2, k3, &CameraKeyframe::eye, s);
+	key.target = catmullRom(k0, k1, k2, k3, &CameraKeyframe::target, s);
+	key.fov = k1.fov + (k2.fov - k1.fov) * s;
+	return key;
+}
+
+glm::mat4 CameraPath::viewMatrix(float time) const{
+	CameraKeyframe key = sample(time);
+	return glm::lookAt(key.eye, key.target, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+glm::mat4 CameraPath::projectionMatrix(float time, float aspect) const{
+	return glm::perspective(glm::radians(sample(time).fov), aspect, CAMERA_PATH_NEAR, CAMERA_PATH_FAR);
+}
+
+CameraRecorder::CameraRecorder(float interval)
+	: interval(interval), nextKeyTime(0.0f){
+}
+
+void CameraRecorder::record(float time, const glm::mat4 & view, const glm::mat4 & projection){
+	if (!recorded.empty() && time < nextKeyTime)
+		return;
+	nextKeyTime = time + interval;
+
+	// The view matrix is a rotation R and translation t: the eye is -R^T t and the camera looks
+	// down -z, the negated third row of R
+	glm::vec3 t(view[3][0], view[3][1], view[3][2]);
+	CameraKeyframe key;
+	key.time = time;
+	key.eye = -glm::vec3(glm::dot(glm::vec3(view[0][0], view[0][1], view[0][2]), t),
+		glm::dot(glm::vec3(view[1][0], view[1][1], view[1][2]), t),
+		glm::dot(glm::vec3(view[2][0], view[2][1], view[2][2]), t));
+	key.target = key.eye - glm::vec3(view[0][2], view[1][2], view[2][2]);
+	key.fov = 2.0f * atanf(1.0f / projection[1][1]) * 57.2957795f;
+	recorded.addKeyframe(key);
+}
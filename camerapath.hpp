@@ -0,0 +1,63 @@
+#ifndef CAMERAPATH_HPP
+#define CAMERAPATH_HPP
+
+#include <stddef.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#define CAMERA_PATH_NEAR 0.1f
+#define CAMERA_PATH_FAR 100.0f
+
+// Camera at one point in time. fov is the vertical field of view in degrees.
+struct CameraKeyframe {
+	float time;
+	glm::vec3 eye;
+	glm::vec3 target;
+	float fov;
+};
+
+// Timestamped camera keyframes, played back with Catmull-Rom splines through the eye and target
+// positions (tangents scaled for uneven key spacing) and a linear blend of the fov. Times before
+// the first or after the last key clamp to that key.
+//
+// The file format is text: a "camerapath 1" line, then one keyframe per line as
+//   time eye.x eye.y eye.z target.x target.y target.z fov
+// Lines starting with # are comments.
+class CameraPath {
+public:
+	bool load(const char * path);
+	bool save(const char * path) const;
+
+	// Keys must come in increasing time order; a key at or before the last one is ignored.
+	void addKeyframe(const CameraKeyframe & keyframe);
+	void clear() { keyframes.clear(); }
+
+	bool empty() const { return keyframes.empty(); }
+	size_t keyframeCount() const { return keyframes.size(); }
+	float duration() const;
+
+	CameraKeyframe sample(float time) const;
+	glm::mat4 viewMatrix(float time) const;
+	glm::mat4 projectionMatrix(float time, float aspect) const;
+
+private:
+	std::vector<CameraKeyframe> keyframes;
+};
+
+// Turns a live session into a CameraPath: record() is called every frame with the matrices in
+// use, and a keyframe is kept every interval seconds.
+class CameraRecorder {
+public:
+	explicit CameraRecorder(float interval = 0.1f);
+
+	void record(float time, const glm::mat4 & view, const glm::mat4 & projection);
+	const CameraPath & path() const { return recorded; }
+
+private:
+	float interval;
+	float nextKeyTime;
+	CameraPath recorded;
+};
+
+#endif
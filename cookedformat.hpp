@@ -0,0 +1,45 @@
+#ifndef COOKEDFORMAT_HPP
+#define COOKEDFORMAT_HPP
+
+#include <stdint.h>
+
+// On-disk layout of a cooked texture (.ptex), written by texturecooker and mapped as is at runtime.
+//
+//   CookedTextureHeader
+//   level 0 data, level 1 data, ... (each level starts on a 16 byte boundary)
+//
+// All fields are little endian. Levels are stored bottom row first, ready for glTexImage2D.
+
+#define COOKED_TEXTURE_MAGIC   0x58455450u // "PTEX"
+#define COOKED_TEXTURE_VERSION 1u
+#define COOKED_MAX_LEVELS      16
+
+enum CookedTextureFormat {
+	COOKED_FORMAT_RGBA8 = 0, // uncompressed, sRGB encoded values
+	COOKED_FORMAT_BC1   = 1, // DXT1, opaque
+	COOKED_FORMAT_BC3   = 2  // DXT5, with alpha
+};
+
+struct CookedMipLevel {
+	uint32_t offset; // from the start of the file
+	uint32_t size;   // bytes
+	uint32_t width;
+	uint32_t height;
+};
+
+struct CookedTextureHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t format;
+	uint32_t levelCount;
+	uint32_t width;
+	uint32_t height;
+	// Source BMP the levels were cooked from. Size/mtime are a cheap first check,
+	// the hash decides when they differ.
+	uint64_t sourceHash;
+	uint64_t sourceSize;
+	int64_t sourceMTime;
+	CookedMipLevel levels[COOKED_MAX_LEVELS];
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "hash.hpp"
+#include "cookedtexture.hpp"
+
+// True if the cooked data was produced from the current contents of sourcePath.
+static bool isCookedSourceCurrent(const CookedTextureHeader & header, const char * sourcePath){
+	struct stat st;
+	if (sourcePath == NULL || stat(sourcePath, &st) != 0)
+		return true; // shipped without the source BMPs, nothing to compare against
+
+	if ((uint64_t)st.st_size != header.sourceSize)
+		return false;
+	if ((int64_t)st.st_mtime == header.sourceMTime)
+		return true;
+
+	// Touched but maybe not changed (fresh checkout, copy): let the contents decide
+	uint64_t hash;
+	return hashFile(sourcePath, hash) && hash == header.sourceHash;
+}
+
+// Bytes GL reads for a width x height level of format.
+static uint64_t cookedLevelBytes(uint32_t format, uint32_t width, uint32_t height){
+	if (format == COOKED_FORMAT_RGBA8)
+		return (uint64_t)width * height * 4;
+	uint64_t blocks = (uint64_t)((width + 3) / 4) * ((height + 3) / 4);
+	return blocks * (format == COOKED_FORMAT_BC1 ? 8 : 16);
+}
+
+// Every level is checked, not just the header fields: GL reads as many bytes as the level's
+// size and format call for, wherever the file ends, so a truncated or corrupt file must not
+// get that far.
+static bool isCookedHeaderValid(const CookedTextureHeader & header, size_t fileSize){
+	if (header.magic != COOKED_TEXTURE_MAGIC || header.version != COOKED_TEXTURE_VERSION)
+		return false;
+	if (header.format > COOKED_FORMAT_BC3 || header.levelCount == 0 || header.levelCount > COOKED_MAX_LEVELS)
+		return false;
+	if (header.width == 0 || header.height == 0)
+		return false;
+	for (uint32_t i = 0; i < header.levelCount; i++) {
+		const CookedMipLevel & level = header.levels[i];
+		// Each level halves the one above it, down to 1 pixel, as texturecooker builds them
+		uint32_t width = header.width >> i > 0 ? header.width >> i : 1;
+		uint32_t height = header.height >> i > 0 ? header.height >> i : 1;
+		if (level.width != width || level.height != height)
+			return false;
+		if (level.size != cookedLevelBytes(header.format, width, height))
+			return false;
+		if (level.offset > fileSize || level.size > fileSize - level.offset)
+			return false;
+	}
+	return true;
+}
+
+bool openCookedTexture(const char * cookedPath, const char * sourcePath, MappedFile & file, CookedTextureHeader & header){
+	if (!mapFile(cookedPath, file))
+		return false;
+
+	if (file.size < sizeof(CookedTextureHeader)) {
+		unmapFile(file);
+		return false;
+	}
+	memcpy(&header, file.data, sizeof(header));
+
+	if (!isCookedHeaderValid(header, file.size)) {
+		printf("%s is not a valid cooked texture, ignoring it\n", cookedPath);
+		unmapFile(file);
+		return false;
+	}
+	if (!isCookedSourceCurrent(header, sourcePath)) {
+		printf("%s is older than %s, re-run texturecooker\n", cookedPath, sourcePath);
+		unmapFile(file);
+		return false;
+	}
+	return true;
+}
+
+bool cookedPathForBMP(const char * bmpPath, char * cookedPath, size_t size){
+	size_t length = strlen(bmpPath);
+	const char * extension = strrchr(bmpPath, '.');
+	if (extension != NULL && strpbrk(extension, "/\\") == NULL)
+		length = extension - bmpPath;
+	if (length + sizeof(".ptex") > size)
+		return false;
+	memcpy(cookedPath, bmpPath, length);
+	strcpy(cookedPath + length, ".ptex");
+	return true;
+}
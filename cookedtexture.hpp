@@ -0,0 +1,16 @@
+#ifndef COOKEDTEXTURE_HPP
+#define COOKEDTEXTURE_HPP
+
+#include "mappedfile.hpp"
+#include "cookedformat.hpp"
+
+// Maps a cooked texture and checks its header and source hash. On success the caller owns the
+// mapping and must unmapFile it once the levels have been consumed. Makes no GL calls and doesn't
+// look at driver capabilities, so it is safe before a context exists; whether an S3TC format
+// can be used is up to the caller.
+bool openCookedTexture(const char * cookedPath, const char * sourcePath, MappedFile & file, CookedTextureHeader & header);
+
+// "dir/name.bmp" -> "dir/name.ptex". Returns false if the result doesn't fit.
+bool cookedPathForBMP(const char * bmpPath, char * cookedPath, size_t size);
+
+#endif
@@ -0,0 +1,323 @@
+#include <string.h>
+#include <math.h>
+#include <chrono>
+
+#include "crowd.hpp"
+
+#define CROWD_DENSITY 1.5f        // agents per square unit the queue areas are sized for
+#define CROWD_MIN_QUEUE_RADIUS 2.0f
+#define CROWD_WALK_SPEED 1.2f     // mean, units per second
+#define CROWD_STEERING 4.0f       // how fast the velocity turns toward the wanted one, per second
+#define CROWD_SEPARATION 2.5f     // push from a neighbour at zero distance, units per second
+#define CROWD_ARRIVAL 0.4f        // distance to the target that counts as arrived
+#define CROWD_STRIDE 9.0f         // walk phase per unit walked
+#define CROWD_TURN_RATE 6.0f      // heading change toward the velocity, per second
+
+static const uint32_t s_shirtColors[] = {
+	0xff3040d0u, 0xffd05030u, 0xff30a040u, 0xff20c0e0u, 0xffa040a0u, 0xffe0e0e0u, 0xff404040u, 0xff2080f0u
+};
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start){
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+CrowdGrid::CrowdGrid()
+	: inverseCellSize(1.0f), mask(0), columnMask(0), columnShift(0){
+}
+
+void CrowdGrid::init(size_t capacity, float cellSize){
+	inverseCellSize = 1.0f / cellSize;
+	// About two buckets per point keeps collisions between cells rare
+	uint32_t size = 1024;
+	while (size < capacity * 2)
+		size *= 2;
+	mask = size - 1;
+	// As square as the power of two allows, with the extra factor of two along x
+	columnShift = 0;
+	while ((2u << (2 * columnShift)) <= size)
+		columnShift++;
+	columnMask = (1u << columnShift) - 1;
+	starts.assign((size_t)size + 1, 0);
+	buckets.assign(capacity, 0);
+	sortedIndex.assign(capacity, 0);
+	sortedX.assign(capacity, 0.0f);
+	sortedZ.assign(capacity, 0.0f);
+}
+
+void CrowdGrid::build(const float * x, const float * z, size_t count, WorkerPool & workers){
+	workers.parallelFor(count, CROWD_CHUNK, [&](size_t, size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			buckets[i] = bucket(cellOf(x[i]), cellOf(z[i]));
+	});
+
+	// Counting sort: sizes, then starts (an exclusive prefix sum), then scatter. The scatter
+	// walks starts[b + 1] back down to the start of b, leaving starts as it should be.
+	memset(&starts[0], 0, starts.size() * sizeof(uint32_t));
+	for (size_t i = 0; i < count; i++)
+		starts[buckets[i] + 1]++;
+	for (size_t b = 1; b < starts.size(); b++)
+		starts[b] += starts[b - 1];
+	for (size_t i = count; i-- > 0;) {
+		uint32_t slot = --starts[buckets[i] + 1];
+		sortedIndex[slot] = (uint32_t)i;
+		sortedX[slot] = x[i];
+		sortedZ[slot] = z[i];
+	}
+	// starts[b + 1] is now the start of bucket b; shift back by one
+	memmove(&starts[0], &starts[1], (starts.size() - 1) * sizeof(uint32_t));
+	starts.back() = (uint32_t)count;
+}
+
+void CrowdGrid::renumber(){
+	for (size_t s = 0; s < sortedIndex.size(); s++)
+		sortedIndex[s] = (uint32_t)s;
+}
+
+Crowd::Crowd()
+	: workers(NULL), count(0), destinationRadius(CROWD_MIN_QUEUE_RADIUS){
+	memset(&counters, 0, sizeof(counters));
+}
+
+float Crowd::random(size_t agent){
+	// xorshift32
+	uint32_t & state = randomState[agent];
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+void Crowd::pickTarget(size_t agent){
+	// Any ride but the one just visited
+	size_t rides = destinations.size();
+	size_t next = (destination[agent] + 1 + (size_t)(random(agent) * (rides - 1))) % rides;
+	if (rides == 1)
+		next = 0;
+	destination[agent] = (uint8_t)next;
+	// A uniform spot in the queue area
+	float angle = random(agent) * 6.2831853f;
+	float distance = sqrtf(random(agent)) * destinationRadius;
+	targetX[agent] = destinations[next].position.x + distance * cosf(angle);
+	targetZ[agent] = destinations[next].position.y + distance * sinf(angle);
+	wait[agent] = 0.0f;
+}
+
+void Crowd::init(size_t count, WorkerPool * pool, const std::vector<CrowdDestination> & destinations,
+	const std::vector<CrowdObstacle> & obstacles){
+	workers = pool;
+	this->count = count;
+	this->destinations = destinations;
+	this->obstacles = obstacles;
+	memset(&counters, 0, sizeof(counters));
+	if (destinations.empty())
+		this->count = count = 0;
+
+	float area = count / (CROWD_DENSITY * (destinations.empty() ? 1 : destinations.size()));
+	destinationRadius = sqrtf(area / 3.1415927f);
+	if (destinationRadius < CROWD_MIN_QUEUE_RADIUS)
+		destinationRadius = CROWD_MIN_QUEUE_RADIUS;
+
+	std::vector<float> * floats[] = {
+		&posX, &posZ, &velX, &velZ, &nextX, &nextZ, &nextVelX, &nextVelZ,
+		&targetX, &targetZ, &wait, &speed, &heading, &phase
+	};
+	for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); i++)
+		floats[i]->assign(count, 0.0f);
+	color.assign(count, 0);
+	destination.assign(count, 0);
+	randomState.assign(count, 0);
+	size_t chunks = WorkerPool::chunkCount(count, CROWD_CHUNK);
+	scratchWords.assign(count, 0);
+	scratchBytes.assign(count, 0);
+	chunkChecks.assign(chunks, 0);
+	chunkArrivals.assign(chunks, 0);
+	grid.init(count, CROWD_PERSONAL_SPACE);
+
+	for (size_t i = 0; i < count; i++) {
+		// Any nonzero seed will do; spread the indices over the bits
+		randomState[i] = (uint32_t)(i * 2654435761u) ^ 0x9e3779b9u;
+		if (randomState[i] == 0)
+			randomState[i] = 1;
+		// Start queueing in a random queue, partway through the wait
+		destination[i] = (uint8_t)(random(i) * destinations.size());
+		float angle = random(i) * 6.2831853f;
+		float distance = sqrtf(random(i)) * destinationRadius;
+		posX[i] = destinations[destination[i]].position.x + distance * cosf(angle);
+		posZ[i] = destinations[destination[i]].position.y + distance * sinf(angle);
+		targetX[i] = posX[i];
+		targetZ[i] = posZ[i];
+		wait[i] = random(i) * 8.0f;
+		speed[i] = CROWD_WALK_SPEED * (0.7f + 0.6f * random(i));
+		heading[i] = random(i) * 6.2831853f;
+		phase[i] = random(i) * 6.2831853f;
+		color[i] = s_shirtColors[(int)(random(i) * (sizeof(s_shirtColors) / sizeof(s_shirtColors[0])))] & 0x00ffffffu;
+	}
+}
+
+void Crowd::simulate(size_t chunk, size_t begin, size_t end, float deltaTime){
+	const uint32_t * indices = grid.indices();
+	const float * xs = grid.xs();
+	const float * zs = grid.zs();
+	const float space = CROWD_PERSONAL_SPACE;
+	float steer = CROWD_STEERING * deltaTime < 1.0f ? CROWD_STEERING * deltaTime : 1.0f;
+	float turn = CROWD_TURN_RATE * deltaTime < 1.0f ? CROWD_TURN_RATE * deltaTime : 1.0f;
+	long long checks = 0;
+	long long arrivals = 0;
+
+	for (size_t i = begin; i < end; i++) {
+		float x = posX[i], z = posZ[i];
+
+		// Where the agent wants to go
+		float wantX = 0.0f, wantZ = 0.0f;
+		if (wait[i] > 0.0f) {
+			wait[i] -= deltaTime;
+			if (wait[i] <= 0.0f)
+				pickTarget(i);
+		}
+		if (wait[i] <= 0.0f) {
+			float toX = targetX[i] - x, toZ = targetZ[i] - z;
+			float distance = sqrtf(toX * toX + toZ * toZ);
+			if (distance < CROWD_ARRIVAL) {
+				wait[i] = 3.0f + 7.0f * random(i);
+				arrivals++;
+			} else {
+				// Slow down over the last unit
+				float slow = distance < 1.0f ? distance : 1.0f;
+				wantX = toX / distance * speed[i] * slow;
+				wantZ = toZ / distance * speed[i] * slow;
+			}
+		}
+
+		// Separation from the neighbours in the 3 x 3 cells around, a row of cells at a time
+		float pushX = 0.0f, pushZ = 0.0f;
+		int neighbours = 0;
+		int cellX = grid.cellOf(x), cellZ = grid.cellOf(z);
+		for (int dz = -1; dz <= 1 && neighbours < CROWD_MAX_NEIGHBOURS; dz++) {
+			uint32_t ranges[2][2];
+			int rangeCount = grid.rowRanges(cellX, cellZ + dz, ranges);
+			for (int r = 0; r < rangeCount && neighbours < CROWD_MAX_NEIGHBOURS; r++) {
+				for (uint32_t j = ranges[r][0]; j < ranges[r][1]; j++) {
+					checks++;
+					float awayX = x - xs[j], awayZ = z - zs[j];
+					float distanceSquared = awayX * awayX + awayZ * awayZ;
+					if (distanceSquared >= space * space || indices[j] == i)
+						continue;
+					// (space - distance) / space along the unit vector away from the neighbour
+					float strength;
+					if (distanceSquared > 1e-8f) {
+						strength = 1.0f / sqrtf(distanceSquared) - 1.0f / space;
+					} else {
+						// Exactly on top of each other: split by index
+						awayX = indices[j] < i ? 1.0f : -1.0f;
+						awayZ = 0.0f;
+						strength = 1.0f;
+					}
+					pushX += awayX * strength;
+					pushZ += awayZ * strength;
+					if (++neighbours >= CROWD_MAX_NEIGHBOURS)
+						break;
+				}
+			}
+		}
+
+		// Rides: pushed out of the footprint, and sidestepping it while heading into it
+		for (size_t o = 0; o < obstacles.size(); o++) {
+			const CrowdObstacle & obstacle = obstacles[o];
+			float awayX = x - obstacle.center.x, awayZ = z - obstacle.center.y;
+			float reach = obstacle.radius + space;
+			float distanceSquared = awayX * awayX + awayZ * awayZ;
+			if (distanceSquared >= reach * reach || distanceSquared < 1e-8f)
+				continue;
+			float distance = sqrtf(distanceSquared);
+			awayX /= distance;
+			awayZ /= distance;
+			float depth = (reach - distance) / space;
+			pushX += awayX * depth;
+			pushZ += awayZ * depth;
+			float into = -(wantX * awayX + wantZ * awayZ);
+			if (into > 0.0f) {
+				// Turn the part of the wanted velocity that points into the ride along its edge
+				float side = wantX * -awayZ + wantZ * awayX >= 0.0f ? 1.0f : -1.0f;
+				wantX += into * (awayX - side * awayZ);
+				wantZ += into * (awayZ + side * awayX);
+			}
+		}
+
+		float newVelX = velX[i] + (wantX + pushX * CROWD_SEPARATION - velX[i]) * steer;
+		float newVelZ = velZ[i] + (wantZ + pushZ * CROWD_SEPARATION - velZ[i]) * steer;
+		float limit = 2.0f * speed[i];
+		float velocitySquared = newVelX * newVelX + newVelZ * newVelZ;
+		if (velocitySquared > limit * limit) {
+			float scale = limit / sqrtf(velocitySquared);
+			newVelX *= scale;
+			newVelZ *= scale;
+		}
+		nextVelX[i] = newVelX;
+		nextVelZ[i] = newVelZ;
+		nextX[i] = x + newVelX * deltaTime;
+		nextZ[i] = z + newVelZ * deltaTime;
+
+		// Face where the agent walks, turning smoothly; the stride follows the distance walked
+		float moved = sqrtf(velocitySquared) * deltaTime;
+		if (velocitySquared > 0.01f) {
+			float wanted = atan2f(newVelX, newVelZ);
+			float difference = remainderf(wanted - heading[i], 6.2831853f);
+			heading[i] = remainderf(heading[i] + difference * turn, 6.2831853f);
+		}
+		phase[i] = fmodf(phase[i] + moved * CROWD_STRIDE, 6.2831853f);
+		bool walking = wait[i] <= 0.0f;
+		color[i] = (color[i] & 0x00ffffffu) | (walking ? 0xff000000u : 0u);
+	}
+	chunkChecks[chunk] = checks;
+	chunkArrivals[chunk] = arrivals;
+}
+
+// scratch[s] = values[order[s]] for every agent, then swapped in
+template <typename T>
+static void gather(std::vector<T> & values, std::vector<T> & scratch, const uint32_t * order, WorkerPool & workers){
+	workers.parallelFor(values.size(), CROWD_CHUNK, [&](size_t, size_t begin, size_t end) {
+		for (size_t s = begin; s < end; s++)
+			scratch[s] = values[order[s]];
+	});
+	values.swap(scratch);
+}
+
+void Crowd::reorder(){
+	const uint32_t * order = grid.indices();
+	// The next-frame arrays are free until the steering, so they serve as the float scratch
+	std::vector<float> * floats[] = {
+		&posX, &posZ, &velX, &velZ, &targetX, &targetZ, &wait, &speed, &heading, &phase
+	};
+	for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); i++)
+		gather(*floats[i], nextX, order, *workers);
+	gather(color, scratchWords, order, *workers);
+	gather(randomState, scratchWords, order, *workers);
+	gather(destination, scratchBytes, order, *workers);
+	grid.renumber();
+}
+
+void Crowd::update(float deltaTime){
+	if (count == 0)
+		return;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	grid.build(&posX[0], &posZ[0], count, *workers);
+	if (counters.frames % CROWD_REORDER_FRAMES == 0)
+		reorder();
+	counters.gridMs += millisecondsSince(start);
+
+	start = std::chrono::steady_clock::now();
+	workers->parallelFor(count, CROWD_CHUNK, [&](size_t chunk, size_t begin, size_t end) {
+		simulate(chunk, begin, end, deltaTime);
+	});
+	posX.swap(nextX);
+	posZ.swap(nextZ);
+	velX.swap(nextVelX);
+	velZ.swap(nextVelZ);
+	counters.simulateMs += millisecondsSince(start);
+
+	for (size_t chunk = 0; chunk < chunkChecks.size(); chunk++) {
+		counters.neighbourChecks += chunkChecks[chunk];
+		counters.arrivals += chunkArrivals[chunk];
+	}
+	counters.frames++;
+}
@@ -0,0 +1,154 @@
+#ifndef CROWD_HPP
+#define CROWD_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "workerpool.hpp"
+
+// Park visitors walking between ride queues. GL-free; crowdrenderer.hpp draws them.
+//
+// Agents live in structure-of-arrays form on the ground plane (x/z). Every frame a uniform
+// spatial hash grid (CrowdGrid) is rebuilt over their positions, then each agent steers toward
+// its spot in a ride's queue area, away from neighbours closer than CROWD_PERSONAL_SPACE (found
+// through the grid) and around the rides' footprints. The steering of chunks of CROWD_CHUNK
+// agents runs on a WorkerPool, reading this frame's positions and writing the next ones, so
+// the result doesn't depend on the thread count. Arrived agents queue for a while, then pick
+// another ride. Every CROWD_REORDER_FRAMES frames the agents are renumbered in grid order, so
+// neighbours stay close in memory as the crowd mixes; agent indices are not stable.
+
+#define CROWD_CHUNK 4096
+#define CROWD_PERSONAL_SPACE 0.5f // neighbours closer than this push each other apart
+#define CROWD_MAX_NEIGHBOURS 16   // neighbours an agent reacts to, so jams cost no more than open ground
+#define CROWD_REORDER_FRAMES 30
+
+// Where agents go: the queue area in front of a ride
+struct CrowdDestination {
+	glm::vec2 position; // x, z
+};
+
+// A ride footprint agents walk around
+struct CrowdObstacle {
+	glm::vec2 center;
+	float radius;
+};
+
+// Summed over frames; divide by frames for averages
+struct CrowdStats {
+	long long frames;
+	long long arrivals;
+	long long neighbourChecks; // candidates looked at in the grid
+	double gridMs;
+	double simulateMs;
+};
+
+// Spatial hash over points in the x/z plane: square cells of cellSize, wrapped onto a table of
+// a power of two buckets laid out in rows, with the points sorted by bucket (a counting sort), so
+// the points of a bucket, and of neighbouring cells in a row, are contiguous. Cells a table
+// width or height apart share a bucket; callers check distances. Allocates only in init.
+class CrowdGrid {
+public:
+	CrowdGrid();
+
+	// For up to capacity points
+	void init(size_t capacity, float cellSize);
+	// Hashes the points in parallel and sorts them into buckets on the calling thread.
+	void build(const float * x, const float * z, size_t count, WorkerPool & workers);
+
+	int cellOf(float coordinate) const { return (int)floorf(coordinate * inverseCellSize); }
+	uint32_t bucket(int cellX, int cellZ) const{
+		return ((uint32_t)cellX & columnMask) | (((uint32_t)cellZ << columnShift) & mask);
+	}
+	// Points of cells cellX - 1 to cellX + 1 of row cellZ: one range of sorted points, or two
+	// where the row wraps around the table. Returns the number of ranges.
+	int rowRanges(int cellX, int cellZ, uint32_t ranges[2][2]) const{
+		uint32_t first = bucket(cellX - 1, cellZ), last = bucket(cellX + 1, cellZ);
+		ranges[0][0] = starts[first];
+		if (first <= last) {
+			ranges[0][1] = starts[last + 1];
+			return 1;
+		}
+		ranges[0][1] = starts[(first | columnMask) + 1];
+		ranges[1][0] = starts[last & ~columnMask];
+		ranges[1][1] = starts[last + 1];
+		return 2;
+	}
+	// After the caller moved its points into sorted order: point s is the sorted point s
+	void renumber();
+	// Points in a bucket: sortedIndex/sortedX/sortedZ over [start(bucket), start(bucket + 1))
+	uint32_t start(uint32_t bucket) const { return starts[bucket]; }
+	const uint32_t * indices() const { return &sortedIndex[0]; }
+	const float * xs() const { return &sortedX[0]; }
+	const float * zs() const { return &sortedZ[0]; }
+
+private:
+	float inverseCellSize;
+	uint32_t mask;
+	uint32_t columnMask;
+	int columnShift;
+	std::vector<uint32_t> starts;    // mask + 2 entries
+	std::vector<uint32_t> buckets;   // per point
+	std::vector<uint32_t> sortedIndex;
+	std::vector<float> sortedX;
+	std::vector<float> sortedZ;
+};
+
+class Crowd {
+public:
+	Crowd();
+
+	// count agents scattered over the destinations' queue areas, which are sized so the
+	// crowd has room at any count. The same count always gives the same crowd.
+	void init(size_t count, WorkerPool * pool, const std::vector<CrowdDestination> & destinations,
+		const std::vector<CrowdObstacle> & obstacles);
+
+	void update(float deltaTime);
+
+	size_t size() const { return count; }
+	// Position, heading (radians around y, 0 facing +z), walk phase and color (RGBA8) of agent i;
+	// color alpha is 255 while walking and 0 while queueing
+	const float * x() const { return &posX[0]; }
+	const float * z() const { return &posZ[0]; }
+	const float * headings() const { return &heading[0]; }
+	const float * phases() const { return &phase[0]; }
+	const uint32_t * colors() const { return &color[0]; }
+	float queueRadius() const { return destinationRadius; }
+	const CrowdStats & stats() const { return counters; }
+
+private:
+	void simulate(size_t chunk, size_t begin, size_t end, float deltaTime);
+	void reorder(); // into grid order
+	void pickTarget(size_t agent);
+	float random(size_t agent); // [0, 1), from the agent's own state
+
+	WorkerPool * workers;
+	size_t count;
+	std::vector<CrowdDestination> destinations;
+	std::vector<CrowdObstacle> obstacles;
+	float destinationRadius;
+	CrowdGrid grid;
+
+	// This frame's and the next frame's motion, swapped after every update
+	std::vector<float> posX, posZ, velX, velZ;
+	std::vector<float> nextX, nextZ, nextVelX, nextVelZ;
+	// Written only by the agent's own update
+	std::vector<float> targetX, targetZ;
+	std::vector<float> wait;    // seconds left in the queue, 0 while walking
+	std::vector<float> speed;
+	std::vector<float> heading;
+	std::vector<float> phase;
+	std::vector<uint32_t> color;
+	std::vector<uint8_t> destination;
+	std::vector<uint32_t> randomState;
+	std::vector<uint32_t> scratchWords; // for reorder
+	std::vector<uint8_t> scratchBytes;
+	std::vector<long long> chunkChecks;
+	std::vector<long long> chunkArrivals;
+	CrowdStats counters;
+};
+
+#endif
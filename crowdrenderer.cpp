@@ -0,0 +1,291 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stddef.h>
+
+#include <GL/glew.h>
+
+#include "shadercache.hpp"
+#include "bvh.hpp"
+#include "crowdrenderer.hpp"
+
+// Camera distance up to which each level is used; agents further than the last aren't drawn
+static const float s_lodDistances[CROWD_LOD_COUNT] = { 12.0f, 35.0f, 100.0f };
+// Bounding sphere of a visitor, around its middle
+#define CROWD_CENTER_HEIGHT 0.3f
+#define CROWD_BOUNDS_RADIUS 0.35f
+
+// One instance as the vertex shader takes it
+struct CrowdInstance {
+	float x, z;
+	float heading;
+	float phase;
+	unsigned char color[4];
+	float ground;
+};
+
+struct CrowdVertex {
+	float position[3];
+	float color[4];
+};
+
+// Unindexed triangles, so drawing them leaves the scene's index buffer bound to the VAO
+class CrowdMeshBuilder {
+public:
+	std::vector<CrowdVertex> vertices;
+
+	// Two triangles over a, b, c, d (in order around the quad), counter-clockwise seen from
+	// the outward side
+	void quad(const glm::vec3 & a, const glm::vec3 & b, const glm::vec3 & c, const glm::vec3 & d,
+		const glm::vec3 & outward, const glm::vec4 & color){
+		if (glm::dot(glm::cross(b - a, c - a), outward) < 0.0f) {
+			quad(a, d, c, b, outward, color);
+			return;
+		}
+		const glm::vec3 * corners[6] = { &a, &b, &c, &a, &c, &d };
+		for (int i = 0; i < 6; i++)
+			add(*corners[i], color);
+	}
+
+	void box(const glm::vec3 & center, const glm::vec3 & half, const glm::vec4 & color){
+		for (int axis = 0; axis < 3; axis++) {
+			for (int sign = -1; sign <= 1; sign += 2) {
+				glm::vec3 normal(0.0f);
+				normal[axis] = (float)sign;
+				glm::vec3 u(0.0f), v(0.0f);
+				u[(axis + 1) % 3] = half[(axis + 1) % 3];
+				v[(axis + 2) % 3] = half[(axis + 2) % 3];
+				glm::vec3 face = center + normal * half[axis];
+				quad(face - u - v, face + u - v, face + u + v, face - u + v, normal, color);
+			}
+		}
+	}
+
+	// Upright prism with sides faces between bottom and top, closed at both ends
+	void prism(int sides, float radius, float bottom, float top, const glm::vec4 & color){
+		for (int i = 0; i < sides; i++) {
+			float a0 = i * 6.2831853f / sides, a1 = (i + 1) * 6.2831853f / sides;
+			glm::vec3 p0(radius * cosf(a0), 0.0f, radius * sinf(a0));
+			glm::vec3 p1(radius * cosf(a1), 0.0f, radius * sinf(a1));
+			glm::vec3 up(0.0f, top, 0.0f), down(0.0f, bottom, 0.0f);
+			quad(p0 + down, p1 + down, p1 + up, p0 + up, p0 + p1, color);
+			glm::vec3 caps[2][3] = { { up, p0 + up, p1 + up }, { down, p1 + down, p0 + down } };
+			for (int cap = 0; cap < 2; cap++) {
+				glm::vec3 outward(0.0f, cap == 0 ? 1.0f : -1.0f, 0.0f);
+				glm::vec3 * t = caps[cap];
+				bool flip = glm::dot(glm::cross(t[1] - t[0], t[2] - t[0]), outward) < 0.0f;
+				add(t[0], color);
+				add(t[flip ? 2 : 1], color);
+				add(t[flip ? 1 : 2], color);
+			}
+		}
+	}
+
+private:
+	void add(const glm::vec3 & position, const glm::vec4 & color){
+		CrowdVertex vertex;
+		for (int i = 0; i < 3; i++)
+			vertex.position[i] = position[i];
+		for (int i = 0; i < 4; i++)
+			vertex.color[i] = color[i];
+		vertices.push_back(vertex);
+	}
+};
+
+CrowdRenderer::CrowdRenderer()
+	: viewProjectionLocation(-1), culledCount(0){
+	memset(meshes, 0, sizeof(meshes));
+	memset(lodCounts, 0, sizeof(lodCounts));
+}
+
+CrowdRenderer::~CrowdRenderer(){
+	shutdown();
+}
+
+bool CrowdRenderer::init(size_t capacity){
+	// Same fragment shader as the scene's vertex color permutation
+	program.adopt(LoadShadersCached("CrowdVertexShader.vertexshader", "ColorFragmentShader.fragmentshader"),
+		"crowd", "crowd program");
+	if (program == 0) {
+		printf("Crowd shaders failed to build\n");
+		return false;
+	}
+	viewProjectionLocation = glGetUniformLocation(program, "VP");
+
+	// Shirt color alpha 1 takes the agent's color; skin and trousers keep their own
+	const glm::vec4 shirt(1.0f, 1.0f, 1.0f, 1.0f);
+	const glm::vec4 skin(0.95f, 0.78f, 0.62f, 0.0f);
+	const glm::vec4 trousers(0.18f, 0.2f, 0.32f, 0.0f);
+	CrowdMeshBuilder builder;
+	builder.box(glm::vec3(-0.05f, 0.1f, 0.0f), glm::vec3(0.04f, 0.1f, 0.05f), trousers);
+	builder.box(glm::vec3(0.05f, 0.1f, 0.0f), glm::vec3(0.04f, 0.1f, 0.05f), trousers);
+	builder.prism(8, 0.11f, 0.2f, 0.46f, shirt);
+	builder.box(glm::vec3(0.0f, 0.53f, 0.0f), glm::vec3(0.065f), skin);
+	meshes[CROWD_LOD_FULL].vertexCount = (int)builder.vertices.size();
+	meshes[CROWD_LOD_BOXES].firstVertex = builder.vertices.size();
+	builder.box(glm::vec3(0.0f, 0.1f, 0.0f), glm::vec3(0.09f, 0.1f, 0.05f), trousers);
+	builder.box(glm::vec3(0.0f, 0.33f, 0.0f), glm::vec3(0.11f, 0.13f, 0.08f), shirt);
+	builder.box(glm::vec3(0.0f, 0.53f, 0.0f), glm::vec3(0.065f), skin);
+	meshes[CROWD_LOD_BOXES].vertexCount = (int)(builder.vertices.size() - meshes[CROWD_LOD_BOXES].firstVertex);
+	meshes[CROWD_LOD_SINGLE].firstVertex = builder.vertices.size();
+	builder.box(glm::vec3(0.0f, 0.3f, 0.0f), glm::vec3(0.1f, 0.3f, 0.08f), shirt);
+	meshes[CROWD_LOD_SINGLE].vertexCount = (int)(builder.vertices.size() - meshes[CROWD_LOD_SINGLE].firstVertex);
+
+	size_t vertexBytes = builder.vertices.size() * sizeof(CrowdVertex);
+	vertexBuffer.create("crowd", "crowd meshes");
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, vertexBytes, &builder.vertices[0], GL_STATIC_DRAW);
+	vertexBuffer.setSize(vertexBytes);
+
+	if (!instances.init(GL_ARRAY_BUFFER, capacity * sizeof(CrowdInstance), 3, "crowd", "crowd instances")) {
+		shutdown();
+		return false;
+	}
+	lods.assign(capacity, 0);
+	grounds.assign(capacity, 0.0f);
+	chunkCounts.assign(WorkerPool::chunkCount(capacity, CROWD_CHUNK) * CROWD_LOD_COUNT, 0);
+	return true;
+}
+
+void CrowdRenderer::shutdown(){
+	instances.shutdown();
+	vertexBuffer.reset();
+	program.reset();
+}
+
+void CrowdRenderer::draw(RenderStateCache & renderState, const Crowd & crowd, WorkerPool & workers,
+	const glm::mat4 & view, const glm::mat4 & viewProjection, float floorY, float (*groundHeight)(float x, float z)){
+	memset(lodCounts, 0, sizeof(lodCounts));
+	culledCount = 0;
+	size_t count = crowd.size();
+	if (program == 0 || count == 0 || count > lods.size())
+		return;
+
+	glm::vec4 planes[6];
+	frustumPlanes(viewProjection, planes);
+	// The view is a rotation and a translation: the camera sits at -R^T t
+	glm::vec3 translation(view[3]);
+	glm::vec3 camera(-glm::dot(glm::vec3(view[0]), translation), -glm::dot(glm::vec3(view[1]), translation),
+		-glm::dot(glm::vec3(view[2]), translation));
+	float limits[CROWD_LOD_COUNT];
+	for (int i = 0; i < CROWD_LOD_COUNT; i++)
+		limits[i] = s_lodDistances[i] * s_lodDistances[i];
+
+	// Pass 1: level (or culled) per agent, counted per chunk
+	const float * xs = crowd.x();
+	const float * zs = crowd.z();
+	workers.parallelFor(count, CROWD_CHUNK, [&](size_t chunk, size_t begin, size_t end) {
+		int * counts = &chunkCounts[chunk * CROWD_LOD_COUNT];
+		for (int lod = 0; lod < CROWD_LOD_COUNT; lod++)
+			counts[lod] = 0;
+		for (size_t i = begin; i < end; i++) {
+			unsigned char lod = CROWD_LOD_COUNT;
+			grounds[i] = groundHeight != NULL ? groundHeight(xs[i], zs[i]) : floorY;
+			float centerY = grounds[i] + CROWD_CENTER_HEIGHT;
+			bool inside = true;
+			for (int p = 0; p < 6 && inside; p++)
+				inside = planes[p].x * xs[i] + planes[p].y * centerY + planes[p].z * zs[i] + planes[p].w > -CROWD_BOUNDS_RADIUS;
+			if (inside) {
+				float dx = xs[i] - camera.x, dy = centerY - camera.y, dz = zs[i] - camera.z;
+				float distanceSquared = dx * dx + dy * dy + dz * dz;
+				for (lod = 0; lod < CROWD_LOD_COUNT && distanceSquared > limits[lod]; lod++)
+					;
+			}
+			lods[i] = lod;
+			if (lod < CROWD_LOD_COUNT)
+				counts[lod]++;
+		}
+	});
+
+	// Each chunk's counts become where it starts writing within its level's range
+	size_t chunks = WorkerPool::chunkCount(count, CROWD_CHUNK);
+	int visible = 0;
+	int firstInstance[CROWD_LOD_COUNT];
+	for (int lod = 0; lod < CROWD_LOD_COUNT; lod++) {
+		firstInstance[lod] = visible;
+		for (size_t chunk = 0; chunk < chunks; chunk++) {
+			int & slot = chunkCounts[chunk * CROWD_LOD_COUNT + lod];
+			int chunkCount = slot;
+			slot = visible;
+			visible += chunkCount;
+		}
+		lodCounts[lod] = visible - firstInstance[lod];
+	}
+	culledCount = (int)count - visible;
+	if (visible == 0)
+		return;
+
+	size_t bytes = visible * sizeof(CrowdInstance);
+	size_t offset = 0;
+	instances.beginFrame(bytes);
+	CrowdInstance * dst = (CrowdInstance *)instances.map(bytes, sizeof(CrowdInstance), offset);
+	if (dst == NULL)
+		return;
+	// Pass 2: every visible agent into its slot
+	const float * headings = crowd.headings();
+	const float * phases = crowd.phases();
+	const uint32_t * colors = crowd.colors();
+	workers.parallelFor(count, CROWD_CHUNK, [&](size_t chunk, size_t begin, size_t end) {
+		int cursors[CROWD_LOD_COUNT];
+		for (int lod = 0; lod < CROWD_LOD_COUNT; lod++)
+			cursors[lod] = chunkCounts[chunk * CROWD_LOD_COUNT + lod];
+		for (size_t i = begin; i < end; i++) {
+			if (lods[i] >= CROWD_LOD_COUNT)
+				continue;
+			CrowdInstance & instance = dst[cursors[lods[i]]++];
+			instance.x = xs[i];
+			instance.z = zs[i];
+			instance.heading = headings[i];
+			instance.phase = phases[i];
+			memcpy(instance.color, &colors[i], 4);
+			instance.ground = grounds[i];
+		}
+	});
+	instances.unmap();
+
+	glUseProgram(program);
+	glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, &viewProjection[0][0]);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(CrowdVertex), (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(CrowdVertex), (void*)(3 * sizeof(float)));
+	glBindBuffer(GL_ARRAY_BUFFER, instances.buffer());
+	glEnableVertexAttribArray(3);
+	glVertexAttribDivisor(3, 1);
+	glEnableVertexAttribArray(4);
+	glVertexAttribDivisor(4, 1);
+	glEnableVertexAttribArray(5);
+	glVertexAttribDivisor(5, 1);
+	for (int lod = 0; lod < CROWD_LOD_COUNT; lod++) {
+		if (lodCounts[lod] == 0)
+			continue;
+		// No base instance in GL 3.3: point the instance attributes at the level's range
+		size_t first = offset + firstInstance[lod] * sizeof(CrowdInstance);
+		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(CrowdInstance), (void*)first);
+		glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CrowdInstance), (void*)(first + 4 * sizeof(float)));
+		glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(CrowdInstance), (void*)(first + offsetof(CrowdInstance, ground)));
+		glDrawArraysInstanced(GL_TRIANGLES, (GLint)meshes[lod].firstVertex, meshes[lod].vertexCount, lodCounts[lod]);
+		if (FrameStats * stats = renderState.stats()) {
+			stats->drawCalls++;
+			stats->triangles += meshes[lod].vertexCount / 3 * lodCounts[lod];
+			stats->vertices += meshes[lod].vertexCount * lodCounts[lod];
+		}
+	}
+	instances.endFrame();
+	glVertexAttribDivisor(3, 0);
+	glVertexAttribDivisor(4, 0);
+	glVertexAttribDivisor(5, 0);
+	for (GLuint i = 0; i < 6; i++) {
+		if (i != 2)
+			glDisableVertexAttribArray(i);
+	}
+	renderState.invalidate();
+
+	if (FrameStats * stats = renderState.stats()) {
+		stats->programBinds++;
+		stats->bufferBinds += 2;
+		stats->uniformUploads++;
+		stats->uploadBytes += bytes;
+	}
+}
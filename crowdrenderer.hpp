@@ -0,0 +1,66 @@
+#ifndef CROWDRENDERER_HPP
+#define CROWDRENDERER_HPP
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "glresource.hpp"
+#include "renderstate.hpp"
+#include "streambuffer.hpp"
+#include "crowd.hpp"
+
+// Levels of detail of a visitor, nearest first
+enum CrowdLod {
+	CROWD_LOD_FULL,   // octagonal body, head and legs
+	CROWD_LOD_BOXES,  // box body and box head
+	CROWD_LOD_SINGLE, // one box
+	CROWD_LOD_COUNT
+};
+
+// Draws a Crowd with one instanced draw per level of detail.
+//
+// Every frame the worker pool tests each agent's bounding sphere against the view frustum and
+// picks its level by distance to the camera, counting per chunk; the counts give every chunk
+// its place in each level's range, and a second pass writes the instances there, straight into
+// this frame's region of a StreamBuffer. The vertex shader turns each instance (position,
+// heading, walk phase, ground height, shirt color) into a placed, bobbing visitor. Agents past the last
+// level's distance are not drawn. GL thread only.
+class CrowdRenderer {
+public:
+	CrowdRenderer();
+	~CrowdRenderer();
+
+	// Builds the meshes and loads the shader. capacity sizes the instance buffer. Needs a
+	// current GL context; false (after printing why) if the shader doesn't build.
+	bool init(size_t capacity);
+	void shutdown();
+
+	// Draws the visible agents standing on groundHeight(x, z), or on floorY without one.
+	// Changes the bound program, so renderState is invalidated; counted in its stats.
+	void draw(RenderStateCache & renderState, const Crowd & crowd, WorkerPool & workers, const glm::mat4 & view,
+		const glm::mat4 & viewProjection, float floorY, float (*groundHeight)(float x, float z) = NULL);
+
+	// Agents drawn at each level, and culled, in the last draw
+	int drawn(CrowdLod lod) const { return lodCounts[lod]; }
+	int culled() const { return culledCount; }
+
+private:
+	struct LodMesh {
+		size_t firstVertex;
+		int vertexCount;
+	};
+
+	GLProgram program;
+	GLint viewProjectionLocation;
+	GLBuffer vertexBuffer;
+	LodMesh meshes[CROWD_LOD_COUNT];
+	StreamBuffer instances;
+	std::vector<unsigned char> lods;       // per agent, CROWD_LOD_COUNT when culled
+	std::vector<float> grounds;            // per agent, the height it stands at
+	std::vector<int> chunkCounts;          // CROWD_LOD_COUNT per chunk, then turned into offsets
+	int lodCounts[CROWD_LOD_COUNT];
+	int culledCount;
+};
+
+#endif
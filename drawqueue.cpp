@@ -0,0 +1,54 @@
+#include <string.h>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include "drawqueue.hpp"
+
+static const char * s_drawOrderNames[] = { "submission", "front-to-back" };
+
+const char * drawOrderName(DrawOrder order){
+	return s_drawOrderNames[order];
+}
+
+bool parseDrawOrder(const char * name, DrawOrder & order){
+	for (int i = 0; i < (int)(sizeof(s_drawOrderNames) / sizeof(s_drawOrderNames[0])); i++) {
+		if (strcmp(name, s_drawOrderNames[i]) == 0) {
+			order = (DrawOrder)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+void OpaqueQueue::add(const SceneMesh * mesh, const glm::mat4 & model, GLuint texture, int layer){
+	OpaqueDraw draw;
+	draw.mesh = mesh;
+	draw.model = model;
+	draw.texture = texture;
+	draw.layer = layer;
+	draw.depth = 0.0f;
+	draw.sequence = (int)draws.size();
+	draws.push_back(draw);
+}
+
+static bool nearerFirst(const OpaqueDraw & a, const OpaqueDraw & b){
+	if (a.layer != b.layer)
+		return a.layer < b.layer;
+	if (a.depth != b.depth)
+		return a.depth < b.depth;
+	return a.sequence < b.sequence;
+}
+
+void OpaqueQueue::sort(const glm::mat4 & view, DrawOrder order){
+	if (order == DRAW_ORDER_SUBMISSION)
+		return;
+	for (size_t i = 0; i < draws.size(); i++) {
+		OpaqueDraw & draw = draws[i];
+		glm::vec3 center = (glm::vec3(draw.mesh->boundsMin[0], draw.mesh->boundsMin[1], draw.mesh->boundsMin[2])
+			+ glm::vec3(draw.mesh->boundsMax[0], draw.mesh->boundsMax[1], draw.mesh->boundsMax[2])) * 0.5f;
+		// The camera looks down -z in view space
+		draw.depth = -(view * draw.model * glm::vec4(center, 1.0f)).z;
+	}
+	std::sort(draws.begin(), draws.end(), nearerFirst);
+}
@@ -0,0 +1,54 @@
+#ifndef DRAWQUEUE_HPP
+#define DRAWQUEUE_HPP
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "scene.hpp"
+
+// Order of the opaque pass.
+//   DRAW_ORDER_SUBMISSION    the order the draws were added in
+//   DRAW_ORDER_FRONT_TO_BACK nearest first by view depth, so the depth test rejects hidden
+//                            fragments before they are shaded
+enum DrawOrder {
+	DRAW_ORDER_SUBMISSION,
+	DRAW_ORDER_FRONT_TO_BACK
+};
+
+const char * drawOrderName(DrawOrder order);
+// Accepts the names drawOrderName returns. false for anything else.
+bool parseDrawOrder(const char * name, DrawOrder & order);
+
+// Front to back sorts within a layer, and layers are drawn in increasing order. The depth of a
+// large surface that everything stands on (the floor) says little about what it hides, so it
+// goes in DRAW_LAYER_GROUND and is drawn after the rest has filled the depth buffer.
+enum DrawLayer {
+	DRAW_LAYER_DEFAULT,
+	DRAW_LAYER_GROUND
+};
+
+struct OpaqueDraw {
+	const SceneMesh * mesh;
+	glm::mat4 model;
+	GLuint texture;    // 0 draws with vertex colors
+	int layer;         // DrawLayer
+	float depth;       // view space depth of the mesh's bounds center, set by sort
+	int sequence;      // position in submission order, keeps the sort stable
+};
+
+// The opaque draws of one frame. Built fresh every frame, then sorted once the view is known.
+class OpaqueQueue {
+public:
+	void clear() { draws.clear(); }
+	void add(const SceneMesh * mesh, const glm::mat4 & model, GLuint texture, int layer = DRAW_LAYER_DEFAULT);
+	void sort(const glm::mat4 & view, DrawOrder order);
+
+	size_t size() const { return draws.size(); }
+	const OpaqueDraw & operator[](size_t i) const { return draws[i]; }
+
+private:
+	std::vector<OpaqueDraw> draws;
+};
+
+#endif
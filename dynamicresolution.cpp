@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <GL/glew.h>
+
+#include "shadercache.hpp"
+#include "dynamicresolution.hpp"
+
+#define RESOLUTION_WINDOW 30
+#define RESOLUTION_HEADROOM 0.75
+#define RESOLUTION_SCALE_STEP 0.1f
+#define RESOLUTION_TIMING_LATENCY 4
+
+static const char * s_upscaleFilterNames[] = { "bilinear", "sharpen" };
+
+const char * upscaleFilterName(UpscaleFilter filter){
+	return s_upscaleFilterNames[filter];
+}
+
+bool parseUpscaleFilter(const char * name, UpscaleFilter & filter){
+	for (int i = 0; i < (int)(sizeof(s_upscaleFilterNames) / sizeof(s_upscaleFilterNames[0])); i++) {
+		if (strcmp(name, s_upscaleFilterNames[i]) == 0) {
+			filter = (UpscaleFilter)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+ResolutionController::ResolutionController(float targetFps, int maxSamples, float minScale)
+	: current(0), budget(targetFps > 0.0f ? 1000.0 / targetFps : 1000.0 / 60.0), changeCount(0){
+	Level level;
+	level.scale = 1.0f;
+	for (level.samples = maxSamples > 1 ? maxSamples : 1; level.samples > 1; level.samples /= 2)
+		levels.push_back(level);
+	level.samples = 1;
+	levels.push_back(level);
+	// Integer steps so 1.0 - n * 0.1 doesn't drift past minScale
+	for (int step = 1; 1.0f - step * RESOLUTION_SCALE_STEP >= minScale - 0.001f; step++) {
+		level.scale = 1.0f - step * RESOLUTION_SCALE_STEP;
+		levels.push_back(level);
+	}
+}
+
+bool ResolutionController::update(double frameMs){
+	window.push_back(frameMs);
+	if ((int)window.size() < RESOLUTION_WINDOW)
+		return false;
+	double sum = 0.0;
+	for (size_t i = 0; i < window.size(); i++)
+		sum += window[i];
+	double average = sum / window.size();
+	window.clear();
+
+	int next = current;
+	if (average > budget && current + 1 < (int)levels.size())
+		next = current + 1;
+	else if (average < budget * RESOLUTION_HEADROOM && current > 0)
+		next = current - 1;
+	if (next == current)
+		return false;
+	current = next;
+	changeCount++;
+	return true;
+}
+
+DynamicResolutionTarget::DynamicResolutionTarget()
+	: filter(UPSCALE_BILINEAR), sharpenSourceLocation(-1), requestedSamples(0), currentTiming(-1), lastGpuMs(0.0){
+}
+
+DynamicResolutionTarget::~DynamicResolutionTarget(){
+	shutdown();
+}
+
+bool DynamicResolutionTarget::init(UpscaleFilter filter){
+	this->filter = filter;
+	if (filter == UPSCALE_SHARPEN) {
+		sharpenProgram.adopt(LoadShadersCached("UpscaleVertexShader.vertexshader", "SharpenFragmentShader.fragmentshader"),
+			"dynamic resolution", "sharpen");
+		if (sharpenProgram == 0) {
+			printf("Sharpening shader failed to build, upscaling bilinear\n");
+			this->filter = UPSCALE_BILINEAR;
+		} else {
+			sharpenSourceLocation = glGetUniformLocation(sharpenProgram, "sourceSampler");
+		}
+	}
+
+	if (GLEW_VERSION_3_3 || GLEW_ARB_timer_query) {
+		timings.resize(RESOLUTION_TIMING_LATENCY + 1);
+		for (size_t i = 0; i < timings.size(); i++) {
+			glGenQueries(1, &timings[i].begin);
+			glGenQueries(1, &timings[i].end);
+			timings[i].pending = false;
+		}
+	}
+	currentTiming = -1;
+	return true;
+}
+
+void DynamicResolutionTarget::shutdown(){
+	deleteOffscreenTarget(target);
+	sourceFramebuffer.reset();
+	sourceTexture.reset();
+	sharpenProgram.reset();
+	for (size_t i = 0; i < timings.size(); i++) {
+		glDeleteQueries(1, &timings[i].begin);
+		glDeleteQueries(1, &timings[i].end);
+	}
+	timings.clear();
+	requestedSamples = 0;
+}
+
+bool DynamicResolutionTarget::createSource(int width, int height){
+	sourceTexture.create("dynamic resolution", "sharpen source");
+	glBindTexture(GL_TEXTURE_2D, sourceTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	sourceTexture.setSize((size_t)width * height * 4);
+
+	sourceFramebuffer.create("dynamic resolution", "sharpen source framebuffer");
+	glBindFramebuffer(GL_FRAMEBUFFER, sourceFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sourceTexture, 0);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		printf("Sharpen source framebuffer is incomplete (0x%x)\n", status);
+		return false;
+	}
+	return true;
+}
+
+bool DynamicResolutionTarget::begin(int outputWidth, int outputHeight, float scale, int samples){
+	int width = (int)(outputWidth * scale + 0.5f);
+	int height = (int)(outputHeight * scale + 0.5f);
+	if (width < 1)
+		width = 1;
+	if (height < 1)
+		height = 1;
+
+	if (width != target.width || height != target.height || samples != requestedSamples) {
+		bool ok = createOffscreenTarget(width, height, samples, target);
+		if (ok && filter == UPSCALE_SHARPEN) {
+			ok = createSource(width, height);
+			glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+		}
+		if (!ok) {
+			requestedSamples = 0;
+			return false;
+		}
+		requestedSamples = samples;
+	} else {
+		glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+		glViewport(0, 0, target.width, target.height);
+	}
+
+	if (!timings.empty()) {
+		currentTiming = (currentTiming + 1) % (int)timings.size();
+		// Still pending here means present() never got to read it; the queries are reused anyway
+		timings[currentTiming].pending = false;
+		glQueryCounter(timings[currentTiming].begin, GL_TIMESTAMP);
+	}
+	return true;
+}
+
+void DynamicResolutionTarget::present(GLuint outputFramebuffer, int outputWidth, int outputHeight){
+	if (target.framebuffer == 0)
+		return;
+
+	if (filter == UPSCALE_SHARPEN) {
+		// Resolve (or copy) into the texture, then draw it over the output with the sharpening shader
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, sourceFramebuffer);
+		glBlitFramebuffer(0, 0, target.width, target.height, 0, 0, target.width, target.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+		glViewport(0, 0, outputWidth, outputHeight);
+		glDisable(GL_DEPTH_TEST);
+		glUseProgram(sharpenProgram);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, sourceTexture);
+		glUniform1i(sharpenSourceLocation, 0);
+		// Fullscreen triangle made in the vertex shader from gl_VertexID
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glEnable(GL_DEPTH_TEST);
+	} else {
+		// A multisampled buffer can't be scaled by a blit, so resolve it first
+		resolveOffscreenTarget(target);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, resolvedOffscreenFramebuffer(target));
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
+		glBlitFramebuffer(0, 0, target.width, target.height, 0, 0, outputWidth, outputHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+	glViewport(0, 0, outputWidth, outputHeight);
+
+	if (timings.empty() || currentTiming < 0)
+		return;
+	glQueryCounter(timings[currentTiming].end, GL_TIMESTAMP);
+	timings[currentTiming].pending = true;
+	// The slot begin() reuses next is the oldest one
+	Timing & oldest = timings[(currentTiming + 1) % timings.size()];
+	if (!oldest.pending)
+		return;
+	GLint available = 0;
+	glGetQueryObjectiv(oldest.end, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return;
+	GLuint64 beginNs = 0, endNs = 0;
+	glGetQueryObjectui64v(oldest.begin, GL_QUERY_RESULT, &beginNs);
+	glGetQueryObjectui64v(oldest.end, GL_QUERY_RESULT, &endNs);
+	lastGpuMs = endNs > beginNs ? (endNs - beginNs) / 1e6 : 0.0;
+	oldest.pending = false;
+}
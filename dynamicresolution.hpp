@@ -0,0 +1,103 @@
+#ifndef DYNAMICRESOLUTION_HPP
+#define DYNAMICRESOLUTION_HPP
+
+#include <vector>
+
+#include "glresource.hpp"
+#include "headless.hpp"
+
+// Dynamic resolution: the scene is drawn into an offscreen target whose size and MSAA sample
+// count follow the measured frame time, and the result is scaled up to the output (the window
+// or the headless framebuffer) before the HUD goes on top.
+
+enum UpscaleFilter {
+	UPSCALE_BILINEAR, // glBlitFramebuffer with GL_LINEAR
+	UPSCALE_SHARPEN   // bilinear plus an unsharp mask in a fullscreen pass
+};
+
+const char * upscaleFilterName(UpscaleFilter filter);
+// Accepts the names upscaleFilterName returns. false for anything else.
+bool parseUpscaleFilter(const char * name, UpscaleFilter & filter);
+
+// Picks a render scale and sample count from frame times. Feed it the larger of the CPU time
+// of the frame (without waiting for the swap, which vsync would stretch to the refresh
+// interval) and the GPU time of the scene.
+//
+// The settings form a ladder from full quality down: first the MSAA samples are halved, then
+// the scale drops in steps to minScale. Frame times are averaged over blocks of
+// RESOLUTION_WINDOW frames and each average is compared with the budget of the target frame
+// rate: above it the controller steps down one level, well below it (RESOLUTION_HEADROOM) it
+// steps back up one. Every decision waits for a full block of frames at the current level, so
+// a single spike (e.g. the reallocation after a change) can't move it twice.
+class ResolutionController {
+public:
+	ResolutionController(float targetFps, int maxSamples, float minScale);
+
+	// Records one frame; true if the level changed.
+	bool update(double frameMs);
+
+	float scale() const { return levels[current].scale; }
+	int samples() const { return levels[current].samples; }
+	int level() const { return current; }
+	int levelCount() const { return (int)levels.size(); }
+	int changes() const { return changeCount; }
+	double budgetMs() const { return budget; }
+
+private:
+	struct Level {
+		float scale;
+		int samples;
+	};
+	std::vector<Level> levels; // levels[0] is full quality
+	int current;
+	double budget;
+	std::vector<double> window;
+	int changeCount;
+};
+
+// The scaled scene target and the upscale pass. GPU time from begin to the end of present is
+// measured with timestamp queries (they don't clash with the profiler's per-frame
+// GL_TIME_ELAPSED query) and read back a few frames later, like the profiler does.
+class DynamicResolutionTarget {
+public:
+	DynamicResolutionTarget();
+	~DynamicResolutionTarget();
+
+	// Loads the sharpening shader when filter needs it. Needs a current GL context.
+	bool init(UpscaleFilter filter);
+	void shutdown();
+
+	// (Re)creates the scene target for the output size times scale when the size or the samples
+	// changed, and leaves it bound for drawing with a matching viewport.
+	bool begin(int outputWidth, int outputHeight, float scale, int samples);
+	// Resolves the scene and scales it up into outputFramebuffer (0 is the window), then leaves
+	// that framebuffer bound with a full-size viewport. The sharpening pass changes the bound
+	// program and texture.
+	void present(GLuint outputFramebuffer, int outputWidth, int outputHeight);
+
+	const OffscreenTarget & scene() const { return target; }
+	// GPU ms of the newest frame whose queries have finished, 0 before the first one.
+	double gpuMs() const { return lastGpuMs; }
+
+private:
+	struct Timing {
+		GLuint begin;
+		GLuint end;
+		bool pending;
+	};
+	bool createSource(int width, int height);
+
+	UpscaleFilter filter;
+	OffscreenTarget target;
+	// Single-sample texture copy of the scene for the sharpening pass
+	GLFramebuffer sourceFramebuffer;
+	GLTexture sourceTexture;
+	GLProgram sharpenProgram;
+	GLint sharpenSourceLocation;
+	int requestedSamples; // target.samples may be clamped to what the driver allows
+	std::vector<Timing> timings;
+	int currentTiming;
+	double lastGpuMs;
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "glresource.hpp"
+
+static const char * s_typeNames[GL_RESOURCE_TYPE_COUNT] = {
+	"buffer", "texture", "renderbuffer", "framebuffer", "vertex array", "program"
+};
+
+const char * glResourceTypeName(GLResourceType type){
+	return s_typeNames[type];
+}
+
+GLResourceTracker & glResources(){
+	static GLResourceTracker tracker;
+	return tracker;
+}
+
+GLuint createGLObject(GLResourceType type){
+	GLuint name = 0;
+	switch (type) {
+	case GL_RESOURCE_BUFFER: glGenBuffers(1, &name); break;
+	case GL_RESOURCE_TEXTURE: glGenTextures(1, &name); break;
+	case GL_RESOURCE_RENDERBUFFER: glGenRenderbuffers(1, &name); break;
+	case GL_RESOURCE_FRAMEBUFFER: glGenFramebuffers(1, &name); break;
+	case GL_RESOURCE_VERTEX_ARRAY: glGenVertexArrays(1, &name); break;
+	case GL_RESOURCE_PROGRAM: name = glCreateProgram(); break;
+	default: break;
+	}
+	return name;
+}
+
+void deleteGLObject(GLResourceType type, GLuint name){
+	switch (type) {
+	case GL_RESOURCE_BUFFER: glDeleteBuffers(1, &name); break;
+	case GL_RESOURCE_TEXTURE: glDeleteTextures(1, &name); break;
+	case GL_RESOURCE_RENDERBUFFER: glDeleteRenderbuffers(1, &name); break;
+	case GL_RESOURCE_FRAMEBUFFER: glDeleteFramebuffers(1, &name); break;
+	case GL_RESOURCE_VERTEX_ARRAY: glDeleteVertexArrays(1, &name); break;
+	case GL_RESOURCE_PROGRAM: glDeleteProgram(name); break;
+	default: break;
+	}
+}
+
+GLResourceTracker::GLResourceTracker()
+	: totalBytes(0), peak(0){
+	memset(typeBytes, 0, sizeof(typeBytes));
+}
+
+int GLResourceTracker::find(GLResourceType type, GLuint name) const{
+	for (size_t i = 0; i < resources.size(); i++) {
+		if (resources[i].type == type && resources[i].name == name)
+			return (int)i;
+	}
+	return -1;
+}
+
+void GLResourceTracker::add(GLResourceType type, GLuint name, const char * owner, const char * label){
+	if (find(type, name) >= 0) {
+		printf("GL %s %u registered twice (%s)\n", glResourceTypeName(type), name, label);
+		return;
+	}
+	Resource resource;
+	resource.type = type;
+	resource.name = name;
+	resource.bytes = 0;
+	resource.owner = owner;
+	resource.label = label;
+	resources.push_back(resource);
+}
+
+void GLResourceTracker::setSize(GLResourceType type, GLuint name, size_t bytes){
+	int index = find(type, name);
+	if (index < 0)
+		return;
+	Resource & resource = resources[index];
+	typeBytes[type] = typeBytes[type] - resource.bytes + bytes;
+	totalBytes = totalBytes - resource.bytes + bytes;
+	resource.bytes = bytes;
+	if (totalBytes > peak)
+		peak = totalBytes;
+}
+
+void GLResourceTracker::remove(GLResourceType type, GLuint name){
+	for (size_t i = 0; i < resources.size(); i++) {
+		if (resources[i].type == type && resources[i].name == name) {
+			typeBytes[type] -= resources[i].bytes;
+			totalBytes -= resources[i].bytes;
+			resources[i] = resources.back();
+			resources.pop_back();
+			break;
+		}
+	}
+	// GL reuses names, so uses of a deleted object must not carry over to the next one
+	for (size_t i = 0; i < uses.size();) {
+		if (uses[i].type == type && uses[i].name == name) {
+			uses[i] = uses.back();
+			uses.pop_back();
+		} else {
+			i++;
+		}
+	}
+}
+
+void GLResourceTracker::addUse(const char * ride, GLResourceType type, GLuint name, size_t bytes){
+	if (name == 0 || find(type, name) < 0)
+		return;
+	Use use;
+	use.ride = ride;
+	use.type = type;
+	use.name = name;
+	use.bytes = bytes;
+	uses.push_back(use);
+}
+
+void GLResourceTracker::clearUses(){
+	uses.clear();
+}
+
+static double megabytes(size_t bytes){
+	return bytes / (1024.0 * 1024.0);
+}
+
+void GLResourceTracker::printReport() const{
+	printf("GL resources: %d objects, %.2f MB live, %.2f MB peak\n", liveCount(), megabytes(totalBytes), megabytes(peak));
+	for (int type = 0; type < GL_RESOURCE_TYPE_COUNT; type++) {
+		int count = 0;
+		for (size_t i = 0; i < resources.size(); i++)
+			count += resources[i].type == type;
+		if (count > 0)
+			printf("  %-14s %3d  %10.2f KB\n", s_typeNames[type], count, typeBytes[type] / 1024.0);
+	}
+
+	std::map<std::string, size_t> owners;
+	for (size_t i = 0; i < resources.size(); i++)
+		owners[resources[i].owner] += resources[i].bytes;
+	printf("  by owner:\n");
+	for (std::map<std::string, size_t>::const_iterator it = owners.begin(); it != owners.end(); ++it)
+		printf("    %-20s %10.2f KB\n", it->first.c_str(), it->second / 1024.0);
+
+	if (uses.empty())
+		return;
+	// A ride's total is per type too, so a shared texture shows up as texture memory of each ride
+	std::map<std::string, std::vector<size_t> > rides;
+	for (size_t i = 0; i < uses.size(); i++) {
+		int index = find(uses[i].type, uses[i].name);
+		if (index < 0)
+			continue;
+		std::vector<size_t> & bytes = rides[uses[i].ride];
+		bytes.resize(GL_RESOURCE_TYPE_COUNT, 0);
+		bytes[uses[i].type] += uses[i].bytes != 0 ? uses[i].bytes : resources[index].bytes;
+	}
+	printf("  by ride (shared objects count for every ride using them):\n");
+	for (std::map<std::string, std::vector<size_t> >::const_iterator it = rides.begin(); it != rides.end(); ++it) {
+		size_t total = 0;
+		for (int type = 0; type < GL_RESOURCE_TYPE_COUNT; type++)
+			total += it->second[type];
+		printf("    %-20s %10.2f KB (buffers %.2f KB, textures %.2f KB)\n", it->first.c_str(), total / 1024.0,
+			it->second[GL_RESOURCE_BUFFER] / 1024.0, it->second[GL_RESOURCE_TEXTURE] / 1024.0);
+	}
+}
+
+int GLResourceTracker::reportLeaks() const{
+	for (size_t i = 0; i < resources.size(); i++) {
+		const Resource & resource = resources[i];
+		printf("Leaked GL %s %u: %s (%s), %zu bytes\n", s_typeNames[resource.type], resource.name,
+			resource.label.c_str(), resource.owner.c_str(), resource.bytes);
+	}
+	return (int)resources.size();
+}
@@ -0,0 +1,141 @@
+#ifndef GLRESOURCE_HPP
+#define GLRESOURCE_HPP
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+enum GLResourceType {
+	GL_RESOURCE_BUFFER,
+	GL_RESOURCE_TEXTURE,
+	GL_RESOURCE_RENDERBUFFER,
+	GL_RESOURCE_FRAMEBUFFER,
+	GL_RESOURCE_VERTEX_ARRAY,
+	GL_RESOURCE_PROGRAM,
+	GL_RESOURCE_TYPE_COUNT
+};
+
+const char * glResourceTypeName(GLResourceType type);
+
+// Every live GL object with the bytes of storage it holds, who created it (owner, e.g.
+// "scene" or "textures") and a label for reports. Sizes are what we asked the driver for;
+// padding and driver-side copies are not visible from here, and programs count the size of
+// their binary where the driver reports one.
+//
+// Rides share buffers and textures, so per-ride numbers come from uses: addUse attributes
+// part or all of an object to a ride, and an object used by several rides counts toward each
+// of them. GL thread only, like the objects themselves.
+class GLResourceTracker {
+public:
+	GLResourceTracker();
+
+	void add(GLResourceType type, GLuint name, const char * owner, const char * label);
+	void setSize(GLResourceType type, GLuint name, size_t bytes);
+	void remove(GLResourceType type, GLuint name);
+
+	// bytes 0 means the whole object, whatever its size is when the report is made.
+	void addUse(const char * ride, GLResourceType type, GLuint name, size_t bytes = 0);
+	void clearUses();
+
+	size_t liveBytes() const { return totalBytes; }
+	size_t liveBytes(GLResourceType type) const { return typeBytes[type]; }
+	size_t peakBytes() const { return peak; }
+	int liveCount() const { return (int)resources.size(); }
+
+	// Live bytes per type, per owner and per ride, and the peak.
+	void printReport() const;
+	// Lists every object still registered. Call after all cleanup; returns how many there were.
+	int reportLeaks() const;
+
+private:
+	struct Resource {
+		GLResourceType type;
+		GLuint name;
+		size_t bytes;
+		std::string owner;
+		std::string label;
+	};
+	struct Use {
+		std::string ride;
+		GLResourceType type;
+		GLuint name;
+		size_t bytes;
+	};
+	int find(GLResourceType type, GLuint name) const; // index into resources, -1 if not found
+
+	std::vector<Resource> resources;
+	std::vector<Use> uses;
+	size_t typeBytes[GL_RESOURCE_TYPE_COUNT];
+	size_t totalBytes;
+	size_t peak;
+};
+
+// The process-wide tracker the handles below register with.
+GLResourceTracker & glResources();
+
+// GL object creation and deletion by type; programs use glCreateProgram / glDeleteProgram.
+GLuint createGLObject(GLResourceType type);
+void deleteGLObject(GLResourceType type, GLuint name);
+
+// Owns one GL object and keeps it registered with glResources() while it lives. Move-only.
+// Converts to the GL name, so it can be passed to glBindBuffer and friends as is.
+//
+// Objects must be reset (or destroyed) while their context is still current; the cleanup
+// code does that explicitly, the destructor only catches what it missed.
+template <GLResourceType Type>
+class GLHandle {
+public:
+	GLHandle() : name(0) {}
+	~GLHandle() { reset(); }
+	GLHandle(GLHandle && other) noexcept : name(other.name) { other.name = 0; }
+	GLHandle & operator=(GLHandle && other) noexcept {
+		if (this != &other) {
+			reset();
+			name = other.name;
+			other.name = 0;
+		}
+		return *this;
+	}
+
+	// Creates a new object, replacing the current one.
+	void create(const char * owner, const char * label){
+		adopt(createGLObject(Type), owner, label);
+	}
+	// Takes over an object created elsewhere (e.g. by compileProgram). 0 just resets.
+	void adopt(GLuint object, const char * owner, const char * label){
+		reset();
+		name = object;
+		if (name != 0)
+			glResources().add(Type, name, owner, label);
+	}
+	// Call whenever the storage is (re)allocated.
+	void setSize(size_t bytes){
+		if (name != 0)
+			glResources().setSize(Type, name, bytes);
+	}
+	void reset(){
+		if (name != 0) {
+			glResources().remove(Type, name);
+			deleteGLObject(Type, name);
+			name = 0;
+		}
+	}
+
+	GLuint get() const { return name; }
+	operator GLuint() const { return name; }
+
+private:
+	GLHandle(const GLHandle &);
+	GLHandle & operator=(const GLHandle &);
+
+	GLuint name;
+};
+
+typedef GLHandle<GL_RESOURCE_BUFFER> GLBuffer;
+typedef GLHandle<GL_RESOURCE_TEXTURE> GLTexture;
+typedef GLHandle<GL_RESOURCE_RENDERBUFFER> GLRenderbuffer;
+typedef GLHandle<GL_RESOURCE_FRAMEBUFFER> GLFramebuffer;
+typedef GLHandle<GL_RESOURCE_VERTEX_ARRAY> GLVertexArray;
+typedef GLHandle<GL_RESOURCE_PROGRAM> GLProgram;
+
+#endif
@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include "mappedfile.hpp"
+#include "bmpimage.hpp"
+#include "goldenimage.hpp"
+
+// Largest possible YIQ delta (black against white)
+#define YIQ_MAX_DELTA 35215.0
+
+bool loadImageBMP(const char * path, RGBAImage & image){
+	MappedFile file;
+	if (!mapFile(path, file))
+		return false;
+	BMPImage bmp;
+	bool ok = parseBMP(file.data, file.size, bmp);
+	if (ok) {
+		image.width = bmp.width;
+		image.height = bmp.height;
+		image.pixels.resize((size_t)bmp.width * bmp.height * 4);
+		convertBMPToRGBA(bmp, &image.pixels[0]);
+	} else {
+		printf("%s is not a BMP we can read\n", path);
+	}
+	unmapFile(file);
+	return ok;
+}
+
+static void writeLE32(unsigned char * p, unsigned int value){
+	p[0] = value & 0xff;
+	p[1] = (value >> 8) & 0xff;
+	p[2] = (value >> 16) & 0xff;
+	p[3] = (value >> 24) & 0xff;
+}
+
+bool saveImageBMP(const char * path, const RGBAImage & image){
+	FILE * file = fopen(path, "wb");
+	if (file == NULL) {
+		printf("Could not write %s\n", path);
+		return false;
+	}
+
+	unsigned int rowPitch = (image.width * 3 + 3) & ~3u;
+	unsigned char header[54];
+	memset(header, 0, sizeof(header));
+	header[0] = 'B';
+	header[1] = 'M';
+	writeLE32(header + 0x02, 54 + rowPitch * image.height);
+	writeLE32(header + 0x0A, 54);
+	writeLE32(header + 0x0E, 40);
+	writeLE32(header + 0x12, image.width);
+	writeLE32(header + 0x16, image.height); // positive: bottom row first, same as RGBAImage
+	header[0x1A] = 1;
+	header[0x1C] = 24;
+	writeLE32(header + 0x22, rowPitch * image.height);
+	fwrite(header, 1, sizeof(header), file);
+
+	std::vector<unsigned char> row(rowPitch, 0);
+	for (unsigned int y = 0; y < image.height; y++) {
+		const unsigned char * src = &image.pixels[(size_t)y * image.width * 4];
+		for (unsigned int x = 0; x < image.width; x++) {
+			row[x * 3 + 0] = src[x * 4 + 2];
+			row[x * 3 + 1] = src[x * 4 + 1];
+			row[x * 3 + 2] = src[x * 4 + 0];
+		}
+		fwrite(&row[0], 1, rowPitch, file);
+	}
+	return fclose(file) == 0;
+}
+
+static double yiqDelta(const unsigned char * a, const unsigned char * b){
+	double r = (double)a[0] - b[0], g = (double)a[1] - b[1], bl = (double)a[2] - b[2];
+	double y = r * 0.29889531 + g * 0.58662247 + bl * 0.11448223;
+	double i = r * 0.59597799 - g * 0.27417610 - bl * 0.32180189;
+	double q = r * 0.21147017 - g * 0.52261711 + bl * 0.31114694;
+	return 0.5053 * y * y + 0.299 * i * i + 0.1957 * q * q;
+}
+
+bool compareImages(const RGBAImage & golden, const RGBAImage & actual, float threshold,
+	ImageDifference & difference, RGBAImage * diff){
+	memset(&difference, 0, sizeof(difference));
+	if (golden.width != actual.width || golden.height != actual.height)
+		return false;
+
+	size_t count = (size_t)golden.width * golden.height;
+	double limit = YIQ_MAX_DELTA * threshold * threshold;
+	if (diff != NULL) {
+		diff->width = golden.width;
+		diff->height = golden.height;
+		diff->pixels.resize(count * 4);
+	}
+
+	double maxDelta = 0.0;
+	for (size_t p = 0; p < count; p++) {
+		const unsigned char * a = &golden.pixels[p * 4];
+		const unsigned char * b = &actual.pixels[p * 4];
+		double delta = yiqDelta(a, b);
+		bool different = delta > limit;
+		if (different)
+			difference.differentPixels++;
+		if (delta > maxDelta)
+			maxDelta = delta;
+
+		if (diff != NULL) {
+			unsigned char * d = &diff->pixels[p * 4];
+			if (different) {
+				d[0] = 255;
+				d[1] = 0;
+				d[2] = 0;
+			} else {
+				// Faded brightness of the golden, so the red stands out
+				unsigned char grey = (unsigned char)(191 + (a[0] * 0.299 + a[1] * 0.587 + a[2] * 0.114) / 4.0);
+				d[0] = d[1] = d[2] = grey;
+			}
+			d[3] = 255;
+		}
+	}
+	difference.differentFraction = count > 0 ? (double)difference.differentPixels / count : 0.0;
+	difference.maxDelta = maxDelta / YIQ_MAX_DELTA;
+	return true;
+}
+
+static void makeDirectory(const std::string & path){
+#ifdef _WIN32
+	_mkdir(path.c_str());
+#else
+	mkdir(path.c_str(), 0755);
+#endif
+}
+
+GoldenCheck::GoldenCheck(const char * goldenDir, const char * outputDir, const char * name, bool update)
+	: goldenDir(goldenDir), outputDir(outputDir), name(name), update(update),
+	threshold(0.1f), maxDifferentFraction(0.001), failedFrames(0), timingFailed(false){
+}
+
+void GoldenCheck::setTolerance(float threshold, double maxDifferentFraction){
+	this->threshold = threshold;
+	this->maxDifferentFraction = maxDifferentFraction;
+}
+
+std::string GoldenCheck::goldenPath(const char * suffix, int frame) const{
+	char file[256];
+	snprintf(file, sizeof(file), "%s_%05d%s.bmp", name.c_str(), frame, suffix);
+	return goldenDir + "/" + file;
+}
+
+std::string GoldenCheck::outputPath(const char * suffix, int frame) const{
+	char file[256];
+	snprintf(file, sizeof(file), "%s_%05d%s.bmp", name.c_str(), frame, suffix);
+	return outputDir + "/" + file;
+}
+
+bool GoldenCheck::checkFrame(int frame, const RGBAImage & image){
+	std::string golden = goldenPath("", frame);
+	if (update) {
+		makeDirectory(goldenDir);
+		bool ok = saveImageBMP(golden.c_str(), image);
+		if (ok)
+			printf("Golden %s written\n", golden.c_str());
+		return ok;
+	}
+
+	RGBAImage expected;
+	ImageDifference difference;
+	RGBAImage diff;
+	bool ok = loadImageBMP(golden.c_str(), expected);
+	if (!ok) {
+		printf("Golden %s is missing, run with --golden-update first\n", golden.c_str());
+	} else if (!compareImages(expected, image, threshold, difference, &diff)) {
+		printf("Golden %s is %ux%u, the frame is %ux%u\n", golden.c_str(), expected.width, expected.height, image.width, image.height);
+		ok = false;
+	} else {
+		ok = difference.differentFraction <= maxDifferentFraction;
+		printf("Golden %s: %s, %u pixels (%.3f%%) differ, max delta %.3f\n", golden.c_str(), ok ? "match" : "MISMATCH",
+			difference.differentPixels, difference.differentFraction * 100.0, difference.maxDelta);
+	}
+
+	if (!ok) {
+		failedFrames++;
+		makeDirectory(outputDir);
+		saveImageBMP(outputPath("_actual", frame).c_str(), image);
+		if (!diff.pixels.empty())
+			saveImageBMP(outputPath("_diff", frame).c_str(), diff);
+	}
+	return ok;
+}
+
+bool GoldenCheck::checkTiming(double p50Ms, double tolerance){
+	std::string path = goldenDir + "/" + name + "_timing.txt";
+	if (update) {
+		makeDirectory(goldenDir);
+		FILE * file = fopen(path.c_str(), "w");
+		if (file == NULL) {
+			printf("Could not write %s\n", path.c_str());
+			return false;
+		}
+		fprintf(file, "p50Ms %.4f\n", p50Ms);
+		return fclose(file) == 0;
+	}
+
+	FILE * file = fopen(path.c_str(), "r");
+	double baseline = 0.0;
+	bool ok = file != NULL && fscanf(file, "p50Ms %lf", &baseline) == 1 && baseline > 0.0;
+	if (file != NULL)
+		fclose(file);
+	if (!ok) {
+		printf("No baseline timing in %s\n", path.c_str());
+		timingFailed = true;
+		return false;
+	}
+
+	timingFailed = p50Ms > baseline * (1.0 + tolerance);
+	printf("Frame time p50 %.3f ms against %.3f ms golden (%+.1f%%): %s\n", p50Ms, baseline,
+		(p50Ms / baseline - 1.0) * 100.0, timingFailed ? "SLOWER" : "ok");
+	return !timingFailed;
+}
@@ -0,0 +1,65 @@
+#ifndef GOLDENIMAGE_HPP
+#define GOLDENIMAGE_HPP
+
+#include <string>
+#include <vector>
+
+// Tightly packed RGBA rows, bottom row first (glReadPixels order).
+struct RGBAImage {
+	unsigned int width;
+	unsigned int height;
+	std::vector<unsigned char> pixels;
+};
+
+bool loadImageBMP(const char * path, RGBAImage & image);
+// Writes a 24 bit BMP; alpha is dropped.
+bool saveImageBMP(const char * path, const RGBAImage & image);
+
+struct ImageDifference {
+	unsigned int differentPixels;
+	double differentFraction;
+	double maxDelta; // 0..1, largest per-pixel difference
+};
+
+// Perceptual comparison: each pixel's difference is measured in YIQ space weighted the way
+// the eye weighs brightness against hue (as in pixelmatch), normalized to 0..1. Pixels above
+// threshold count as different. With diff given, it gets a faded grey copy of the golden with
+// the different pixels in red. Returns false if the sizes don't match.
+bool compareImages(const RGBAImage & golden, const RGBAImage & actual, float threshold,
+	ImageDifference & difference, RGBAImage * diff);
+
+// One golden-image run: frames of a named run (e.g. a camera path) against
+// <goldenDir>/<name>_<frame>.bmp, and the run's median frame time against the one stored with
+// the goldens in <goldenDir>/<name>_timing.txt. With update set, the goldens and timing are
+// written instead. Failing frames leave the rendered image and a diff image in outputDir.
+class GoldenCheck {
+public:
+	GoldenCheck(const char * goldenDir, const char * outputDir, const char * name, bool update);
+
+	// A frame matches when at most maxDifferentFraction of its pixels differ by more than
+	// threshold. Defaults: 0.1 and 0.1%.
+	void setTolerance(float threshold, double maxDifferentFraction);
+
+	bool checkFrame(int frame, const RGBAImage & image);
+	// The run passes if p50Ms is at most the stored median times (1 + tolerance). A negative
+	// tolerance demands a real speedup.
+	bool checkTiming(double p50Ms, double tolerance);
+
+	int imageFailures() const { return failedFrames; }
+	bool slower() const { return timingFailed; }
+
+private:
+	std::string goldenPath(const char * suffix, int frame) const;
+	std::string outputPath(const char * suffix, int frame) const;
+
+	std::string goldenDir;
+	std::string outputDir;
+	std::string name;
+	bool update;
+	float threshold;
+	double maxDifferentFraction;
+	int failedFrames;
+	bool timingFailed;
+};
+
+#endif
@@ -0,0 +1,27 @@
+#include <string.h>
+
+#include "mappedfile.hpp"
+#include "hash.hpp"
+
+uint64_t hashBytes(const void * data, size_t size, uint64_t seed){
+	const unsigned char * bytes = (const unsigned char *)data;
+	uint64_t hash = seed;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+uint64_t hashString(const char * str, uint64_t seed){
+	return hashBytes(str, strlen(str), seed);
+}
+
+bool hashFile(const char * path, uint64_t & hash){
+	MappedFile file;
+	if (!mapFile(path, file))
+		return false;
+	hash = hashBytes(file.data, file.size);
+	unmapFile(file);
+	return true;
+}
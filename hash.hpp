@@ -0,0 +1,18 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HASH_SEED 0xcbf29ce484222325ULL
+
+// 64 bit FNV-1a. Pass a previous result as seed to hash several pieces as one stream.
+uint64_t hashBytes(const void * data, size_t size, uint64_t seed = HASH_SEED);
+
+// Hashes a NUL terminated string (without the terminator).
+uint64_t hashString(const char * str, uint64_t seed = HASH_SEED);
+
+// Hashes the whole contents of a file. Returns false if it can't be read.
+bool hashFile(const char * path, uint64_t & hash);
+
+#endif
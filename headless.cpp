@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <GL/glew.h>
+
+#ifndef _WIN32
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include "headless.hpp"
+#include "streambuffer.hpp"
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+#ifdef _WIN32
+
+bool createHeadlessContext(HeadlessContext & context){
+	memset(&context, 0, sizeof(context));
+	printf("Headless mode needs EGL, which this build doesn't have\n");
+	return false;
+}
+
+void destroyHeadlessContext(HeadlessContext & context){
+	memset(&context, 0, sizeof(context));
+}
+
+#else
+
+static bool hasExtension(const char * extensions, const char * name){
+	if (extensions == NULL)
+		return false;
+	size_t length = strlen(name);
+	for (const char * p = strstr(extensions, name); p != NULL; p = strstr(p + length, name)) {
+		if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0'))
+			return true;
+	}
+	return false;
+}
+
+// The surfaceless platform needs no X server or GPU device; the default display is the fallback
+static EGLDisplay openDisplay(){
+	const char * clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")
+		&& hasExtension(clientExtensions, "EGL_EXT_platform_base")) {
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay != NULL) {
+			EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+			if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL))
+				return display;
+		}
+	}
+
+	EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL))
+		return display;
+	return EGL_NO_DISPLAY;
+}
+
+bool createHeadlessContext(HeadlessContext & context){
+	memset(&context, 0, sizeof(context));
+
+	EGLDisplay display = openDisplay();
+	if (display == EGL_NO_DISPLAY) {
+		printf("Could not open an EGL display (error 0x%x)\n", eglGetError());
+		return false;
+	}
+
+	bool surfaceless = hasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0
+		|| !eglBindAPI(EGL_OPENGL_API)) {
+		printf("No EGL config for desktop OpenGL (error 0x%x)\n", eglGetError());
+		eglTerminate(display);
+		return false;
+	}
+
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLContext eglContext = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	if (eglContext == EGL_NO_CONTEXT) {
+		printf("Could not create a GL 3.3 core context (error 0x%x)\n", eglGetError());
+		eglTerminate(display);
+		return false;
+	}
+
+	// Everything is drawn into an FBO, so the surface is only there if the context needs one
+	EGLSurface surface = EGL_NO_SURFACE;
+	if (!surfaceless) {
+		const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		surface = eglCreatePbufferSurface(display, config, pbufferAttributes);
+	}
+	if ((!surfaceless && surface == EGL_NO_SURFACE) || !eglMakeCurrent(display, surface, surface, eglContext)) {
+		printf("Could not make the headless context current (error 0x%x)\n", eglGetError());
+		if (surface != EGL_NO_SURFACE)
+			eglDestroySurface(display, surface);
+		eglDestroyContext(display, eglContext);
+		eglTerminate(display);
+		return false;
+	}
+
+	context.display = display;
+	context.surface = surface;
+	context.context = eglContext;
+	return true;
+}
+
+void destroyHeadlessContext(HeadlessContext & context){
+	if (context.display == NULL)
+		return;
+	eglMakeCurrent(context.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (context.surface != EGL_NO_SURFACE)
+		eglDestroySurface(context.display, context.surface);
+	if (context.context != EGL_NO_CONTEXT)
+		eglDestroyContext(context.display, context.context);
+	eglTerminate(context.display);
+	memset(&context, 0, sizeof(context));
+}
+
+#endif
+
+static bool checkFramebuffer(const char * name){
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		printf("%s framebuffer is incomplete (0x%x)\n", name, status);
+		return false;
+	}
+	return true;
+}
+
+bool createOffscreenTarget(int width, int height, int samples, OffscreenTarget & target){
+	deleteOffscreenTarget(target);
+	GLint maxSamples = 0;
+	glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+	if (samples > maxSamples) {
+		printf("%d samples requested, the driver allows %d\n", samples, maxSamples);
+		samples = maxSamples;
+	}
+	if (samples < 1)
+		samples = 1;
+	target.width = width;
+	target.height = height;
+	target.samples = samples;
+
+	// Both formats are taken as 4 bytes per sample for the resource tracker
+	size_t bufferBytes = (size_t)width * height * 4 * samples;
+	target.framebuffer.create("offscreen", "offscreen framebuffer");
+	target.colorBuffer.create("offscreen", "offscreen color");
+	target.depthBuffer.create("offscreen", "offscreen depth");
+	glBindRenderbuffer(GL_RENDERBUFFER, target.colorBuffer);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples > 1 ? samples : 0, GL_RGBA8, width, height);
+	target.colorBuffer.setSize(bufferBytes);
+	glBindRenderbuffer(GL_RENDERBUFFER, target.depthBuffer);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples > 1 ? samples : 0, GL_DEPTH_COMPONENT24, width, height);
+	target.depthBuffer.setSize(bufferBytes);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target.depthBuffer);
+	bool ok = checkFramebuffer("Offscreen");
+
+	if (ok && samples > 1) {
+		target.resolveFramebuffer.create("offscreen", "resolve framebuffer");
+		target.resolveColorBuffer.create("offscreen", "resolve color");
+		glBindRenderbuffer(GL_RENDERBUFFER, target.resolveColorBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		target.resolveColorBuffer.setSize((size_t)width * height * 4);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, target.resolveFramebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.resolveColorBuffer);
+		ok = checkFramebuffer("Resolve");
+	}
+
+	if (!ok) {
+		deleteOffscreenTarget(target);
+		return false;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+	glViewport(0, 0, width, height);
+	return true;
+}
+
+GLuint resolvedOffscreenFramebuffer(const OffscreenTarget & target){
+	return target.resolveFramebuffer != 0 ? target.resolveFramebuffer.get() : target.framebuffer.get();
+}
+
+void resolveOffscreenTarget(const OffscreenTarget & target){
+	if (target.resolveFramebuffer != 0) {
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.resolveFramebuffer);
+		glBlitFramebuffer(0, 0, target.width, target.height, 0, 0, target.width, target.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+}
+
+void readOffscreenPixels(const OffscreenTarget & target, unsigned char * rgba){
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, resolvedOffscreenFramebuffer(target));
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, target.width, target.height, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+	glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+}
+
+void deleteOffscreenTarget(OffscreenTarget & target){
+	if (target.framebuffer != 0)
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	target.resolveFramebuffer.reset();
+	target.framebuffer.reset();
+	target.resolveColorBuffer.reset();
+	target.colorBuffer.reset();
+	target.depthBuffer.reset();
+	target.width = 0;
+	target.height = 0;
+	target.samples = 0;
+}
+
+// JSON strings from the driver can contain anything; keep it to printable ASCII without quotes
+static void writeJsonString(FILE * file, const GLubyte * text){
+	fputc('"', file);
+	for (const GLubyte * c = text; c != NULL && *c != '\0'; c++)
+		fputc(*c >= 32 && *c < 127 && *c != '"' && *c != '\\' ? *c : '?', file);
+	fputc('"', file);
+}
+
+bool writeHeadlessReport(const char * path, const HeadlessReport & report, const RenderStats & stats){
+	FILE * file = fopen(path, "w");
+	if (file == NULL) {
+		printf("Could not write %s\n", path);
+		return false;
+	}
+
+	int count = stats.frameTimeCount();
+	double sum = 0.0, minMs = 0.0, maxMs = 0.0;
+	for (int i = 0; i < count; i++) {
+		double ms = stats.frameTime(i);
+		sum += ms;
+		if (i == 0 || ms < minMs)
+			minMs = ms;
+		if (i == 0 || ms > maxMs)
+			maxMs = ms;
+	}
+	long long frames = stats.frameCount();
+	double perFrame = frames > 0 ? 1.0 / frames : 0.0;
+	const FrameStats & total = stats.totals();
+
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"renderer\": ");
+	writeJsonString(file, glGetString(GL_RENDERER));
+	fprintf(file, ",\n\t\"version\": ");
+	writeJsonString(file, glGetString(GL_VERSION));
+	fprintf(file, ",\n\t\"width\": %d,\n\t\"height\": %d,\n\t\"samples\": %d,\n", report.width, report.height, report.samples);
+	fprintf(file, "\t\"frames\": %lld,\n\t\"startupMs\": %.3f,\n\t\"totalMs\": %.3f,\n", frames, report.startupMs, report.totalMs);
+	fprintf(file, "\t\"fps\": %.3f,\n", report.totalMs > 0.0 ? frames * 1000.0 / report.totalMs : 0.0);
+	fprintf(file, "\t\"frameMs\": { \"samples\": %d, \"mean\": %.3f, \"min\": %.3f, \"max\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f },\n",
+		count, count > 0 ? sum / count : 0.0, minMs, maxMs, stats.percentile(50.0), stats.percentile(95.0), stats.percentile(99.0));
+	fprintf(file, "\t\"perFrame\": { \"drawCalls\": %.2f, \"triangles\": %.2f, \"vertices\": %.2f, \"programBinds\": %.2f, \"bufferBinds\": %.2f, \"textureBinds\": %.2f, \"uniformUploads\": %.2f, \"uploadBytes\": %.2f },\n",
+		total.drawCalls * perFrame, total.triangles * perFrame, total.vertices * perFrame, total.programBinds * perFrame,
+		total.bufferBinds * perFrame, total.textureBinds * perFrame, total.uniformUploads * perFrame, total.uploadBytes * perFrame);
+	fprintf(file, "\t\"opaquePass\": { \"drawOrder\": \"%s\", \"depthPrepass\": %s, \"overdraw\": %.3f },\n",
+		report.drawOrder, report.depthPrepass ? "true" : "false", overdraw(total));
+	fprintf(file, "\t\"dynamicResolution\": { \"targetFps\": %.1f, \"meanScale\": %.3f, \"changes\": %d },\n",
+		report.targetFps, report.meanScale, report.resolutionChanges);
+	fprintf(file, "\t\"rideAnimation\": { \"instances\": %d, \"maxError\": %g },\n",
+		report.animatedRides, report.rideAnimationError);
+	fprintf(file, "\t\"particles\": { \"capacity\": %d, \"threads\": %d, \"meanLive\": %.0f, \"peakLive\": %zu, \"updateMs\": %.3f, \"simulateMs\": %.3f, \"renderMs\": %.3f },\n",
+		report.particleCapacity, report.particleThreads, report.particleMeanLive, report.particlePeakLive,
+		report.particleUpdateMs, report.particleSimulateMs, report.particleRenderMs);
+	fprintf(file, "\t\"crowd\": { \"agents\": %d, \"updateMs\": %.3f, \"gridMs\": %.3f, \"neighbourChecks\": %.1f, \"renderMs\": %.3f, \"lodDrawn\": [%.0f, %.0f, %.0f], \"culled\": %.0f },\n",
+		report.crowdAgents, report.crowdUpdateMs, report.crowdGridMs, report.crowdNeighbourChecks, report.crowdRenderMs,
+		report.crowdDrawn[0], report.crowdDrawn[1], report.crowdDrawn[2], report.crowdCulled);
+	fprintf(file, "\t\"bvh\": { \"objects\": %d, \"nodes\": %d, \"depth\": %d, \"culling\": %s, \"refitMs\": %.4f, \"cullMs\": %.4f, \"visible\": %.1f, \"pickUs\": %.2f },\n",
+		report.bvhObjects, report.bvhNodes, report.bvhDepth, report.culling ? "true" : "false", report.bvhRefitMs,
+		report.bvhCullMs, report.bvhVisible, report.bvhPickUs);
+	fprintf(file, "\t\"terrain\": { \"enabled\": %s, \"chunksDrawn\": %.1f, \"selectMs\": %.4f, \"generated\": %lld, \"evicted\": %lld, \"uploadBytes\": %zu, \"poolBytes\": %zu },\n",
+		report.terrain ? "true" : "false", report.terrainChunksDrawn, report.terrainSelectMs, report.terrainGenerated,
+		report.terrainEvicted, report.terrainUploadBytes, report.terrainPoolBytes);
+	fprintf(file, "\t\"rideCells\": { \"enabled\": %s, \"cellsDrawn\": %.1f, \"ridesDrawn\": %.0f, \"selectMs\": %.4f, \"loaded\": %lld, \"unloaded\": %lld, \"evicted\": %lld, \"uploadBytes\": %zu, \"poolBytes\": %zu },\n",
+		report.rideCells ? "true" : "false", report.rideCellsDrawn, report.rideCellRidesDrawn, report.rideCellSelectMs,
+		report.rideCellsLoaded, report.rideCellsUnloaded, report.rideCellsEvicted, report.rideCellUploadBytes,
+		report.rideCellPoolBytes);
+	fprintf(file, "\t\"streamBuffers\": [");
+	const std::vector<StreamBuffer *> & buffers = streamBuffers();
+	for (size_t i = 0; i < buffers.size(); i++) {
+		const StreamBufferStats & streamStats = buffers[i]->stats();
+		fprintf(file, "%s\n\t\t{ \"label\": \"%s\", \"persistent\": %s, \"frameCount\": %d, \"bytesPerFrame\": %zu, \"peakFrameBytes\": %zu, \"frames\": %lld, \"stalls\": %lld, \"waitMs\": %.3f, \"maxWaitMs\": %.3f, \"overflows\": %d, \"grows\": %d }",
+			i > 0 ? "," : "", buffers[i]->label(), buffers[i]->persistent() ? "true" : "false", buffers[i]->frameCount(),
+			buffers[i]->bytesPerFrame(), streamStats.peakFrameBytes, streamStats.frames, streamStats.stalls,
+			streamStats.waitMs, streamStats.maxWaitMs, streamStats.overflows, streamStats.grows);
+	}
+	fprintf(file, "%s],\n", buffers.empty() ? "" : "\n\t");
+	fprintf(file, "\t\"gpuMemory\": { \"liveBytes\": %zu, \"peakBytes\": %zu }\n", report.gpuBytes, report.gpuPeakBytes);
+	fprintf(file, "}\n");
+
+	bool ok = fclose(file) == 0;
+	if (ok)
+		printf("Wrote %s\n", path);
+	return ok;
+}
@@ -0,0 +1,111 @@
+#ifndef HEADLESS_HPP
+#define HEADLESS_HPP
+
+#include "glresource.hpp"
+#include "renderstats.hpp"
+
+// Running without a window: an EGL context that needs no display server (Mesa llvmpipe works
+// on a machine without a GPU) and a framebuffer object to render into instead of a window.
+
+struct HeadlessContext {
+	void * display; // EGLDisplay
+	void * surface; // EGLSurface, EGL_NO_SURFACE with surfaceless contexts
+	void * context; // EGLContext
+};
+
+// Creates a GL 3.3 core context and makes it current. Prefers Mesa's surfaceless platform and
+// falls back to the default display with a 1x1 pbuffer. Prints why and returns false if
+// neither works, or on platforms without EGL.
+bool createHeadlessContext(HeadlessContext & context);
+void destroyHeadlessContext(HeadlessContext & context);
+
+// Color + depth render target. With samples > 1 the color and depth buffers are multisampled
+// and resolveOffscreenTarget blits them into a single-sample color buffer.
+struct OffscreenTarget {
+	OffscreenTarget() : width(0), height(0), samples(0) {}
+
+	int width;
+	int height;
+	int samples;
+	GLFramebuffer framebuffer;
+	GLRenderbuffer colorBuffer;
+	GLRenderbuffer depthBuffer;
+	GLFramebuffer resolveFramebuffer; // only with multisampling
+	GLRenderbuffer resolveColorBuffer;
+};
+
+// samples is clamped to GL_MAX_SAMPLES. Leaves the target bound for drawing.
+bool createOffscreenTarget(int width, int height, int samples, OffscreenTarget & target);
+// Resolves the multisampled buffer (if any) and binds the framebuffer for drawing again.
+void resolveOffscreenTarget(const OffscreenTarget & target);
+// The framebuffer holding the single-sample image after resolveOffscreenTarget.
+GLuint resolvedOffscreenFramebuffer(const OffscreenTarget & target);
+// Reads the resolved color buffer as RGBA, bottom row first. rgba must hold width * height * 4
+// bytes. Call after resolveOffscreenTarget.
+void readOffscreenPixels(const OffscreenTarget & target, unsigned char * rgba);
+void deleteOffscreenTarget(OffscreenTarget & target);
+
+// Summary of a headless run for writeHeadlessReport.
+struct HeadlessReport {
+	int width;
+	int height;
+	int samples;
+	double startupMs;
+	double totalMs; // the frame loop only
+	size_t gpuBytes; // GL objects still alive at the end of the run
+	size_t gpuPeakBytes;
+	const char * drawOrder; // drawOrderName of the opaque pass
+	bool depthPrepass;
+	float targetFps;    // dynamic resolution target, 0 when it was off
+	double meanScale;   // average render scale over the run
+	int resolutionChanges;
+	int animatedRides;        // rides drawn by the GPU animation path
+	float rideAnimationError; // AnimatedRides::verify result, 0 without animated rides
+	int particleCapacity;      // 0 when particles were off
+	int particleThreads;
+	double particleMeanLive;
+	size_t particlePeakLive;
+	double particleUpdateMs;   // per frame: emit, simulate and compact
+	double particleSimulateMs; // the SIMD kernel's part of it
+	double particleRenderMs;   // per frame: writing the instances and issuing the draw
+	int crowdAgents;             // 0 when the crowd was off
+	double crowdUpdateMs;        // per frame: grid and steering
+	double crowdGridMs;
+	double crowdNeighbourChecks; // grid candidates per agent per frame
+	double crowdRenderMs;        // per frame: culling, levels, instances and draws
+	double crowdDrawn[3];        // mean agents per frame at each CrowdLod
+	double crowdCulled;
+	int bvhObjects;              // scene index over the ride parts
+	int bvhNodes;
+	int bvhDepth;
+	bool culling;                // false with --no-culling
+	double bvhRefitMs;           // per frame
+	double bvhCullMs;            // per frame
+	double bvhVisible;           // mean objects per frame that passed the frustum test
+	double bvhPickUs;            // per pick
+	bool terrain;                // false with --flat-floor
+	double terrainChunksDrawn;   // per frame
+	double terrainSelectMs;      // per frame
+	long long terrainGenerated;
+	long long terrainEvicted;
+	size_t terrainUploadBytes;
+	size_t terrainPoolBytes;
+	bool rideCells;              // false without --flat-rides or with --no-ride-cells
+	double rideCellsDrawn;       // per frame
+	double rideCellRidesDrawn;   // per frame
+	double rideCellSelectMs;     // per frame
+	long long rideCellsLoaded;
+	long long rideCellsUnloaded;
+	long long rideCellsEvicted;
+	size_t rideCellUploadBytes;
+	size_t rideCellPoolBytes;
+};
+
+// Writes a JSON report: settings, GL renderer, frame time mean/min/max/p50/p95/p99 over the
+// frames in the stats window, per-frame averages of the counters, the opaque pass mode with its
+// overdraw, dynamic resolution, the GPU ride animation, the particle and crowd costs, the scene
+// BVH's culling and picking, the terrain's chunk and the flat rides' cell streaming, the stream
+// buffers' stall counters and GL memory.
+bool writeHeadlessReport(const char * path, const HeadlessReport & report, const RenderStats & stats);
+
+#endif
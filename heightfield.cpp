@@ -0,0 +1,126 @@
+#include <math.h>
+#include <stdint.h>
+
+#include "heightfield.hpp"
+
+// The roller coaster's track circles this point
+#define TERRAIN_PARK_X 4.0f
+#define TERRAIN_PARK_Z 4.0f
+// Ridge under the track's high western side, fading out toward the station
+#define TERRAIN_RIDGE_RADIUS 10.0f
+#define TERRAIN_RIDGE_WIDTH 1.5f
+#define TERRAIN_RIDGE_HEIGHT 2.5f
+// Rolling hills start at the plaza's edge and reach full height further out
+#define TERRAIN_PLAZA_RADIUS 24.0f
+#define TERRAIN_HILLS_FULL 70.0f
+#define TERRAIN_HILL_HEIGHT 14.0f
+#define TERRAIN_HILL_SCALE 60.0f  // width of the largest hills
+#define TERRAIN_HILL_OCTAVES 4
+
+static float smoothstep(float edge0, float edge1, float x){
+	float t = (x - edge0) / (edge1 - edge0);
+	t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+	return t * t * (3.0f - 2.0f * t);
+}
+
+// 0..1 at integer lattice points
+static float lattice(int x, int z){
+	uint32_t h = (uint32_t)x * 0x8da6b343u ^ (uint32_t)z * 0xd8163841u;
+	h ^= h >> 13;
+	h *= 0x85ebca6bu;
+	h ^= h >> 16;
+	return (h & 0xffff) / 65535.0f;
+}
+
+static float valueNoise(float x, float z){
+	float fx = floorf(x), fz = floorf(z);
+	int ix = (int)fx, iz = (int)fz;
+	float tx = x - fx, tz = z - fz;
+	tx = tx * tx * (3.0f - 2.0f * tx);
+	tz = tz * tz * (3.0f - 2.0f * tz);
+	float a = lattice(ix, iz) + (lattice(ix + 1, iz) - lattice(ix, iz)) * tx;
+	float b = lattice(ix, iz + 1) + (lattice(ix + 1, iz + 1) - lattice(ix, iz + 1)) * tx;
+	return a + (b - a) * tz;
+}
+
+// 0..1, octaves of value noise halving in size and strength
+static float hills(float x, float z){
+	float sum = 0.0f, amplitude = 0.5f, total = 0.0f;
+	float frequency = 1.0f / TERRAIN_HILL_SCALE;
+	for (int i = 0; i < TERRAIN_HILL_OCTAVES; i++) {
+		sum += amplitude * valueNoise(x * frequency, z * frequency);
+		total += amplitude;
+		amplitude *= 0.5f;
+		frequency *= 2.0f;
+	}
+	return sum / total;
+}
+
+float terrainHeight(float x, float z){
+	float dx = x - TERRAIN_PARK_X, dz = z - TERRAIN_PARK_Z;
+	float distance = sqrtf(dx * dx + dz * dz);
+	float height = TERRAIN_FLOOR_Y;
+	float offset = distance - TERRAIN_RIDGE_RADIUS;
+	if (fabsf(offset) < 4.0f * TERRAIN_RIDGE_WIDTH) {
+		// 1 on the west (-x) side, 0 from north and south round to the station in the east
+		float west = smoothstep(0.5f, 0.95f, 0.5f - 0.5f * dx / distance);
+		height += TERRAIN_RIDGE_HEIGHT * west * expf(-offset * offset / (2.0f * TERRAIN_RIDGE_WIDTH * TERRAIN_RIDGE_WIDTH));
+	}
+	if (distance > TERRAIN_PLAZA_RADIUS)
+		height += TERRAIN_HILL_HEIGHT * smoothstep(TERRAIN_PLAZA_RADIUS, TERRAIN_HILLS_FULL, distance) * hills(x, z);
+	return height;
+}
+
+void terrainHeightRange(float minX, float minZ, float maxX, float maxZ, float & low, float & high){
+	// Nearest and farthest distance from the park's centre
+	float nearX = TERRAIN_PARK_X < minX ? minX : (TERRAIN_PARK_X > maxX ? maxX : TERRAIN_PARK_X);
+	float nearZ = TERRAIN_PARK_Z < minZ ? minZ : (TERRAIN_PARK_Z > maxZ ? maxZ : TERRAIN_PARK_Z);
+	float farX = fmaxf(fabsf(minX - TERRAIN_PARK_X), fabsf(maxX - TERRAIN_PARK_X));
+	float farZ = fmaxf(fabsf(minZ - TERRAIN_PARK_Z), fabsf(maxZ - TERRAIN_PARK_Z));
+	float nearest = sqrtf((nearX - TERRAIN_PARK_X) * (nearX - TERRAIN_PARK_X) + (nearZ - TERRAIN_PARK_Z) * (nearZ - TERRAIN_PARK_Z));
+	float farthest = sqrtf(farX * farX + farZ * farZ);
+	low = TERRAIN_FLOOR_Y;
+	high = TERRAIN_FLOOR_Y;
+	if (nearest < TERRAIN_RIDGE_RADIUS + 4.0f * TERRAIN_RIDGE_WIDTH && farthest > TERRAIN_RIDGE_RADIUS - 4.0f * TERRAIN_RIDGE_WIDTH)
+		high += TERRAIN_RIDGE_HEIGHT;
+	high += TERRAIN_HILL_HEIGHT * smoothstep(TERRAIN_PLAZA_RADIUS, TERRAIN_HILLS_FULL, farthest);
+}
+
+void generateTerrainChunk(float minX, float minZ, float size, TerrainVertex * vertices, float & minY, float & maxY){
+	// Heights with a border of one sample, for the normals at the edges
+	const int side = TERRAIN_CHUNK_QUADS + 3;
+	float heights[side * side];
+	float spacing = size / TERRAIN_CHUNK_QUADS;
+	for (int j = 0; j < side; j++) {
+		for (int i = 0; i < side; i++)
+			heights[j * side + i] = terrainHeight(minX + (i - 1) * spacing, minZ + (j - 1) * spacing);
+	}
+	minY = heights[side + 1];
+	maxY = minY;
+	for (int j = 0; j <= TERRAIN_CHUNK_QUADS; j++) {
+		for (int i = 0; i <= TERRAIN_CHUNK_QUADS; i++) {
+			const float * h = &heights[(j + 1) * side + i + 1];
+			TerrainVertex & vertex = vertices[j * (TERRAIN_CHUNK_QUADS + 1) + i];
+			vertex.position[0] = minX + i * spacing;
+			vertex.position[1] = h[0];
+			vertex.position[2] = minZ + j * spacing;
+			// The coarser level has every other vertex and splits its quads along the same
+			// diagonal, so the vertices it lacks lie on its edges and diagonals
+			if ((i & 1) && (j & 1))
+				vertex.coarseHeight = 0.5f * (h[-side - 1] + h[side + 1]);
+			else if (i & 1)
+				vertex.coarseHeight = 0.5f * (h[-1] + h[1]);
+			else if (j & 1)
+				vertex.coarseHeight = 0.5f * (h[-side] + h[side]);
+			else
+				vertex.coarseHeight = h[0];
+			float nx = h[-1] - h[1], ny = 2.0f * spacing, nz = h[-side] - h[side];
+			float length = sqrtf(nx * nx + ny * ny + nz * nz);
+			vertex.normal[0] = nx / length;
+			vertex.normal[1] = ny / length;
+			vertex.normal[2] = nz / length;
+			minY = fminf(minY, h[0]);
+			maxY = fmaxf(maxY, h[0]);
+		}
+	}
+}
@@ -0,0 +1,33 @@
+#ifndef HEIGHTFIELD_HPP
+#define HEIGHTFIELD_HPP
+
+#include <stddef.h>
+
+// Height of the park's ground and the vertices of one terrain chunk over it. GL-free, and
+// pure functions of their arguments, so chunks can be generated on any thread.
+//
+// The park stands on a flat plaza at TERRAIN_FLOOR_Y, where the old floor quad was. A ring of
+// hills rises under the roller coaster's track, low where the station is, and rolling hills
+// take over past the plaza's edge.
+
+#define TERRAIN_FLOOR_Y -3.0f
+// Quads along each side of a chunk, whatever its level; the same index buffer draws them all
+#define TERRAIN_CHUNK_QUADS 8
+#define TERRAIN_CHUNK_VERTICES ((TERRAIN_CHUNK_QUADS + 1) * (TERRAIN_CHUNK_QUADS + 1))
+
+struct TerrainVertex {
+	float position[3];
+	// Height of the next coarser level's surface here, which the vertex shader morphs to.
+	// Equal to position[1] on vertices that level shares.
+	float coarseHeight;
+	float normal[3];
+};
+
+float terrainHeight(float x, float z);
+// Bounds on the height over the rectangle, without sampling it; may be loose
+void terrainHeightRange(float minX, float minZ, float maxX, float maxZ, float & low, float & high);
+// TERRAIN_CHUNK_VERTICES vertices, row by row along +x, of the square of side size at
+// (minX, minZ), with the exact height range it covers
+void generateTerrainChunk(float minX, float minZ, float size, TerrainVertex * vertices, float & minY, float & maxY);
+
+#endif
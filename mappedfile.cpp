@@ -0,0 +1,97 @@
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mappedfile.hpp"
+
+#ifdef _WIN32
+
+bool mapFile(const char * path, MappedFile & file){
+	memset(&file, 0, sizeof(file));
+
+	HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(handle);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		CloseHandle(handle);
+		return false;
+	}
+
+	void * view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL) {
+		CloseHandle(mapping);
+		CloseHandle(handle);
+		return false;
+	}
+
+	file.data = (const unsigned char *)view;
+	file.size = (size_t)fileSize.QuadPart;
+	file.fileHandle = handle;
+	file.mappingHandle = mapping;
+	return true;
+}
+
+void unmapFile(MappedFile & file){
+	if (file.data) {
+		UnmapViewOfFile(file.data);
+		CloseHandle((HANDLE)file.mappingHandle);
+		CloseHandle((HANDLE)file.fileHandle);
+	}
+	memset(&file, 0, sizeof(file));
+}
+
+#else
+
+bool mapFile(const char * path, MappedFile & file){
+	memset(&file, 0, sizeof(file));
+	file.fd = -1;
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	void * view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (view == MAP_FAILED) {
+		close(fd);
+		return false;
+	}
+	// The whole file is consumed right after mapping, so start paging it in now
+	madvise(view, (size_t)st.st_size, MADV_WILLNEED);
+
+	file.data = (const unsigned char *)view;
+	file.size = (size_t)st.st_size;
+	file.fd = fd;
+	return true;
+}
+
+void unmapFile(MappedFile & file){
+	if (file.data) {
+		munmap((void *)file.data, file.size);
+		close(file.fd);
+	}
+	memset(&file, 0, sizeof(file));
+	file.fd = -1;
+}
+
+#endif
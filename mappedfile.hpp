@@ -0,0 +1,24 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <stddef.h>
+
+// Read-only view of a whole file, backed by mmap (or a file mapping on Windows).
+struct MappedFile {
+	const unsigned char * data;
+	size_t size;
+#ifdef _WIN32
+	void * fileHandle;
+	void * mappingHandle;
+#else
+	int fd;
+#endif
+};
+
+// Maps the file read-only. Returns false (and leaves file empty) on failure.
+bool mapFile(const char * path, MappedFile & file);
+
+// Releases a mapping obtained with mapFile. Safe to call after a failed mapFile.
+void unmapFile(MappedFile & file);
+
+#endif
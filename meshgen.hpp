@@ -0,0 +1,208 @@
+#ifndef MESHGEN_HPP
+#define MESHGEN_HPP
+
+#include <stddef.h>
+#include <array>
+
+// Compile-time primitive generators. Each returns a fixed-size vertex attribute array whose
+// vertex count is part of its type, so buffers and draw counts can't disagree with what the
+// generator writes. With constant arguments the arrays are built by the compiler, e.g.
+//
+//   constexpr auto side = meshgen::cylinderSide<36>(1.0f);
+//   static_assert(side.vertexCount == 36 * 6, "");
+//
+// Needs C++17 (constexpr std::array writes). The layouts match the old makeXxx(GLfloat *)
+// functions: unindexed triangles, except the circle, which is a triangle fan.
+//
+// Every generator winds its triangles counter-clockwise seen from outside (from above for the
+// flat ones), so the meshes can be drawn with back face culling. Surfaces that are seen from
+// both sides (umbrella, rail) are made double sided when they are baked, not here.
+
+namespace meshgen {
+
+// Vertex attribute data: VertexCount vertices of Components floats each.
+template <size_t VertexCount, size_t Components>
+struct AttributeArray : std::array<float, VertexCount * Components> {
+	static constexpr size_t vertexCount = VertexCount;
+	static constexpr size_t components = Components;
+};
+
+template <size_t VertexCount> using Positions = AttributeArray<VertexCount, 3>;
+template <size_t VertexCount> using Colors = AttributeArray<VertexCount, 3>;
+template <size_t VertexCount> using UVs = AttributeArray<VertexCount, 2>;
+
+constexpr double PI = 3.141592;       // the value the park geometry has always used
+constexpr double EXACT_PI = 3.14159265358979323846;
+
+// sin/cos usable in constant expressions: reduce to [-pi, pi], then a Taylor series that is
+// accurate to double precision on that range.
+constexpr double reduceAngle(double x){
+	double turns = x / (2.0 * EXACT_PI);
+	long long whole = (long long)(turns < 0.0 ? turns - 0.5 : turns + 0.5);
+	return x - (double)whole * 2.0 * EXACT_PI;
+}
+
+constexpr double constSin(double x){
+	x = reduceAngle(x);
+	double term = x, sum = x;
+	for (int n = 1; n < 16; n++) {
+		term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+		sum += term;
+	}
+	return sum;
+}
+
+constexpr double constCos(double x){
+	x = reduceAngle(x);
+	double term = 1.0, sum = 1.0;
+	for (int n = 1; n < 16; n++) {
+		term *= -x * x / ((2.0 * n - 1.0) * (2.0 * n));
+		sum += term;
+	}
+	return sum;
+}
+
+template <typename Array>
+constexpr void setVertex(Array & out, size_t vertex, float a, float b, float c){
+	out[3 * vertex] = a;
+	out[3 * vertex + 1] = b;
+	out[3 * vertex + 2] = c;
+}
+
+template <typename Array>
+constexpr void setUV(Array & out, size_t vertex, float u, float v){
+	out[2 * vertex] = u;
+	out[2 * vertex + 1] = v;
+}
+
+// The same color on every vertex, sized to match any attribute array with N vertices.
+template <size_t N>
+constexpr Colors<N> solidColor(float red, float green, float blue){
+	Colors<N> out{};
+	for (size_t i = 0; i < N; i++)
+		setVertex(out, i, red, green, blue);
+	return out;
+}
+
+// Triangle fan facing +y: center, then Sides + 1 rim vertices, the last one closing the
+// circle. The rim runs clockwise in x/z (decreasing angle), which is counter-clockwise seen
+// from above.
+template <int Sides>
+constexpr Positions<Sides + 2> circleVertices(float x, float y, float z, float radius){
+	Positions<Sides + 2> out{};
+	setVertex(out, 0, 0.0f, y, 0.0f);
+	for (int i = 0; i <= Sides; i++) {
+		double angle = (Sides - i) * 2.0 * PI / Sides;
+		setVertex(out, i + 1, (float)(x + radius * constCos(angle)), y, (float)(z + radius * constSin(angle)));
+	}
+	return out;
+}
+
+template <int Sides>
+constexpr UVs<Sides + 2> circleUVs(){
+	UVs<Sides + 2> out{};
+	setUV(out, 0, 0.5f, 0.5f);
+	for (int i = 0; i <= Sides; i++) {
+		double angle = (Sides - i) * 2.0 * PI / Sides;
+		setUV(out, i + 1, (float)(0.5 + 0.5 * constCos(angle)), (float)(0.5 + 0.5 * constSin(angle)));
+	}
+	return out;
+}
+
+// Open cylinder of height radius centered on the origin, two triangles per side, facing out.
+template <int Sides>
+constexpr Positions<Sides * 6> cylinderSide(float radius){
+	Positions<Sides * 6> out{};
+	for (int i = 0; i < Sides; i++) {
+		float x0 = (float)(radius * constCos(i * 2.0 * PI / Sides));
+		float z0 = (float)(radius * constSin(i * 2.0 * PI / Sides));
+		float x1 = (float)(radius * constCos((i + 1) * 2.0 * PI / Sides));
+		float z1 = (float)(radius * constSin((i + 1) * 2.0 * PI / Sides));
+		float top = radius / 2.0f, bottom = -radius / 2.0f;
+		setVertex(out, 6 * i + 0, x0, top, z0);
+		setVertex(out, 6 * i + 1, x1, top, z1);
+		setVertex(out, 6 * i + 2, x0, bottom, z0);
+		setVertex(out, 6 * i + 3, x1, top, z1);
+		setVertex(out, 6 * i + 4, x1, bottom, z1);
+		setVertex(out, 6 * i + 5, x0, bottom, z0);
+	}
+	return out;
+}
+
+template <int Sides>
+constexpr UVs<Sides * 6> cylinderUVs(){
+	UVs<Sides * 6> out{};
+	for (int i = 0; i < Sides; i++) {
+		float u0 = (float)i / Sides, u1 = (float)(i + 1) / Sides;
+		setUV(out, 6 * i + 0, u0, 1.0f);
+		setUV(out, 6 * i + 1, u1, 1.0f);
+		setUV(out, 6 * i + 2, u0, 0.0f);
+		setUV(out, 6 * i + 3, u1, 1.0f);
+		setUV(out, 6 * i + 4, u1, 0.0f);
+		setUV(out, 6 * i + 5, u0, 0.0f);
+	}
+	return out;
+}
+
+// Cone roof: one triangle per side from the apex at height y down to the rim at y = 0, facing
+// out (up).
+template <int Sides>
+constexpr Positions<Sides * 3> umbrella(float y, float radius){
+	Positions<Sides * 3> out{};
+	for (int i = 0; i < Sides; i++) {
+		setVertex(out, 3 * i + 0, 0.0f, y, 0.0f);
+		setVertex(out, 3 * i + 1, (float)(radius * constCos((i + 1) * 2.0 * PI / Sides)), 0.0f,
+			(float)(radius * constSin((i + 1) * 2.0 * PI / Sides)));
+		setVertex(out, 3 * i + 2, (float)(radius * constCos(i * 2.0 * PI / Sides)), 0.0f,
+			(float)(radius * constSin(i * 2.0 * PI / Sides)));
+	}
+	return out;
+}
+
+template <int Sides>
+constexpr UVs<Sides * 3> umbrellaUVs(){
+	UVs<Sides * 3> out{};
+	for (int i = 0; i < Sides; i++) {
+		setUV(out, 3 * i + 0, 0.5f, 0.5f);
+		setUV(out, 3 * i + 1, (float)(0.5 + 0.5 * constCos((i + 1) * 2.0 * PI / Sides)),
+			(float)(0.5 + 0.5 * constSin((i + 1) * 2.0 * PI / Sides)));
+		setUV(out, 3 * i + 2, (float)(0.5 + 0.5 * constCos(i * 2.0 * PI / Sides)),
+			(float)(0.5 + 0.5 * constSin(i * 2.0 * PI / Sides)));
+	}
+	return out;
+}
+
+// Height of the coaster track at angle t, with t = -2pi + (0 .. 4pi) around the ring.
+constexpr double railHeight(double t){
+	return 3.0 * constSin(t) / t + 2.0 * constCos(t);
+}
+
+// Flat ring of width 0.1 around radius 1 whose height follows railHeight, two triangles per
+// segment, facing up.
+template <int Segments>
+constexpr Positions<Segments * 6> railVertices(){
+	Positions<Segments * 6> out{};
+	const double segment = 4.0 * PI / Segments;
+	double angle = 0.0, nextAngle = 0.0;
+	for (int i = 0; i < Segments; i++) {
+		if (i > 0) angle += segment;
+		nextAngle += segment;
+
+		float height = (float)railHeight(-2.0 * PI + angle);
+		float nextHeight = (float)railHeight(-2.0 * PI + nextAngle);
+		double c0 = constCos(i * 2.0 * PI / Segments), s0 = constSin(i * 2.0 * PI / Segments);
+		double c1 = constCos((i + 1) * 2.0 * PI / Segments), s1 = constSin((i + 1) * 2.0 * PI / Segments);
+
+		setVertex(out, 6 * i + 0, (float)(0.95 * c0), height, (float)(0.95 * s0));
+		setVertex(out, 6 * i + 1, (float)(0.95 * c1), nextHeight, (float)(0.95 * s1));
+		setVertex(out, 6 * i + 2, (float)(1.05 * c0), height, (float)(1.05 * s0));
+		setVertex(out, 6 * i + 3, (float)(0.95 * c1), nextHeight, (float)(0.95 * s1));
+		setVertex(out, 6 * i + 4, (float)(1.05 * c1), nextHeight, (float)(1.05 * s1));
+		setVertex(out, 6 * i + 5, (float)(1.05 * c0), height, (float)(1.05 * s0));
+	}
+	return out;
+}
+
+} // namespace meshgen
+
+#endif
@@ -0,0 +1,732 @@
+// Micro-benchmarks for the CPU side of a frame and of startup.
+//
+//   microbench [--filter text] [--min-time seconds] [--out results.json]
+//
+// Covers the mesh generators at several side counts, the whole park bake, BMP loading (read into
+// a heap copy as loadBMP_custom does, mapped as the texture streamer does, and the RGBA conversion),
+// the per-frame ride transforms, the coaster track math, the particle update at a million
+// particles, the crowd update at 10k and 100k visitors, and the scene BVH's build, refit, culling
+// (against testing every box) and raycast at 10k and 100k objects, and the terrain's height function
+// and chunk generation. Each benchmark is repeated until it has run for --min-time seconds (0.5 by
+// default); the results go to stdout and, with --out, to a JSON file in Google Benchmark's format,
+// so its compare.py can diff two runs.
+//
+// Only needs rides.cpp, particles.cpp, crowd.cpp, workerpool.cpp, bvh.cpp, heightfield.cpp,
+// parkgeometry.cpp, scenebuilder.cpp, mappedfile.cpp and bmpimage.cpp; no GL.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "meshgen.hpp"
+#include "scenebuilder.hpp"
+#include "parkgeometry.hpp"
+#include "mappedfile.hpp"
+#include "bmpimage.hpp"
+#include "rides.hpp"
+#include "particles.hpp"
+#include "crowd.hpp"
+#include "bvh.hpp"
+#include "heightfield.hpp"
+
+//******************************************
+// Harness
+//******************************************
+
+// Keeps the compiler from dropping a result that is never used.
+template <typename T>
+static inline void doNotOptimize(const T & value){
+#if defined(__GNUC__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const void * sink;
+	sink = &value;
+#endif
+}
+
+struct BenchmarkState {
+	long long iterations;
+	int arg;
+	// Per iteration, for the throughput columns. Left at 0 when they don't apply.
+	double bytes;
+	double items;
+	bool skipped;
+	// Set by a benchmark whose batch included one-time setup, so the batch is run again
+	bool setUp;
+};
+
+typedef void (*BenchmarkFunction)(BenchmarkState & state);
+
+struct Benchmark {
+	std::string name;
+	BenchmarkFunction function;
+	int arg;
+};
+
+struct BenchmarkResult {
+	std::string name;
+	long long iterations;
+	double realNs; // per iteration
+	double cpuNs;
+	double bytesPerSecond;
+	double itemsPerSecond;
+};
+
+static double secondsNow(){
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool runBenchmark(const Benchmark & benchmark, double minTime, BenchmarkResult & result){
+	BenchmarkState state;
+	state.arg = benchmark.arg;
+	state.iterations = 1;
+
+	// Grow the iteration count until one batch takes minTime, like Google Benchmark does
+	for (;;) {
+		state.bytes = 0.0;
+		state.items = 0.0;
+		state.skipped = false;
+		state.setUp = false;
+		double start = secondsNow();
+		clock_t cpuStart = clock();
+		benchmark.function(state);
+		double real = secondsNow() - start;
+		double cpu = (double)(clock() - cpuStart) / CLOCKS_PER_SEC;
+		if (state.skipped)
+			return false;
+		if (state.setUp)
+			continue;
+
+		if (real >= minTime || state.iterations >= 1000000000LL) {
+			result.name = benchmark.name;
+			result.iterations = state.iterations;
+			result.realNs = real * 1e9 / state.iterations;
+			result.cpuNs = cpu * 1e9 / state.iterations;
+			result.bytesPerSecond = real > 0.0 ? state.bytes * state.iterations / real : 0.0;
+			result.itemsPerSecond = real > 0.0 ? state.items * state.iterations / real : 0.0;
+			return true;
+		}
+
+		double multiplier = real > 0.0 ? minTime * 1.4 / real : 10.0;
+		if (multiplier > 10.0 || real < minTime / 10.0)
+			multiplier = 10.0;
+		long long next = (long long)(state.iterations * multiplier);
+		state.iterations = next > state.iterations ? next : state.iterations + 1;
+	}
+}
+
+static bool writeResults(const char * path, const char * executable, double minTime,
+	const std::vector<BenchmarkResult> & results){
+	FILE * file = fopen(path, "w");
+	if (file == NULL) {
+		printf("Could not write %s\n", path);
+		return false;
+	}
+
+	char date[64];
+	time_t now = time(NULL);
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+	fprintf(file, "{\n  \"context\": {\n");
+	fprintf(file, "    \"date\": \"%s\",\n", date);
+	fprintf(file, "    \"executable\": \"%s\",\n", executable);
+	fprintf(file, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+	fprintf(file, "    \"min_time\": %g,\n", minTime);
+#ifdef NDEBUG
+	fprintf(file, "    \"library_build_type\": \"release\"\n");
+#else
+	fprintf(file, "    \"library_build_type\": \"debug\"\n");
+#endif
+	fprintf(file, "  },\n  \"benchmarks\": [\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchmarkResult & r = results[i];
+		fprintf(file, "    {\n");
+		fprintf(file, "      \"name\": \"%s\",\n", r.name.c_str());
+		fprintf(file, "      \"run_name\": \"%s\",\n", r.name.c_str());
+		fprintf(file, "      \"run_type\": \"iteration\",\n");
+		fprintf(file, "      \"iterations\": %lld,\n", r.iterations);
+		fprintf(file, "      \"real_time\": %.3f,\n", r.realNs);
+		fprintf(file, "      \"cpu_time\": %.3f,\n", r.cpuNs);
+		if (r.bytesPerSecond > 0.0)
+			fprintf(file, "      \"bytes_per_second\": %.1f,\n", r.bytesPerSecond);
+		if (r.itemsPerSecond > 0.0)
+			fprintf(file, "      \"items_per_second\": %.1f,\n", r.itemsPerSecond);
+		fprintf(file, "      \"time_unit\": \"ns\"\n");
+		fprintf(file, "    }%s\n", i + 1 < results.size() ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+	fclose(file);
+	return true;
+}
+
+//******************************************
+// Geometry generation
+//******************************************
+
+// Radius passed through a volatile so the generators run at runtime instead of being folded.
+static volatile float benchRadius = 1.0f;
+
+template <int Sides>
+static void benchCircle(BenchmarkState & state){
+	for (long long i = 0; i < state.iterations; i++) {
+		auto vertices = meshgen::circleVertices<Sides>(0.0f, 0.0f, 0.0f, benchRadius);
+		doNotOptimize(vertices);
+	}
+	state.items = Sides + 2;
+}
+
+template <int Sides>
+static void benchCylinderSide(BenchmarkState & state){
+	for (long long i = 0; i < state.iterations; i++) {
+		auto vertices = meshgen::cylinderSide<Sides>(benchRadius);
+		doNotOptimize(vertices);
+	}
+	state.items = Sides * 6;
+}
+
+template <int Sides>
+static void benchUmbrella(BenchmarkState & state){
+	for (long long i = 0; i < state.iterations; i++) {
+		auto vertices = meshgen::umbrella<Sides>(1.0f, benchRadius);
+		doNotOptimize(vertices);
+	}
+	state.items = Sides * 3;
+}
+
+// The rail takes no arguments, so it is called through a volatile pointer for the same reason
+template <int Segments>
+static void benchRail(BenchmarkState & state){
+	meshgen::Positions<Segments * 6> (* volatile generate)() = meshgen::railVertices<Segments>;
+	for (long long i = 0; i < state.iterations; i++) {
+		auto vertices = generate();
+		doNotOptimize(vertices);
+	}
+	state.items = Segments * 6;
+}
+
+// Every park mesh into a builder, including the vertex welding; no file is written
+static void benchBuildParkScene(BenchmarkState & state){
+	for (long long i = 0; i < state.iterations; i++) {
+		SceneBuilder builder;
+		buildParkScene(builder);
+		doNotOptimize(builder);
+	}
+}
+
+//******************************************
+// Texture decode
+//******************************************
+
+static const char * bmpPaths[] = { "uvtemplate.bmp", "wood.bmp", "yellow.bmp", "bluestrip.bmp" };
+
+// What loadBMP_custom does before it reaches GL: read the header, then the pixels into a heap copy
+static void benchBMPRead(BenchmarkState & state){
+	const char * path = bmpPaths[state.arg];
+	size_t fileSize = 0;
+	for (long long i = 0; i < state.iterations; i++) {
+		FILE * file = fopen(path, "rb");
+		if (file == NULL) {
+			state.skipped = true;
+			return;
+		}
+		unsigned char header[54];
+		if (fread(header, 1, 54, file) != 54) {
+			fclose(file);
+			state.skipped = true;
+			return;
+		}
+		unsigned int dataPos = *(unsigned int *)&header[0x0A];
+		unsigned int width = *(unsigned int *)&header[0x12];
+		unsigned int height = *(unsigned int *)&header[0x16];
+		unsigned int imageSize = width * height * 3;
+		if (dataPos == 0) dataPos = 54;
+		fseek(file, dataPos, SEEK_SET);
+		unsigned char * data = new unsigned char[imageSize];
+		size_t read = fread(data, 1, imageSize, file);
+		fclose(file);
+		doNotOptimize(data[read / 2]);
+		delete[] data;
+		fileSize = dataPos + imageSize;
+	}
+	state.bytes = (double)fileSize;
+}
+
+// What the texture streamer does before it reaches GL, minus the RGBA conversion
+static void benchBMPMap(BenchmarkState & state){
+	const char * path = bmpPaths[state.arg];
+	size_t fileSize = 0;
+	for (long long i = 0; i < state.iterations; i++) {
+		MappedFile file;
+		BMPImage image;
+		if (!mapFile(path, file) || !parseBMP(file.data, file.size, image)) {
+			unmapFile(file);
+			state.skipped = true;
+			return;
+		}
+		// Touch every page, the driver would read them all during the upload
+		unsigned int sum = 0;
+		for (size_t offset = 0; offset < file.size; offset += 4096)
+			sum += file.data[offset];
+		doNotOptimize(sum);
+		fileSize = file.size;
+		unmapFile(file);
+	}
+	state.bytes = (double)fileSize;
+}
+
+// The BGR -> RGBA expansion top-down files and the streamer's fallback go through
+static void benchBMPConvert(BenchmarkState & state){
+	MappedFile file;
+	BMPImage image;
+	if (!mapFile(bmpPaths[state.arg], file) || !parseBMP(file.data, file.size, image)) {
+		unmapFile(file);
+		state.skipped = true;
+		return;
+	}
+	std::vector<unsigned char> rgba((size_t)image.width * image.height * 4);
+	for (long long i = 0; i < state.iterations; i++) {
+		convertBMPToRGBA(image, &rgba[0]);
+		doNotOptimize(rgba[0]);
+	}
+	state.bytes = (double)rgba.size();
+	unmapFile(file);
+}
+
+//******************************************
+// Ride transforms
+//******************************************
+
+static const float frameTime = 1.0f / 60.0f;
+
+static void benchViking(BenchmarkState & state){
+	VikingRide ride;
+	initViking(ride);
+	for (long long i = 0; i < state.iterations; i++) {
+		updateViking(ride, frameTime);
+		doNotOptimize(ride.models);
+	}
+	state.items = VIKING_PART_COUNT;
+}
+
+static void benchMerryGoRound(BenchmarkState & state){
+	MerryGoRoundRide ride;
+	initMerryGoRound(ride);
+	for (long long i = 0; i < state.iterations; i++) {
+		updateMerryGoRound(ride, frameTime);
+		doNotOptimize(ride.models);
+	}
+	state.items = MGR_PART_COUNT;
+}
+
+static void benchRollerCoaster(BenchmarkState & state){
+	RollerCoasterRide ride;
+	initRollerCoaster(ride);
+	for (long long i = 0; i < state.iterations; i++) {
+		updateRollerCoaster(ride, frameTime);
+		doNotOptimize(ride.models);
+	}
+	state.items = COASTER_PART_COUNT;
+}
+
+// All three updates plus the view-projection multiply for every model, as one frame does
+static void benchRideFrame(BenchmarkState & state){
+	VikingRide viking;
+	MerryGoRoundRide merryGoRound;
+	RollerCoasterRide rollerCoaster;
+	initViking(viking);
+	initMerryGoRound(merryGoRound);
+	initRollerCoaster(rollerCoaster);
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 15.0f, 30.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 mvps[VIKING_PART_COUNT + MGR_PART_COUNT + COASTER_PART_COUNT];
+	for (long long i = 0; i < state.iterations; i++) {
+		updateViking(viking, frameTime);
+		updateMerryGoRound(merryGoRound, frameTime);
+		updateRollerCoaster(rollerCoaster, frameTime);
+		glm::mat4 viewProjection = projection * view;
+		int n = 0;
+		for (int j = 0; j < VIKING_PART_COUNT; j++)
+			mvps[n++] = viewProjection * viking.models[j];
+		for (int j = 0; j < MGR_PART_COUNT; j++)
+			mvps[n++] = viewProjection * merryGoRound.models[j];
+		for (int j = 0; j < COASTER_PART_COUNT; j++)
+			mvps[n++] = viewProjection * rollerCoaster.models[j];
+		doNotOptimize(mvps);
+	}
+	state.items = VIKING_PART_COUNT + MGR_PART_COUNT + COASTER_PART_COUNT;
+}
+
+//******************************************
+// Coaster track
+//******************************************
+
+#define TRACK_SAMPLES 1024
+
+static void benchCoasterHeight(BenchmarkState & state){
+	float angles[TRACK_SAMPLES];
+	for (int j = 0; j < TRACK_SAMPLES; j++)
+		angles[j] = 0.001f + j * (2.0f * 3.141592f / TRACK_SAMPLES);
+	for (long long i = 0; i < state.iterations; i++) {
+		float sum = 0.0f;
+		for (int j = 0; j < TRACK_SAMPLES; j++)
+			sum += coasterTrackHeight(angles[j]);
+		doNotOptimize(sum);
+	}
+	state.items = TRACK_SAMPLES;
+}
+
+// Height and pitch of one car per call, the slope probe included
+static void benchCoasterCar(BenchmarkState & state){
+	CoasterCar car;
+	car.angle = 2.0 * 3.141592f;
+	car.height = 0.0f;
+	car.lastY = 0.0f;
+	car.pitch = 0.0f;
+	for (long long i = 0; i < state.iterations; i++) {
+		advanceCoasterCar(car, frameTime);
+		doNotOptimize(car);
+	}
+	state.items = 1;
+}
+
+//******************************************
+// Particles
+//******************************************
+
+#define BENCH_PARTICLES 1000000
+
+// Every hardware thread, shared by the benchmarks that run on a pool
+static WorkerPool & benchWorkers(){
+	static WorkerPool workers;
+	if (workers.threadCount() == 1 && defaultWorkerCount() > 0)
+		workers.start(defaultWorkerCount());
+	return workers;
+}
+
+// The SIMD kernel alone on one thread, over particles that never die
+static void benchParticleSimulate(BenchmarkState & state){
+	static ParticlePool pool;
+	static std::vector<uint32_t> dead(PARTICLE_CHUNK);
+	if (pool.capacity == 0) {
+		pool.capacity = pool.count = BENCH_PARTICLES;
+		std::vector<float> * floats[] = { &pool.x, &pool.y, &pool.z, &pool.vx, &pool.vy, &pool.vz, &pool.age, &pool.size };
+		for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); i++)
+			floats[i]->assign(BENCH_PARTICLES, 1.0f);
+		pool.life.assign(BENCH_PARTICLES, 1e30f);
+		pool.drag.assign(BENCH_PARTICLES, 0.5f);
+		state.setUp = true;
+	}
+	for (long long i = 0; i < state.iterations; i++) {
+		for (size_t begin = 0; begin < pool.count; begin += PARTICLE_CHUNK)
+			doNotOptimize(simulateParticles(pool, begin, std::min(pool.count, begin + (size_t)PARTICLE_CHUNK), frameTime, 0.0f, &dead[0]));
+	}
+	state.items = BENCH_PARTICLES;
+	state.bytes = BENCH_PARTICLES * 9.0 * sizeof(float);
+}
+
+// A whole frame of the park's effects (emit, simulate on every hardware thread, compact),
+// after warming up until the pool is about full
+static void benchParticleUpdate(BenchmarkState & state){
+	static ParticleSystem particles;
+	if (particles.capacity() == 0) {
+		particles.init(BENCH_PARTICLES, &benchWorkers(), -3.0f);
+		particles.addFireworks(glm::vec3(-2.0f, 3.0f, 2.0f));
+		particles.addFireworks(glm::vec3(6.0f, 3.0f, 6.0f));
+		particles.addFireworks(glm::vec3(4.0f, 6.0f, 4.0f));
+		particles.addFountain(glm::vec3(-8.0f, -3.0f, 10.0f));
+		particles.addConfetti(glm::vec3(14.0f, -3.0f, 4.0f));
+		for (int i = 0; i < 600; i++)
+			particles.update(frameTime);
+		state.setUp = true;
+	}
+	for (long long i = 0; i < state.iterations; i++)
+		particles.update(frameTime);
+	state.items = (double)particles.liveCount();
+}
+
+//******************************************
+// Crowd
+//******************************************
+
+// One frame of visitors walking between the three rides' queues (grid build and steering on
+// every hardware thread), after a few seconds of walking so queues have formed
+template <int Count>
+static void benchCrowdUpdate(BenchmarkState & state){
+	static Crowd crowd;
+	if (crowd.size() == 0) {
+		std::vector<CrowdDestination> destinations(3);
+		destinations[0].position = glm::vec2(-2.0f, 7.0f);
+		destinations[1].position = glm::vec2(6.0f, 11.5f);
+		destinations[2].position = glm::vec2(16.0f, 7.5f);
+		std::vector<CrowdObstacle> obstacles(2);
+		obstacles[0].center = glm::vec2(-2.0f, 2.0f);
+		obstacles[0].radius = 2.8f;
+		obstacles[1].center = glm::vec2(6.0f, 6.0f);
+		obstacles[1].radius = 3.3f;
+		crowd.init(Count, &benchWorkers(), destinations, obstacles);
+		for (int i = 0; i < 180; i++)
+			crowd.update(frameTime);
+		state.setUp = true;
+	}
+	for (long long i = 0; i < state.iterations; i++)
+		crowd.update(frameTime);
+	state.items = Count;
+}
+
+//******************************************
+// Bounding volume hierarchy
+//******************************************
+
+// A park of Count / 10 rides on a square grid RIDE_GRID_SPACING apart, each ten part boxes of
+// different sizes around its pivot; every tenth part swings, as the moving ones do
+struct BenchPark {
+	std::vector<Aabb> bounds;
+	std::vector<uint32_t> moving;
+	Bvh bvh;
+	glm::vec4 planes[6];
+};
+
+template <int Count>
+static BenchPark & benchPark(){
+	static BenchPark park;
+	if (park.bounds.empty()) {
+		int rides = Count / 10;
+		int side = 1;
+		while (side * side < rides)
+			side++;
+		srand(1);
+		for (int ride = 0; ride < rides; ride++) {
+			glm::vec3 pivot((ride % side) * 10.0f, 0.0f, (ride / side) * 10.0f);
+			for (int part = 0; part < 10; part++) {
+				glm::vec3 center = pivot + glm::vec3(rand() % 600 / 100.0f - 3.0f, rand() % 500 / 100.0f - 2.0f,
+					rand() % 600 / 100.0f - 3.0f);
+				glm::vec3 extent(0.2f + rand() % 100 / 100.0f, 0.2f + rand() % 100 / 100.0f, 0.2f + rand() % 100 / 100.0f);
+				Aabb box = { center - extent, center + extent };
+				if (part == 0)
+					park.moving.push_back((uint32_t)park.bounds.size());
+				park.bounds.push_back(box);
+			}
+		}
+		park.bvh.build(&park.bounds[0], park.bounds.size());
+		// From one corner looking across the park, as the overview camera does
+		float extent = side * 10.0f;
+		glm::mat4 view = glm::lookAt(glm::vec3(-10.0f, 15.0f, -10.0f), glm::vec3(extent * 0.3f, 0.0f, extent * 0.3f),
+			glm::vec3(0.0f, 1.0f, 0.0f));
+		frustumPlanes(glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f) * view, park.planes);
+	}
+	return park;
+}
+
+template <int Count>
+static void benchBvhBuild(BenchmarkState & state){
+	BenchPark & park = benchPark<Count>();
+	Bvh bvh;
+	for (long long i = 0; i < state.iterations; i++) {
+		bvh.build(&park.bounds[0], park.bounds.size());
+		doNotOptimize(bvh.nodeCount());
+	}
+	state.items = Count;
+}
+
+// The moving tenth shifts back and forth
+template <int Count>
+static void benchBvhRefit(BenchmarkState & state){
+	BenchPark & park = benchPark<Count>();
+	std::vector<Aabb> bounds = park.bounds;
+	Bvh bvh;
+	bvh.build(&bounds[0], bounds.size());
+	for (long long i = 0; i < state.iterations; i++) {
+		glm::vec3 offset((i & 1) ? 0.5f : -0.5f, 0.0f, 0.0f);
+		for (size_t j = 0; j < park.moving.size(); j++) {
+			bounds[park.moving[j]].min += offset;
+			bounds[park.moving[j]].max += offset;
+		}
+		bvh.refit(&bounds[0], &park.moving[0], park.moving.size());
+	}
+	state.items = (double)park.moving.size();
+}
+
+template <int Count>
+static void benchBvhCull(BenchmarkState & state){
+	BenchPark & park = benchPark<Count>();
+	std::vector<uint32_t> visible;
+	for (long long i = 0; i < state.iterations; i++) {
+		visible.clear();
+		park.bvh.cull(park.planes, visible);
+		doNotOptimize(visible.size());
+	}
+	state.items = Count;
+}
+
+// What culling costs without the tree: every box against the planes
+template <int Count>
+static void benchLinearCull(BenchmarkState & state){
+	BenchPark & park = benchPark<Count>();
+	std::vector<uint32_t> visible;
+	for (long long i = 0; i < state.iterations; i++) {
+		visible.clear();
+		for (size_t j = 0; j < park.bounds.size(); j++) {
+			const Aabb & box = park.bounds[j];
+			bool inside = true;
+			for (int p = 0; p < 6 && inside; p++) {
+				const glm::vec4 & plane = park.planes[p];
+				glm::vec3 corner(plane.x >= 0.0f ? box.max.x : box.min.x, plane.y >= 0.0f ? box.max.y : box.min.y,
+					plane.z >= 0.0f ? box.max.z : box.min.z);
+				inside = plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w >= 0.0f;
+			}
+			if (inside)
+				visible.push_back((uint32_t)j);
+		}
+		doNotOptimize(visible.size());
+	}
+	state.items = Count;
+}
+
+// Rays from above the park down into random spots on it, boxes as the precise test
+template <int Count>
+static void benchBvhRaycast(BenchmarkState & state){
+	BenchPark & park = benchPark<Count>();
+	float extent = sqrtf(Count / 10.0f) * 10.0f;
+	float distance;
+	srand(2);
+	for (long long i = 0; i < state.iterations; i++) {
+		glm::vec3 target(rand() % 1000 / 1000.0f * extent, 0.0f, rand() % 1000 / 1000.0f * extent);
+		glm::vec3 origin = target + glm::vec3(-20.0f, 30.0f, -20.0f);
+		int hit = park.bvh.raycast(origin, glm::normalize(target - origin), 1000.0f, BvhRayTest(), distance);
+		doNotOptimize(hit);
+	}
+	state.items = 1;
+}
+
+//******************************************
+// Terrain
+//******************************************
+
+// Samples across the plaza, the coaster's ridge and the hills beyond
+static void benchTerrainHeight(BenchmarkState & state){
+	float sum = 0.0f;
+	for (long long i = 0; i < state.iterations; i++) {
+		float x = (float)(i % 256) - 124.0f, z = (float)(i / 256 % 256) - 124.0f;
+		sum += terrainHeight(x, z);
+	}
+	doNotOptimize(sum);
+	state.items = 1;
+}
+
+// One chunk as a generator thread builds it; Level sets its size and so where it samples
+template <int Level>
+static void benchTerrainChunk(BenchmarkState & state){
+	std::vector<TerrainVertex> vertices(TERRAIN_CHUNK_VERTICES);
+	float size = 8.0f * (1 << Level), minY, maxY;
+	for (long long i = 0; i < state.iterations; i++) {
+		generateTerrainChunk(-size * (float)(i % 8), 20.0f, size, &vertices[0], minY, maxY);
+		doNotOptimize(vertices);
+	}
+	state.items = TERRAIN_CHUNK_VERTICES;
+	state.bytes = TERRAIN_CHUNK_VERTICES * sizeof(TerrainVertex);
+}
+
+//******************************************
+// main
+//******************************************
+
+static void addBenchmark(std::vector<Benchmark> & benchmarks, const std::string & name, BenchmarkFunction function, int arg = 0){
+	Benchmark benchmark;
+	benchmark.name = name;
+	benchmark.function = function;
+	benchmark.arg = arg;
+	benchmarks.push_back(benchmark);
+}
+
+int main(int argc, char ** argv){
+	const char * filter = NULL;
+	const char * outputPath = NULL;
+	double minTime = 0.5;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+			filter = argv[++i];
+		else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+			minTime = atof(argv[++i]);
+		else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			outputPath = argv[++i];
+		else {
+			fprintf(stderr, "usage: %s [--filter text] [--min-time seconds] [--out results.json]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	std::vector<Benchmark> benchmarks;
+	addBenchmark(benchmarks, "meshgen/circle/12", benchCircle<12>);
+	addBenchmark(benchmarks, "meshgen/circle/36", benchCircle<36>);
+	addBenchmark(benchmarks, "meshgen/circle/144", benchCircle<144>);
+	addBenchmark(benchmarks, "meshgen/cylinderSide/12", benchCylinderSide<12>);
+	addBenchmark(benchmarks, "meshgen/cylinderSide/36", benchCylinderSide<36>);
+	addBenchmark(benchmarks, "meshgen/cylinderSide/144", benchCylinderSide<144>);
+	addBenchmark(benchmarks, "meshgen/umbrella/8", benchUmbrella<8>);
+	addBenchmark(benchmarks, "meshgen/umbrella/36", benchUmbrella<36>);
+	addBenchmark(benchmarks, "meshgen/umbrella/144", benchUmbrella<144>);
+	addBenchmark(benchmarks, "meshgen/rail/37", benchRail<37>);
+	addBenchmark(benchmarks, "meshgen/rail/148", benchRail<148>);
+	addBenchmark(benchmarks, "scene/buildParkScene", benchBuildParkScene);
+	for (int i = 0; i < (int)(sizeof(bmpPaths) / sizeof(bmpPaths[0])); i++) {
+		addBenchmark(benchmarks, std::string("bmp/read/") + bmpPaths[i], benchBMPRead, i);
+		addBenchmark(benchmarks, std::string("bmp/map/") + bmpPaths[i], benchBMPMap, i);
+		addBenchmark(benchmarks, std::string("bmp/convertRGBA/") + bmpPaths[i], benchBMPConvert, i);
+	}
+	addBenchmark(benchmarks, "rides/viking", benchViking);
+	addBenchmark(benchmarks, "rides/merryGoRound", benchMerryGoRound);
+	addBenchmark(benchmarks, "rides/rollerCoaster", benchRollerCoaster);
+	addBenchmark(benchmarks, "rides/frame", benchRideFrame);
+	addBenchmark(benchmarks, "coaster/trackHeight", benchCoasterHeight);
+	addBenchmark(benchmarks, "coaster/car", benchCoasterCar);
+	addBenchmark(benchmarks, "particles/simulate/1M", benchParticleSimulate);
+	addBenchmark(benchmarks, "particles/update/1M", benchParticleUpdate);
+	addBenchmark(benchmarks, "crowd/update/10k", benchCrowdUpdate<10000>);
+	addBenchmark(benchmarks, "crowd/update/100k", benchCrowdUpdate<100000>);
+	addBenchmark(benchmarks, "bvh/build/10k", benchBvhBuild<10000>);
+	addBenchmark(benchmarks, "bvh/build/100k", benchBvhBuild<100000>);
+	addBenchmark(benchmarks, "bvh/refit/10k", benchBvhRefit<10000>);
+	addBenchmark(benchmarks, "bvh/refit/100k", benchBvhRefit<100000>);
+	addBenchmark(benchmarks, "bvh/cull/10k", benchBvhCull<10000>);
+	addBenchmark(benchmarks, "bvh/cull/100k", benchBvhCull<100000>);
+	addBenchmark(benchmarks, "linear/cull/10k", benchLinearCull<10000>);
+	addBenchmark(benchmarks, "linear/cull/100k", benchLinearCull<100000>);
+	addBenchmark(benchmarks, "bvh/raycast/10k", benchBvhRaycast<10000>);
+	addBenchmark(benchmarks, "bvh/raycast/100k", benchBvhRaycast<100000>);
+	addBenchmark(benchmarks, "terrain/height", benchTerrainHeight);
+	addBenchmark(benchmarks, "terrain/chunk/0", benchTerrainChunk<0>);
+	addBenchmark(benchmarks, "terrain/chunk/4", benchTerrainChunk<4>);
+
+	std::vector<BenchmarkResult> results;
+	printf("%-36s %14s %14s %14s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations");
+	for (size_t i = 0; i < benchmarks.size(); i++) {
+		if (filter != NULL && strstr(benchmarks[i].name.c_str(), filter) == NULL)
+			continue;
+		BenchmarkResult result;
+		if (!runBenchmark(benchmarks[i], minTime, result)) {
+			printf("%-36s skipped (missing input)\n", benchmarks[i].name.c_str());
+			continue;
+		}
+		printf("%-36s %14.1f %14.1f %14lld", result.name.c_str(), result.realNs, result.cpuNs, result.iterations);
+		if (result.bytesPerSecond > 0.0)
+			printf("  %.1f MB/s", result.bytesPerSecond / (1024.0 * 1024.0));
+		if (result.itemsPerSecond > 0.0)
+			printf("  %.2f M items/s", result.itemsPerSecond / 1e6);
+		printf("\n");
+		results.push_back(result);
+	}
+
+	if (outputPath != NULL && !writeResults(outputPath, argv[0], minTime, results))
+		return 1;
+	return 0;
+}
@@ -0,0 +1,63 @@
+#include <GL/glew.h>
+
+#include "overdraw.hpp"
+
+OverdrawMeter::OverdrawMeter()
+	: current(-1), dropped(0){
+}
+
+OverdrawMeter::~OverdrawMeter(){
+	shutdown();
+}
+
+void OverdrawMeter::init(int frameLatency){
+	ring.resize(frameLatency + 1);
+	for (size_t i = 0; i < ring.size(); i++) {
+		glGenQueries(1, &ring[i].query);
+		ring[i].pending = false;
+		ring[i].screenSamples = 0;
+	}
+	current = -1;
+}
+
+void OverdrawMeter::shutdown(){
+	for (size_t i = 0; i < ring.size(); i++)
+		glDeleteQueries(1, &ring[i].query);
+	ring.clear();
+	current = -1;
+}
+
+void OverdrawMeter::begin(size_t screenSamples){
+	if (ring.empty())
+		return;
+	current = (current + 1) % (int)ring.size();
+	Measurement & measurement = ring[current];
+	// Not collected in time (end() reads the slot after this one); the query is reused anyway
+	if (measurement.pending) {
+		measurement.pending = false;
+		dropped++;
+	}
+	measurement.screenSamples = screenSamples;
+	glBeginQuery(GL_SAMPLES_PASSED, measurement.query);
+}
+
+void OverdrawMeter::end(FrameStats & stats){
+	if (ring.empty() || current < 0)
+		return;
+	glEndQuery(GL_SAMPLES_PASSED);
+	ring[current].pending = true;
+
+	// The slot begin() reuses next frame is the oldest one
+	Measurement & oldest = ring[(current + 1) % ring.size()];
+	if (!oldest.pending)
+		return;
+	GLint available = 0;
+	glGetQueryObjectiv(oldest.query, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return;
+	GLuint64 samples = 0;
+	glGetQueryObjectui64v(oldest.query, GL_QUERY_RESULT, &samples);
+	stats.shadedSamples += (size_t)samples;
+	stats.screenSamples += oldest.screenSamples;
+	oldest.pending = false;
+}
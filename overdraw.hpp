@@ -0,0 +1,43 @@
+#ifndef OVERDRAW_HPP
+#define OVERDRAW_HPP
+
+#include <stddef.h>
+#include <vector>
+
+#include "renderstats.hpp"
+
+// Counts the samples that pass the depth test in one pass per frame (a GL_SAMPLES_PASSED query),
+// i.e. the fragments that get shaded. Divided by the samples on screen that is the overdraw:
+// 1.0 means every sample was shaded once.
+//
+// Like the profiler, queries go into a ring and are read back frameLatency frames later; a
+// result that isn't ready by then is dropped rather than waited for.
+class OverdrawMeter {
+public:
+	OverdrawMeter();
+	~OverdrawMeter();
+
+	// Needs a current GL context.
+	void init(int frameLatency = 4);
+	void shutdown();
+
+	// Wrap the measured pass. screenSamples is width * height * samples of the target.
+	void begin(size_t screenSamples);
+	// Ends the query and adds the oldest finished measurement to stats (shadedSamples and
+	// screenSamples), if there is one.
+	void end(FrameStats & stats);
+
+	int droppedFrames() const { return dropped; }
+
+private:
+	struct Measurement {
+		GLuint query;
+		bool pending;
+		size_t screenSamples;
+	};
+	std::vector<Measurement> ring;
+	int current;
+	int dropped;
+};
+
+#endif
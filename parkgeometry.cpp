@@ -0,0 +1,166 @@
+#include <stddef.h>
+
+#include <GL/glew.h>
+
+#include "meshgen.hpp"
+#include "scenebuilder.hpp"
+#include "parkgeometry.hpp"
+
+// 1. cube 모양 vertex data
+static const GLfloat g_vertex_buffer_data[] = {
+	-1.0f,-1.0f,-1.0f,
+	-1.0f,-1.0f, 1.0f,
+	-1.0f, 1.0f, 1.0f,
+	1.0f, 1.0f,-1.0f,
+	-1.0f,-1.0f,-1.0f,
+	-1.0f, 1.0f,-1.0f,
+	1.0f,-1.0f, 1.0f,
+	-1.0f,-1.0f,-1.0f,
+	1.0f,-1.0f,-1.0f,
+	1.0f, 1.0f,-1.0f,
+	1.0f,-1.0f,-1.0f,
+	-1.0f,-1.0f,-1.0f,
+	-1.0f,-1.0f,-1.0f,
+	-1.0f, 1.0f, 1.0f,
+	-1.0f, 1.0f,-1.0f,
+	1.0f,-1.0f, 1.0f,
+	-1.0f,-1.0f, 1.0f,
+	-1.0f,-1.0f,-1.0f,
+	-1.0f, 1.0f, 1.0f,
+	-1.0f,-1.0f, 1.0f,
+	1.0f,-1.0f, 1.0f,
+	1.0f, 1.0f, 1.0f,
+	1.0f,-1.0f,-1.0f,
+	1.0f, 1.0f,-1.0f,
+	1.0f,-1.0f,-1.0f,
+	1.0f, 1.0f, 1.0f,
+	1.0f,-1.0f, 1.0f,
+	1.0f, 1.0f, 1.0f,
+	1.0f, 1.0f,-1.0f,
+	-1.0f, 1.0f,-1.0f,
+	1.0f, 1.0f, 1.0f,
+	-1.0f, 1.0f,-1.0f,
+	-1.0f, 1.0f, 1.0f,
+	1.0f, 1.0f, 1.0f,
+	-1.0f, 1.0f, 1.0f,
+	1.0f,-1.0f, 1.0f
+};
+
+// 2. Rectangle Vertex Data
+static const GLfloat g_rect_vertex_data[] = {
+	-1.0f, 0.0f, -1.0f,
+	-1.0f, 0.0f, 1.0f,
+	1.0f, 0.0f, 1.0f,
+	1.0f, 0.0f, 1.0f,
+	1.0f, 0.0f, -1.0f,
+	-1.0f, 0.0f, -1.0f
+};
+
+// 3. Rectangle UV Data
+static const GLfloat g_rect_uv_data[] = {
+	0.0f, 0.0f,
+	0.0f, 1.0f,
+	1.0f, 1.0f,
+	1.0f, 1.0f,
+	1.0f, 0.0f,
+	0.0f, 0.0f
+};
+
+//4. cube에 대한 texture uv 좌표 계산
+static const GLfloat g_uv_buffer_data[] = {
+	0.000059f, 1.0f - 0.000004f,
+	0.000103f, 1.0f - 0.336048f,
+	0.335973f, 1.0f - 0.335903f,
+	1.000023f, 1.0f - 0.000013f,
+	0.667979f, 1.0f - 0.335851f,
+	0.999958f, 1.0f - 0.336064f,
+	0.667979f, 1.0f - 0.335851f,
+	0.336024f, 1.0f - 0.671877f,
+	0.667969f, 1.0f - 0.671889f,
+	1.000023f, 1.0f - 0.000013f,
+	0.668104f, 1.0f - 0.000013f,
+	0.667979f, 1.0f - 0.335851f,
+	0.000059f, 1.0f - 0.000004f,
+	0.335973f, 1.0f - 0.335903f,
+	0.336098f, 1.0f - 0.000071f,
+	0.667979f, 1.0f - 0.335851f,
+	0.335973f, 1.0f - 0.335903f,
+	0.336024f, 1.0f - 0.671877f,
+	1.000004f, 1.0f - 0.671847f,
+	0.999958f, 1.0f - 0.336064f,
+	0.667979f, 1.0f - 0.335851f,
+	0.668104f, 1.0f - 0.000013f,
+	0.335973f, 1.0f - 0.335903f,
+	0.667979f, 1.0f - 0.335851f,
+	0.335973f, 1.0f - 0.335903f,
+	0.668104f, 1.0f - 0.000013f,
+	0.336098f, 1.0f - 0.000071f,
+	0.000103f, 1.0f - 0.336048f,
+	0.000004f, 1.0f - 0.671870f,
+	0.336024f, 1.0f - 0.671877f,
+	0.000103f, 1.0f - 0.336048f,
+	0.336024f, 1.0f - 0.671877f,
+	0.335973f, 1.0f - 0.335903f,
+	0.667969f, 1.0f - 0.671889f,
+	1.000004f, 1.0f - 0.671847f,
+	0.667979f, 1.0f - 0.335851f
+};
+
+// 회전목마 원기둥 / 우산 등분 개수, 롤러코스터 rail 구간 개수
+static constexpr int numOfSides = 36;
+static constexpr int umbrellaOfSides = 8;
+static constexpr int railSegments = 37;
+static constexpr float radius = 1.0f;
+
+// 놀이기구 mesh 는 모두 compile time 에 만들어진다. vertex 개수는 배열 type 에 들어 있다.
+static constexpr auto circleVertices = meshgen::circleVertices<numOfSides>(0.0f, 0.0f, 0.0f, radius);
+static constexpr auto circleColors = meshgen::solidColor<decltype(circleVertices)::vertexCount>(1.0f, 1.0f, 0.0f);
+static constexpr auto circleUVs = meshgen::circleUVs<numOfSides>();
+
+static constexpr auto sideVertices = meshgen::cylinderSide<numOfSides>(radius);
+static constexpr auto sideColors = meshgen::solidColor<decltype(sideVertices)::vertexCount>(1.0f, 1.0f, 0.0f);
+static constexpr auto sideUVs = meshgen::cylinderUVs<numOfSides>();
+
+static constexpr auto umbrellaVertices = meshgen::umbrella<umbrellaOfSides>(1.0f, radius);
+static constexpr auto umbrellaColors = meshgen::solidColor<decltype(umbrellaVertices)::vertexCount>(0.0f, 1.0f, 0.0f);
+static constexpr auto umbrellaUVs = meshgen::umbrellaUVs<umbrellaOfSides>();
+
+static constexpr auto railVertices = meshgen::railVertices<railSegments>();
+static constexpr auto railColors = meshgen::solidColor<decltype(railVertices)::vertexCount>(1.0f, 1.0f, 0.0f);
+
+// attribute 배열끼리 vertex 개수가 다르면 compile 되지 않는다.
+template <size_t N>
+static void addParkMesh(SceneBuilder &builder, const char *name, GLenum mode, const meshgen::Positions<N> &positions,
+	const meshgen::Colors<N> *colors, const meshgen::UVs<N> *uvs, bool doubleSided = false)
+{
+	builder.addMesh(name, mode, positions.data(), colors != NULL ? colors->data() : NULL,
+		uvs != NULL ? uvs->data() : NULL, (int)N, doubleSided);
+}
+
+// 놀이기구 mesh 를 builder 에 넣기
+void buildParkScene(SceneBuilder &builder)
+{
+	// cube, 바닥은 위의 table 그대로 사용
+	const int cubeVertexCount = sizeof(g_vertex_buffer_data) / (3 * sizeof(GLfloat));
+	const int floorVertexCount = sizeof(g_rect_vertex_data) / (3 * sizeof(GLfloat));
+	static_assert(sizeof(g_uv_buffer_data) == cubeVertexCount * 2 * sizeof(GLfloat), "cube uv count");
+	static_assert(sizeof(g_rect_uv_data) == floorVertexCount * 2 * sizeof(GLfloat), "floor uv count");
+	builder.addMesh("cube", GL_TRIANGLES, g_vertex_buffer_data, NULL, g_uv_buffer_data, cubeVertexCount);
+	builder.addMesh("floor", GL_TRIANGLES, g_rect_vertex_data, NULL, g_rect_uv_data, floorVertexCount);
+
+	// 회전목마 원(triangle fan), 원기둥 사이드, 우산 윗모양
+	// 우산은 아래에서도 보이므로 양면으로 bake 한다. 나머지는 culling 되는 뒷면이 안 보이는 mesh 이다.
+	addParkMesh(builder, "circle", GL_TRIANGLE_FAN, circleVertices, &circleColors, &circleUVs);
+	addParkMesh(builder, "cylinderSide", GL_TRIANGLES, sideVertices, &sideColors, &sideUVs);
+	addParkMesh(builder, "umbrella", GL_TRIANGLES, umbrellaVertices, &umbrellaColors, &umbrellaUVs, true);
+
+	// 롤러코스터 rail, 얇은 띠라서 양면
+	addParkMesh<decltype(railVertices)::vertexCount>(builder, "rail", GL_TRIANGLES, railVertices, &railColors, NULL, true);
+}
+
+bool bakeParkScene(const char *path)
+{
+	SceneBuilder builder;
+	buildParkScene(builder);
+	return builder.write(path, PARK_SCENE_REVISION);
+}
@@ -0,0 +1,16 @@
+#ifndef PARKGEOMETRY_HPP
+#define PARKGEOMETRY_HPP
+
+class SceneBuilder;
+
+// 놀이공원 geometry 를 bake 한 scene 파일 경로
+#define PARK_SCENE_PATH "park.scene"
+// parkgeometry.cpp 의 mesh 나 meshgen.hpp 의 생성 함수를 바꾸면 올려야 한다. 이전 revision 으로 bake 한 scene 파일은 다시 bake 된다.
+#define PARK_SCENE_REVISION 3
+
+// 모든 놀이기구 mesh (cube, floor, circle, cylinderSide, umbrella, rail) 를 builder 에 넣는 함수
+void buildParkScene(SceneBuilder &builder);
+// buildParkScene 결과를 path 에 scene 파일로 쓰는 함수
+bool bakeParkScene(const char *path);
+
+#endif
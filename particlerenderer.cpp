@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "shadercache.hpp"
+#include "particlerenderer.hpp"
+
+#define PARTICLE_SPRITE_SIZE 32
+
+// Premultiplied RGBA of one sprite texel, u and v in [-1, 1] across the sprite
+static void spriteTexel(ParticleSprite sprite, float u, float v, unsigned char * texel){
+	float distance = sqrtf(u * u + v * v);
+	float r, g, b, a;
+	if (sprite == PARTICLE_SPRITE_SPARK) {
+		// Bright core with a wide glow
+		float glow = distance < 1.0f ? (1.0f - distance) * (1.0f - distance) : 0.0f;
+		float core = distance < 0.25f ? 1.0f - distance * 4.0f : 0.0f;
+		r = g = b = glow + core < 1.0f ? glow + core : 1.0f;
+		a = r;
+	} else if (sprite == PARTICLE_SPRITE_DROPLET) {
+		// Round drop with a soft edge and a highlight up and to the left
+		a = distance < 0.7f ? 1.0f : distance < 1.0f ? (1.0f - distance) / 0.3f : 0.0f;
+		float highlight = sqrtf((u + 0.3f) * (u + 0.3f) + (v - 0.3f) * (v - 0.3f));
+		r = g = b = a * (highlight < 0.3f ? 1.0f : 0.7f);
+	} else {
+		// Paper square, darker along one diagonal as if it were bent
+		float edge = fabsf(u) > fabsf(v) ? fabsf(u) : fabsf(v);
+		a = edge < 0.8f ? 1.0f : edge < 0.9f ? (0.9f - edge) / 0.1f : 0.0f;
+		r = g = b = a * (u + v > 0.0f ? 1.0f : 0.75f);
+	}
+	texel[0] = (unsigned char)(r * 255.0f + 0.5f);
+	texel[1] = (unsigned char)(g * 255.0f + 0.5f);
+	texel[2] = (unsigned char)(b * 255.0f + 0.5f);
+	texel[3] = (unsigned char)(a * 255.0f + 0.5f);
+}
+
+ParticleRenderer::ParticleRenderer()
+	: viewProjectionLocation(-1), cameraRightLocation(-1), cameraUpLocation(-1){
+}
+
+ParticleRenderer::~ParticleRenderer(){
+	shutdown();
+}
+
+bool ParticleRenderer::init(size_t capacity){
+	program.adopt(LoadShadersCached("ParticleVertexShader.vertexshader", "ParticleFragmentShader.fragmentshader"),
+		"particles", "particle program");
+	if (program == 0) {
+		printf("Particle shaders failed to build\n");
+		return false;
+	}
+	viewProjectionLocation = glGetUniformLocation(program, "VP");
+	cameraRightLocation = glGetUniformLocation(program, "cameraRight");
+	cameraUpLocation = glGetUniformLocation(program, "cameraUp");
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "spriteSampler"), 0);
+
+	std::vector<unsigned char> pixels((size_t)PARTICLE_SPRITE_SIZE * PARTICLE_SPRITE_SIZE * 4 * PARTICLE_SPRITE_COUNT);
+	unsigned char * texel = &pixels[0];
+	for (int layer = 0; layer < PARTICLE_SPRITE_COUNT; layer++) {
+		for (int y = 0; y < PARTICLE_SPRITE_SIZE; y++) {
+			for (int x = 0; x < PARTICLE_SPRITE_SIZE; x++, texel += 4) {
+				float u = (x + 0.5f) / PARTICLE_SPRITE_SIZE * 2.0f - 1.0f;
+				float v = (y + 0.5f) / PARTICLE_SPRITE_SIZE * 2.0f - 1.0f;
+				spriteTexel((ParticleSprite)layer, u, v, texel);
+			}
+		}
+	}
+	sprites.create("particles", "particle sprites");
+	glBindTexture(GL_TEXTURE_2D_ARRAY, sprites);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, PARTICLE_SPRITE_SIZE, PARTICLE_SPRITE_SIZE, PARTICLE_SPRITE_COUNT, 0,
+		GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	// A full mip chain adds a third
+	sprites.setSize(pixels.size() * 4 / 3);
+
+	// Every particle every frame, with a few frames in flight
+	if (!instances.init(GL_ARRAY_BUFFER, capacity * sizeof(ParticleInstance), 3, "particles", "particle instances")) {
+		shutdown();
+		return false;
+	}
+	return true;
+}
+
+void ParticleRenderer::shutdown(){
+	instances.shutdown();
+	sprites.reset();
+	program.reset();
+}
+
+void ParticleRenderer::draw(RenderStateCache & renderState, ParticleSystem & particles, const glm::mat4 & view,
+	const glm::mat4 & viewProjection){
+	size_t count = particles.liveCount();
+	if (program == 0 || count == 0)
+		return;
+
+	size_t bytes = count * sizeof(ParticleInstance);
+	size_t offset = 0;
+	instances.beginFrame(bytes);
+	ParticleInstance * dst = (ParticleInstance *)instances.map(bytes, sizeof(ParticleInstance), offset);
+	if (dst == NULL)
+		return;
+	particles.writeInstances(dst);
+	instances.unmap();
+
+	// The rows of the view rotation are the camera's axes
+	glm::vec3 right(view[0][0], view[1][0], view[2][0]);
+	glm::vec3 up(view[0][1], view[1][1], view[2][1]);
+	glUseProgram(program);
+	glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, &viewProjection[0][0]);
+	glUniform3fv(cameraRightLocation, 1, &right[0]);
+	glUniform3fv(cameraUpLocation, 1, &up[0]);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, sprites);
+
+	GLsizei stride = sizeof(ParticleInstance);
+	glBindBuffer(GL_ARRAY_BUFFER, instances.buffer());
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+	glVertexAttribDivisor(0, 1);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(offset + 4 * sizeof(float)));
+	glVertexAttribDivisor(1, 1);
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 1, GL_UNSIGNED_BYTE, GL_FALSE, stride, (void*)(offset + 4 * sizeof(float) + 4));
+	glVertexAttribDivisor(2, 1);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_FALSE);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)count);
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+	instances.endFrame();
+
+	// The mesh draws share these attributes without a divisor
+	for (GLuint i = 0; i < 3; i++) {
+		glVertexAttribDivisor(i, 0);
+		glDisableVertexAttribArray(i);
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	renderState.invalidate();
+
+	if (FrameStats * stats = renderState.stats()) {
+		stats->drawCalls++;
+		stats->triangles += (unsigned int)(2 * count);
+		stats->vertices += (unsigned int)(4 * count);
+		stats->programBinds++;
+		stats->bufferBinds++;
+		stats->textureBinds++;
+		stats->uniformUploads += 3;
+		stats->uploadBytes += bytes;
+	}
+}
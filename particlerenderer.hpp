@@ -0,0 +1,43 @@
+#ifndef PARTICLERENDERER_HPP
+#define PARTICLERENDERER_HPP
+
+#include <glm/glm.hpp>
+
+#include "glresource.hpp"
+#include "renderstate.hpp"
+#include "streambuffer.hpp"
+#include "particles.hpp"
+
+// Draws a ParticleSystem as camera-facing quads, one instance per particle, in a single
+// instanced draw. The worker pool writes the instances straight into this frame's region of a
+// StreamBuffer; the quads are built in the vertex shader from the camera's axes, and each
+// samples its sprite from a texture array (ParticleSprite layers, made procedurally at init).
+//
+// Premultiplied blending lets one draw mix glowing sparks (alpha 0, added to the scene) and
+// solid confetti. Particles are depth tested against the scene but don't write depth, and are
+// not sorted. GL thread only.
+class ParticleRenderer {
+public:
+	ParticleRenderer();
+	~ParticleRenderer();
+
+	// Loads the shaders and makes the sprites. capacity sizes the instance buffer. Needs a
+	// current GL context; false (after printing why) if the shaders don't build.
+	bool init(size_t capacity);
+	void shutdown();
+
+	// Draws every live particle of particles. Changes the bound program and texture, so
+	// renderState is invalidated; counted in its stats.
+	void draw(RenderStateCache & renderState, ParticleSystem & particles, const glm::mat4 & view,
+		const glm::mat4 & viewProjection);
+
+private:
+	GLProgram program;
+	GLint viewProjectionLocation;
+	GLint cameraRightLocation;
+	GLint cameraUpLocation;
+	GLTexture sprites;
+	StreamBuffer instances;
+};
+
+#endif
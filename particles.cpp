@@ -0,0 +1,358 @@
+#include <string.h>
+#include <math.h>
+#include <chrono>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLES_USE_SSE2
+#endif
+
+#include "particles.hpp"
+
+#define PARTICLE_GRAVITY 9.8f
+#define PARTICLE_BOUNCE 0.3f   // vertical speed kept by a bounce off the floor
+#define PARTICLE_FRICTION 0.6f // horizontal speed kept by a bounce
+#define PARTICLE_LIVE_SHARE 0.95f // of the capacity the emitters aim for, leaving room for bursts
+
+// Life of each effect's particles (uniform between the two) and the part of it they fade in
+struct ParticleLook {
+	float minLife, maxLife;
+	float fade;
+};
+static const ParticleLook s_looks[PARTICLE_SPRITE_COUNT] = {
+	{ 1.5f, 2.5f, 0.4f },  // spark
+	{ 2.5f, 3.5f, 0.2f },  // droplet
+	{ 4.0f, 6.0f, 0.15f }, // confetti
+};
+
+static const uint32_t s_fireworkColors[] = {
+	0x003030ffu, 0x0030c0ffu, 0x0040ff40u, 0x00ff8040u, 0x00ff40e0u, 0x00c0ffffu
+};
+static const uint32_t s_confettiColors[] = {
+	0xff3030f0u, 0xff30c0ffu, 0xff40d040u, 0xffe06030u, 0xffc040e0u, 0xfff0f0f0u
+};
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start){
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+size_t simulateParticles(ParticlePool & pool, size_t begin, size_t end, float deltaTime, float floorY, uint32_t * dead){
+	float * x = &pool.x[0];
+	float * y = &pool.y[0];
+	float * z = &pool.z[0];
+	float * vx = &pool.vx[0];
+	float * vy = &pool.vy[0];
+	float * vz = &pool.vz[0];
+	float * age = &pool.age[0];
+	const float * life = &pool.life[0];
+	const float * drag = &pool.drag[0];
+	size_t deadCount = 0;
+	size_t i = begin;
+#ifdef PARTICLES_USE_SSE2
+	// Drag and floor friction shrink velocities toward zero for as long as a particle lives;
+	// flush them to zero instead of letting them crawl through the slow denormal range
+	unsigned int savedCsr = _mm_getcsr();
+	_mm_setcsr(savedCsr | 0x8040); // flush to zero, denormals are zero
+	const __m128 dt = _mm_set1_ps(deltaTime);
+	const __m128 fall = _mm_set1_ps(PARTICLE_GRAVITY * deltaTime);
+	const __m128 ground = _mm_set1_ps(floorY);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 bounce = _mm_set1_ps(-PARTICLE_BOUNCE);
+	const __m128 friction = _mm_set1_ps(PARTICLE_FRICTION);
+	for (; i + 4 <= end; i += 4) {
+		// Linear drag, never reversing the velocity on a long frame
+		__m128 keep = _mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(_mm_loadu_ps(drag + i), dt)), zero);
+		__m128 velX = _mm_mul_ps(_mm_loadu_ps(vx + i), keep);
+		__m128 velY = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(vy + i), keep), fall);
+		__m128 velZ = _mm_mul_ps(_mm_loadu_ps(vz + i), keep);
+		__m128 posX = _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(velX, dt));
+		__m128 posY = _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(velY, dt));
+		__m128 posZ = _mm_add_ps(_mm_loadu_ps(z + i), _mm_mul_ps(velZ, dt));
+
+		// Below the floor: back on it, bouncing up with some of the speed
+		__m128 below = _mm_cmplt_ps(posY, ground);
+		posY = _mm_or_ps(_mm_and_ps(below, ground), _mm_andnot_ps(below, posY));
+		velY = _mm_or_ps(_mm_and_ps(below, _mm_mul_ps(velY, bounce)), _mm_andnot_ps(below, velY));
+		__m128 slide = _mm_or_ps(_mm_and_ps(below, friction), _mm_andnot_ps(below, one));
+		velX = _mm_mul_ps(velX, slide);
+		velZ = _mm_mul_ps(velZ, slide);
+
+		_mm_storeu_ps(vx + i, velX);
+		_mm_storeu_ps(vy + i, velY);
+		_mm_storeu_ps(vz + i, velZ);
+		_mm_storeu_ps(x + i, posX);
+		_mm_storeu_ps(y + i, posY);
+		_mm_storeu_ps(z + i, posZ);
+
+		__m128 older = _mm_add_ps(_mm_loadu_ps(age + i), dt);
+		_mm_storeu_ps(age + i, older);
+		int expired = _mm_movemask_ps(_mm_cmpge_ps(older, _mm_loadu_ps(life + i)));
+		if (expired != 0) {
+			for (int lane = 0; lane < 4; lane++) {
+				if (expired & (1 << lane))
+					dead[deadCount++] = (uint32_t)(i + lane);
+			}
+		}
+	}
+#endif
+	for (; i < end; i++) {
+		float keep = 1.0f - drag[i] * deltaTime;
+		if (keep < 0.0f)
+			keep = 0.0f;
+		vx[i] *= keep;
+		vy[i] = vy[i] * keep - PARTICLE_GRAVITY * deltaTime;
+		vz[i] *= keep;
+		x[i] += vx[i] * deltaTime;
+		y[i] += vy[i] * deltaTime;
+		z[i] += vz[i] * deltaTime;
+		if (y[i] < floorY) {
+			y[i] = floorY;
+			vy[i] *= -PARTICLE_BOUNCE;
+			vx[i] *= PARTICLE_FRICTION;
+			vz[i] *= PARTICLE_FRICTION;
+		}
+		age[i] += deltaTime;
+		if (age[i] >= life[i])
+			dead[deadCount++] = (uint32_t)i;
+	}
+#ifdef PARTICLES_USE_SSE2
+	_mm_setcsr(savedCsr);
+#endif
+	return deadCount;
+}
+
+ParticleSystem::ParticleSystem()
+	: workers(NULL), floorY(0.0f), randomState(0x2545f491u){
+	particles.capacity = 0;
+	particles.count = 0;
+	memset(&counters, 0, sizeof(counters));
+}
+
+void ParticleSystem::init(size_t capacity, WorkerPool * pool, float floorY){
+	workers = pool;
+	this->floorY = floorY;
+	particles.capacity = capacity;
+	particles.count = 0;
+	std::vector<float> * floats[] = {
+		&particles.x, &particles.y, &particles.z, &particles.vx, &particles.vy, &particles.vz,
+		&particles.age, &particles.life, &particles.drag, &particles.size
+	};
+	for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); i++)
+		floats[i]->assign(capacity, 0.0f);
+	particles.color.assign(capacity, 0);
+	particles.sprite.assign(capacity, 0);
+	dead.assign(capacity, 0);
+	deadCounts.assign(WorkerPool::chunkCount(capacity, PARTICLE_CHUNK), 0);
+	emitters.clear();
+	memset(&counters, 0, sizeof(counters));
+}
+
+void ParticleSystem::addEmitter(EmitterType type, const glm::vec3 & position){
+	Emitter emitter;
+	emitter.type = type;
+	emitter.position = position;
+	emitter.carry = 0.0f;
+	emitter.nextShell = random(0.0f, 1.0f);
+	emitters.push_back(emitter);
+	// Shells in flight at once stay few; reserve so update never allocates
+	emitters.back().shells.reserve(type == EMITTER_FIREWORKS ? 16 : 0);
+}
+
+void ParticleSystem::addFireworks(const glm::vec3 & position){
+	addEmitter(EMITTER_FIREWORKS, position);
+}
+
+void ParticleSystem::addFountain(const glm::vec3 & position){
+	addEmitter(EMITTER_FOUNTAIN, position);
+}
+
+void ParticleSystem::addConfetti(const glm::vec3 & position){
+	addEmitter(EMITTER_CONFETTI, position);
+}
+
+float ParticleSystem::random(){
+	// xorshift32
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return (randomState >> 8) * (1.0f / 16777216.0f);
+}
+
+glm::vec3 ParticleSystem::randomDirection(){
+	float height = random(-1.0f, 1.0f);
+	float angle = random(0.0f, 6.2831853f);
+	float ring = sqrtf(1.0f - height * height);
+	return glm::vec3(ring * cosf(angle), height, ring * sinf(angle));
+}
+
+bool ParticleSystem::spawn(const glm::vec3 & position, const glm::vec3 & velocity, float life, float drag, float size,
+	uint32_t color, ParticleSprite sprite){
+	if (particles.count >= particles.capacity)
+		return false;
+	size_t i = particles.count++;
+	particles.x[i] = position.x;
+	particles.y[i] = position.y;
+	particles.z[i] = position.z;
+	particles.vx[i] = velocity.x;
+	particles.vy[i] = velocity.y;
+	particles.vz[i] = velocity.z;
+	particles.age[i] = 0.0f;
+	particles.life[i] = life;
+	particles.drag[i] = drag;
+	particles.size[i] = size;
+	particles.color[i] = color;
+	particles.sprite[i] = (uint8_t)sprite;
+	counters.spawned++;
+	return true;
+}
+
+void ParticleSystem::emitFireworks(Emitter & emitter, float deltaTime){
+	const ParticleLook & look = s_looks[PARTICLE_SPRITE_SPARK];
+	const float meanInterval = 1.5f;
+	// Sparks of one burst so the emitter's share stays live between bursts
+	float target = particles.capacity * PARTICLE_LIVE_SHARE / emitters.size();
+	int burst = (int)(target / (0.5f * (look.minLife + look.maxLife)) * meanInterval);
+
+	emitter.nextShell -= deltaTime;
+	if (emitter.nextShell <= 0.0f && emitter.shells.size() < emitter.shells.capacity()) {
+		Shell shell;
+		shell.position = emitter.position;
+		shell.velocity = glm::vec3(random(-1.5f, 1.5f), random(11.0f, 14.0f), random(-1.5f, 1.5f));
+		shell.fuse = random(0.9f, 1.3f);
+		shell.color = s_fireworkColors[(int)(random() * (sizeof(s_fireworkColors) / sizeof(s_fireworkColors[0])))];
+		emitter.shells.push_back(shell);
+		emitter.nextShell += random(meanInterval - 0.5f, meanInterval + 0.5f);
+	}
+
+	for (size_t i = 0; i < emitter.shells.size();) {
+		Shell & shell = emitter.shells[i];
+		shell.velocity.y -= PARTICLE_GRAVITY * deltaTime;
+		shell.position += shell.velocity * deltaTime;
+		shell.fuse -= deltaTime;
+		// A short-lived trail while it climbs
+		for (int j = 0; j < 4; j++)
+			spawn(shell.position, randomDirection() * 0.5f, random(0.2f, 0.5f), 2.0f, 0.06f, 0x0060c0ffu, PARTICLE_SPRITE_SPARK);
+		if (shell.fuse > 0.0f) {
+			i++;
+			continue;
+		}
+		// Burst into a sphere of sparks, a little uneven so it doesn't read as a shell
+		for (int j = 0; j < burst; j++) {
+			glm::vec3 velocity = shell.velocity * 0.3f + randomDirection() * random(5.0f, 8.0f);
+			if (!spawn(shell.position, velocity, random(look.minLife, look.maxLife), 1.2f, 0.12f, shell.color,
+				PARTICLE_SPRITE_SPARK))
+				break;
+		}
+		emitter.shells[i] = emitter.shells.back();
+		emitter.shells.pop_back();
+	}
+}
+
+void ParticleSystem::emit(Emitter & emitter, float deltaTime){
+	if (emitter.type == EMITTER_FIREWORKS) {
+		emitFireworks(emitter, deltaTime);
+		return;
+	}
+
+	ParticleSprite sprite = emitter.type == EMITTER_FOUNTAIN ? PARTICLE_SPRITE_DROPLET : PARTICLE_SPRITE_CONFETTI;
+	const ParticleLook & look = s_looks[sprite];
+	float target = particles.capacity * PARTICLE_LIVE_SHARE / emitters.size();
+	float rate = target / (0.5f * (look.minLife + look.maxLife));
+	emitter.carry += rate * deltaTime;
+	int count = (int)emitter.carry;
+	emitter.carry -= count;
+	for (int i = 0; i < count; i++) {
+		bool added;
+		if (emitter.type == EMITTER_FOUNTAIN) {
+			// An upward cone that falls back into a pool around the nozzle
+			float angle = random(0.0f, 6.2831853f);
+			float spread = random(0.0f, 1.2f);
+			glm::vec3 velocity(spread * cosf(angle), random(7.0f, 9.0f), spread * sinf(angle));
+			added = spawn(emitter.position, velocity, random(look.minLife, look.maxLife), 0.1f, 0.06f, 0x80ffd0a0u, sprite);
+		} else {
+			// Shot up and out, then fluttering down slowly under heavy drag
+			glm::vec3 velocity(random(-3.0f, 3.0f), random(5.0f, 9.0f), random(-3.0f, 3.0f));
+			uint32_t color = s_confettiColors[(int)(random() * (sizeof(s_confettiColors) / sizeof(s_confettiColors[0])))];
+			added = spawn(emitter.position, velocity, random(look.minLife, look.maxLife), 2.5f, 0.08f, color, sprite);
+		}
+		if (!added)
+			break;
+	}
+}
+
+void ParticleSystem::update(float deltaTime){
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	size_t chunks = WorkerPool::chunkCount(particles.count, PARTICLE_CHUNK);
+	std::function<void(size_t, size_t, size_t)> simulate = [&](size_t chunk, size_t begin, size_t end) {
+		deadCounts[chunk] = simulateParticles(particles, begin, end, deltaTime, floorY, &dead[chunk * PARTICLE_CHUNK]);
+	};
+	workers->parallelFor(particles.count, PARTICLE_CHUNK, simulate);
+	counters.simulateMs += millisecondsSince(start);
+
+	// Highest hole first: everything above it is already live, so the last particle is too
+	start = std::chrono::steady_clock::now();
+	size_t removed = 0;
+	for (size_t chunk = chunks; chunk-- > 0;) {
+		const uint32_t * holes = &dead[chunk * PARTICLE_CHUNK];
+		for (size_t j = deadCounts[chunk]; j-- > 0;) {
+			size_t hole = holes[j];
+			size_t last = --particles.count;
+			if (hole != last) {
+				particles.x[hole] = particles.x[last];
+				particles.y[hole] = particles.y[last];
+				particles.z[hole] = particles.z[last];
+				particles.vx[hole] = particles.vx[last];
+				particles.vy[hole] = particles.vy[last];
+				particles.vz[hole] = particles.vz[last];
+				particles.age[hole] = particles.age[last];
+				particles.life[hole] = particles.life[last];
+				particles.drag[hole] = particles.drag[last];
+				particles.size[hole] = particles.size[last];
+				particles.color[hole] = particles.color[last];
+				particles.sprite[hole] = particles.sprite[last];
+			}
+			removed++;
+		}
+	}
+	counters.died += removed;
+	counters.compactMs += millisecondsSince(start);
+
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < emitters.size(); i++)
+		emit(emitters[i], deltaTime);
+	counters.emitMs += millisecondsSince(start);
+
+	counters.frames++;
+	counters.liveSum += (double)particles.count;
+	if (particles.count > counters.peakLive)
+		counters.peakLive = particles.count;
+}
+
+void ParticleSystem::writeInstances(ParticleInstance * out){
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	float fadeScale[PARTICLE_SPRITE_COUNT];
+	for (int i = 0; i < PARTICLE_SPRITE_COUNT; i++)
+		fadeScale[i] = 1.0f / s_looks[i].fade;
+	std::function<void(size_t, size_t, size_t)> write = [&](size_t, size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			ParticleInstance & instance = out[i];
+			instance.x = particles.x[i];
+			instance.y = particles.y[i];
+			instance.z = particles.z[i];
+			instance.size = particles.size[i];
+			uint8_t sprite = particles.sprite[i];
+			// 1 until the last fade part of the life, then down to 0
+			float fade = (particles.life[i] - particles.age[i]) / particles.life[i] * fadeScale[sprite];
+			fade = fade < 1.0f ? (fade > 0.0f ? fade : 0.0f) : 1.0f;
+			int scale = (int)(fade * 256.0f);
+			uint32_t color = particles.color[i];
+			for (int c = 0; c < 4; c++)
+				instance.color[c] = (uint8_t)((((color >> (8 * c)) & 0xff) * scale) >> 8);
+			instance.sprite = sprite;
+			instance.pad[0] = instance.pad[1] = instance.pad[2] = 0;
+		}
+	};
+	workers->parallelFor(particles.count, PARTICLE_CHUNK, write);
+	counters.writeMs += millisecondsSince(start);
+}
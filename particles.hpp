@@ -0,0 +1,133 @@
+#ifndef PARTICLES_HPP
+#define PARTICLES_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "workerpool.hpp"
+
+// Particle effects of the park: fireworks over the rides, fountain spray and confetti at the
+// coaster station. GL-free; particlerenderer.hpp draws them.
+//
+// Particles live in a structure-of-arrays pool sized once at init: one array per component, so
+// the update kernel streams through plain float arrays four particles at a time with SSE2 (with
+// a scalar tail, and a scalar path without SSE2). The kernel runs over chunks of
+// PARTICLE_CHUNK particles on a WorkerPool and lists the particles that died in each chunk;
+// compaction then fills every hole with the last live particle, from the highest hole down.
+// Nothing is allocated after init, and particles never move except to fill a hole.
+
+#define PARTICLE_CHUNK 16384
+
+enum ParticleSprite {
+	PARTICLE_SPRITE_SPARK,    // soft glow, drawn additively
+	PARTICLE_SPRITE_DROPLET,
+	PARTICLE_SPRITE_CONFETTI, // solid paper square
+	PARTICLE_SPRITE_COUNT
+};
+
+// One particle as the renderer's instance buffer takes it
+struct ParticleInstance {
+	float x, y, z;
+	float size;       // half the quad's width
+	uint8_t color[4]; // premultiplied by the fade; alpha 0 adds light, 255 covers
+	uint8_t sprite;   // ParticleSprite, the texture array layer
+	uint8_t pad[3];
+};
+
+// Cost of the last frames, summed; divide by frames for averages
+struct ParticleStats {
+	long long frames;
+	long long spawned;
+	long long died;
+	size_t peakLive;
+	double liveSum;     // for the mean live count
+	double emitMs;      // emitters, on the calling thread
+	double simulateMs;  // the SIMD kernel over all threads, wall clock
+	double compactMs;
+	double writeMs;     // writeInstances, wall clock
+};
+
+// The particle arrays. x/y/z position, vx/vy/vz velocity, age and life in seconds, drag per
+// second, size (half the quad's width) in world units, color RGBA8 (alpha as in
+// ParticleInstance), sprite.
+struct ParticlePool {
+	size_t capacity;
+	size_t count;
+	std::vector<float> x, y, z;
+	std::vector<float> vx, vy, vz;
+	std::vector<float> age, life, drag, size;
+	std::vector<uint32_t> color;
+	std::vector<uint8_t> sprite;
+};
+
+// Moves particles [begin, end) of pool by deltaTime (gravity, drag, bouncing off the floor at
+// floorY) and ages them. Writes the indices that reached their life, in increasing order, to
+// dead and returns how many there were.
+size_t simulateParticles(ParticlePool & pool, size_t begin, size_t end, float deltaTime, float floorY, uint32_t * dead);
+
+class ParticleSystem {
+public:
+	ParticleSystem();
+
+	// Room for capacity particles. The emitters share it: each aims for an equal part of it
+	// live, so a full park runs near capacity. pool runs the kernels; one without workers runs
+	// them on the calling thread.
+	void init(size_t capacity, WorkerPool * pool, float floorY);
+
+	// Emitters. Fireworks launch shells from position that burst high above it.
+	void addFireworks(const glm::vec3 & position);
+	void addFountain(const glm::vec3 & position);
+	void addConfetti(const glm::vec3 & position);
+
+	// Emits, simulates and compacts.
+	void update(float deltaTime);
+
+	// Writes every live particle to out (liveCount() of them), on the worker pool. fade for
+	// the last part of each particle's life is applied here.
+	void writeInstances(ParticleInstance * out);
+
+	size_t liveCount() const { return particles.count; }
+	size_t capacity() const { return particles.capacity; }
+	int emitterCount() const { return (int)emitters.size(); }
+	const ParticleStats & stats() const { return counters; }
+
+private:
+	enum EmitterType { EMITTER_FIREWORKS, EMITTER_FOUNTAIN, EMITTER_CONFETTI };
+	struct Shell {
+		glm::vec3 position;
+		glm::vec3 velocity;
+		float fuse;     // seconds until it bursts
+		uint32_t color;
+	};
+	struct Emitter {
+		EmitterType type;
+		glm::vec3 position;
+		float carry;    // fraction of a particle left over from the last frame
+		float nextShell;
+		std::vector<Shell> shells;
+	};
+
+	void addEmitter(EmitterType type, const glm::vec3 & position);
+	void emit(Emitter & emitter, float deltaTime);
+	void emitFireworks(Emitter & emitter, float deltaTime);
+	// Adds one particle if there is room
+	bool spawn(const glm::vec3 & position, const glm::vec3 & velocity, float life, float drag, float size, uint32_t color,
+		ParticleSprite sprite);
+	float random();              // [0, 1)
+	float random(float low, float high){ return low + (high - low) * random(); }
+	glm::vec3 randomDirection(); // uniform on the unit sphere
+
+	ParticlePool particles;
+	WorkerPool * workers;
+	float floorY;
+	std::vector<Emitter> emitters;
+	std::vector<uint32_t> dead;        // PARTICLE_CHUNK slots per chunk
+	std::vector<size_t> deadCounts;    // per chunk
+	uint32_t randomState;
+	ParticleStats counters;
+};
+
+#endif
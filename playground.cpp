@@ -1,6 +1,12 @@
 // Include standard headers
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <chrono>
+#include <initializer_list>
+#include <algorithm>
+#include <thread>
 
 // Include GLEW
 #include <GL/glew.h>
@@ -22,2310 +28,1283 @@ using namespace glm;
 #include <common/controls.hpp>
 #include <common/texture.hpp>
 
-//circle texture uv 
-GLfloat *makeCircleUVBuffer(GLfloat *arr, GLint sideNums);
-//object vertex  * 3ŭ Color  ϴ Լ
-GLfloat *makeColorBuffer(GLfloat *arr, GLint vertexNum, GLfloat red, GLfloat green, GLfloat blue);
-// Vertex  ϴ Լ
-GLfloat *makeCircleVertexData(GLfloat *arr, GLfloat x, GLfloat y, GLfloat z, GLfloat radius, GLint numberOfSides);
-// ̵  ϴ Լ
-GLfloat *makeCylinderSide(GLfloat *arr, GLfloat radius, GLint numberOfSides);
-// ̵ ÷ ϴ Լ
-GLfloat *makeCylinderColor(GLfloat *arr, GLint numberOfSides, GLfloat r, GLfloat g, GLfloat b);
-// ̵ UV ϴ Լ
-GLfloat *makeCylinderUVBuffer(GLfloat *arr, GLint numberOfSides);
-//   ϴ Լ
-GLfloat *makeUmbrella(GLfloat *arr, GLfloat y, GLfloat radius, GLint numberOfSides);
-//  ÷ ϴ Լ
-GLfloat *makeUmbrellaColor(GLfloat *arr, GLint vertexNum, GLfloat red, GLfloat green, GLfloat blue);
-//  texture uv ϴ Լ
-GLfloat *makeUmbrellaUV(GLfloat *arr, GLint vertexNum);
-//ѷڽƮ Rail   Լ.
-GLfloat *makeRailVertexBuffer(GLfloat *arr, GLint vertexNum);
-//ѷڽƮ Rail Color   Լ.
-GLfloat *makeRailColorBuffer(GLfloat *arr, GLint vertexNum, GLfloat red, GLfloat green, GLfloat blue);
-
-int main(void)
+#include "texturestreamer.hpp"
+#include "shaderpermutation.hpp"
+#include "renderstate.hpp"
+#include "scene.hpp"
+#include "parkgeometry.hpp"
+#include "shadercache.hpp"
+#include "startupgraph.hpp"
+#include "profiler.hpp"
+#include "renderstats.hpp"
+#include "statshud.hpp"
+#include "headless.hpp"
+#include "camerapath.hpp"
+#include "rides.hpp"
+#include "goldenimage.hpp"
+#include "drawqueue.hpp"
+#include "overdraw.hpp"
+#include "dynamicresolution.hpp"
+#include "streambuffer.hpp"
+#include "rideanimation.hpp"
+#include "workerpool.hpp"
+#include "particles.hpp"
+#include "particlerenderer.hpp"
+#include "crowd.hpp"
+#include "crowdrenderer.hpp"
+#include "sceneindex.hpp"
+#include "terrain.hpp"
+#include "ridecells.hpp"
+
+// scene 안의 mesh 하나. 모든 mesh 는 scene 의 vertex / index buffer 를 같이 쓴다.
+struct Mesh {
+	const SceneMesh *sceneMesh;
+};
+// BVH (sceneindex.hpp) 에 넣은 물체 하나를 그리는 방법. parkDraws[i] 는 sceneIndex 의 물체 i 이다.
+// rideInstance 가 0 이상이면 animatedRides 의 놀이기구 (instance 순서) 이고 나머지는 쓰지 않는다.
+struct ParkDraw {
+	const SceneMesh *mesh;
+	const glm::mat4 *model;
+	const GLuint *texture;  // texture streamer 가 매 프레임 바꾸는 변수. NULL 이면 vertex color 로 그린다.
+	int layer;
+	int rideInstance;
+};
+// scene 에서 이름으로 mesh 를 찾는 함수. 없으면 false
+bool findMesh(const Scene &scene, const char *name, Mesh &mesh);
+// texture 가 0 이 아니면 textured permutation, 0 이면 vertex color permutation 으로 mesh 를 그리는 함수
+// depthOnly 면 position 만 bind 해서 depth 만 쓴다 (depth pre-pass, color mask 는 호출하는 쪽에서 끈다).
+void drawMesh(RenderStateCache &renderState, GLuint vertexBuffer, const SceneMesh &sceneMesh, const glm::mat4 &MVP,
+	GLuint texture, bool depthOnly = false);
+// 놀이기구 하나가 쓰는 mesh (scene buffer 의 일부) 와 texture 를 resource tracker 에 알려주는 함수
+void addRideUses(const char *ride, const Scene &scene, std::initializer_list<const Mesh *> meshes, std::initializer_list<GLuint> textures);
+// mesh 하나를 sceneIndex 와 parkDraws 에 같이 추가하는 함수. moving 이면 매 프레임 model 을 다시 읽어 refit 한다.
+void addParkObject(SceneIndex &sceneIndex, std::vector<ParkDraw> &parkDraws, const char *ride, const char *part,
+	const Mesh &mesh, const glm::mat4 *model, const GLuint *texture, bool moving, int layer = DRAW_LAYER_DEFAULT);
+// 화면 좌표 (x, y, 왼쪽 위가 0) 를 지나는 world space ray. direction 은 단위 벡터
+void screenRay(const glm::mat4 &viewProjection, double x, double y, int width, int height, glm::vec3 &origin, glm::vec3 &direction);
+// pick 된 물체의 HUD 정보 (놀이기구, 부품, 거리, 위치). 아무것도 없으면 빈 목록
+std::vector<std::string> pickInfo(const SceneIndex &sceneIndex, const ScenePick &pick);
+// 프로그램 시작 후 지난 시간(초). headless 모드에서는 GLFW 를 쓰지 않으므로 glfwGetTime 대신 사용한다.
+double currentSeconds();
+
+int main(int argc, char *argv[])
 {
-	// Initialise GLFW
-	if (!glfwInit())
-	{
-		fprintf(stderr, "Failed to initialize GLFW\n");
-		getchar();
+	// --hud : 통계 overlay 를 켠 채로 시작 (F3 으로 켜고 끈다)
+	// --stats-csv <path> : 매 프레임 통계를 CSV 로 저장
+	// --stats-interval <seconds> : 통계 요약을 출력하는 간격 (0 이면 출력하지 않음)
+	// --headless : window 없이 EGL context 와 FBO 로 정해진 프레임 수만큼 그리고 JSON 리포트를 쓴 뒤 종료
+	// --frames <n>, --report <path> : headless 모드의 프레임 수와 리포트 경로
+	// --width <w> --height <h> --msaa <samples> : 해상도와 MSAA sample 수 (window 모드에도 적용)
+	// --camera-path <file> : 마우스/키보드 대신 camera path 파일(camerapaths/*.campath)로 카메라를 움직인다.
+	//                        headless 모드에서 --frames 가 없으면 path 길이만큼 그린다.
+	// --record-camera <file> : window 모드에서 움직인 카메라를 camera path 파일로 저장
+	// --golden <dir> : headless 모드에서 --golden-every 프레임마다 FBO 를 읽어 <dir> 의 golden image 와 비교하고,
+	//                  frame time 중앙값도 golden 과 같이 저장된 값과 비교한다. 다르면 golden_out 에 실제/diff image 를 쓴다.
+	//                  종료 코드: 0 통과, 1 image 불일치, 2 image 는 같지만 느려짐
+	// --golden-update : 비교 대신 golden image 와 frame time 을 새로 저장
+	// --golden-every <n>, --golden-threshold <0..1>, --golden-max-diff <fraction>, --golden-timing-tolerance <fraction>
+	// --draw-order <submission|front-to-back> : 불투명 draw 순서. 기본은 front-to-back (가까운 것부터, 바닥은 맨 나중)
+	// --depth-prepass : position 만으로 depth 를 먼저 채운 뒤 같은 depth 인 fragment 만 shading 한다.
+	//                   overdraw (shading 된 sample / 화면 sample) 는 통계, HUD, 리포트에 나오므로 장면마다 빠른 쪽을 고르면 된다.
+	// --target-fps <fps> : dynamic resolution. 장면을 FBO 에 그리고, frame time 이 목표를 넘으면 MSAA sample 수를
+	//                      줄이고 그 다음 해상도를 낮춘다. 결과는 window (headless 는 출력 FBO) 크기로 늘려서 그린다.
+	// --min-scale <0..1> : dynamic resolution 의 최저 해상도 비율 (기본 0.5)
+	// --upscale <bilinear|sharpen> : 늘리는 방법. sharpen 은 bilinear 에 unsharp mask 를 더한다.
+	// --no-buffer-storage : 매 프레임 쓰는 buffer (StreamBuffer) 를 persistent mapping 대신 GL 3.3 방식
+	//                       (unsynchronized glMapBufferRange) 으로 쓴다. 종료할 때 두 방식의 stall 수를 비교할 수 있다.
+	// --gpu-rides : 바이킹과 회전목마를 CPU (rides.cpp) 대신 vertex shader 에서 time uniform 으로 움직인다.
+	// --flat-rides <n> : 공원 둘레에 바이킹 / 회전목마 n 개를 더 세운다. GPU 애니메이션으로 instanced draw 한다.
+	//                    GPU 애니메이션을 쓰면 시작할 때 transform feedback 으로 읽은 행렬을 CPU 계산과 비교한다.
+	//                    공원을 world cell 로 나누어 카메라 근처 cell 의 놀이기구만 background thread 에서 만들어 올린다.
+	// --particles <n> : 놀이기구 위 불꽃놀이, 분수, 롤러코스터 승강장의 색종이를 particle n 개까지 켠다 (기본 0 = 끔).
+	//                   update (SIMD, worker thread) 와 render (instance 쓰기 + draw) 비용을 따로 출력 / 리포트한다.
+	// --crowd <n> : 바이킹, 회전목마, 롤러코스터 대기 줄 사이를 걸어 다니는 방문객 n 명 (기본 0).
+	//               spatial hash grid 로 이웃을 찾고, 거리에 따라 3 단계 LOD 로 instanced draw 한다.
+	// --worker-threads <n> : particle 과 방문객을 나눠 처리할 worker thread 수 (기본: hardware thread 수 - 1)
+	// --no-culling : 놀이기구 부품의 BVH frustum culling 을 끄고 전부 그린다 (비교용).
+	//                window 모드에서는 왼쪽 클릭으로 화면 가운데 (십자선) 의 놀이기구를 BVH 로 pick 해서 정보를 띄운다.
+	// --flat-floor : 지형 대신 예전의 평평한 바닥 사각형 하나를 그린다 (비교용).
+	// --terrain-memory <MB> : 지형 chunk 가 쓸 GPU 메모리 상한 (기본 16). 넘치면 가장 오래 안 그린 chunk 부터 버린다.
+	// --terrain-budget <KB> : 한 프레임에 올리는 지형 chunk 의 최대 크기 (기본 256)
+	// --no-ride-cells : --flat-rides 의 놀이기구를 cell 로 나누지 않고 시작할 때 전부 올린다 (비교용).
+	// --ride-cell-memory <KB> : 놀이기구 cell 이 쓸 GPU 메모리 상한 (기본 512). 넘치면 가장 오래 안 쓴 cell 부터 버린다.
+	// --ride-cell-budget <KB> : 한 프레임에 올리는 놀이기구 cell 의 최대 크기 (기본 32)
+	double processStart = currentSeconds();
+	bool hudVisible = false;
+	const char *statsCsvPath = NULL;
+	double statsInterval = 5.0;
+	bool headless = false;
+	int benchmarkFrames = 600;
+	bool framesGiven = false;
+	const char *cameraPathFile = NULL;
+	const char *recordCameraFile = NULL;
+	const char *goldenDir = NULL;
+	bool goldenUpdate = false;
+	int goldenEvery = 60;
+	float goldenThreshold = 0.1f;
+	double goldenMaxDiff = 0.001, goldenTimingTolerance = 0.03;
+	const char *reportPath = "benchmark_report.json";
+	int screenWidth = 1024, screenHeight = 768, msaaSamples = 4;
+	DrawOrder drawOrder = DRAW_ORDER_FRONT_TO_BACK;
+	bool depthPrepass = false;
+	float targetFps = 0.0f, minScale = 0.5f;
+	UpscaleFilter upscaleFilter = UPSCALE_BILINEAR;
+	bool gpuRides = false;
+	int flatRides = 0;
+	int particleCapacity = 0;
+	int crowdSize = 0;
+	bool culling = true;
+	bool flatFloor = false;
+	int terrainMemoryMB = 16, terrainBudgetKB = 256;
+	bool rideCellsEnabled = true;
+	int rideCellMemoryKB = 512, rideCellBudgetKB = 32;
+	int workerThreads = defaultWorkerCount();
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--hud") == 0)
+			hudVisible = true;
+		else if (strcmp(argv[i], "--headless") == 0)
+			headless = true;
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			benchmarkFrames = atoi(argv[++i]);
+			framesGiven = true;
+		}
+		else if (strcmp(argv[i], "--camera-path") == 0 && i + 1 < argc)
+			cameraPathFile = argv[++i];
+		else if (strcmp(argv[i], "--record-camera") == 0 && i + 1 < argc)
+			recordCameraFile = argv[++i];
+		else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc)
+			goldenDir = argv[++i];
+		else if (strcmp(argv[i], "--golden-update") == 0)
+			goldenUpdate = true;
+		else if (strcmp(argv[i], "--golden-every") == 0 && i + 1 < argc)
+			goldenEvery = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--golden-threshold") == 0 && i + 1 < argc)
+			goldenThreshold = (float)atof(argv[++i]);
+		else if (strcmp(argv[i], "--golden-max-diff") == 0 && i + 1 < argc)
+			goldenMaxDiff = atof(argv[++i]);
+		else if (strcmp(argv[i], "--golden-timing-tolerance") == 0 && i + 1 < argc)
+			goldenTimingTolerance = atof(argv[++i]);
+		else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc)
+			reportPath = argv[++i];
+		else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc)
+			screenWidth = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc)
+			screenHeight = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--msaa") == 0 && i + 1 < argc)
+			msaaSamples = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--stats-csv") == 0 && i + 1 < argc)
+			statsCsvPath = argv[++i];
+		else if (strcmp(argv[i], "--stats-interval") == 0 && i + 1 < argc)
+			statsInterval = atof(argv[++i]);
+		else if (strcmp(argv[i], "--draw-order") == 0 && i + 1 < argc) {
+			if (!parseDrawOrder(argv[++i], drawOrder)) {
+				fprintf(stderr, "--draw-order must be submission or front-to-back\n");
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "--depth-prepass") == 0)
+			depthPrepass = true;
+		else if (strcmp(argv[i], "--no-buffer-storage") == 0)
+			allowPersistentMapping(false);
+		else if (strcmp(argv[i], "--gpu-rides") == 0)
+			gpuRides = true;
+		else if (strcmp(argv[i], "--flat-rides") == 0 && i + 1 < argc)
+			flatRides = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--particles") == 0 && i + 1 < argc)
+			particleCapacity = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--crowd") == 0 && i + 1 < argc)
+			crowdSize = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--no-culling") == 0)
+			culling = false;
+		else if (strcmp(argv[i], "--flat-floor") == 0)
+			flatFloor = true;
+		else if (strcmp(argv[i], "--terrain-memory") == 0 && i + 1 < argc)
+			terrainMemoryMB = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--terrain-budget") == 0 && i + 1 < argc)
+			terrainBudgetKB = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--no-ride-cells") == 0)
+			rideCellsEnabled = false;
+		else if (strcmp(argv[i], "--ride-cell-memory") == 0 && i + 1 < argc)
+			rideCellMemoryKB = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--ride-cell-budget") == 0 && i + 1 < argc)
+			rideCellBudgetKB = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--worker-threads") == 0 && i + 1 < argc)
+			workerThreads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--target-fps") == 0 && i + 1 < argc)
+			targetFps = (float)atof(argv[++i]);
+		else if (strcmp(argv[i], "--min-scale") == 0 && i + 1 < argc)
+			minScale = (float)atof(argv[++i]);
+		else if (strcmp(argv[i], "--upscale") == 0 && i + 1 < argc) {
+			if (!parseUpscaleFilter(argv[++i], upscaleFilter)) {
+				fprintf(stderr, "--upscale must be bilinear or sharpen\n");
+				return -1;
+			}
+		}
+		else
+			printf("Unknown option %s\n", argv[i]);
+	}
+	if (screenWidth <= 0 || screenHeight <= 0 || benchmarkFrames <= 0 || goldenEvery <= 0) {
+		fprintf(stderr, "--width, --height, --frames and --golden-every must be positive\n");
 		return -1;
 	}
-
-	glfwWindowHint(GLFW_SAMPLES, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // To make MacOS happy; should not be needed
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-	// Open a window and create its OpenGL context
-	window = glfwCreateWindow(1024, 768, "Amusement Park", NULL, NULL);
-	if (window == NULL) {
-		fprintf(stderr, "Failed to open GLFW window. If you have an Intel GPU, they are not 3.3 compatible. Try the 2.1 version of the tutorials.\n");
-		getchar();
-		glfwTerminate();
+	if (flatRides < 0 || particleCapacity < 0 || crowdSize < 0 || workerThreads < 0) {
+		fprintf(stderr, "--flat-rides, --particles, --crowd and --worker-threads must not be negative\n");
 		return -1;
 	}
-	glfwMakeContextCurrent(window);
-
-	// Initialize GLEW
-	glewExperimental = true; // Needed for core profile
-	if (glewInit() != GLEW_OK) {
-		fprintf(stderr, "Failed to initialize GLEW\n");
-		getchar();
-		glfwTerminate();
+	if (terrainMemoryMB <= 0 || terrainBudgetKB <= 0) {
+		fprintf(stderr, "--terrain-memory and --terrain-budget must be positive\n");
+		return -1;
+	}
+	if (rideCellMemoryKB <= 0 || rideCellBudgetKB <= 0) {
+		fprintf(stderr, "--ride-cell-memory and --ride-cell-budget must be positive\n");
+		return -1;
+	}
+	if (targetFps < 0.0f || minScale <= 0.0f || minScale > 1.0f) {
+		fprintf(stderr, "--target-fps must not be negative and --min-scale must be in (0, 1]\n");
+		return -1;
+	}
+	// dynamic resolution 에서는 MSAA 를 장면 FBO 가 가지므로 window / 출력 FBO 는 single sample 이다.
+	bool dynamicResolution = targetFps > 0.0f;
+	int outputSamples = dynamicResolution ? 1 : msaaSamples;
+	if (goldenDir != NULL && !headless) {
+		fprintf(stderr, "--golden needs --headless\n");
 		return -1;
 	}
 
-	// Ensure we can capture the escape key being pressed below
-	glfwSetInputMode(window, GLFW_STICKY_KEYS, GL_TRUE);
-	// Hide the mouse and enable unlimited mouvement
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-	// Dark Red background( ο  Ѵ)
-	glClearColor(0.5f, 0.0f, 0.0f, 0.0f);
-
-	// Enable depth test
-	glEnable(GL_DEPTH_TEST);
-	// Accept fragment if it closer to the camera than the former one
-	glDepthFunc(GL_LESS);
-
-	GLuint VertexArrayID;
-	glGenVertexArrays(1, &VertexArrayID);
-	glBindVertexArray(VertexArrayID);
-
-	// Create and compile our GLSL program from the shaders
-	GLuint programID = LoadShaders("TransformVertexShader.vertexshader", "ColorFragmentShader.fragmentshader");
-
-	// Get a handle for our "MVP" uniform
-	GLuint MatrixID = glGetUniformLocation(programID, "MVP");
-
-	// Get a handle for our "myTextureSampler" uniform
-	// Texture bmp ̹ bmp 
-	static GLuint TextureFloor = loadBMP_custom("uvtemplate.bmp"); // floor texture
-	static GLuint TextureWood = loadBMP_custom("wood.bmp"); // wood texture
-	static GLuint TextureYellow = loadBMP_custom("yellow.bmp"); // background yellow texture
-	static GLuint TextureStrip = loadBMP_custom("bluestrip.bmp"); // background strip texture
-	static GLuint TextureID = glGetUniformLocation(programID, "myTextureSampler");
-	GLuint isTexture = glGetUniformLocation(programID, "isTexture");
-
-	// 1. cube  vertex data
-	static const GLfloat g_vertex_buffer_data[] = {
-		-1.0f,-1.0f,-1.0f,
-		-1.0f,-1.0f, 1.0f,
-		-1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f,-1.0f,
-		-1.0f,-1.0f,-1.0f,
-		-1.0f, 1.0f,-1.0f,
-		1.0f,-1.0f, 1.0f,
-		-1.0f,-1.0f,-1.0f,
-		1.0f,-1.0f,-1.0f,
-		1.0f, 1.0f,-1.0f,
-		1.0f,-1.0f,-1.0f,
-		-1.0f,-1.0f,-1.0f,
-		-1.0f,-1.0f,-1.0f,
-		-1.0f, 1.0f, 1.0f,
-		-1.0f, 1.0f,-1.0f,
-		1.0f,-1.0f, 1.0f,
-		-1.0f,-1.0f, 1.0f,
-		-1.0f,-1.0f,-1.0f,
-		-1.0f, 1.0f, 1.0f,
-		-1.0f,-1.0f, 1.0f,
-		1.0f,-1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f,-1.0f,-1.0f,
-		1.0f, 1.0f,-1.0f,
-		1.0f,-1.0f,-1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f,-1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f,-1.0f,
-		-1.0f, 1.0f,-1.0f,
-		1.0f, 1.0f, 1.0f,
-		-1.0f, 1.0f,-1.0f,
-		-1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		-1.0f, 1.0f, 1.0f,
-		1.0f,-1.0f, 1.0f
-	};
-
-	// 2. Rectangle Vertex Data
-	static const GLfloat g_rect_vertex_data[] = {
-		-1.0f, 0.0f, -1.0f,
-		-1.0f, 0.0f, 1.0f,
-		1.0f, 0.0f, 1.0f,
-		1.0f, 0.0f, 1.0f,
-		1.0f, 0.0f, -1.0f,
-		-1.0f, 0.0f, -1.0f
-	};
-
-	// 3. Rectangle UV Data
-	static const GLfloat g_rect_uv_data[] = {
-		0.0f, 0.0f,
-		0.0f, 1.0f,
-		1.0f, 1.0f,
-		1.0f, 1.0f,
-		1.0f, 0.0f,
-		0.0f, 0.0f
-	};
-
-	//4. cube  texture uv ǥ 
-	static const GLfloat g_uv_buffer_data[] = {
-		0.000059f, 1.0f - 0.000004f,
-		0.000103f, 1.0f - 0.336048f,
-		0.335973f, 1.0f - 0.335903f,
-		1.000023f, 1.0f - 0.000013f,
-		0.667979f, 1.0f - 0.335851f,
-		0.999958f, 1.0f - 0.336064f,
-		0.667979f, 1.0f - 0.335851f,
-		0.336024f, 1.0f - 0.671877f,
-		0.667969f, 1.0f - 0.671889f,
-		1.000023f, 1.0f - 0.000013f,
-		0.668104f, 1.0f - 0.000013f,
-		0.667979f, 1.0f - 0.335851f,
-		0.000059f, 1.0f - 0.000004f,
-		0.335973f, 1.0f - 0.335903f,
-		0.336098f, 1.0f - 0.000071f,
-		0.667979f, 1.0f - 0.335851f,
-		0.335973f, 1.0f - 0.335903f,
-		0.336024f, 1.0f - 0.671877f,
-		1.000004f, 1.0f - 0.671847f,
-		0.999958f, 1.0f - 0.336064f,
-		0.667979f, 1.0f - 0.335851f,
-		0.668104f, 1.0f - 0.000013f,
-		0.335973f, 1.0f - 0.335903f,
-		0.667979f, 1.0f - 0.335851f,
-		0.335973f, 1.0f - 0.335903f,
-		0.668104f, 1.0f - 0.000013f,
-		0.336098f, 1.0f - 0.000071f,
-		0.000103f, 1.0f - 0.336048f,
-		0.000004f, 1.0f - 0.671870f,
-		0.336024f, 1.0f - 0.671877f,
-		0.000103f, 1.0f - 0.336048f,
-		0.336024f, 1.0f - 0.671877f,
-		0.335973f, 1.0f - 0.335903f,
-		0.667969f, 1.0f - 0.671889f,
-		1.000004f, 1.0f - 0.671847f,
-		0.667979f, 1.0f - 0.335851f
-	};
-
-	//******************************************
-	//Merry go round(ȸ) setting start
-	//******************************************
-	//  ̵ ,  ̵ ,   
-	const GLint numOfSides = 36;
-	const GLint umbrellaOfSides = 8;
-	const GLint radius = 1;
-
-	static GLfloat g_circle_buffer_data[38 * 3] = { 0.0f }; // circle ϴ vertex buffer set
-	makeCircleVertexData(g_circle_buffer_data, 0, 0, 0, radius, 36);
-
-	static GLfloat g_circle_color_data[38 * 3] = { 0.0f }; // circle ϴ color buffer set
-	makeColorBuffer(g_circle_color_data, 38, 1.0f, 1.0f, 0.0f);
-
-	static GLfloat g_circle_uv_data[38 * 2] = { 0.0f }; // circle ϴ texture buffer set
-	makeCircleUVBuffer(g_circle_uv_data, 36);
-
-	static GLfloat g_side_buffer_data[36 * 18] = { 0.0f }; //  side ϴ vertex buffer set
-	makeCylinderSide(g_side_buffer_data, radius, numOfSides); //  (radius)  (numOfSides) Ű ִ´.
-
-	static GLfloat g_side_color_data[36 * 18] = { 0.0f }; //  side ϴ color buffer set
-	makeCylinderColor(g_side_color_data, numOfSides, 1.0f, 1.0f, 0.0f); //  (numOfSides), rgb  Ű ִ´.
-
-	static GLfloat g_side_uv_data[36 * 12] = { 0.0f }; //  side ϴ texture buffer set
-	makeCylinderUVBuffer(g_side_uv_data, numOfSides);
+	// 시작 과정은 dependency graph 로 실행한다. GLFW/GL 작업은 main thread 에서 순서대로,
+	// shader source 읽기, scene 파일 mmap(필요하면 bake), texture decode 는 worker thread 에서
+	// window 와 context 가 만들어지는 동안 같이 진행된다. 끝나면 단계별 timeline 을 출력한다.
+	StartupGraph startup;
+
+	GLVertexArray VertexArrayID;
+	std::string vertexShaderSource, fragmentShaderSource;
+	ShaderProgram programs[SHADER_PERMUTATION_COUNT];
+	MappedFile sceneFile;
+	SceneFileHeader sceneHeader;
+	Scene scene;
+	Mesh cubeMesh, floorMesh, circleMesh, sideMesh, umbrellaMesh, railMesh;
+	TextureStreamer textureStreamer;
+	int TextureFloorHandle, TextureWoodHandle, TextureYellowHandle, TextureStripHandle;
+	double textureLoadStart = 0.0;
+	CameraPath cameraPath;
+	HeadlessContext headlessContext;
+	OffscreenTarget offscreen;
+	memset(&sceneFile, 0, sizeof(sceneFile));
+	memset(&headlessContext, 0, sizeof(headlessContext));
+
+	int windowReady;
+	if (headless) {
+		// window 대신 EGL context (GPU 없는 환경에서는 Mesa llvmpipe) 를 만든다.
+		windowReady = startup.addTask("createHeadlessContext", STARTUP_MAIN_THREAD, [&]() {
+			return createHeadlessContext(headlessContext);
+		});
+	} else {
+		int glfwReady = startup.addTask("glfwInit", STARTUP_MAIN_THREAD, [&]() {
+			// Initialise GLFW
+			if (!glfwInit())
+			{
+				fprintf(stderr, "Failed to initialize GLFW\n");
+				return false;
+			}
+			return true;
+		});
+
+		windowReady = startup.addTask("createWindow", STARTUP_MAIN_THREAD, [&]() {
+			glfwWindowHint(GLFW_SAMPLES, outputSamples > 1 ? outputSamples : 0);
+			glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+			glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+			glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // To make MacOS happy; should not be needed
+			glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+			// Open a window and create its OpenGL context
+			window = glfwCreateWindow(screenWidth, screenHeight, "Amusement Park", NULL, NULL);
+			if (window == NULL) {
+				fprintf(stderr, "Failed to open GLFW window. If you have an Intel GPU, they are not 3.3 compatible. Try the 2.1 version of the tutorials.\n");
+				return false;
+			}
+			glfwMakeContextCurrent(window);
+			return true;
+		}, { glfwReady });
+	}
 
-	static GLfloat umbrella_vertex_data[8 * 9] = { 0.0f }; // ȸ () vertex buffer set
-	makeUmbrella(umbrella_vertex_data, 1.0f, radius, umbrellaOfSides); //  (umbrellaOfSides) Է¹޴´.
+	int glReady = startup.addTask("glewInit", STARTUP_MAIN_THREAD, [&]() {
+		// Initialize GLEW
+		glewExperimental = true; // Needed for core profile
+		GLenum glewResult = glewInit();
+		// GLX 로 빌드된 GLEW 는 EGL context 에서 GLX display 가 없다고 하지만 GL 함수는 정상적으로 읽어 온다.
+		if (glewResult != GLEW_OK && !(headless && glewResult == GLEW_ERROR_NO_GLX_DISPLAY)) {
+			fprintf(stderr, "Failed to initialize GLEW\n");
+			return false;
+		}
 
-	static GLfloat umbrella_color_data[8 * 9] = { 0.0f }; // ȸ () color buffer set
-	makeUmbrellaColor(umbrella_color_data, umbrellaOfSides, 0.0f, 1.0f, 0.0f); // (umbrellaOfSides), rgb  Է¹޴´.
+		if (headless) {
+			// window 의 default framebuffer 대신 그릴 FBO
+			if (!createOffscreenTarget(screenWidth, screenHeight, outputSamples, offscreen)) {
+				fprintf(stderr, "Failed to create the offscreen framebuffer\n");
+				return false;
+			}
+		} else {
+			// Ensure we can capture the escape key being pressed below
+			glfwSetInputMode(window, GLFW_STICKY_KEYS, GL_TRUE);
+			// Hide the mouse and enable unlimited mouvement
+			glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		}
 
-	static GLfloat umbrella_uv_data[8 * 6] = { 0.0f }; // ȸ () texture buffer set
-	makeUmbrellaUV(umbrella_uv_data, umbrellaOfSides);
+		// Dark Red background(배경색을 어두운 붉은색으로 설정한다)
+		glClearColor(0.5f, 0.0f, 0.0f, 0.0f);
 
-	//******************************************
-	//Merry go round(ȸ) setting end
-	//******************************************
+		// Enable depth test
+		glEnable(GL_DEPTH_TEST);
+		// Accept fragment if it closer to the camera than the former one
+		glDepthFunc(GL_LESS);
+		// 모든 mesh 는 바깥에서 보아 CCW 로 감겨 있으므로 뒷면은 그리지 않는다.
+		// (양쪽에서 보이는 우산, rail 은 양면으로 bake 되어 있다)
+		glFrontFace(GL_CCW);
+		glCullFace(GL_BACK);
+		glEnable(GL_CULL_FACE);
 
-	//******************************************
-	//Roller Coaster setting start
-	//******************************************
+		VertexArrayID.create("playground", "vertex array");
+		glBindVertexArray(VertexArrayID);
+		return true;
+	}, { windowReady });
 
-	static GLfloat rail_vertex_buffer[18 * 37] = { 0.0f };
-	makeRailVertexBuffer(rail_vertex_buffer, 37);
-
-	static GLfloat rail_color_buffer[18 * 37] = { 0.0f };
-	makeRailColorBuffer(rail_color_buffer, 37, 1.0f, 1.0f, 0.0f);
+	// Create and compile our GLSL program from the shaders
+	// 하나의 shader source 에서 #define 으로 textured / vertex color permutation 을 모두 미리 만든다.
+	// 이전 실행에서 저장한 program binary 가 있으면 컴파일 없이 바로 사용한다.
+	int shadersRead = startup.addTask("readShaders", STARTUP_WORKER_THREAD, [&]() {
+		if (!readTextFile("TransformVertexShader.vertexshader", vertexShaderSource)
+			|| !readTextFile("ColorFragmentShader.fragmentshader", fragmentShaderSource)) {
+			fprintf(stderr, "Impossible to read the shaders. Are you in the right directory ?\n");
+			return false;
+		}
+		return true;
+	});
+	startup.addTask("buildShaders", STARTUP_MAIN_THREAD, [&]() {
+		if (!buildShaderPermutations(vertexShaderSource, fragmentShaderSource, programs)) {
+			fprintf(stderr, "Failed to build the shader permutations\n");
+			return false;
+		}
+		return true;
+	}, { glReady, shadersRead });
+
+	// Texture bmp 이미지마다 bmp 설정
+	// 텍스처는 백그라운드 스레드에서 읽고(.ptex 가 있으면 mip chain 까지), 올라오기 전까지는 1x1 placeholder 로 그린다.
+	// decode 는 context 가 생기기 전부터 시작한다.
+	int texturesRequested = startup.addTask("requestTextures", STARTUP_WORKER_THREAD, [&]() {
+		textureLoadStart = currentSeconds();
+		textureStreamer.startWorker();
+		TextureFloorHandle = textureStreamer.request("uvtemplate.bmp"); // floor texture
+		TextureWoodHandle = textureStreamer.request("wood.bmp"); // wood texture
+		TextureYellowHandle = textureStreamer.request("yellow.bmp"); // background yellow texture
+		TextureStripHandle = textureStreamer.request("bluestrip.bmp"); // background strip texture
+		return true;
+	});
+	startup.addTask("startTextureUploads", STARTUP_MAIN_THREAD, [&]() {
+		textureStreamer.start();
+		return true;
+	}, { glReady, texturesRequested });
+
+	if (cameraPathFile != NULL) {
+		startup.addTask("loadCameraPath", STARTUP_WORKER_THREAD, [&]() {
+			return cameraPath.load(cameraPathFile);
+		});
+	}
 
 	//******************************************
-	//Roller Coaster setting end
+	//GL 프로그램에서 사용할 buffer setting start
 	//******************************************
-
+	// 모든 놀이기구 geometry 는 scenebaker 로 미리 bake 한 park.scene 을 mmap 해서 그대로 올린다.
+	// 파일이 없거나 geometry revision 이 다르면 여기서 한 번 bake 해서 저장한다.
+	int sceneOpened = startup.addTask("openScene", STARTUP_WORKER_THREAD, [&]() {
+		if (openScene(PARK_SCENE_PATH, PARK_SCENE_REVISION, sceneFile, sceneHeader, scene))
+			return true;
+		printf("Baking %s\n", PARK_SCENE_PATH);
+		if (!bakeParkScene(PARK_SCENE_PATH) || !openScene(PARK_SCENE_PATH, PARK_SCENE_REVISION, sceneFile, sceneHeader, scene)) {
+			fprintf(stderr, "Failed to load %s\n", PARK_SCENE_PATH);
+			return false;
+		}
+		return true;
+	});
+	startup.addTask("uploadScene", STARTUP_MAIN_THREAD, [&]() {
+		uploadScene(sceneFile, sceneHeader, scene);
+		unmapFile(sceneFile);
+		// index buffer 는 VAO 에 묶인다.
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene.indexBuffer);
+
+		// 렌더링에 쓰는 mesh 목록
+		if (!findMesh(scene, "cube", cubeMesh) || !findMesh(scene, "floor", floorMesh)
+			|| !findMesh(scene, "circle", circleMesh) || !findMesh(scene, "cylinderSide", sideMesh)
+			|| !findMesh(scene, "umbrella", umbrellaMesh) || !findMesh(scene, "rail", railMesh)) {
+			fprintf(stderr, "%s is missing meshes, delete it to bake it again\n", PARK_SCENE_PATH);
+			return false;
+		}
+		return true;
+	}, { glReady, sceneOpened });
 	//******************************************
-	//GL α׷  buffer setting start
+	//GL 프로그램에서 사용할 buffer setting end
 	//******************************************
 
-	// cube vertex   
-	GLuint vertexbuffer;
-	glGenBuffers(1, &vertexbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(g_vertex_buffer_data), g_vertex_buffer_data, GL_STATIC_DRAW);
-
-	// texture color   
-	GLuint uvbuffer;
-	glGenBuffers(1, &uvbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(g_uv_buffer_data), g_uv_buffer_data, GL_STATIC_DRAW);
-
-	// ٴ vertex   
-	GLuint rectVertexBuffer;
-	glGenBuffers(1, &rectVertexBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, rectVertexBuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(g_rect_vertex_data), g_rect_vertex_data, GL_STATIC_DRAW);
-
-	// ٴ texture   
-	GLuint rectUVBuffer;
-	glGenBuffers(1, &rectUVBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, rectUVBuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(g_rect_uv_data), g_rect_uv_data, GL_STATIC_DRAW);
+	bool started = startup.run();
+	startup.printTimeline();
+	startup.writeTimeline("startup_timeline.json");
+	if (!started) {
+		unmapFile(sceneFile);
+		textureStreamer.stop();
+		deleteScene(scene);
+		deleteShaderPermutations(programs);
+		VertexArrayID.reset();
+		if (headless) {
+			deleteOffscreenTarget(offscreen);
+			destroyHeadlessContext(headlessContext);
+		} else {
+			getchar();
+			glfwTerminate();
+		}
+		return -1;
+	}
 
-	//******************************************
-	//Merry go round buffer setting start
-	//******************************************
-	GLuint circlebuffer;
-	glGenBuffers(1, &circlebuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, circlebuffer);
-	glBufferData(GL_ARRAY_BUFFER, 38 * 3 * sizeof(GLfloat), g_circle_buffer_data, GL_STATIC_DRAW);
-
-	GLuint circleColor;
-	glGenBuffers(1, &circleColor);
-	glBindBuffer(GL_ARRAY_BUFFER, circleColor);
-	glBufferData(GL_ARRAY_BUFFER, 38 * 3 * sizeof(GLfloat), g_circle_color_data, GL_STATIC_DRAW);
-
-	GLuint circleUV;
-	glGenBuffers(1, &circleUV);
-	glBindBuffer(GL_ARRAY_BUFFER, circleUV);
-	glBufferData(GL_ARRAY_BUFFER, 38 * 2 * sizeof(GLfloat), g_circle_uv_data, GL_STATIC_DRAW);
-
-	//  ̵
-	GLuint sidebuffer;
-	glGenBuffers(1, &sidebuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, sidebuffer);
-	glBufferData(GL_ARRAY_BUFFER, numOfSides * 18 * sizeof(GLfloat), g_side_buffer_data, GL_STATIC_DRAW);
-
-	GLuint side_color_buffer;
-	glGenBuffers(1, &side_color_buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, side_color_buffer);
-	glBufferData(GL_ARRAY_BUFFER, numOfSides * 18 * sizeof(GLfloat), g_side_color_data, GL_STATIC_DRAW);
-
-	GLuint side_uv_buffer;
-	glGenBuffers(1, &side_uv_buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, side_uv_buffer);
-	glBufferData(GL_ARRAY_BUFFER, numOfSides * 12 * sizeof(GLfloat), g_side_uv_data, GL_STATIC_DRAW);
-
-	//  vertex and color  
-	GLuint umbrellaBuffer;
-	glGenBuffers(1, &umbrellaBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, umbrellaBuffer);
-	glBufferData(GL_ARRAY_BUFFER, 8 * 9 * sizeof(GLfloat), umbrella_vertex_data, GL_STATIC_DRAW);
-
-	GLuint umbrellaColor;
-	glGenBuffers(1, &umbrellaColor);
-	glBindBuffer(GL_ARRAY_BUFFER, umbrellaColor);
-	glBufferData(GL_ARRAY_BUFFER, 8 * 9 * sizeof(GLfloat), umbrella_color_data, GL_STATIC_DRAW);
-
-	GLuint umbrellaUV;
-	glGenBuffers(1, &umbrellaUV);
-	glBindBuffer(GL_ARRAY_BUFFER, umbrellaUV);
-	glBufferData(GL_ARRAY_BUFFER, 8 * 6 * sizeof(GLfloat), umbrella_uv_data, GL_STATIC_DRAW);
+	// camera path 를 끝까지 한 번 재생하는 프레임 수 (60fps 기준)
+	if (headless && !cameraPath.empty() && !framesGiven)
+		benchmarkFrames = (int)ceil(cameraPath.duration() * 60.0f) + 1;
+	CameraRecorder cameraRecorder;
+
+	// golden image 이름은 camera path 파일 이름 (camerapaths/coaster.campath -> coaster)
+	std::string goldenName = "fixed";
+	if (cameraPathFile != NULL) {
+		goldenName = cameraPathFile;
+		size_t slash = goldenName.find_last_of("/\\");
+		if (slash != std::string::npos)
+			goldenName = goldenName.substr(slash + 1);
+		size_t dot = goldenName.find_last_of('.');
+		if (dot != std::string::npos)
+			goldenName = goldenName.substr(0, dot);
+	}
+	GoldenCheck goldenCheck(goldenDir != NULL ? goldenDir : "golden", "golden_out", goldenName.c_str(), goldenUpdate);
+	goldenCheck.setTolerance(goldenThreshold, goldenMaxDiff);
+	RGBAImage goldenFrame;
+	if (goldenDir != NULL) {
+		// 매번 같은 그림이 나오도록 texture 가 전부 올라온 다음에 시작한다.
+		while (!textureStreamer.isIdle()) {
+			textureStreamer.update(16 * 1024 * 1024);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		goldenFrame.width = offscreen.width;
+		goldenFrame.height = offscreen.height;
+		goldenFrame.pixels.resize((size_t)offscreen.width * offscreen.height * 4);
+	}
 
-	//******************************************
-	//Merry go round buffer setting end
-	//******************************************
+	// draw call, bind, upload 수와 frame time 통계
+	// headless 모드에서는 모든 프레임의 percentile 을 리포트하도록 window 를 프레임 수만큼 잡는다.
+	RenderStats renderStats(headless ? benchmarkFrames : 240);
+	renderStats.setPrintInterval(statsInterval);
+	if (statsCsvPath != NULL)
+		renderStats.openCsv(statsCsvPath);
+	RenderStateCache renderState(programs, &renderStats.frame());
+	StatsHud statsHud;
+	statsHud.init();
+	bool hudKeyDown = false;
+	// 프레임 단위 CPU/GPU 시간 측정. 종료할 때 frame_trace.json 으로 저장한다.
+	FrameProfiler profiler;
+	profiler.init();
+	// 불투명 pass 의 overdraw 측정. 화면 sample 수는 MSAA sample 수까지 곱한 값이다.
+	OverdrawMeter overdrawMeter;
+	overdrawMeter.init();
+	GLint framebufferSamples = 0;
+	glGetIntegerv(GL_SAMPLES, &framebufferSamples);
+	if (framebufferSamples < 1)
+		framebufferSamples = 1;
+	OpaqueQueue opaqueQueue;
+	// dynamic resolution: 장면 FBO 와 그 해상도 / sample 수를 고르는 controller
+	GLint maxSamples = 0;
+	glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+	ResolutionController resolution(targetFps, std::min(msaaSamples, (int)maxSamples), minScale);
+	DynamicResolutionTarget dynamicTarget;
+	double scaleSum = 0.0;
+	if (dynamicResolution) {
+		dynamicTarget.init(upscaleFilter);
+		printf("Dynamic resolution: %.1f ms budget, %d levels down to %.0f%% scale, %s upscale\n",
+			resolution.budgetMs(), resolution.levelCount(), minScale * 100.0f, upscaleFilterName(upscaleFilter));
+	}
+	// 지형. 보이는 chunk 는 background thread 가 만들고 매 프레임 정해진 양만큼 올린다.
+	Terrain terrain;
+	double terrainSelectMs = 0.0, terrainDrawnSum = 0.0;
+	size_t terrainWaitBytes = 0;
+	if (!flatFloor) {
+		if (!terrain.init((size_t)terrainMemoryMB * 1024 * 1024)) {
+			fprintf(stderr, "Failed to set up the terrain, drawing the flat floor\n");
+			flatFloor = true;
+		} else {
+			printf("Terrain: %.0f units across, %d levels, %d chunk slots (%.1f MB)\n", TERRAIN_SIZE, TERRAIN_LEVELS,
+				terrain.poolCapacity(), terrain.poolBytes() / (1024.0 * 1024.0));
+		}
+	}
+	// GPU 애니메이션 놀이기구. instance 는 한 번만 올리고 매 프레임 part 마다 instanced draw 한 번씩 한다.
+	// --flat-rides 의 놀이기구는 rideCells 가 카메라 근처 cell 만 올리고, 그 instance 도 animatedRides 가 그린다.
+	AnimatedRides animatedRides;
+	RideCells rideCells;
+	bool streamRides = rideCellsEnabled && flatRides > 0;
+	float rideAnimationError = 0.0f;
+	double rideCellSelectMs = 0.0, rideCellDrawnSum = 0.0, rideCellRidesSum = 0.0;
+	if (gpuRides || flatRides > 0) {
+		std::vector<RideInstance> rideInstances[RIDE_TYPE_COUNT];
+		if (gpuRides) {
+			rideInstances[RIDE_TYPE_VIKING].push_back(parkVikingInstance());
+			rideInstances[RIDE_TYPE_MERRY_GO_ROUND].push_back(parkMerryGoRoundInstance());
+		}
+		if (!streamRides)
+			layoutFlatRides(flatRides, rideInstances);
+		// 공원 밖의 놀이기구는 언덕 위에 세운다. 비탈에서는 받침이 뜨지 않도록 가장 낮은 곳에 맞춘다.
+		if (!flatFloor) {
+			for (int type = 0; type < RIDE_TYPE_COUNT; type++)
+				standRidesOnGround(rideInstances[type], terrainHeight, TERRAIN_FLOOR_Y);
+		}
+		if (!animatedRides.init(scene, programs, rideInstances)) {
+			fprintf(stderr, "Failed to set up the animated rides\n");
+			gpuRides = false;
+			streamRides = false;
+		} else {
+			// shader 가 계산한 행렬이 CPU 기준 구현 (rideModel) 과 같은지 여러 시간에서 확인한다.
+			const float verifyTimes[] = { 0.0f, 0.37f, 1.5f, 4.0f, 17.25f, 95.0f };
+			bool matched = animatedRides.verify(vertexShaderSource, verifyTimes, sizeof(verifyTimes) / sizeof(verifyTimes[0]),
+				1e-3f, rideAnimationError);
+			printf("Ride animation: %d rides, %d parts, GPU %s the CPU reference (max error %g)\n", animatedRides.instanceCount(),
+				animatedRides.partCount(), matched ? "matches" : "DIFFERS FROM", rideAnimationError);
+		}
+	}
+	if (streamRides) {
+		float reach[RIDE_TYPE_COUNT], bobReach[RIDE_TYPE_COUNT];
+		animatedRides.rideReach(reach, bobReach);
+		rideCells.init(flatRides, flatFloor ? NULL : terrainHeight, TERRAIN_FLOOR_Y, reach, bobReach, (size_t)rideCellMemoryKB * 1024);
+		printf("Ride cells: %d rides in cells %.0f units across, loaded within %.0f units, %d cell slots (%.1f KB)\n", flatRides,
+			RIDE_CELL_SIZE, RIDE_CELL_LOAD_RADIUS, rideCells.poolCapacity(), rideCells.poolBytes() / 1024.0);
+	}
+	// particle 과 방문객 update 를 나눠 처리하는 thread
+	WorkerPool workerPool;
+	if (particleCapacity > 0 || crowdSize > 0)
+		workerPool.start(workerThreads);
+	// particle 효과. 바닥 (y = -3) 에서 튀어 오르고, 불꽃은 각 놀이기구 위에서 터진다.
+	ParticleSystem particles;
+	ParticleRenderer particleRenderer;
+	double particleRenderMs = 0.0;
+	if (particleCapacity > 0) {
+		particles.init(particleCapacity, &workerPool, -3.0f);
+		particles.addFireworks(vec3(-2.0f, 3.0f, 2.0f));  // 바이킹
+		particles.addFireworks(vec3(6.0f, 3.0f, 6.0f));   // 회전목마
+		particles.addFireworks(vec3(4.0f, 6.0f, 4.0f));   // 롤러코스터
+		particles.addFountain(vec3(-8.0f, -3.0f, 10.0f));
+		particles.addConfetti(vec3(14.0f, -3.0f, 4.0f));  // 롤러코스터 승강장 (차가 출발하는 곳)
+		if (!particleRenderer.init(particleCapacity)) {
+			fprintf(stderr, "Failed to set up the particle renderer\n");
+			particleCapacity = 0;
+		} else {
+			printf("Particles: up to %d, %d emitters, %d threads\n", particleCapacity, particles.emitterCount(),
+				workerPool.threadCount());
+		}
+	}
+	// 방문객. 놀이기구 (와 롤러코스터 기둥) 는 피해서 걷는다.
+	Crowd crowd;
+	CrowdRenderer crowdRenderer;
+	double crowdRenderMs = 0.0;
+	double crowdDrawnSum[CROWD_LOD_COUNT] = { 0.0, 0.0, 0.0 };
+	double crowdCulledSum = 0.0;
+	if (crowdSize > 0) {
+		std::vector<CrowdDestination> destinations(3);
+		destinations[0].position = vec2(-2.0f, 7.0f);   // 바이킹 앞
+		destinations[1].position = vec2(6.0f, 11.5f);   // 회전목마 앞
+		destinations[2].position = vec2(16.0f, 7.5f);   // 롤러코스터 승강장
+		const CrowdObstacle obstacles[] = {
+			{ vec2(-2.0f, 2.0f), 2.8f }, { vec2(6.0f, 6.0f), 3.3f },
+			{ vec2(14.0f, 4.0f), 0.5f }, { vec2(-6.0f, 4.0f), 0.5f }, { vec2(5.25f, 13.92f), 0.5f }, { vec2(5.25f, -5.92f), 0.5f }
+		};
+		crowd.init(crowdSize, &workerPool, destinations,
+			std::vector<CrowdObstacle>(obstacles, obstacles + sizeof(obstacles) / sizeof(obstacles[0])));
+		if (!crowdRenderer.init(crowdSize)) {
+			fprintf(stderr, "Failed to set up the crowd renderer\n");
+			crowdSize = 0;
+		} else {
+			printf("Crowd: %d visitors, queue areas %.1f units across, %d threads\n", crowdSize, crowd.queueRadius() * 2.0f,
+				workerPool.threadCount());
+		}
+	}
+	bool texturesReported = false;
+	GLuint TextureFloor, TextureWood, TextureYellow, TextureStrip;
 
-	//******************************************
-	//Roller Coaster setting start
-	//******************************************
+	// For speed computation
+	double lastTime = currentSeconds();
+	double lastFrameTime = lastTime;
+	double startupMs = (lastTime - processStart) * 1000.0;
+	int renderedFrames = 0;
+	// 놀이기구 애니메이션 상태 (rides.cpp)
+	VikingRide viking;
+	MerryGoRoundRide merryGoRound;
+	RollerCoasterRide rollerCoaster;
+	initViking(viking);
+	initMerryGoRound(merryGoRound);
+	initRollerCoaster(rollerCoaster);
+
+	// 바닥(Floor) 데이터 설정 (Floor는 Texture Mapping을 한다)
+	glm::mat4 ModelFloor = scale(mat4(), vec3(20.0f, 1.0f, 20.0f)) * translate(mat4(), vec3(0.0f, -3.0f, 0.0f)) * glm::mat4(1.0f);
+	// 놀이기구 부품의 BVH. 보이는 부품만 queue 에 넣고 (frustum culling), 십자선 picking 에도 쓴다.
+	// 움직이는 부품 (바이킹 배, 회전목마, 롤러코스터 차) 만 매 프레임 refit 하고, tree 는 물체가 바뀔 때만 다시 만든다.
+	// 추가하는 순서가 submission 순서이다.
+	SceneIndex sceneIndex;
+	std::vector<ParkDraw> parkDraws;
+	// 바닥 (모든 놀이기구 밑에 깔리므로 front-to-back 에서는 ground layer 로 맨 나중에 그린다)
+	// 지형을 쓰면 지형이 따로 culling 하고 불투명 pass 의 맨 끝에 그린다.
+	if (flatFloor)
+		addParkObject(sceneIndex, parkDraws, "PARK", "FLOOR", floorMesh, &ModelFloor, &TextureFloor, false, DRAW_LAYER_GROUND);
+	// --gpu-rides 면 바이킹과 회전목마는 아래에서 animatedRides 의 instance 로 들어간다.
+	if (!gpuRides) {
+		//***********************
+		// Viking
+		//***********************
+		// 바이킹 윗 기둥, viking 의 최상단 부분은 yellow texture로 mapping 한다.
+		addParkObject(sceneIndex, parkDraws, "VIKING SHIP", "TOP BEAM", cubeMesh, &viking.models[VIKING_TOP_BEAM], &TextureYellow, false);
+		// 바이킹 아래 기둥
+		addParkObject(sceneIndex, parkDraws, "VIKING SHIP", "BOAT", cubeMesh, &viking.models[VIKING_BOAT], &TextureWood, true);
+		// 바이킹 세로 기둥 2개 (대각선 기둥)
+		addParkObject(sceneIndex, parkDraws, "VIKING SHIP", "ARM", cubeMesh, &viking.models[VIKING_ARM_LEFT], &TextureWood, true);
+		addParkObject(sceneIndex, parkDraws, "VIKING SHIP", "ARM", cubeMesh, &viking.models[VIKING_ARM_RIGHT], &TextureWood, true);
+		// 바이킹 천장을 받치는 4개 기둥
+		for (int i = VIKING_LEG_1; i <= VIKING_LEG_4; i++)
+			addParkObject(sceneIndex, parkDraws, "VIKING SHIP", "LEG", cubeMesh, &viking.models[i], &TextureWood, false);
 
-	GLuint railBuffer;
-	glGenBuffers(1, &railBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, railBuffer);
-	glBufferData(GL_ARRAY_BUFFER, 37 * 18 * sizeof(GLfloat), rail_vertex_buffer, GL_STATIC_DRAW);
+		//***********************
+		// Merry-go-round (전부 돈다)
+		//***********************
+		// 2-1, 2-2. 회전목마 원기둥 윗 원, 밑 원
+		addParkObject(sceneIndex, parkDraws, "MERRY-GO-ROUND", "TOP", circleMesh, &merryGoRound.models[MGR_TOP], &TextureYellow, true);
+		addParkObject(sceneIndex, parkDraws, "MERRY-GO-ROUND", "BOTTOM", circleMesh, &merryGoRound.models[MGR_BOTTOM], &TextureYellow, true);
+		// 2-3. 원기둥 사이드 with Texture Wood
+		addParkObject(sceneIndex, parkDraws, "MERRY-GO-ROUND", "SIDE", sideMesh, &merryGoRound.models[MGR_SIDE], &TextureWood, true);
+		// 2-4. 2번째 원기둥 with texture
+		addParkObject(sceneIndex, parkDraws, "MERRY-GO-ROUND", "CENTER POLE", sideMesh, &merryGoRound.models[MGR_POLE], &TextureWood, true);
+		// 2-5. 우산 (Texture)
+		addParkObject(sceneIndex, parkDraws, "MERRY-GO-ROUND", "UMBRELLA", umbrellaMesh, &merryGoRound.models[MGR_UMBRELLA], &TextureYellow, true);
+		// 2-6 ~ 2-9. 서브 원기둥 with texture
+		for (int i = MGR_SUB_POLE_1; i <= MGR_SUB_POLE_4; i++)
+			addParkObject(sceneIndex, parkDraws, "MERRY-GO-ROUND", "POLE", sideMesh, &merryGoRound.models[i], &TextureWood, true);
+		// 2-10 ~ 2-13. 원기둥 위에 올라갈 큐브 (회전목마 cube 부분은 strip texture로 mapping 한다.)
+		for (int i = MGR_SEAT_1; i <= MGR_SEAT_4; i++)
+			addParkObject(sceneIndex, parkDraws, "MERRY-GO-ROUND", "SEAT", cubeMesh, &merryGoRound.models[i], &TextureStrip, true);
+	}
 
-	GLuint railColor;
-	glGenBuffers(1, &railColor);
-	glBindBuffer(GL_ARRAY_BUFFER, railColor);
-	glBufferData(GL_ARRAY_BUFFER, 37 * 18 * sizeof(GLfloat), rail_color_buffer, GL_STATIC_DRAW);
+	//***********************
+	// 3. Roller Coaster
+	//***********************
+	// 3-1. Rail (texture 없이 vertex color 로 그린다)
+	addParkObject(sceneIndex, parkDraws, "ROLLER COASTER", "RAIL", railMesh, &rollerCoaster.models[COASTER_RAIL], NULL, false);
+	// 3-2 ~ 3-5. Roller Coaster Cube (롤러코스트 cube 부분은 strip texture로 mapping 한다.)
+	for (int i = COASTER_CAR_1; i <= COASTER_CAR_4; i++)
+		addParkObject(sceneIndex, parkDraws, "ROLLER COASTER", "CAR", cubeMesh, &rollerCoaster.models[i], &TextureStrip, true);
+	// 3-6 ~ 3-9. Roller Coaster Cube (Rail 받침)
+	for (int i = COASTER_SUPPORT_1; i <= COASTER_SUPPORT_4; i++)
+		addParkObject(sceneIndex, parkDraws, "ROLLER COASTER", "SUPPORT", cubeMesh, &rollerCoaster.models[i], &TextureWood, false);
+
+	// GPU 애니메이션 놀이기구는 어떤 각도에서도 다 들어가는 상자 하나씩으로 넣는다 (움직이지 않는 물체).
+	std::vector<Aabb> rideBoxes;
+	animatedRides.rideBounds(rideBoxes);
+	for (int type = 0, ride = 0; type < RIDE_TYPE_COUNT; type++) {
+		for (int i = 0; i < animatedRides.instanceCount((RideType)type); i++, ride++) {
+			SceneObject object = { type == RIDE_TYPE_VIKING ? "VIKING SHIP" : "MERRY-GO-ROUND", NULL,
+				rideBoxes[ride].min, rideBoxes[ride].max, NULL, false };
+			sceneIndex.add(object);
+			ParkDraw draw = { NULL, NULL, NULL, DRAW_LAYER_DEFAULT, ride };
+			parkDraws.push_back(draw);
+		}
+	}
+	// 이번 프레임에 보이는 물체와 GPU 애니메이션 놀이기구, culling / pick 통계
+	std::vector<uint32_t> visibleObjects, visibleRides;
+	double cullMs = 0.0, visibleSum = 0.0, pickMs = 0.0;
+	long long picks = 0;
+	bool pickButtonDown = false;
 
-	//******************************************
-	//Roaller Coaster setting end
-	//******************************************
+	do {
+		profiler.beginFrame();
+		double frameStart = currentSeconds();
+
+		profiler.beginScope("textureStreaming");
+		// 한 프레임에 정해진 양만큼만 텍스처를 올린다. 다 올라오기 전에는 placeholder 가 반환된다.
+		renderStats.frame().uploadBytes += textureStreamer.update(2 * 1024 * 1024);
+		TextureFloor = textureStreamer.texture(TextureFloorHandle);
+		TextureWood = textureStreamer.texture(TextureWoodHandle);
+		TextureYellow = textureStreamer.texture(TextureYellowHandle);
+		TextureStrip = textureStreamer.texture(TextureStripHandle);
+		if (!texturesReported && textureStreamer.isIdle()) {
+			printf("All textures resident after %.2f ms\n", (currentSeconds() - textureLoadStart) * 1000.0);
+			texturesReported = true;
+		}
+		profiler.endScope();
+		// 다 만들어진 지형 chunk 도 정해진 양만큼만 올린다. 아직 없는 chunk 자리에는 한 단계 큰 chunk 를 그린다.
+		if (!flatFloor) {
+			profiler.beginScope("terrainStreaming");
+			renderStats.frame().uploadBytes += terrain.update((size_t)terrainBudgetKB * 1024);
+			profiler.endScope();
+		}
+		// 놀이기구 cell 도 다 만들어진 것을 정해진 양만큼만 올린다.
+		if (streamRides) {
+			profiler.beginScope("rideCellStreaming");
+			renderStats.frame().uploadBytes += rideCells.update((size_t)rideCellBudgetKB * 1024);
+			profiler.endScope();
+		}
 
-	// For speed computation
-	double lastTime = glfwGetTime();
-	double lastFrameTime = lastTime;
-	vec3 gOrientation1, gOrientation2; // gOrientation1 - ŷ .
-	int flag = 0;
-	// Merry go round     Setting Start
-	vec3 gPosForMGR7(0.0f, 2.0f, -1.0f);
-	vec3 gPosForMGR8(0.0f, -2.0f, 1.0f);
-	vec3 gPosForMGR9(2.0f, 0.0f, -0.5f);
-	vec3 gPosForMGR10(-2.0f, 0.0f, 0.5f);
-	vec3 gOrientForMGRSub;
-	int flagForSub1 = 0;
-	int flagForSub2 = 0;
-	int flagForSub3 = 0;
-	int flagForSub4 = 0;
-	// Merry go round     Setting end
-
-	// Roller Coaster   Cube ġ, ȸ vec3
-	float doublePi = 2.0 * 3.141592f; // 2 * PI
-
-	// Roller Coaster Rail  ִ 4 ť꿡  ʱ 
-	float angle = 2.0 * 3.141592f; 
-	float angle2 = 2.0 * 3.141592f - (3.141592f / 2.0f);
-	float angle3 = 3.141592f;
-	float angle4 = 3.141592f / 2.0f;
-
-	float height = 0.0f, height2 = 0.0f, height3 = 0.0f, height4 = 0.0f; // Roller Coaster Rail  ִ 4 ť꿡  ̰(y)
-	float result = 0.0f, result2 = 0.0f, result3 = 0.0f, result4 = 0.0f; // Roller Coaster Rail  ִ 4 ť꿡  
-	float yDiff = 0.0f, yDiff2 = 0.0f, yDiff3 = 0.0f, yDiff4 = 0.0f; // Roller Coaster Rail  ִ 4 ť꿡  y 
-	float tempY = 0.0f, tempY2 = 0.0f, tempY3 = 0.0f, tempY4 = 0.0f; // Roller Coaster Rail  ִ 4 ť꿡  y  ӽð
-	float angVel = 0.0f, angVel2 = 0.0f, angVel3 = 0.0f, angVel4 = 0.0f; // Roller Coaster Rail  ִ 4 ť꿡  ӽ ӵ
-	// Roller Coaster Rail  ִ 4 ť꿡  ̵ 
-	vec3 gPosForRC(10.0f, 2.0f * (2.0f * cos(doublePi)) + 2.0f, 0.0f);
-	vec3 gPosForRC2(10.0f, 2.0f * (2.0f * cos(doublePi)) + 2.0f, 0.0f);
-	vec3 gPosForRC3(10.0f, 2.0f * (2.0f * cos(doublePi)) + 2.0f, 0.0f);
-	vec3 gPosForRC4(10.0f, 2.0f * (2.0f * cos(doublePi)) + 2.0f, 0.0f);
-	// Roller Coaster Rail  ִ 4 ť꿡  ȸ 
-	vec3 gOrientForRC(0.0f, 0.0f, 0.0f);
-	vec3 gOrientForRC2(0.0f, 0.0f, 0.0f);
-	vec3 gOrientForRC3(0.0f, 0.0f, 0.0f);
-	vec3 gOrientForRC4(0.0f, 0.0f, 0.0f);
+		// window 크기는 바뀔 수 있으므로 매 프레임 framebuffer 크기를 읽는다 (dynamic resolution, overdraw, HUD)
+		int framebufferWidth = screenWidth, framebufferHeight = screenHeight;
+		if (!headless)
+			glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		// 장면을 그리는 target 의 크기와 sample 수
+		int sceneWidth = framebufferWidth, sceneHeight = framebufferHeight, sceneSamples = framebufferSamples;
+		if (dynamicResolution && dynamicTarget.begin(framebufferWidth, framebufferHeight, resolution.scale(), resolution.samples())) {
+			sceneWidth = dynamicTarget.scene().width;
+			sceneHeight = dynamicTarget.scene().height;
+			sceneSamples = dynamicTarget.scene().samples;
+		}
 
-	do {
 		// Clear the screen
+		profiler.beginScope("clear", true);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glDisable(GL_CULL_FACE);
-		// Use our shader
-		glUseProgram(programID);
+		profiler.endScope();
+		// texture streamer 가 texture binding 을 바꾸므로 매 프레임 처음에는 다시 bind 하도록 한다.
+		renderState.invalidate();
 
-		// ȸϱ deltaTime Ѵ.
-		double currentTime = glfwGetTime();
+		//지속적으로 회전하기위해 deltaTime값을 구한다.
+		double currentTime = currentSeconds();
 		float deltaTime = (float)(currentTime - lastFrameTime);
 		lastFrameTime = currentTime;
+		// headless 모드는 매번 같은 장면이 나오도록 60fps 기준 고정 시간 간격으로 움직인다.
+		if (headless)
+			deltaTime = 1.0f / 60.0f;
 
+		profiler.beginScope("update");
+		profiler.beginScope("camera");
 		//***************************
-		//View  
-		//***************************
-		// start Keyboard Mouse  View ī޶ 		
-		computeMatricesFromInputs();
-		glm::mat4 Projection = getProjectionMatrix();
-		glm::mat4 View = getViewMatrix();
-
-		// ٴ(Floor)   (Floor Texture Mapping Ѵ)
-		glm::mat4 ModelFloor = scale(mat4(), vec3(20.0f, 1.0f, 20.0f)) * translate(mat4(), vec3(0.0f, -3.0f, 0.0f)) * glm::mat4(1.0f);
-		glm::mat4 basicMVP = Projection * View * ModelFloor; // Remember, matrix multiplication is the other way around		
-
-		//***************************
-		//1. Viking   
+		//View 시점 설정
 		//***************************
-
-		//x,z鿡 ġ Ų   (1 Transition Matrix  )
-		vec3 gPosition1(0.0f, 1.0f, 0.0f);
-		vec3 gPosition2(0.0f, 2.0f, 0.0f);
-		vec3 gPosForVike(1.1f, 1.5f, 1.1f);
-		vec3 gOrientForVike(3.14f / 5.0f, 3.14f / 5.0f, 0.0f);
-
-		gOrientation1.x = 3.14f;
-		gOrientation1.y = 0.0f;
-
-		//谪 Ѿ flag
-		if (gOrientation1.z > 1.2f)
-			flag = 1;
-		else if (gOrientation1.z < -1.2f)
-			flag = 0;
-
-		//1.2f Ѿ +, -1.2f ۾ -
-		if (flag == 1) {
-			gOrientation1.z -= 3.14159f / 2.0f * deltaTime * (cos(gOrientation1.z) * cos(gOrientation1.z));
-		}
-		else {
-			gOrientation1.z += 3.14159f / 2.0f * deltaTime * (cos(gOrientation1.z) * cos(gOrientation1.z));
+		// start Keyboard와 Mouse 관련 View 카메라 설정		
+		glm::mat4 Projection, View;
+		// camera path 시간은 headless 모드에서는 고정 간격, window 모드에서는 실제 경과 시간
+		float cameraTime = headless ? renderedFrames / 60.0f : (float)(currentTime - lastTime);
+		if (!cameraPath.empty()) {
+			Projection = cameraPath.projectionMatrix(cameraTime, (float)screenWidth / (float)screenHeight);
+			View = cameraPath.viewMatrix(cameraTime);
+		} else if (headless) {
+			// 입력이 없으므로 공원 전체가 보이는 고정 카메라
+			Projection = glm::perspective(glm::radians(45.0f), (float)screenWidth / (float)screenHeight, 0.1f, 100.0f);
+			View = glm::lookAt(vec3(0.0f, 15.0f, 30.0f), vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f));
+		} else {
+			computeMatricesFromInputs();
+			Projection = getProjectionMatrix();
+			View = getViewMatrix();
+			if (recordCameraFile != NULL)
+				cameraRecorder.record(cameraTime, View, Projection);
 		}
 
-		//1-1. ŷ  ¸   Matrix 
-		glm::mat4 transMatForVikeAll = translate(mat4(), vec3(-2.0f, 0.0f, 2.0f));
-		glm::mat4 transMatForVike1 = translate(mat4(), gPosition1); // A bit to the left
-		glm::mat4 rotMatForVike1 = eulerAngleYXZ(gOrientation1.y, gOrientation1.x, gOrientation1.z);
-		glm::mat4 scalMatForVike1 = scale(mat4(), vec3(0.1f, 1.15f, 0.1f));
-		glm::mat4 modelForVike1 = glm::mat4(1.0f);
-		modelForVike1 = modelForVike1 * transMatForVikeAll * rotMatForVike1*transMatForVike1* scalMatForVike1;
-		glm::mat4 MVPForVike = Projection * View * modelForVike1; // Remember, matrix multiplication is the other way around				
-
-		//1-2. ŷ  ¸   Matrix .
-		glm::mat4 transMatForVike2 = translate(mat4(), vec3(gPosition1.x, gPosition1.y - 0.15, gPosition1.z)); // A bit to the left
-		glm::mat4 rotMatForVike2 = eulerAngleYXZ(0.0f, 0.0f, 0.0f);
-		glm::mat4 scalMatForVike2 = scale(mat4(), vec3(0.6f, 0.1f, 0.6f));
-		glm::mat4 modelForVike2 = glm::mat4(1.0f);
-		modelForVike2 = modelForVike2 * transMatForVikeAll * scalMatForVike2 * transMatForVike2;
-		glm::mat4 MVPForVike2 = Projection * View * modelForVike2; // Remember, matrix multiplication is the other way around
-
-		//1-3. ŷ Ʒ ¸   Matrix .
-		glm::mat4 transMatForVike3 = translate(mat4(), vec3(gPosition2.x, gPosition2.y, gPosition2.z)); // A bit to the left
-		glm::mat4 rotMatForVike3 = eulerAngleYXZ(gOrientation1.y, 0.0f, 0.0f);
-		glm::mat4 scalMatForVike3 = scale(mat4(), vec3(1.5f, 0.3f, 0.3f));
-		glm::mat4 modelForVike3 = glm::mat4(1.0f);
-		modelForVike3 = modelForVike3 * transMatForVikeAll * rotMatForVike1 * transMatForVike3 * scalMatForVike3;
-		glm::mat4 MVPForVike3 = Projection * View * modelForVike3; // Remember, matrix multiplication is the other way around
-
-		//1-4. ŷ   Matrix 
-		glm::mat4 rotMatForVike4 = eulerAngleYXZ(gOrientation1.y, gOrientation1.x, 3.14f / 8.0f + gOrientation1.z);
-		glm::mat4 modelForVike4 = glm::mat4(1.0f);
-		modelForVike4 = modelForVike4 * transMatForVikeAll * rotMatForVike4* transMatForVike1* scalMatForVike1;
-		glm::mat4 MVPForVike4 = Projection * View * modelForVike4; // Remember, matrix multiplication is the other way around
-
-		//1-5. ŷ   Matrix 
-		glm::mat4 rotMatForVike5 = eulerAngleYXZ(gOrientation1.y, gOrientation1.x, -(3.14f / 8.0f) + gOrientation1.z);
-		glm::mat4 modelForVike5 = glm::mat4(1.0f);
-		modelForVike5 = modelForVike5 * transMatForVikeAll * rotMatForVike5* transMatForVike1 * scalMatForVike1;
-		glm::mat4 MVPForVike5 = Projection * View * modelForVike5; // Remember, matrix multiplication is the other way around
-
-		//1-6. ŷ õ ġ (1)
-		glm::mat4 transMatForVike6 = translate(mat4(), vec3(-gPosForVike.x, -gPosForVike.y, -gPosForVike.z));
-		glm::mat4 scalMatForVike6 = scale(mat4(), vec3(0.1f, 2.0f, 0.1f));
-		glm::mat4 rotMatForVike6 = eulerAngleYXZ(gOrientForVike.y, gOrientForVike.x, gOrientForVike.z);
-		glm::mat4 modelForVike6 = transMatForVikeAll * transMatForVike6 * rotMatForVike6 * scalMatForVike6 * glm::mat4(1.0f);
-		glm::mat4 MVPForVike6 = Projection * View * modelForVike6; // Remember, matrix multiplication is the other way around				
-
-		//1-6. ŷ õ ġ (2)
-		glm::mat4 transMatForVike7 = translate(mat4(), vec3(-gPosForVike.x, -gPosForVike.y, gPosForVike.z));
-		glm::mat4 rotMatForVike7 = eulerAngleYXZ(3.14f - gOrientForVike.y, gOrientForVike.x, gOrientForVike.z);
-		glm::mat4 modelForVike7 = transMatForVikeAll * transMatForVike7 * rotMatForVike7 * scalMatForVike6 * glm::mat4(1.0f);
-		glm::mat4 MVPForVike7 = Projection * View * modelForVike7; // Remember, matrix multiplication is the other way around				
-
-		//1-6. ŷ õ ġ (3)		
-		glm::mat4 transMatForVike8 = translate(mat4(), vec3(gPosForVike.x, -gPosForVike.y, -gPosForVike.z));
-		glm::mat4 rotMatForVike8 = eulerAngleYXZ(3.14f - gOrientForVike.y, 3.14f - gOrientForVike.x, gOrientForVike.z);
-		glm::mat4 modelForVike8 = transMatForVikeAll * transMatForVike8 * rotMatForVike8 * scalMatForVike6 * glm::mat4(1.0f);
-		glm::mat4 MVPForVike8 = Projection * View * modelForVike8; // Remember, matrix multiplication is the other way around				
-
-																   //1-6. ŷ õ ġ (4)	
-		glm::mat4 transMatForVike9 = translate(mat4(), vec3(gPosForVike.x, -gPosForVike.y, gPosForVike.z));
-		glm::mat4 rotMatForVike9 = eulerAngleYXZ(gOrientForVike.y, 3.14f - gOrientForVike.x, gOrientForVike.z);
-		glm::mat4 modelForVike9 = transMatForVikeAll * transMatForVike9 * rotMatForVike9 * scalMatForVike6 * glm::mat4(1.0f);
-		glm::mat4 MVPForVike9 = Projection * View * modelForVike9; // Remember, matrix multiplication is the other way around				
+		glm::mat4 ViewProjection = Projection * View; // Remember, matrix multiplication is the other way around
 
-		//***************************
-		//Viking   
-		//***************************
+		profiler.endScope();
 
-		//***************************
-		//2. ȸ   
-		//***************************
-		vec3 gPosForMGR(6.0f, 0.0f, 6.0f); // ȸ ̱ⱸ ü  translation 
-		glm::mat4 transMatForMGRAll = translate(mat4(), gPosForMGR); // A bit to the left
-		gOrientation2.x = 0.0f;
-		gOrientation2.y += 3.141592f / 2.0f * deltaTime;
-		gOrientation2.z = 0.0f;
-
-		//  
-		glm::mat4 transMatForMGR1 = translate(mat4(), vec3(0.0f, -2.0f, 0.0f)); // A bit to the left
-		glm::mat4 rotMatForMGR1 = eulerAngleYXZ(gOrientation2.y, gOrientation2.x, gOrientation2.z);
-		glm::mat4 scalMatForMGR1 = scale(mat4(), vec3(3.0f, 1.0f, 3.0f));
-		glm::mat4 modelForMGR1 = glm::mat4(1.0f);
-		modelForMGR1 = modelForMGR1 * transMatForMGRAll * scalMatForMGR1 * rotMatForMGR1 * transMatForMGR1;
-		glm::mat4 MVPForMGR1 = Projection * View * modelForMGR1; // Remember, matrix multiplication is the other way around
-
-		// ظ 
-		vec3 gPosForMGR3(0.0f, -3.0f, 0.0f);
-		glm::mat4 transMatForMGR3 = translate(mat4(), gPosForMGR3); // A bit to the left
-		glm::mat4 modelForMGR3 = glm::mat4(1.0f);
-		modelForMGR3 = modelForMGR3 * transMatForMGRAll * scalMatForMGR1 * transMatForMGR3 * rotMatForMGR1;
-		glm::mat4 MVPForMGR3 = Projection * View * modelForMGR3; // Remember, matrix multiplication is the other way around	
-
-		//  ̵ κ
-		vec3 gPosForMGR4(0.0f, -2.5f, 0.0f);
-		glm::mat4 transMatForMGR4 = translate(mat4(), gPosForMGR4); // A bit to the left
-		glm::mat4 rotMatForMGR4 = eulerAngleYXZ(gOrientation2.y, 0.0f, 0.0f);
-		glm::mat4 scalMatForMGR4 = scale(mat4(), vec3(1.0f, 1.0f, 1.0f));
-		glm::mat4 modelForMGR4 = glm::mat4(1.0f);
-		modelForMGR4 = modelForMGR4 * transMatForMGRAll * scalMatForMGR1 * rotMatForMGR4 * transMatForMGR4;
-		glm::mat4 MVPForMGR4 = Projection * View * modelForMGR4; // Remember, matrix multiplication is the other way around	
-
-		//    κ
-		vec3 gPosForMGR5(0.0f, 0.0f, 0.0f);
-		glm::mat4 transMatForMGR5 = translate(mat4(), gPosForMGR5); // A bit to the left
-		glm::mat4 scalMatForMGR5 = scale(mat4(), vec3(0.1f, 4.0f, 0.1f));
-		glm::mat4 modelForMGR5 = glm::mat4(1.0f);
-		modelForMGR5 = modelForMGR5 * transMatForMGRAll * scalMatForMGR5 * rotMatForMGR4 * transMatForMGR5;
-		glm::mat4 MVPForMGR5 = Projection * View * modelForMGR5; // Remember, matrix multiplication is the other way around	
-
-		//  
-		vec3 gPosForMGR6(0.0f, 1.5f, 0.0f);
-		glm::mat4 transMatForMGR6 = translate(mat4(), gPosForMGR6); // A bit to the left
-		glm::mat4 scalMatForMGR6 = scale(mat4(), vec3(2.0f, 1.0f, 2.0f));
-		glm::mat4 modelForMGR6 = glm::mat4(1.0f);
-		modelForMGR6 = modelForMGR6 * transMatForMGRAll * scalMatForMGR6 * rotMatForMGR4 * transMatForMGR6;
-		glm::mat4 MVPForMGR6 = Projection * View * modelForMGR6; // Remember, matrix multiplication is the other way around	
-
-		//Merry go round     4  Matrix 
-		//谪 Ѿ flag. ȸ   ϱ  ڵ
-		if (gPosForMGR7.z < -2.0f)
-			flagForSub1 = 1;
-		else if (gPosForMGR7.z > -1.0f)
-			flagForSub1 = 0;
-
-		//-5.0f ۾ +, -1.0f Ŀ -
-		if (flagForSub1 == 1)
-			gPosForMGR7.z += 1.0f*deltaTime;
-		else
-			gPosForMGR7.z -= 1.0f*deltaTime;
+		// --gpu-rides 면 바이킹과 회전목마는 vertex shader 가 움직이므로 CPU 에서 할 일이 없다.
+		if (!gpuRides) {
+			profiler.beginScope("viking");
+			updateViking(viking, deltaTime);
+			profiler.endScope();
 
-		glm::mat4 transMatForY = translate(mat4(), vec3(0.0f, -3.0f, 0.0f));
-
-		// merry go round ִ 4    Matrix 
-		glm::mat4 transMatForMGR7 = translate(mat4(), gPosForMGR7); // A bit to the left
-		glm::mat4 rotMatForMGR7 = eulerAngleYXZ(gOrientForMGRSub.y, 1.57f, gOrientForMGRSub.z);
-		glm::mat4 scalMatForMGR7 = scale(mat4(), vec3(0.4f, 1.6f, 0.4f));
-		glm::mat4 modelForMGR7 = glm::mat4(1.0f);
-		modelForMGR7 = modelForMGR7 * transMatForMGRAll * rotMatForMGR4 * transMatForY * rotMatForMGR7
-			* transMatForMGR7 * rotMatForMGR7 * scalMatForMGR7;
-		glm::mat4 MVPForMGR7 = Projection * View * modelForMGR7; // Remember, matrix multiplication is the other way around	
-
-
-		//谪 Ѿ flag. ȸ   ϱ  ڵ
-		if (gPosForMGR8.z < -2.0f)
-			flagForSub2 = 1;
-		else if (gPosForMGR8.z > -1.0f)
-			flagForSub2 = 0;
-
-		//-5.0f ۾ +, -1.0f Ŀ -
-		if (flagForSub2 == 1)
-			gPosForMGR8.z += 1.0f*deltaTime;
-		else
-			gPosForMGR8.z -= 1.0f*deltaTime;
-
-		glm::mat4 transMatForMGR8 = translate(mat4(), gPosForMGR8); // A bit to the left
-		glm::mat4 modelForMGR8 = glm::mat4(1.0f);
-		modelForMGR8 = modelForMGR8 * transMatForMGRAll * rotMatForMGR4 * transMatForY
-			* rotMatForMGR7 * transMatForMGR8 * rotMatForMGR7 * scalMatForMGR7;
-		glm::mat4 MVPForMGR8 = Projection * View * modelForMGR8;
-
-		//谪 Ѿ flag. ȸ   ϱ  ڵ
-		if (gPosForMGR9.z < -2.0f)
-			flagForSub3 = 1;
-		else if (gPosForMGR9.z > -1.0f)
-			flagForSub3 = 0;
-
-		//-5.0f ۾ +, -1.0f Ŀ -
-		if (flagForSub3 == 1)
-			gPosForMGR9.z += 1.0f*deltaTime;
-		else
-			gPosForMGR9.z -= 1.0f*deltaTime;
-
-		glm::mat4 transMatForMGR9 = translate(mat4(), gPosForMGR9); // A bit to the left
-		glm::mat4 modelForMGR9 = glm::mat4(1.0f);
-		modelForMGR9 = modelForMGR9 * transMatForMGRAll * rotMatForMGR4 * transMatForY
-			* rotMatForMGR7 * transMatForMGR9 * rotMatForMGR7 * scalMatForMGR7;
-		glm::mat4 MVPForMGR9 = Projection * View * modelForMGR9;
-
-		//谪 Ѿ flag. ȸ   ϱ  ڵ
-		if (gPosForMGR10.z < -2.0f)
-			flagForSub4 = 1;
-		else if (gPosForMGR10.z > -1.0f)
-			flagForSub4 = 0;
-
-		//-5.0f ۾ +, -1.0f Ŀ -
-		if (flagForSub4 == 1)
-			gPosForMGR10.z += 1.0f*deltaTime;
-		else
-			gPosForMGR10.z -= 1.0f*deltaTime;
-
-		glm::mat4 transMatForMGR10 = translate(mat4(), gPosForMGR10); // A bit to the left
-		glm::mat4 modelForMGR10 = glm::mat4(1.0f);
-		modelForMGR10 = modelForMGR10 * transMatForMGRAll * rotMatForMGR4 * transMatForY
-			* rotMatForMGR7 * transMatForMGR10 * rotMatForMGR7 * scalMatForMGR7;
-		glm::mat4 MVPForMGR10 = Projection * View * modelForMGR10;
-
-		//    ö cube  Matrix
-		glm::mat4 transMatForMGR11 = translate(mat4(), vec3(0.0f, 1.0f, 0.0f)); // A bit to the left
-		glm::mat4 scalMatForMGR11 = scale(mat4(), vec3(0.5f, 0.5f, 0.5f));
-		glm::mat4 modelForMGR11 = glm::mat4(1.0f);
-		modelForMGR11 = modelForMGR11 * transMatForMGR11 * transMatForMGRAll * rotMatForMGR4 * transMatForY * rotMatForMGR7
-			* transMatForMGR7 * rotMatForMGR7 * scalMatForMGR11;
-		glm::mat4 MVPForMGR11 = Projection * View * modelForMGR11;
-
-		//    ö cube  Matrix
-		glm::mat4 modelForMGR12 = glm::mat4(1.0f);
-		modelForMGR12 = modelForMGR12 * transMatForMGR11 * transMatForMGRAll * rotMatForMGR4 * transMatForY * rotMatForMGR7
-			* transMatForMGR8 * rotMatForMGR7 * scalMatForMGR11;
-		glm::mat4 MVPForMGR12 = Projection * View * modelForMGR12;
-
-		//    ö cube  Matrix
-		glm::mat4 modelForMGR13 = glm::mat4(1.0f);
-		modelForMGR13 = modelForMGR13 * transMatForMGR11 * transMatForMGRAll * rotMatForMGR4 * transMatForY * rotMatForMGR7
-			* transMatForMGR9 * rotMatForMGR7 * scalMatForMGR11;
-		glm::mat4 MVPForMGR13 = Projection * View * modelForMGR13;
-
-		//    ö cube  Matrix
-		glm::mat4 modelForMGR14 = glm::mat4(1.0f);
-		modelForMGR14 = modelForMGR14 * transMatForMGR11 * transMatForMGRAll * rotMatForMGR4 * transMatForY * rotMatForMGR7
-			* transMatForMGR10 * rotMatForMGR7 * scalMatForMGR11;
-		glm::mat4 MVPForMGR14 = Projection * View * modelForMGR14;
-
-		//***************************
-		//2. ȸ   
-		//***************************
-
-		//***************************
-		//3. ѷڽ   
-		//***************************
-		if (angle <= 0.0f) angle = doublePi;
-		if (angle2 <= 0.0f) angle2 = doublePi;
-		if (angle3 <= 0.0f) angle3 = doublePi;
-		if (angle4 <= 0.0f) angle4 = doublePi;
-
-		// ӵ    ׽Ʈ (Rail  ִ 4 ť꿡   ׽ƮѴ.)
-		angle -= 0.5f * deltaTime;
-		angle2 -= 0.5f * deltaTime;
-		angle3 -= 0.5f * deltaTime;
-		angle4 -= 0.5f * deltaTime;
-
-		result = doublePi - angle * 2.0f;
-		height = 2.0f * (3.0f * sin(result) / result + 2.0f * cos(result));
-
-		result2 = doublePi - angle2 * 2.0f;
-		height2 = 2.0f * (3.0f * sin(result2) / result2 + 2.0f * cos(result2));
-
-		result3 = doublePi - angle3 * 2.0f;
-		height3 = 2.0f * (3.0f * sin(result3) / result3 + 2.0f * cos(result3));
-
-		result4 = doublePi - angle4 * 2.0f;
-		height4 = 2.0f * (3.0f * sin(result4) / result4 + 2.0f * cos(result4));
-
-		gPosForRC.x = 10 * cos(angle);
-		gPosForRC.y = 2.0f * (3.0f * sin(result) / result + 2.0f * cos(result));
-		gPosForRC.z = 10 * sin(angle);
-
-		gPosForRC2.x = 10 * cos(angle2);
-		gPosForRC2.y = 2.0f * (3.0f * sin(result2) / result2 + 2.0f * cos(result2));
-		gPosForRC2.z = 10 * sin(angle2);
-
-		gPosForRC3.x = 10 * cos(angle3);
-		gPosForRC3.y = 2.0f * (3.0f * sin(result3) / result3 + 2.0f * cos(result3));
-		gPosForRC3.z = 10 * sin(angle3);
-
-		gPosForRC4.x = 10 * cos(angle4);
-		gPosForRC4.y = 2.0f * (3.0f * sin(result4) / result4 + 2.0f * cos(result4));
-		gPosForRC4.z = 10 * sin(angle4);
-
-		yDiff = gPosForRC.y - tempY;
-		yDiff2 = gPosForRC2.y - tempY2;
-		yDiff3 = gPosForRC3.y - tempY3;
-		yDiff4 = gPosForRC4.y - tempY4;
-
-		angVel = atan((yDiff / (0.5f * deltaTime) / 8.0f));
-		angVel2 = atan((yDiff2 / (0.5f * deltaTime) / 8.0f));
-		angVel3 = atan((yDiff3 / (0.5f * deltaTime) / 8.0f));
-		angVel4 = atan((yDiff4 / (0.5f * deltaTime) / 8.0f));
-
-		tempY = gPosForRC.y;
-		tempY2 = gPosForRC2.y;
-		tempY3 = gPosForRC3.y;
-		tempY4 = gPosForRC4.y;
-
-		//  ӵ  ׽Ʈ ߱ , angle    .
-		angle += 0.5f * deltaTime;
-		angle2 += 0.5f * deltaTime;
-		angle3 += 0.5f * deltaTime;
-		angle4 += 0.5f * deltaTime;
-
-		//    Ȱؼ ӵ ϰ, ̸ ̵ӵ Ѵ. (4 Cube  )
-		angle -= (0.5f - (0.25f * (angVel))) * deltaTime;
-		angle2 -= (0.5f - (0.25f * (angVel2))) * deltaTime;
-		angle3 -= (0.5f - (0.25f * (angVel3))) * deltaTime;
-		angle4 -= (0.5f - (0.25f * (angVel4))) * deltaTime;
-
-		result = doublePi - angle * 2.0f;
-		height = 2.0f * (3.0f * sin(result) / result + 2.0f * cos(result));
-
-		result2 = doublePi - angle2 * 2.0f;
-		height2 = 2.0f * (3.0f * sin(result2) / result2 + 2.0f * cos(result2));
-
-		result3 = doublePi - angle3 * 2.0f;
-		height3 = 2.0f * (3.0f * sin(result3) / result3 + 2.0f * cos(result3));
-
-		result4 = doublePi - angle4 * 2.0f;
-		height4 = 2.0f * (3.0f * sin(result4) / result4 + 2.0f * cos(result4));
-
-		// Cube  x,y,z ǥ  (4 Cube  )
-		gPosForRC.x = 10 * cos(angle);
-		gPosForRC.y = 2.0f * (3.0f * sin(result) / result + 2.0f * cos(result));
-		gPosForRC.z = 10 * sin(angle);
-
-		gPosForRC2.x = 10 * cos(angle2);
-		gPosForRC2.y = 2.0f * (3.0f * sin(result2) / result2 + 2.0f * cos(result2));
-		gPosForRC2.z = 10 * sin(angle2);
-
-		gPosForRC3.x = 10 * cos(angle3);
-		gPosForRC3.y = 2.0f * (3.0f * sin(result3) / result3 + 2.0f * cos(result3));
-		gPosForRC3.z = 10 * sin(angle3);
-
-		gPosForRC4.x = 10 * cos(angle4);
-		gPosForRC4.y = 2.0f * (3.0f * sin(result4) / result4 + 2.0f * cos(result4));
-		gPosForRC4.z = 10 * sin(angle4);
-
-		yDiff = gPosForRC.y - tempY;
-		yDiff2 = gPosForRC2.y - tempY2;
-		yDiff3 = gPosForRC3.y - tempY3;
-		yDiff4 = gPosForRC4.y - tempY4;
-
-
-		// Cube  ȸ vector  (4 Cube  )
-		if (angVel > 0.0f) // Cube  Rail 󿡼   ִ 
-			gOrientForRC.x = -atan(yDiff / ((0.5f - (0.25f * (angVel))) * deltaTime) / 8.0f);
-		else // Cube  Rail 󿡼 ϰ  ִ 
-			gOrientForRC.x = atan(yDiff / ((0.5f - (0.25f * (angVel))) * deltaTime) / 4.0f);
+			profiler.beginScope("merryGoRound");
+			updateMerryGoRound(merryGoRound, deltaTime);
+			profiler.endScope();
+		}
 
-		if (angVel2 > 0.0f)
-			gOrientForRC2.x = -atan(yDiff2 / ((0.5f - (0.25f * (angVel2))) * deltaTime) / 8.0f);
-		else
-			gOrientForRC2.x = atan(yDiff2 / ((0.5f - (0.25f * (angVel2))) * deltaTime) / 4.0f);
+		profiler.beginScope("rollerCoaster");
+		updateRollerCoaster(rollerCoaster, deltaTime);
+		profiler.endScope();
 
-		if (angVel3 > 0.0f)
-			gOrientForRC3.x = -atan(yDiff3 / ((0.5f - (0.25f * (angVel3))) * deltaTime) / 8.0f);
-		else
-			gOrientForRC3.x = atan(yDiff3 / ((0.5f - (0.25f * (angVel3))) * deltaTime) / 4.0f);
+		if (particleCapacity > 0) {
+			profiler.beginScope("particlesUpdate");
+			particles.update(deltaTime);
+			profiler.endScope();
+		}
 
-		if (angVel4 > 0.0f)
-			gOrientForRC4.x = -atan(yDiff4 / ((0.5f - (0.25f * (angVel4))) * deltaTime) / 8.0f);
-		else
-			gOrientForRC4.x = atan(yDiff4 / ((0.5f - (0.25f * (angVel4))) * deltaTime) / 4.0f);
-
-		tempY = gPosForRC.y;
-		tempY2 = gPosForRC2.y;
-		tempY3 = gPosForRC3.y;
-		tempY4 = gPosForRC4.y;
-
-		// ѷڽ ü ü ̵
-		glm::mat4 transMatAllForRC = translate(mat4(), vec3(4.0f, 4.0f, 4.0f));
-
-		// ѷڽ Rail 
-		glm::mat4 transMatForRC1 = translate(mat4(), vec3(0.0f, 0.15f, 0.0f));
-		glm::mat4 modelForRC1 = glm::mat4(1.0f);
-		glm::mat4 scalMatForRC1 = scale(mat4(), vec3(10.0f, 2.0f, 10.0f));
-		modelForRC1 = modelForRC1 * transMatAllForRC * transMatForRC1 * scalMatForRC1;
-		glm::mat4 MVPForRC1 = Projection * View * modelForRC1;
-
-		// ѷڽͿ  Cube 		
-		glm::mat4 modelForRC2 = glm::mat4(1.0f);
-		glm::mat4 transMatForRC2 = translate(mat4(), vec3(10 * cos(angle), height + 0.75f, 10 * sin(angle)));
-		glm::mat4 rotMatForRC2 = eulerAngleYXZ(gOrientForRC.y - angle, gOrientForRC.x, gOrientForRC.z);
-		glm::mat4 scalMatForRC2 = scale(mat4(), vec3(0.5f, 0.5f, 1.0f));
-		modelForRC2 = modelForRC2 * transMatAllForRC * transMatForRC2 * rotMatForRC2 *scalMatForRC2;
-		glm::mat4 MVPForRC2 = Projection * View * modelForRC2;
-
-		// ѷڽͿ  Cube  (2)
-		glm::mat4 modelForRC2_2 = glm::mat4(1.0f);
-		glm::mat4 transMatForRC2_2 = translate(mat4(), vec3(10 * cos(angle2), height2 + 0.75f, 10 * sin(angle2)));
-		glm::mat4 rotMatForRC2_2 = eulerAngleYXZ(gOrientForRC2.y - angle2, gOrientForRC2.x, gOrientForRC2.z);
-		modelForRC2_2 = modelForRC2_2 * transMatAllForRC * transMatForRC2_2 * rotMatForRC2_2 * scalMatForRC2;
-		glm::mat4 MVPForRC2_2 = Projection * View * modelForRC2_2;
-
-		// ѷڽͿ  Cube  (3)
-		glm::mat4 modelForRC2_3 = glm::mat4(1.0f);
-		glm::mat4 transMatForRC2_3 = translate(mat4(), vec3(10 * cos(angle3), height3 + 0.75f, 10 * sin(angle3)));
-		glm::mat4 rotMatForRC2_3 = eulerAngleYXZ(gOrientForRC3.y - angle3, gOrientForRC3.x, gOrientForRC3.z);
-		modelForRC2_3 = modelForRC2_3 * transMatAllForRC * transMatForRC2_3 * rotMatForRC2_3 * scalMatForRC2;
-		glm::mat4 MVPForRC2_3 = Projection * View * modelForRC2_3;
-
-		// ѷڽͿ  Cube  (4)
-		glm::mat4 modelForRC2_4 = glm::mat4(1.0f);
-		glm::mat4 transMatForRC2_4 = translate(mat4(), vec3(10 * cos(angle4), height4 + 0.75f, 10 * sin(angle4)));
-		glm::mat4 rotMatForRC2_4 = eulerAngleYXZ(gOrientForRC4.y - angle4, gOrientForRC4.x, gOrientForRC4.z);
-		modelForRC2_4 = modelForRC2_4 * transMatAllForRC * transMatForRC2_4 * rotMatForRC2_4 * scalMatForRC2;
-		glm::mat4 MVPForRC2_4 = Projection * View * modelForRC2_4;
-
-		// Rail ħ cube  (1)
-		glm::mat4 modelForRC4 = glm::mat4(1.0f);
-		glm::mat4 transMatForRC4 = translate(mat4(), vec3(10.0f * cos(doublePi),
-			2 * (3.0f * sin(doublePi) / doublePi + 2.0f * cos(doublePi)) - 6.0f, 10 * sin(doublePi)));
-		glm::mat4 scalMatForRC4 = scale(mat4(), vec3(0.5f, 6.0f, 0.5f));
-		modelForRC4 = modelForRC4 * transMatAllForRC * transMatForRC4 *scalMatForRC4;
-		glm::mat4 MVPForRC4 = Projection * View * modelForRC4;
-
-		// Rail ħ cube  (2)
-		glm::mat4 modelForRC5 = glm::mat4(1.0f);
-		glm::mat4 transMatForRC5 = translate(mat4(), vec3(10.0f * cos(doublePi / 2.0f),
-			1.0f, 10 * sin(doublePi / 2.0f)));
-		glm::mat4 scalMatForRC5 = scale(mat4(), vec3(0.5f, 9.0f, 0.5f));
-		modelForRC5 = modelForRC5 * transMatAllForRC * transMatForRC5 *scalMatForRC5;
-		glm::mat4 MVPForRC5 = Projection * View * modelForRC5;
-
-		// Rail ħ cube  (3)
-		glm::mat4 modelForRC6 = glm::mat4(1.0f);
-		glm::mat4 transMatForRC6 = translate(mat4(), vec3(10.0f * cos(doublePi / 4.0f - 0.125f),
-			2 * (3.0f * sin(-doublePi / 2.0f) / (-doublePi / 2.0f) + 2.0f * cos(-doublePi / 2.0f)) - 6.15f, 10 * sin((doublePi / 4.0f) - 0.125f)));
-		glm::mat4 scalMatForRC6 = scale(mat4(), vec3(0.5f, 6.0f, 0.5f));
-		modelForRC6 = modelForRC6 * transMatAllForRC * transMatForRC6 *scalMatForRC6;
-		glm::mat4 MVPForRC6 = Projection * View * modelForRC6;
-
-		// Rail ħ cube  (4)
-		glm::mat4 modelForRC7 = glm::mat4(1.0f);
-		glm::mat4 transMatForRC7 = translate(mat4(), vec3(10.0f * cos(doublePi / 4.0f * 3.0f + 0.125f),
-			2 * (3.0f * sin(doublePi / 2.0f) / (doublePi / 2.0f) + 2.0f * cos(doublePi / 2.0f)) - 6.15f, 10 * sin(doublePi / 4.0f * 3.0f + 0.125f)));
-		glm::mat4 scalMatForRC7 = scale(mat4(), vec3(0.5f, 6.0f, 0.5f));
-		modelForRC7 = modelForRC7 * transMatAllForRC * transMatForRC7 *scalMatForRC7;
-		glm::mat4 MVPForRC7 = Projection * View * modelForRC7;
+		if (crowdSize > 0) {
+			profiler.beginScope("crowdUpdate");
+			crowd.update(deltaTime);
+			profiler.endScope();
+		}
 
-		//***************************
-		//3. ѷڽ   
-		//***************************
+		// 움직인 부품만 BVH 를 refit 한다 (첫 프레임에는 tree 를 만든다).
+		profiler.beginScope("sceneIndex");
+		sceneIndex.update();
+		profiler.endScope();
+
+		// 왼쪽 클릭으로 화면 가운데 (HUD 의 십자선) 에 있는 놀이기구를 pick 해서 HUD 에 정보를 띄운다. 빈 곳을 누르면 지운다.
+		// 마우스는 카메라를 돌리는 데 쓰이고 커서는 매 프레임 가운데로 돌아가므로 커서 위치는 읽지 않는다.
+		// headless 모드는 같은 곳을 매 프레임 pick 해서 비용만 잰다.
+		bool pickButton = !headless && glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+		if (headless || (pickButton && !pickButtonDown)) {
+			vec3 rayOrigin, rayDirection;
+			screenRay(ViewProjection, screenWidth * 0.5, screenHeight * 0.5, screenWidth, screenHeight, rayOrigin, rayDirection);
+			profiler.beginScope("pick");
+			double pickStart = currentSeconds();
+			ScenePick pick = sceneIndex.pick(rayOrigin, rayDirection, 1000.0f);
+			pickMs += (currentSeconds() - pickStart) * 1000.0;
+			picks++;
+			profiler.endScope();
+			if (!headless)
+				statsHud.setInfo(pickInfo(sceneIndex, pick));
+		}
+		pickButtonDown = pickButton;
+		profiler.endScope(); // update
 
 		//*********************************
-		//  κ ķδ  ƮԴϴ.
+		// 이 부분 이후로는 렌더링 파트입니다.
 		//*********************************
 
-		// ٴ ׸
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &basicMVP[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureFloor);
-		glUniform1i(TextureID, 0);
-
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, rectVertexBuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// Texture ̹ color  ÿ layout 2 ϹǷ Ʒ  Ѵ.
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, rectUVBuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLES, 0, 2 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		//***********************
-		// Viking Rendering 
-		//***********************
-		// ŷ õ ġ 4  ׸ (MVPForVike6,MVPForVike7, MVPForVike8, MVPForVike9)
-		// ŷ   2 ׸(밢  ׸) (MVPForVike4, MVPForVike5)
-		// ŷ Ʒ  ׸ (MVPForVike3)
-		// ŷ   ׸ (MVPForVike2)
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForVike2[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureYellow); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForVike3[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForVike4[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForVike5[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForVike6[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForVike7[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForVike8[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForVike9[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		//***********************
-		// Viking Rendering 
-		//***********************
-
-		//***********************
-		// Merry-go-round Rendering 
-		//***********************
-		// 2-1. ȸ    ׸. (MVPForMGR1)
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForMGR1[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureYellow); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, circlebuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, circleUV);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLE_FAN, 0, sizeof(g_circle_buffer_data) / sizeof(GLfloat));
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		// 2-2. ȸ    ׸.
-		// Send our transformation to the currently bound shader, 
-		// in the "MVP" uniform
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForMGR3[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureYellow); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, circlebuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, circleUV);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLE_FAN, 0, sizeof(g_circle_buffer_data) / sizeof(GLfloat));
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		// 2-3.  ̵ ׸ with Texture Wood
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForMGR4[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, sidebuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, side_uv_buffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLES, 0, 18 * 36);
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		//2-4 2°  ׸ with texture
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForMGR5[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, sidebuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, side_uv_buffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLES, 0, 18 * 36);
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		// 2-5.  ׸(Texture)
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForMGR6[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureYellow); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, umbrellaBuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, umbrellaUV);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLES, 0, 8 * 9); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		//2-6.   ׸ with texture
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForMGR7[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, sidebuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, side_uv_buffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLES, 0, 18 * 36);
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		//2-7.   ׸ with texture
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForMGR8[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, sidebuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, side_uv_buffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLES, 0, 18 * 36);
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		//2-8.   ׸ with texture
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForMGR9[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, sidebuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, side_uv_buffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLES, 0, 18 * 36);
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		//2-9.   ׸
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForMGR10[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // viking  ֻ κ yellow texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, sidebuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, side_uv_buffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLES, 0, 18 * 36);
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		//2-10.   ö ť ׸
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForMGR11[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		//glBindTexture(GL_TEXTURE_2D, TextureYellow); // ȸ cube κ strip texture mapping Ѵ.
-		glBindTexture(GL_TEXTURE_2D, TextureStrip); // ȸ cube κ strip texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		//2-11.   ö ť ׸
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForMGR12[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		//glBindTexture(GL_TEXTURE_2D, TextureYellow); // ȸ cube κ strip texture mapping Ѵ.
-		glBindTexture(GL_TEXTURE_2D, TextureStrip); // ȸ cube κ strip texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		//2-12.   ö ť ׸
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForMGR13[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		//glBindTexture(GL_TEXTURE_2D, TextureYellow); // ȸ cube κ strip texture mapping Ѵ.
-		glBindTexture(GL_TEXTURE_2D, TextureStrip); // ȸ cube κ strip texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		//2-13.   ö ť ׸
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForMGR14[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureStrip); // ȸ cube κ strip texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		//***********************
-		// Merry-go-round Rendering 
-		//***********************
-
-		//***********************
-		// 3. Roller Coaster Rendering 
-		//***********************
-
-		//3-1. Rail ׸
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForRC1[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), false);
-
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, railBuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, railColor);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLES, 0, 18 * 37);
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-
-		//3-2. Roller Coaster Cube ׸
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForRC2[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureStrip); // ѷڽƮ cube κ strip texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		// 3-3 Roller Coaster Cube ׸ (2)
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForRC2_2[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		//glBindTexture(GL_TEXTURE_2D, TextureYellow); // ѷڽƮ cube κ strip texture mapping Ѵ.
-		glBindTexture(GL_TEXTURE_2D, TextureStrip); // ѷڽƮ cube κ strip texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		// 3-4 Roller Coaster Cube ׸ (2)
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForRC2_3[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		//glBindTexture(GL_TEXTURE_2D, TextureYellow); // ѷڽƮ cube κ strip texture mapping Ѵ.
-		glBindTexture(GL_TEXTURE_2D, TextureStrip); // ѷڽƮ cube κ strip texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
-
-		// 3-5 Roller Coaster Cube ׸ (2)
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForRC2_4[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		//glBindTexture(GL_TEXTURE_2D, TextureYellow); // ѷڽƮ cube κ strip texture mapping Ѵ.
-		glBindTexture(GL_TEXTURE_2D, TextureStrip); // ѷڽƮ cube κ strip texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
+		profiler.beginScope("render", true);
+		// 불투명 mesh 는 바로 그리지 않고 queue 에 모은 다음 --draw-order 대로 정렬해서 그린다.
+		profiler.beginScope("buildDrawList");
+		opaqueQueue.clear();
+		// 보이는 물체만 추가한 순서대로 queue 에 넣는다. --no-culling 이면 전부 넣는다.
+		profiler.beginScope("cull");
+		double cullStart = currentSeconds();
+		if (culling) {
+			sceneIndex.cull(ViewProjection, visibleObjects);
+		} else {
+			visibleObjects.resize(parkDraws.size());
+			for (size_t i = 0; i < visibleObjects.size(); i++)
+				visibleObjects[i] = (uint32_t)i;
+		}
+		cullMs += (currentSeconds() - cullStart) * 1000.0;
+		visibleSum += visibleObjects.size();
+		profiler.endScope();
+		visibleRides.clear();
+		for (size_t i = 0; i < visibleObjects.size(); i++) {
+			const ParkDraw &draw = parkDraws[visibleObjects[i]];
+			if (draw.rideInstance >= 0)
+				visibleRides.push_back((uint32_t)draw.rideInstance);
+			else
+				opaqueQueue.add(draw.mesh, *draw.model, draw.texture != NULL ? *draw.texture : 0, draw.layer);
+		}
+		// GPU 애니메이션 놀이기구는 보이는 것만 이번 프레임의 instance buffer 로 복사해서 그린다.
+		if (culling && animatedRides.instanceCount() > 0)
+			renderStats.frame().uploadBytes += animatedRides.setVisible(visibleRides.empty() ? NULL : &visibleRides[0], visibleRides.size());
+		// 카메라 거리에 따라 지형 chunk 의 LOD 를 고른다. golden image 를 비교할 때는 매번 같은 그림이 나오도록
+		// 고른 chunk 가 전부 올라올 때까지 기다린다.
+		if (!flatFloor) {
+			profiler.beginScope("terrainSelect");
+			double terrainStart = currentSeconds();
+			vec3 cameraPosition(glm::inverse(View)[3]);
+			if (goldenDir != NULL) {
+				size_t waitBytes = terrain.selectResident(cameraPosition, ViewProjection);
+				renderStats.frame().uploadBytes += waitBytes;
+				terrainWaitBytes += waitBytes;
+			} else {
+				terrain.select(cameraPosition, ViewProjection);
+			}
+			terrainSelectMs += (currentSeconds() - terrainStart) * 1000.0;
+			terrainDrawnSum += terrain.drawnCount();
+			profiler.endScope();
+		}
+		// 카메라에서 먼 놀이기구 cell 은 내리고 가까운 cell 은 요청한다. 그리는 것은 올라와 있고 보이는 cell 뿐이다.
+		if (streamRides) {
+			profiler.beginScope("rideCellSelect");
+			double rideCellStart = currentSeconds();
+			vec3 cameraPosition(glm::inverse(View)[3]);
+			if (goldenDir != NULL)
+				renderStats.frame().uploadBytes += rideCells.selectResident(cameraPosition, ViewProjection);
+			else
+				rideCells.select(cameraPosition, ViewProjection);
+			rideCellSelectMs += (currentSeconds() - rideCellStart) * 1000.0;
+			rideCellDrawnSum += rideCells.drawnCount();
+			rideCellRidesSum += rideCells.drawnRides();
+			profiler.endScope();
+		}
+		const std::vector<RideRun> *rideRuns = streamRides ? rideCells.runs() : NULL;
+
+		opaqueQueue.sort(View, drawOrder);
+		// GPU 애니메이션 놀이기구는 queue 를 거치지 않고 part 마다 instanced draw 한다 (textures 는 RideTexture 순서).
+		GLuint rideTextures[RIDE_TEXTURE_COUNT] = { TextureYellow, TextureWood, TextureStrip };
+		profiler.endScope();
+
+		if (depthPrepass) {
+			// position 만으로 depth buffer 를 먼저 채운다. 뒤의 color pass 는 보이는 fragment 만 shading 한다.
+			profiler.beginScope("depthPrepass", true);
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+			for (size_t i = 0; i < opaqueQueue.size(); i++)
+				drawMesh(renderState, scene.vertexBuffer, *opaqueQueue[i].mesh, ViewProjection * opaqueQueue[i].model, 0, true);
+			animatedRides.draw(renderState, ViewProjection, cameraTime, rideTextures, true, rideRuns);
+			if (!flatFloor)
+				terrain.draw(renderState, ViewProjection, TextureFloor);
+			glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+			// pre-pass 와 같은 depth 인 fragment 만 통과시키고 depth 는 다시 쓰지 않는다.
+			glDepthFunc(GL_LEQUAL);
+			glDepthMask(GL_FALSE);
+			profiler.endScope();
+		}
 
-		// 3-6 Roller Coaster Cube ׸ (Rail ħ) (1)
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForRC4[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // ѷڽƮ cube κ strip texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
+		profiler.beginScope("drawOpaque", true);
+		overdrawMeter.begin((size_t)sceneWidth * sceneHeight * sceneSamples);
+		for (size_t i = 0; i < opaqueQueue.size(); i++) {
+			const OpaqueDraw &draw = opaqueQueue[i];
+			drawMesh(renderState, scene.vertexBuffer, *draw.mesh, ViewProjection * draw.model, draw.texture);
+		}
+		// 놀이기구 시간은 camera path 와 같은 시간을 쓴다 (headless 는 60fps 고정 간격)
+		profiler.beginScope("drawAnimatedRides", true);
+		animatedRides.draw(renderState, ViewProjection, cameraTime, rideTextures, false, rideRuns);
+		profiler.endScope();
+		// 지형은 바닥처럼 맨 나중에 그려서 놀이기구에 가려진 부분은 depth test 로 버린다.
+		if (!flatFloor) {
+			profiler.beginScope("drawTerrain", true);
+			terrain.draw(renderState, ViewProjection, TextureFloor);
+			profiler.endScope();
+		}
+		overdrawMeter.end(renderStats.frame());
+		profiler.endScope();
 
-		// 3-7 Roller Coaster Cube ׸ (Rail ħ) (2)
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForRC5[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // ѷڽƮ cube κ strip texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
+		if (depthPrepass) {
+			glDepthMask(GL_TRUE);
+			glDepthFunc(GL_LESS);
+		}
+		animatedRides.endFrame();
+
+		// 방문객은 불투명이지만 instance 를 직접 쓰므로 queue 를 거치지 않고 LOD 마다 instanced draw 한 번씩 한다.
+		if (crowdSize > 0) {
+			profiler.beginScope("drawCrowd", true);
+			double crowdStart = currentSeconds();
+			crowdRenderer.draw(renderState, crowd, workerPool, View, ViewProjection, -3.0f, flatFloor ? NULL : terrainHeight);
+			crowdRenderMs += (currentSeconds() - crowdStart) * 1000.0;
+			for (int lod = 0; lod < CROWD_LOD_COUNT; lod++)
+				crowdDrawnSum[lod] += crowdRenderer.drawn((CrowdLod)lod);
+			crowdCulledSum += crowdRenderer.culled();
+			profiler.endScope();
+		}
 
-		// 3-8 Roller Coaster Cube ׸ (Rail ħ) (3)
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForRC6[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // ѷڽƮ cube κ strip texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
+		// particle 은 불투명 장면 뒤에 depth test 만 하고 (depth 는 쓰지 않고) 정렬 없이 그린다.
+		if (particleCapacity > 0) {
+			profiler.beginScope("drawParticles", true);
+			double particleStart = currentSeconds();
+			particleRenderer.draw(renderState, particles, View, ViewProjection);
+			particleRenderMs += (currentSeconds() - particleStart) * 1000.0;
+			profiler.endScope();
+		}
+		profiler.endScope(); // render
+
+		if (dynamicResolution) {
+			// 줄인 해상도로 그린 장면을 출력 크기로 늘린다. HUD 는 그 위에 원래 해상도로 그린다.
+			profiler.beginScope("upscale", true);
+			dynamicTarget.present(headless ? offscreen.framebuffer.get() : 0, framebufferWidth, framebufferHeight);
+			renderState.invalidate();
+			profiler.endScope();
+		}
 
-		// 3-9 Roller Coaster Cube ׸ (Rail ħ) (4)
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPForRC7[0][0]);
-		glUniform1i(glGetUniformLocation(programID, "isTexture"), true);
-
-		// Texture setting
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, TextureWood); // ѷڽƮ cube κ strip texture mapping Ѵ.
-		glUniform1i(TextureID, 0);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-		glVertexAttribPointer(
-			2,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			2,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(2);
+		// F3 으로 통계 overlay 켜고 끄기
+		bool hudKey = !headless && glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS;
+		if (hudKey && !hudKeyDown)
+			hudVisible = !hudVisible;
+		hudKeyDown = hudKey;
+		// window 모드에서는 pick 하는 곳을 보여 주는 십자선 때문에 HUD pass 가 항상 돈다.
+		statsHud.setCrosshair(!headless);
+		if (hudVisible || statsHud.hasInfo() || !headless) {
+			profiler.beginScope("drawHud", true);
+			statsHud.draw(renderState, hudVisible ? &renderStats : NULL, framebufferWidth, framebufferHeight);
+			profiler.endScope();
+		}
 
-		//***********************
-		// Roller Coaster Rendering 
-		//***********************		
+		// swap (vsync 를 기다리는 시간) 을 뺀 CPU 시간. dynamic resolution 은 이것과 GPU 시간 중 큰 쪽을 본다.
+		double cpuMs = (currentSeconds() - frameStart) * 1000.0;
 
 		// Swap buffers
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		profiler.beginScope("swapBuffers");
+		if (headless) {
+			// swap 대신 MSAA resolve 를 하고 GPU 가 프레임을 끝낼 때까지 기다려서 frame time 에 포함시킨다.
+			resolveOffscreenTarget(offscreen);
+			glFinish();
+		} else {
+			glfwSwapBuffers(window);
+			glfwPollEvents();
+		}
+		profiler.endScope();
+		profiler.endFrame();
+		renderStats.endFrame((currentSeconds() - frameStart) * 1000.0);
+		if (dynamicResolution) {
+			scaleSum += resolution.scale();
+			if (resolution.update(std::max(cpuMs, dynamicTarget.gpuMs())))
+				printf("Dynamic resolution: %.0f%% scale, %dx MSAA\n", resolution.scale() * 100.0f, resolution.samples());
+		}
+		// golden image 읽기는 frame time 에 넣지 않는다.
+		if (goldenDir != NULL && renderedFrames % goldenEvery == 0) {
+			readOffscreenPixels(offscreen, &goldenFrame.pixels[0]);
+			goldenCheck.checkFrame(renderedFrames, goldenFrame);
+		}
+		renderedFrames++;
 	} // Check if the ESC key was pressed or the window was closed
-	while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
-		glfwWindowShouldClose(window) == 0);
+	while (headless ? renderedFrames < benchmarkFrames :
+		glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS && glfwWindowShouldClose(window) == 0);
+
+	// 종료 직전의 GL 메모리 사용량 (종류별, 주인별, 놀이기구별)
+	glResources().clearUses();
+	if (flatFloor)
+		addRideUses("floor", scene, { &floorMesh }, { TextureFloor });
+	else
+		addRideUses("floor", scene, {}, { TextureFloor });
+	addRideUses("viking", scene, { &cubeMesh }, { TextureYellow, TextureWood });
+	addRideUses("merryGoRound", scene, { &circleMesh, &sideMesh, &umbrellaMesh, &cubeMesh }, { TextureYellow, TextureWood, TextureStrip });
+	addRideUses("rollerCoaster", scene, { &railMesh, &cubeMesh }, { TextureStrip, TextureWood });
+	glResources().printReport();
+	// ring 크기를 정하는 데 쓰는 stream buffer 의 stall / 대기 시간
+	printStreamBufferStats();
+	// particle update 와 render 의 프레임당 평균 CPU 시간 (render 의 GPU 시간은 frame_trace 의 drawParticles)
+	const ParticleStats &particleStats = particles.stats();
+	long long particleFrames = particleStats.frames > 0 ? particleStats.frames : 1;
+	if (particleCapacity > 0) {
+		printf("Particles: %.0f live on average (peak %zu of %d) | update %.2f ms/frame (emit %.2f, simulate %.2f, compact %.2f) | render %.2f ms/frame (write %.2f) on %d threads\n",
+			particleStats.liveSum / particleFrames, particleStats.peakLive, particleCapacity,
+			(particleStats.emitMs + particleStats.simulateMs + particleStats.compactMs) / particleFrames,
+			particleStats.emitMs / particleFrames, particleStats.simulateMs / particleFrames,
+			particleStats.compactMs / particleFrames, particleRenderMs / particleFrames,
+			particleStats.writeMs / particleFrames, workerPool.threadCount());
+	}
+	// BVH: 물체 / node 수, tree 를 만든 횟수, refit 과 culling 의 프레임당 CPU 시간, 평균으로 보인 물체 수, pick 한 번의 시간
+	const SceneIndexStats &indexStats = sceneIndex.stats();
+	int frameCount = renderedFrames > 0 ? renderedFrames : 1;
+	printf("Scene BVH: %d objects, %d nodes, depth %d | %lld builds (%.2f ms), refit %.3f ms/frame | cull %.3f ms/frame, %.1f of %d visible%s | pick %.1f us\n",
+		(int)sceneIndex.size(), (int)sceneIndex.tree().nodeCount(), sceneIndex.tree().depth(), indexStats.builds, indexStats.buildMs,
+		indexStats.refitMs / frameCount, cullMs / frameCount, visibleSum / frameCount, (int)sceneIndex.size(),
+		culling ? "" : " (culling off)", picks > 0 ? pickMs * 1000.0 / picks : 0.0);
+	// 지형: 평균으로 그린 chunk 수, LOD 선택의 프레임당 CPU 시간, chunk 를 만들고 올리고 버린 횟수
+	const TerrainStats &terrainStats = terrain.stats();
+	if (!flatFloor) {
+		printf("Terrain: %.1f chunks drawn, select %.3f ms/frame | %lld generated, %lld uploaded (%.1f MB, %.1f MB waited for), %lld evicted, %lld dropped | %d of %d slots resident\n",
+			terrainDrawnSum / frameCount, terrainSelectMs / frameCount, terrainStats.generated, terrainStats.uploaded,
+			terrainStats.uploadedBytes / (1024.0 * 1024.0), terrainWaitBytes / (1024.0 * 1024.0), terrainStats.evicted,
+			terrainStats.dropped, terrain.residentCount(), terrain.poolCapacity());
+	}
+	// 놀이기구 cell: 평균으로 그린 cell 과 놀이기구 수, 선택의 프레임당 CPU 시간, cell 을 만들고 올리고 내리고 버린 횟수
+	const RideCellStats &rideCellStats = rideCells.stats();
+	if (streamRides) {
+		printf("Ride cells: %.1f cells (%.0f rides) drawn, select %.3f ms/frame | %lld loaded, %lld uploaded (%.1f KB), %lld unloaded, %lld evicted, %lld dropped | %d of %d slots resident\n",
+			rideCellDrawnSum / frameCount, rideCellRidesSum / frameCount, rideCellSelectMs / frameCount, rideCellStats.loaded,
+			rideCellStats.uploaded, rideCellStats.uploadedBytes / 1024.0, rideCellStats.unloaded, rideCellStats.evicted,
+			rideCellStats.dropped, rideCells.residentCount(), rideCells.poolCapacity());
+	}
+	// 방문객 update (grid + steering) 와 render (culling, LOD, instance 쓰기 + draw) 의 프레임당 평균 CPU 시간
+	const CrowdStats &crowdStats = crowd.stats();
+	long long crowdFrames = crowdStats.frames > 0 ? crowdStats.frames : 1;
+	if (crowdSize > 0) {
+		printf("Crowd: %d visitors | update %.2f ms/frame (grid %.2f, steering %.2f, %.1f neighbour checks per visitor) | render %.2f ms/frame, LOD %.0f / %.0f / %.0f, %.0f culled | %lld arrivals\n",
+			crowdSize, (crowdStats.gridMs + crowdStats.simulateMs) / crowdFrames, crowdStats.gridMs / crowdFrames,
+			crowdStats.simulateMs / crowdFrames, (double)crowdStats.neighbourChecks / crowdFrames / crowdSize, crowdRenderMs / crowdFrames,
+			crowdDrawnSum[0] / crowdFrames, crowdDrawnSum[1] / crowdFrames, crowdDrawnSum[2] / crowdFrames,
+			crowdCulledSum / crowdFrames, crowdStats.arrivals);
+	}
+
+	if (headless) {
+		HeadlessReport report;
+		report.width = screenWidth;
+		report.height = screenHeight;
+		report.samples = offscreen.samples;
+		report.startupMs = startupMs;
+		report.totalMs = (currentSeconds() - lastTime) * 1000.0;
+		report.gpuBytes = glResources().liveBytes();
+		report.gpuPeakBytes = glResources().peakBytes();
+		report.drawOrder = drawOrderName(drawOrder);
+		report.depthPrepass = depthPrepass;
+		report.targetFps = targetFps;
+		report.meanScale = renderedFrames > 0 && dynamicResolution ? scaleSum / renderedFrames : 1.0;
+		report.resolutionChanges = resolution.changes();
+		report.animatedRides = animatedRides.instanceCount();
+		report.rideAnimationError = rideAnimationError;
+		report.particleCapacity = particleCapacity;
+		report.particleThreads = particleCapacity > 0 ? workerPool.threadCount() : 0;
+		report.particleMeanLive = particleStats.liveSum / particleFrames;
+		report.particlePeakLive = particleStats.peakLive;
+		report.particleUpdateMs = (particleStats.emitMs + particleStats.simulateMs + particleStats.compactMs) / particleFrames;
+		report.particleSimulateMs = particleStats.simulateMs / particleFrames;
+		report.particleRenderMs = particleRenderMs / particleFrames;
+		report.crowdAgents = crowdSize;
+		report.crowdUpdateMs = (crowdStats.gridMs + crowdStats.simulateMs) / crowdFrames;
+		report.crowdGridMs = crowdStats.gridMs / crowdFrames;
+		report.crowdNeighbourChecks = crowdSize > 0 ? (double)crowdStats.neighbourChecks / crowdFrames / crowdSize : 0.0;
+		report.crowdRenderMs = crowdRenderMs / crowdFrames;
+		for (int lod = 0; lod < CROWD_LOD_COUNT; lod++)
+			report.crowdDrawn[lod] = crowdDrawnSum[lod] / crowdFrames;
+		report.crowdCulled = crowdCulledSum / crowdFrames;
+		report.bvhObjects = (int)sceneIndex.size();
+		report.bvhNodes = (int)sceneIndex.tree().nodeCount();
+		report.bvhDepth = sceneIndex.tree().depth();
+		report.culling = culling;
+		report.bvhRefitMs = indexStats.refitMs / frameCount;
+		report.bvhCullMs = cullMs / frameCount;
+		report.bvhVisible = visibleSum / frameCount;
+		report.bvhPickUs = picks > 0 ? pickMs * 1000.0 / picks : 0.0;
+		report.terrain = !flatFloor;
+		report.terrainChunksDrawn = terrainDrawnSum / frameCount;
+		report.terrainSelectMs = terrainSelectMs / frameCount;
+		report.terrainGenerated = terrainStats.generated;
+		report.terrainEvicted = terrainStats.evicted;
+		report.terrainUploadBytes = terrainStats.uploadedBytes;
+		report.terrainPoolBytes = flatFloor ? 0 : terrain.poolBytes();
+		report.rideCells = streamRides;
+		report.rideCellsDrawn = rideCellDrawnSum / frameCount;
+		report.rideCellRidesDrawn = rideCellRidesSum / frameCount;
+		report.rideCellSelectMs = rideCellSelectMs / frameCount;
+		report.rideCellsLoaded = rideCellStats.loaded;
+		report.rideCellsUnloaded = rideCellStats.unloaded;
+		report.rideCellsEvicted = rideCellStats.evicted;
+		report.rideCellUploadBytes = rideCellStats.uploadedBytes;
+		report.rideCellPoolBytes = streamRides ? rideCells.poolBytes() : 0;
+		writeHeadlessReport(reportPath, report, renderStats);
+	}
+	int exitCode = 0;
+	if (goldenDir != NULL) {
+		goldenCheck.checkTiming(renderStats.percentile(50.0), goldenTimingTolerance);
+		if (!goldenUpdate) {
+			exitCode = goldenCheck.imageFailures() > 0 ? 1 : goldenCheck.slower() ? 2 : 0;
+			printf("Golden run %s: %s\n", goldenName.c_str(),
+				exitCode == 0 ? "PASSED" : exitCode == 1 ? "FAILED (images differ)" : "FAILED (slower)");
+		}
+	}
+
+	if (recordCameraFile != NULL && !cameraRecorder.path().empty() && cameraRecorder.path().save(recordCameraFile))
+		printf("Recorded %d camera keyframes to %s\n", (int)cameraRecorder.path().keyframeCount(), recordCameraFile);
+	profiler.writeTrace("frame_trace.json");
+	profiler.shutdown();
+	overdrawMeter.shutdown();
+	dynamicTarget.shutdown();
+	statsHud.shutdown();
+	rideCells.shutdown();
+	animatedRides.shutdown();
+	particleRenderer.shutdown();
+	crowdRenderer.shutdown();
+	terrain.shutdown();
+	workerPool.stop();
 
 	// Cleanup VBO and shader
-	glDeleteBuffers(1, &vertexbuffer);
-	glDeleteBuffers(1, &uvbuffer);
-	glDeleteBuffers(1, &rectVertexBuffer);
-	glDeleteBuffers(1, &rectUVBuffer);
-	glDeleteBuffers(1, &circlebuffer);
-	glDeleteBuffers(1, &circleColor);
-	glDeleteBuffers(1, &circleUV);
-	glDeleteBuffers(1, &sidebuffer);
-	glDeleteBuffers(1, &side_color_buffer);
-	glDeleteBuffers(1, &side_uv_buffer);
-	glDeleteBuffers(1, &umbrellaBuffer);
-	glDeleteBuffers(1, &umbrellaColor);
-	glDeleteBuffers(1, &umbrellaUV);
-	glDeleteBuffers(1, &railBuffer);
-	glDeleteBuffers(1, &railColor);
-	glDeleteProgram(programID);
-	glDeleteTextures(1, &TextureID);
-	glDeleteVertexArrays(1, &VertexArrayID);
+	deleteScene(scene);
+	deleteShaderPermutations(programs);
+	VertexArrayID.reset();
+	textureStreamer.stop();
+	if (headless)
+		deleteOffscreenTarget(offscreen);
+	// 여기까지 지우지 않은 GL object 는 leak
+	glResources().reportLeaks();
+
+	if (headless) {
+		destroyHeadlessContext(headlessContext);
+		return exitCode;
+	}
 
 	// Close OpenGL window and terminate GLFW
 	glfwTerminate();
 	return 0;
 }
 
-// Circle  Vertex Data 
-GLfloat* makeCircleVertexData(GLfloat *arr, GLfloat x, GLfloat y, GLfloat z, GLfloat radius, GLint numberOfSides)
+double currentSeconds()
 {
-	GLint numberOfVertices = numberOfSides + 2;
-	GLfloat doublePi = 2.0f * 3.141592f;
-	GLfloat *allCircleVertices = arr;
-
-	allCircleVertices[0] = 0.0f;
-	allCircleVertices[1] = y;
-	allCircleVertices[2] = 0.0f;
-
-	for (int i = 0; i < numberOfVertices; i++)
-	{
-		allCircleVertices[3 * (i + 1)] = x + (radius * cos(i * doublePi / numberOfSides));
-		allCircleVertices[3 * (i + 1) + 1] = y;
-		allCircleVertices[3 * (i + 1) + 2] = z + (radius * sin(i * doublePi / numberOfSides));
-	}
-	return allCircleVertices;
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 }
 
-// Cylinder Side ׸
-GLfloat *makeCylinderSide(GLfloat *arr, GLfloat radius, GLint numberOfSides) {
-
-	GLfloat doublePi = 2.0f * 3.141592f;
-	GLfloat *allSideVertices = arr;
-
-	for (int i = 0; i < numberOfSides; i++)
-	{
-		// x,y,z 迭  
-		// return  ۿ   
-		allSideVertices[18 * i] = (radius * cos(i * doublePi / numberOfSides));
-		allSideVertices[18 * i + 1] = radius / 2.0f;
-		allSideVertices[18 * i + 2] = (radius * sin(i * doublePi / numberOfSides));
-
-		allSideVertices[18 * i + 3] = (radius * cos(i * doublePi / numberOfSides));
-		allSideVertices[18 * i + 4] = -radius / 2.0f;
-		allSideVertices[18 * i + 5] = (radius * sin(i * doublePi / numberOfSides));
-
-		allSideVertices[18 * i + 6] = (radius * cos((i + 1) * doublePi / numberOfSides));
-		allSideVertices[18 * i + 7] = radius / 2.0f;
-		allSideVertices[18 * i + 8] = (radius * sin((i + 1) * doublePi / numberOfSides));
-
-		allSideVertices[18 * i + 9] = (radius * cos((i + 1) * doublePi / numberOfSides));
-		allSideVertices[18 * i + 10] = radius / 2.0f;
-		allSideVertices[18 * i + 11] = (radius * sin((i + 1) * doublePi / numberOfSides));
-
-		allSideVertices[18 * i + 12] = (radius * cos(i * doublePi / numberOfSides));
-		allSideVertices[18 * i + 13] = -radius / 2.0f;
-		allSideVertices[18 * i + 14] = (radius * sin(i * doublePi / numberOfSides));
-
-		allSideVertices[18 * i + 15] = (radius * cos((i + 1) * doublePi / numberOfSides));
-		allSideVertices[18 * i + 16] = -radius / 2.0f;
-		allSideVertices[18 * i + 17] = (radius * sin((i + 1) * doublePi / numberOfSides));
-	}
-	return allSideVertices;
-}
-
-// Cylinder Color ׸
-GLfloat *makeCylinderColor(GLfloat *arr, GLint numberOfSides, GLfloat r, GLfloat g, GLfloat b) {
-	GLfloat *cylinderColor = arr;
-	for (int i = 0; i < numberOfSides; i++)
-	{
-		cylinderColor[18 * i] = r;
-		cylinderColor[18 * i + 1] = g;
-		cylinderColor[18 * i + 2] = b;
-
-		cylinderColor[18 * i + 3] = r;
-		cylinderColor[18 * i + 4] = g;
-		cylinderColor[18 * i + 5] = b;
-
-		cylinderColor[18 * i + 6] = r;
-		cylinderColor[18 * i + 7] = g;
-		cylinderColor[18 * i + 8] = b;
-
-		cylinderColor[18 * i + 9] = r;
-		cylinderColor[18 * i + 10] = g;
-		cylinderColor[18 * i + 11] = b;
-
-		cylinderColor[18 * i + 12] = r;
-		cylinderColor[18 * i + 13] = g;
-		cylinderColor[18 * i + 14] = b;
-
-		cylinderColor[18 * i + 15] = r;
-		cylinderColor[18 * i + 16] = g;
-		cylinderColor[18 * i + 17] = b;
-	}
-	return cylinderColor;
+// scene 에서 이름으로 mesh 찾기
+bool findMesh(const Scene &scene, const char *name, Mesh &mesh)
+{
+	mesh.sceneMesh = findSceneMesh(scene, name);
+	if (mesh.sceneMesh == NULL)
+		printf("Scene has no mesh named %s\n", name);
+	return mesh.sceneMesh != NULL;
 }
 
-// Cylinder UV Buffer ׸
-GLfloat *makeCylinderUVBuffer(GLfloat *arr, GLint numberOfSides) {
-	GLfloat *allSideUVs = arr;
-
-	for (int i = 0; i < numberOfSides; i++)
-	{
-		//  ̵忡  UV Buffer 
-
-		allSideUVs[12 * i] = ((float)i) / numberOfSides;
-		allSideUVs[12 * i + 1] = 1.0f;
-
-		allSideUVs[12 * i + 2] = ((float)i) / numberOfSides;
-		allSideUVs[12 * i + 3] = 0.0f;
-
-		allSideUVs[12 * i + 4] = ((float)i + 1) / numberOfSides;
-		allSideUVs[12 * i + 5] = 1.0f;
-
-		allSideUVs[12 * i + 6] = ((float)i + 1) / numberOfSides;
-		allSideUVs[12 * i + 7] = 1.0f;
-
-		allSideUVs[12 * i + 8] = ((float)i) / numberOfSides;
-		allSideUVs[12 * i + 9] = 0.0f;
-
-		allSideUVs[12 * i + 10] = ((float)i + 1) / numberOfSides;
-		allSideUVs[12 * i + 11] = 0.0f;
-	}
-	return allSideUVs;
+void addParkObject(SceneIndex &sceneIndex, std::vector<ParkDraw> &parkDraws, const char *ride, const char *part,
+	const Mesh &mesh, const glm::mat4 *model, const GLuint *texture, bool moving, int layer)
+{
+	const SceneMesh &sceneMesh = *mesh.sceneMesh;
+	SceneObject object = { ride, part, vec3(sceneMesh.boundsMin[0], sceneMesh.boundsMin[1], sceneMesh.boundsMin[2]),
+		vec3(sceneMesh.boundsMax[0], sceneMesh.boundsMax[1], sceneMesh.boundsMax[2]), model, moving };
+	sceneIndex.add(object);
+	ParkDraw draw = { mesh.sceneMesh, model, texture, layer, -1 };
+	parkDraws.push_back(draw);
 }
 
-// vertex  °  ÷ ޾ Color  
-GLfloat *makeColorBuffer(GLfloat *arr, GLint vertexNum, GLfloat red, GLfloat green, GLfloat blue) {
-	//GLfloat *allColorVertices = new GLfloat[vertexNum * 3];
-	GLfloat *allColorVertices = arr;
-	for (int i = 0; i < vertexNum; i++)
-	{
-		allColorVertices[3 * i] = red;
-		allColorVertices[3 * i + 1] = green;
-		allColorVertices[3 * i + 2] = blue;
-	}
-	return allColorVertices;
+// 화면 좌표를 NDC 로 바꾸고 near / far plane 위의 두 점을 view-projection 의 역행렬로 되돌린다.
+void screenRay(const glm::mat4 &viewProjection, double x, double y, int width, int height, glm::vec3 &origin, glm::vec3 &direction)
+{
+	float ndcX = (float)(x / width * 2.0 - 1.0);
+	float ndcY = (float)(1.0 - y / height * 2.0);
+	glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+	origin = vec3(nearPoint) / nearPoint.w;
+	direction = glm::normalize(vec3(farPoint) / farPoint.w - origin);
 }
 
-//   vertex data 
-GLfloat *makeUmbrella(GLfloat *arr, GLfloat y, GLfloat radius, GLint numberOfSides) {
-	GLint numberOfVertices = numberOfSides + 1;
-	GLfloat doublePi = 2.0f * 3.141592f;
-	GLfloat *allUmbrellaVertices = arr;
-	for (int i = 0; i < numberOfVertices; i++)
-	{
-		allUmbrellaVertices[9 * i] = 0.0f;
-		allUmbrellaVertices[9 * i + 1] = y;
-		allUmbrellaVertices[9 * i + 2] = 0.0f;
-
-		allUmbrellaVertices[9 * i + 3] = (radius * cos(i * doublePi / numberOfSides));
-		allUmbrellaVertices[9 * i + 4] = 0.0f;
-		allUmbrellaVertices[9 * i + 5] = (radius * sin(i * doublePi / numberOfSides));
-
-		allUmbrellaVertices[9 * i + 6] = (radius * cos((i + 1) * doublePi / numberOfSides));
-		allUmbrellaVertices[9 * i + 7] = 0.0f;
-		allUmbrellaVertices[9 * i + 8] = (radius * sin((i + 1) * doublePi / numberOfSides));
+std::vector<std::string> pickInfo(const SceneIndex &sceneIndex, const ScenePick &pick)
+{
+	std::vector<std::string> lines;
+	if (pick.object < 0)
+		return lines;
+	const SceneObject &object = sceneIndex.object((uint32_t)pick.object);
+	char line[96];
+	lines.push_back(object.ride);
+	if (object.part != NULL) {
+		snprintf(line, sizeof(line), "PART %s", object.part);
+		lines.push_back(line);
 	}
-	return allUmbrellaVertices;
+	snprintf(line, sizeof(line), "DISTANCE %.1f", pick.distance);
+	lines.push_back(line);
+	snprintf(line, sizeof(line), "AT %.1f %.1f %.1f", pick.point.x, pick.point.y, pick.point.z);
+	lines.push_back(line);
+	return lines;
 }
 
-//   color buffer 
-GLfloat *makeUmbrellaColor(GLfloat *arr, GLint numberOfSides, GLfloat red, GLfloat green, GLfloat blue) {
-	GLfloat *allUmbrellaColors = NULL;
-	allUmbrellaColors = arr;
-
-	for (int i = 0; i < numberOfSides; i++)
-	{
-		allUmbrellaColors[9 * i] = red;
-		allUmbrellaColors[9 * i + 1] = green;
-		allUmbrellaColors[9 * i + 2] = blue;
-
-		allUmbrellaColors[9 * i + 3] = red;
-		allUmbrellaColors[9 * i + 4] = green;
-		allUmbrellaColors[9 * i + 5] = blue;
-
-		allUmbrellaColors[9 * i + 6] = red;
-		allUmbrellaColors[9 * i + 7] = green;
-		allUmbrellaColors[9 * i + 8] = blue;
+// 놀이기구가 쓰는 mesh 부분과 texture 등록. texture 는 여러 놀이기구가 같이 쓰면 각각에 모두 계산된다.
+void addRideUses(const char *ride, const Scene &scene, std::initializer_list<const Mesh *> meshes, std::initializer_list<GLuint> textures)
+{
+	GLResourceTracker &tracker = glResources();
+	for (const Mesh *mesh : meshes) {
+		tracker.addUse(ride, GL_RESOURCE_BUFFER, scene.vertexBuffer, sceneMeshVertexBytes(*mesh->sceneMesh));
+		tracker.addUse(ride, GL_RESOURCE_BUFFER, scene.indexBuffer, sceneMeshIndexBytes(*mesh->sceneMesh));
 	}
-	return allUmbrellaColors;
+	for (GLuint texture : textures)
+		tracker.addUse(ride, GL_RESOURCE_TEXTURE, texture);
 }
 
-//   uv buffer 
-GLfloat *makeUmbrellaUV(GLfloat *arr, GLint numberOfSides) {
-	GLfloat *allUmbrellaUVs = NULL;
-	GLfloat doublePi = 2.0f * 3.141592f;
-	allUmbrellaUVs = arr;
-
-	for (int i = 0; i < numberOfSides; i++)
-	{
-		allUmbrellaUVs[6 * i] = 0.5f;
-		allUmbrellaUVs[6 * i + 1] = 0.5f;
-
-		allUmbrellaUVs[6 * i + 2] = 0.5f + (0.5 * cos(i * doublePi / numberOfSides));
-		allUmbrellaUVs[6 * i + 3] = 0.5f + (0.5 * sin(i * doublePi / numberOfSides));
-
-		allUmbrellaUVs[6 * i + 4] = 0.5f + (0.5 * cos((i + 1) * doublePi / numberOfSides));
-		allUmbrellaUVs[6 * i + 5] = 0.5f + (0.5 * sin((i + 1) * doublePi / numberOfSides));
-
+// mesh 한 개 그리기. 이전 draw 와 같은 permutation / texture 면 다시 bind 하지 않는다.
+void drawMesh(RenderStateCache &renderState, GLuint vertexBuffer, const SceneMesh &sceneMesh, const glm::mat4 &MVP,
+	GLuint texture, bool depthOnly)
+{
+	// depth 만 쓸 때는 texture 가 필요 없으므로 가장 가벼운 vertex color permutation 을 쓴다.
+	if (depthOnly)
+		texture = 0;
+	unsigned int features = texture != 0 ? SHADER_TEXTURED : 0;
+	const ShaderProgram &program = renderState.apply(makeRenderStateKey(features, texture));
+	glUniformMatrix4fv(program.mvpLocation, 1, GL_FALSE, &MVP[0][0]);
+
+	if (FrameStats *stats = renderState.stats()) {
+		stats->drawCalls++;
+		stats->triangles += sceneMesh.indexCount / 3;
+		stats->vertices += sceneMesh.vertexCount;
+		stats->bufferBinds++;
+		stats->uniformUploads++;
 	}
-	return allUmbrellaUVs;
-}
-
-// Circle  UV buffer 
-GLfloat *makeCircleUVBuffer(GLfloat *arr, GLint sideNums) {
-	GLfloat *allCircleUVs = NULL;
 
-	GLint numberOfVertices = sideNums + 2;
-	GLfloat doublePi = 2.0f * 3.141592f;
-	allCircleUVs = arr;
-
-	allCircleUVs[0] = 0.5f;
-	allCircleUVs[1] = 0.5f;
-
-	for (int i = 0; i < numberOfVertices; i++)
-	{
-		allCircleUVs[2 * (i + 1)] = 0.5f + (0.5 * cos(i * doublePi / sideNums));
-		allCircleUVs[2 * (i + 1) + 1] = 0.5f + (0.5 * sin(i * doublePi / sideNums));
+	// 모든 mesh 가 하나의 vertex buffer 를 쓰고 attribute 마다 offset 만 다르다.
+	bool hasColor = !depthOnly && (sceneMesh.attributes & SCENE_ATTRIB_COLOR) != 0;
+	bool hasUV = !depthOnly && (sceneMesh.attributes & SCENE_ATTRIB_UV) != 0;
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)sceneMesh.positionOffset);
+	if (hasColor) {
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void*)sceneMesh.colorOffset);
 	}
-	return allCircleUVs;
-}
-
-// roller coaster rail vertex buffer  Լ
-GLfloat *makeRailVertexBuffer(GLfloat *arr, GLint numberOfSides) {
-	GLfloat *allRailVertexBuffer = NULL;
-	allRailVertexBuffer = arr;
-
-	GLfloat doublePi = 2.0f * 3.141592f; // -2 * 3.141592 ~ 2 * 3.141592
-	GLfloat angle = 0.0f; // -2 * 3.141592 ~ 2 * 3.141592
-	GLfloat nextangle = 0.0f; // -2 * 3.141592 ~ 2 * 3.141592
-	GLfloat segment = 4.0f * 3.141592f / ((float)numberOfSides);
-	GLfloat result = 0.0f, nextResult = 0.0f;
-	GLfloat height = 0.0f, nextheight = 0.0f;
-
-	for (int i = 0; i < numberOfSides; i++)
-	{
-		if (i > 0) angle += segment;
-		nextangle += segment;
-
-		height = -2.0f * 3.141592f + angle;
-		nextheight = -2.0f * 3.141592f + nextangle;
-
-		result = 3.0f * sin(height) / height + 2.0f * cos(height);
-		nextResult = 3.0f * sin(nextheight) / nextheight + 2.0f * cos(nextheight);
-
-		allRailVertexBuffer[18 * i] = 0.0 + (0.95f * cos(i * doublePi / numberOfSides));
-		allRailVertexBuffer[18 * i + 1] = result;
-		allRailVertexBuffer[18 * i + 2] = 0.0 + (0.95f * sin(i * doublePi / numberOfSides));
-
-		allRailVertexBuffer[18 * i + 3] = 0.0 + (1.05f * cos(i * doublePi / numberOfSides));
-		allRailVertexBuffer[18 * i + 4] = result;
-		allRailVertexBuffer[18 * i + 5] = 0.0 + (1.05f * sin(i * doublePi / numberOfSides));
-
-		allRailVertexBuffer[18 * i + 6] = 0.0 + (0.95f * cos((i + 1) * doublePi / numberOfSides));
-		allRailVertexBuffer[18 * i + 7] = nextResult;
-		allRailVertexBuffer[18 * i + 8] = 0.0 + (0.95f * sin((i + 1) * doublePi / numberOfSides));
-
-		allRailVertexBuffer[18 * i + 9] = 0.0 + (0.95f * cos((i + 1) * doublePi / numberOfSides));
-		allRailVertexBuffer[18 * i + 10] = nextResult;
-		allRailVertexBuffer[18 * i + 11] = 0.0 + (0.95f * sin((i + 1) * doublePi / numberOfSides));
-
-		allRailVertexBuffer[18 * i + 12] = 0.0 + (1.05f * cos((i + 1) * doublePi / numberOfSides));
-		allRailVertexBuffer[18 * i + 13] = nextResult;
-		allRailVertexBuffer[18 * i + 14] = 0.0 + (1.05f * sin((i + 1) * doublePi / numberOfSides));
-
-		allRailVertexBuffer[18 * i + 15] = 0.0 + (1.05f * cos(i * doublePi / numberOfSides));
-		allRailVertexBuffer[18 * i + 16] = result;
-		allRailVertexBuffer[18 * i + 17] = 0.0 + (1.05f * sin(i * doublePi / numberOfSides));
+	if (hasUV) {
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, (void*)sceneMesh.uvOffset);
 	}
 
-	return allRailVertexBuffer;
-}
-
-// roller coaster rail vertex buffer  Լ
-GLfloat *makeRailColorBuffer(GLfloat *arr, GLint numberOfSides, GLfloat red, GLfloat green, GLfloat blue) {
-	GLfloat *allRailColorBuffer = NULL;
-	allRailColorBuffer = arr;
-
-	for (int i = 0; i < numberOfSides; i++)
-	{
+	glDrawElements(GL_TRIANGLES, sceneMesh.indexCount, sceneMesh.indexType, (void*)sceneMesh.indexOffset);
 
-		allRailColorBuffer[18 * i] = red;
-		allRailColorBuffer[18 * i + 1] = green;
-		allRailColorBuffer[18 * i + 2] = blue;
-
-		allRailColorBuffer[18 * i + 3] = red;
-		allRailColorBuffer[18 * i + 4] = green;
-		allRailColorBuffer[18 * i + 5] = blue;
-
-		allRailColorBuffer[18 * i + 6] = red;
-		allRailColorBuffer[18 * i + 7] = green;
-		allRailColorBuffer[18 * i + 8] = blue;
-
-		allRailColorBuffer[18 * i + 9] = red;
-		allRailColorBuffer[18 * i + 10] = green;
-		allRailColorBuffer[18 * i + 11] = blue;
-
-		allRailColorBuffer[18 * i + 12] = red;
-		allRailColorBuffer[18 * i + 13] = green;
-		allRailColorBuffer[18 * i + 14] = blue;
-
-		allRailColorBuffer[18 * i + 15] = red;
-		allRailColorBuffer[18 * i + 16] = green;
-		allRailColorBuffer[18 * i + 17] = blue;
-	}
-
-	return allRailColorBuffer;
+	glDisableVertexAttribArray(0);
+	if (hasColor)
+		glDisableVertexAttribArray(1);
+	if (hasUV)
+		glDisableVertexAttribArray(2);
 }
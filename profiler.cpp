@@ -0,0 +1,206 @@
+#include <stdio.h>
+
+#include <GL/glew.h>
+
+#include "profiler.hpp"
+
+// Enough for several minutes of frames at 60 fps; recording simply stops after that
+#define PROFILER_MAX_EVENTS (1 << 20)
+#define PROFILER_TIMESTAMPS_PER_FRAME 64
+#define PROFILER_CALIBRATE_INTERVAL 300
+
+FrameProfiler::FrameProfiler()
+	: gpuTiming(false), origin(std::chrono::steady_clock::now()), gpuOffsetUs(0.0),
+	current(-1), frameNumber(0), droppedFrames(0){
+}
+
+FrameProfiler::~FrameProfiler(){
+	shutdown();
+}
+
+double FrameProfiler::nowUs() const{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void FrameProfiler::init(int frameLatency){
+	gpuTiming = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+	if (!gpuTiming)
+		printf("No timer queries, the profiler records CPU time only\n");
+
+	frames.resize(frameLatency + 1);
+	for (size_t i = 0; i < frames.size(); i++) {
+		Frame & frame = frames[i];
+		frame.number = -1;
+		frame.pending = false;
+		frame.cpuStart = 0.0;
+		frame.elapsedQuery = 0;
+		frame.usedTimestamps = 0;
+		if (gpuTiming) {
+			glGenQueries(1, &frame.elapsedQuery);
+			frame.timestamps.resize(PROFILER_TIMESTAMPS_PER_FRAME);
+			glGenQueries(PROFILER_TIMESTAMPS_PER_FRAME, frame.timestamps.data());
+		}
+	}
+	current = -1;
+	if (gpuTiming)
+		calibrateGpuClock();
+}
+
+void FrameProfiler::shutdown(){
+	for (size_t i = 0; i < frames.size(); i++) {
+		Frame & frame = frames[i];
+		if (frame.elapsedQuery != 0)
+			glDeleteQueries(1, &frame.elapsedQuery);
+		if (!frame.timestamps.empty())
+			glDeleteQueries((GLsizei)frame.timestamps.size(), frame.timestamps.data());
+	}
+	frames.clear();
+	current = -1;
+}
+
+// GL_TIMESTAMP counts in GPU time; match it against the CPU clock so both tracks line up.
+// Reading GL_TIMESTAMP with glGetInteger64v doesn't wait for queued commands to finish.
+void FrameProfiler::calibrateGpuClock(){
+	GLint64 gpuNs = 0;
+	double cpu = nowUs();
+	glGetInteger64v(GL_TIMESTAMP, &gpuNs);
+	gpuOffsetUs = cpu - gpuNs / 1000.0;
+}
+
+void FrameProfiler::addEvent(const char * name, int track, double start, double duration, long long number){
+	if (events.size() >= PROFILER_MAX_EVENTS)
+		return;
+	Event event = { name, track, start, duration, number };
+	events.push_back(event);
+}
+
+int FrameProfiler::issueTimestamp(Frame & frame){
+	if (!gpuTiming || frame.usedTimestamps == (int)frame.timestamps.size())
+		return -1;
+	glQueryCounter(frame.timestamps[frame.usedTimestamps], GL_TIMESTAMP);
+	return frame.usedTimestamps++;
+}
+
+// Reads a finished frame's queries. Returns false without blocking if the GPU isn't done yet.
+bool FrameProfiler::collect(Frame & frame){
+	if (gpuTiming) {
+		// Queries complete in order, so the frame's last query tells for all of them
+		GLuint available = 0;
+		glGetQueryObjectuiv(frame.elapsedQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			return false;
+
+		GLuint64 start = 0, elapsed = 0;
+		glGetQueryObjectui64v(frame.timestamps[0], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(frame.elapsedQuery, GL_QUERY_RESULT, &elapsed);
+		addEvent("frame (GPU)", 1, start / 1000.0 + gpuOffsetUs, elapsed / 1000.0, frame.number);
+
+		for (size_t i = 0; i < frame.scopes.size(); i++) {
+			const Scope & scope = frame.scopes[i];
+			if (scope.gpuBegin < 0 || scope.gpuEnd < 0)
+				continue;
+			GLuint64 begin = 0, end = 0;
+			glGetQueryObjectui64v(frame.timestamps[scope.gpuBegin], GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(frame.timestamps[scope.gpuEnd], GL_QUERY_RESULT, &end);
+			addEvent(scope.name, 1, begin / 1000.0 + gpuOffsetUs, (end - begin) / 1000.0, frame.number);
+		}
+	}
+	frame.pending = false;
+	return true;
+}
+
+void FrameProfiler::beginFrame(){
+	if (frames.empty())
+		return;
+
+	current = (current + 1) % (int)frames.size();
+	Frame & frame = frames[current];
+	if (frame.pending && !collect(frame)) {
+		// Still running after frameLatency frames: give up on it rather than stall
+		droppedFrames++;
+		frame.pending = false;
+	}
+
+	if (gpuTiming && frameNumber % PROFILER_CALIBRATE_INTERVAL == 0)
+		calibrateGpuClock();
+
+	frame.number = frameNumber++;
+	frame.cpuStart = nowUs();
+	frame.usedTimestamps = 0;
+	frame.scopes.clear();
+	openScopes.clear();
+	if (gpuTiming) {
+		// Timestamp 0 places the frame on the GPU track
+		issueTimestamp(frame);
+		glBeginQuery(GL_TIME_ELAPSED, frame.elapsedQuery);
+	}
+}
+
+void FrameProfiler::endFrame(){
+	if (current < 0)
+		return;
+	Frame & frame = frames[current];
+	while (!openScopes.empty())
+		endScope();
+
+	double end = nowUs();
+	addEvent("frame", 0, frame.cpuStart, end - frame.cpuStart, frame.number);
+	for (size_t i = 0; i < frame.scopes.size(); i++) {
+		const Scope & scope = frame.scopes[i];
+		addEvent(scope.name, 0, scope.cpuStart, scope.cpuEnd - scope.cpuStart, frame.number);
+	}
+
+	if (gpuTiming) {
+		glEndQuery(GL_TIME_ELAPSED);
+		frame.pending = true;
+	}
+}
+
+void FrameProfiler::beginScope(const char * name, bool gpu){
+	if (current < 0)
+		return;
+	Frame & frame = frames[current];
+	Scope scope;
+	scope.name = name;
+	scope.depth = (int)openScopes.size();
+	scope.cpuStart = nowUs();
+	scope.cpuEnd = scope.cpuStart;
+	scope.gpuBegin = gpu ? issueTimestamp(frame) : -1;
+	scope.gpuEnd = -1;
+	openScopes.push_back((int)frame.scopes.size());
+	frame.scopes.push_back(scope);
+}
+
+void FrameProfiler::endScope(){
+	if (current < 0 || openScopes.empty())
+		return;
+	Frame & frame = frames[current];
+	Scope & scope = frame.scopes[openScopes.back()];
+	openScopes.pop_back();
+	if (scope.gpuBegin >= 0)
+		scope.gpuEnd = issueTimestamp(frame);
+	scope.cpuEnd = nowUs();
+}
+
+bool FrameProfiler::writeTrace(const char * path) const{
+	FILE * file = fopen(path, "w");
+	if (file == NULL) {
+		printf("Could not write %s\n", path);
+		return false;
+	}
+
+	fprintf(file, "{\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n");
+	fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GPU\"}}");
+	for (size_t i = 0; i < events.size(); i++) {
+		const Event & event = events[i];
+		fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%lld}}",
+			event.name, event.track == 0 ? "cpu" : "gpu", event.track, event.start, event.duration, event.frame);
+	}
+	fprintf(file, "\n]}\n");
+
+	bool ok = fclose(file) == 0;
+	if (ok)
+		printf("Wrote %d trace events to %s (%d frames without GPU times)\n", (int)events.size(), path, droppedFrames);
+	return ok;
+}
@@ -0,0 +1,98 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <chrono>
+#include <vector>
+
+// Frame profiler: nestable CPU scopes plus GPU time for the scopes that ask for it,
+// exported as a Chrome trace (chrome://tracing, Perfetto).
+//
+// GPU scopes put a GL_TIMESTAMP query at each end, and every frame is wrapped in a
+// GL_TIME_ELAPSED query. Queries go into a ring of frames and are only read back once the
+// ring comes around to them again, several frames later; if the GPU still hasn't finished
+// by then the frame's GPU results are dropped instead of waited for. Without timer query
+// support only the CPU side is recorded.
+//
+// Scope names must be string literals (or otherwise outlive the profiler).
+class FrameProfiler {
+public:
+	FrameProfiler();
+	~FrameProfiler();
+
+	// Needs a current GL context. frameLatency is how many frames a query gets before its
+	// result is wanted.
+	void init(int frameLatency = 4);
+	void shutdown();
+
+	void beginFrame();
+	void endFrame();
+
+	void beginScope(const char * name, bool gpu = false);
+	void endScope();
+
+	// Writes everything recorded so far.
+	bool writeTrace(const char * path) const;
+
+	int droppedGpuFrames() const { return droppedFrames; }
+
+private:
+	struct Scope {
+		const char * name;
+		int depth;
+		double cpuStart;
+		double cpuEnd;
+		int gpuBegin; // query index in the frame, -1 for CPU only
+		int gpuEnd;
+	};
+
+	struct Frame {
+		long long number;
+		bool pending;           // queries issued, results not read yet
+		double cpuStart;
+		GLuint elapsedQuery;
+		std::vector<GLuint> timestamps;
+		int usedTimestamps;
+		std::vector<Scope> scopes;
+	};
+
+	struct Event {
+		const char * name;
+		int track; // 0 CPU, 1 GPU
+		double start; // us
+		double duration;
+		long long frame;
+	};
+
+	double nowUs() const;
+	void calibrateGpuClock();
+	bool collect(Frame & frame);
+	int issueTimestamp(Frame & frame);
+	void addEvent(const char * name, int track, double start, double duration, long long frameNumber);
+
+	bool gpuTiming;
+	std::chrono::steady_clock::time_point origin;
+	double gpuOffsetUs; // CPU time in us = GPU time in us + offset
+	std::vector<Frame> frames;
+	int current;
+	long long frameNumber;
+	std::vector<int> openScopes;
+	std::vector<Event> events;
+	int droppedFrames;
+};
+
+// Begins a scope and ends it when leaving the C++ scope.
+class ProfileScope {
+public:
+	ProfileScope(FrameProfiler & profiler, const char * name, bool gpu = false)
+		: profiler(profiler){
+		profiler.beginScope(name, gpu);
+	}
+	~ProfileScope(){
+		profiler.endScope();
+	}
+
+private:
+	FrameProfiler & profiler;
+};
+
+#endif
@@ -0,0 +1,32 @@
+#include <GL/glew.h>
+
+#include "renderstate.hpp"
+
+RenderStateCache::RenderStateCache(const ShaderProgram * programs, FrameStats * stats)
+	: programs(programs), boundProgram(0), boundTexture(0), frameStats(stats){
+}
+
+const ShaderProgram & RenderStateCache::apply(RenderStateKey key){
+	const ShaderProgram & program = programs[renderStateFeatures(key)];
+	if (program.program != boundProgram) {
+		glUseProgram(program.program);
+		boundProgram = program.program;
+		if (frameStats != NULL)
+			frameStats->programBinds++;
+	}
+
+	GLuint texture = renderStateTexture(key);
+	if (texture != 0 && texture != boundTexture) {
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		boundTexture = texture;
+		if (frameStats != NULL)
+			frameStats->textureBinds++;
+	}
+	return program;
+}
+
+void RenderStateCache::invalidate(){
+	boundProgram = 0;
+	boundTexture = 0;
+}
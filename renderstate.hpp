@@ -0,0 +1,48 @@
+#ifndef RENDERSTATE_HPP
+#define RENDERSTATE_HPP
+
+#include <stdint.h>
+
+#include "shaderpermutation.hpp"
+#include "renderstats.hpp"
+
+// Everything a draw needs bound apart from its vertex buffers and MVP: the shader permutation
+// (feature bits) and the texture. Draws with equal keys can share state, and sorting by the key
+// groups them.
+typedef uint64_t RenderStateKey;
+
+inline RenderStateKey makeRenderStateKey(unsigned int features, GLuint texture){
+	return ((uint64_t)features << 32) | texture;
+}
+
+inline unsigned int renderStateFeatures(RenderStateKey key){
+	return (unsigned int)(key >> 32);
+}
+
+inline GLuint renderStateTexture(RenderStateKey key){
+	return (GLuint)(key & 0xffffffffu);
+}
+
+// Tracks the bound program and texture and only issues the GL calls for what changed.
+// With stats given, the binds it does issue are counted there.
+class RenderStateCache {
+public:
+	explicit RenderStateCache(const ShaderProgram * programs, FrameStats * stats = NULL);
+
+	// Binds the permutation and texture for key and returns the program, for its uniforms.
+	const ShaderProgram & apply(RenderStateKey key);
+
+	// Forget what is bound, e.g. after other code has changed program or texture bindings.
+	void invalidate();
+
+	// Counters for the draws made through this cache, or NULL.
+	FrameStats * stats() const { return frameStats; }
+
+private:
+	const ShaderProgram * programs;
+	GLuint boundProgram;
+	GLuint boundTexture;
+	FrameStats * frameStats;
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include <string.h>
+#include <algorithm>
+
+#include "renderstats.hpp"
+
+static void addFrameStats(FrameStats & sum, const FrameStats & frame){
+	sum.drawCalls += frame.drawCalls;
+	sum.triangles += frame.triangles;
+	sum.vertices += frame.vertices;
+	sum.programBinds += frame.programBinds;
+	sum.bufferBinds += frame.bufferBinds;
+	sum.textureBinds += frame.textureBinds;
+	sum.uniformUploads += frame.uniformUploads;
+	sum.uploadBytes += frame.uploadBytes;
+	sum.shadedSamples += frame.shadedSamples;
+	sum.screenSamples += frame.screenSamples;
+}
+
+RenderStats::RenderStats(int windowSize)
+	: windowSize(windowSize > 0 ? windowSize : 1), nextFrameTime(0), printInterval(5.0),
+	sincePrintMs(0.0), sincePrintFrames(0), csv(NULL), frameNumber(0){
+	memset(&current, 0, sizeof(current));
+	memset(&last, 0, sizeof(last));
+	memset(&total, 0, sizeof(total));
+	memset(&sincePrint, 0, sizeof(sincePrint));
+}
+
+RenderStats::~RenderStats(){
+	closeCsv();
+}
+
+bool RenderStats::openCsv(const char * path){
+	closeCsv();
+	csv = fopen(path, "w");
+	if (csv == NULL) {
+		printf("Could not write %s\n", path);
+		return false;
+	}
+	fprintf(csv, "frame,frameMs,drawCalls,triangles,vertices,programBinds,bufferBinds,textureBinds,uniformUploads,uploadBytes,overdraw\n");
+	return true;
+}
+
+void RenderStats::closeCsv(){
+	if (csv != NULL)
+		fclose(csv);
+	csv = NULL;
+}
+
+double RenderStats::frameTime(int i) const{
+	// Before the ring fills up, entry 0 is the oldest
+	if ((int)frameTimes.size() < windowSize)
+		return frameTimes[i];
+	return frameTimes[(nextFrameTime + i) % windowSize];
+}
+
+double RenderStats::percentile(double p) const{
+	if (frameTimes.empty())
+		return 0.0;
+	std::vector<double> sorted(frameTimes);
+	size_t rank = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+	rank = std::min(rank, sorted.size() - 1);
+	std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+	return sorted[rank];
+}
+
+void RenderStats::endFrame(double frameMs){
+	if ((int)frameTimes.size() < windowSize)
+		frameTimes.push_back(frameMs);
+	else
+		frameTimes[nextFrameTime] = frameMs;
+	nextFrameTime = (nextFrameTime + 1) % windowSize;
+
+	if (csv != NULL) {
+		fprintf(csv, "%lld,%.3f,%u,%u,%u,%u,%u,%u,%u,%lu,%.3f\n", frameNumber, frameMs,
+			current.drawCalls, current.triangles, current.vertices,
+			current.programBinds, current.bufferBinds, current.textureBinds,
+			current.uniformUploads, (unsigned long)current.uploadBytes, overdraw(current));
+	}
+
+	addFrameStats(sincePrint, current);
+	addFrameStats(total, current);
+	sincePrintFrames++;
+	sincePrintMs += frameMs;
+	if (printInterval > 0.0 && sincePrintMs >= printInterval * 1000.0) {
+		printSummary();
+		memset(&sincePrint, 0, sizeof(sincePrint));
+		sincePrintFrames = 0;
+		sincePrintMs = 0.0;
+	}
+
+	last = current;
+	memset(&current, 0, sizeof(current));
+	frameNumber++;
+}
+
+void RenderStats::printSummary() const{
+	double frames = sincePrintFrames;
+	printf("%d frames, %.1f fps | frame ms p50 %.2f p95 %.2f p99 %.2f\n",
+		sincePrintFrames, frames * 1000.0 / sincePrintMs, percentile(50.0), percentile(95.0), percentile(99.0));
+	printf("  per frame: %.1f draws, %.0f tris, %.0f verts | binds: %.1f program, %.1f buffer, %.1f texture | %.1f uniforms | %.1f KB uploaded | overdraw %.2f\n",
+		sincePrint.drawCalls / frames, sincePrint.triangles / frames, sincePrint.vertices / frames,
+		sincePrint.programBinds / frames, sincePrint.bufferBinds / frames, sincePrint.textureBinds / frames,
+		sincePrint.uniformUploads / frames, sincePrint.uploadBytes / frames / 1024.0, overdraw(sincePrint));
+}
@@ -0,0 +1,81 @@
+#ifndef RENDERSTATS_HPP
+#define RENDERSTATS_HPP
+
+#include <stddef.h>
+#include <stdio.h>
+#include <vector>
+
+// What one frame submitted to GL. The renderer increments these as it goes.
+struct FrameStats {
+	unsigned int drawCalls;
+	unsigned int triangles;
+	unsigned int vertices;
+	unsigned int programBinds;
+	unsigned int bufferBinds;
+	unsigned int textureBinds;
+	unsigned int uniformUploads;
+	size_t uploadBytes;
+	// Overdraw measurement (OverdrawMeter) that finished during the frame, if any: samples
+	// shaded by the opaque pass and samples on screen. The ratio is the overdraw.
+	size_t shadedSamples;
+	size_t screenSamples;
+};
+
+// shadedSamples / screenSamples, 0 without a measurement.
+inline double overdraw(const FrameStats & stats){
+	return stats.screenSamples > 0 ? (double)stats.shadedSamples / stats.screenSamples : 0.0;
+}
+
+// Collects FrameStats and frame times.
+//
+// Frame times are kept over a sliding window of the last windowSize frames for the p50/p95/p99
+// percentiles. Every printInterval seconds a summary (counter averages since the last print
+// plus the percentiles) goes to stdout, and with a CSV open every frame is written as a row.
+class RenderStats {
+public:
+	explicit RenderStats(int windowSize = 240);
+	~RenderStats();
+
+	// Counters of the frame in progress.
+	FrameStats & frame() { return current; }
+	// Counters of the last finished frame.
+	const FrameStats & lastFrame() const { return last; }
+	// Sums over every finished frame.
+	const FrameStats & totals() const { return total; }
+	long long frameCount() const { return frameNumber; }
+
+	// Finishes the frame: records frameMs, prints or writes what's due and resets the counters.
+	void endFrame(double frameMs);
+
+	// Percentile (0..100) of the frame times in the window, 0 before the first frame.
+	double percentile(double p) const;
+	// Frame times in the window, oldest first.
+	int frameTimeCount() const { return (int)frameTimes.size(); }
+	double frameTime(int i) const;
+
+	// 0 disables the periodic print.
+	void setPrintInterval(double seconds) { printInterval = seconds; }
+	bool openCsv(const char * path);
+	void closeCsv();
+
+private:
+	void printSummary() const;
+
+	FrameStats current;
+	FrameStats last;
+	FrameStats total;
+
+	std::vector<double> frameTimes; // ring of windowSize entries
+	int windowSize;
+	int nextFrameTime;
+
+	double printInterval;
+	double sincePrintMs;
+	int sincePrintFrames;
+	FrameStats sincePrint; // sums over the frames since the last print
+
+	FILE * csv;
+	long long frameNumber;
+};
+
+#endif
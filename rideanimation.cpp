@@ -0,0 +1,413 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "hash.hpp"
+#include "shadercache.hpp"
+#include "rides.hpp"
+#include "rideanimation.hpp"
+
+#define RIDE_VERIFY_INSTANCES 256
+
+static const float s_pi = 3.14159265f;
+
+// 0..1 from 8 bits of hash
+static float hashUnit(uint64_t hash, int byte){
+	return ((hash >> (byte * 8)) & 0xff) / 255.0f;
+}
+
+// The placed-th flat ride, at grid position (x, z)
+static void addFlatRide(int placed, int x, int z, std::vector<RideInstance> * instances){
+	uint64_t hash = hashBytes(&placed, sizeof(placed));
+	RideType type = ((x + z) & 1) ? RIDE_TYPE_VIKING : RIDE_TYPE_MERRY_GO_ROUND;
+	RideInstance ride;
+	ride.pivot = glm::vec4(x * RIDE_GRID_SPACING, 0.0f, z * RIDE_GRID_SPACING, hashUnit(hash, 0) * 2.0f * s_pi);
+	float speed = s_pi / 2.0f * (0.8f + 0.4f * hashUnit(hash, 1));
+	float amplitude = type == RIDE_TYPE_VIKING ? 0.9f + 0.3f * hashUnit(hash, 2) : 0.3f + 0.2f * hashUnit(hash, 2);
+	ride.motion = glm::vec4(amplitude, hashUnit(hash, 3), speed, 0.0f);
+	instances[type].push_back(ride);
+}
+
+// How many rides layoutFlatRides places before the one at grid position (x, z); -1 inside the park
+static long long flatRideIndex(int x, int z){
+	long long ring = std::max(abs(x), abs(z));
+	if (ring <= RIDE_PARK_RINGS)
+		return -1;
+	// Ring r has 8r positions, visited row by row: all of its first and last rows, the two ends
+	// of the rows between
+	long long before = (2 * ring - 1) * (2 * ring - 1) - (2 * RIDE_PARK_RINGS + 1) * (2 * RIDE_PARK_RINGS + 1);
+	if (z == -ring)
+		return before + x + ring;
+	if (z == ring)
+		return before + (2 * ring + 1) + 2 * (2 * ring - 1) + x + ring;
+	return before + (2 * ring + 1) + 2 * (z + ring - 1) + (x == ring ? 1 : 0);
+}
+
+void layoutFlatRides(int count, std::vector<RideInstance> * instances){
+	int placed = 0;
+	for (int ring = RIDE_PARK_RINGS + 1; placed < count; ring++) {
+		for (int z = -ring; z <= ring && placed < count; z++) {
+			for (int x = -ring; x <= ring && placed < count; x++) {
+				if (abs(x) != ring && abs(z) != ring)
+					continue;
+				addFlatRide(placed, x, z, instances);
+				placed++;
+			}
+		}
+	}
+}
+
+void layoutFlatRideArea(int count, int minX, int minZ, int maxX, int maxZ, std::vector<RideInstance> * instances){
+	for (int z = minZ; z <= maxZ; z++) {
+		for (int x = minX; x <= maxX; x++) {
+			long long placed = flatRideIndex(x, z);
+			if (placed >= 0 && placed < count)
+				addFlatRide((int)placed, x, z, instances);
+		}
+	}
+}
+
+void standRidesOnGround(std::vector<RideInstance> & rides, float (*groundHeight)(float x, float z), float floorY){
+	for (size_t i = 0; i < rides.size(); i++) {
+		glm::vec4 & pivot = rides[i].pivot;
+		float ground = groundHeight(pivot.x, pivot.z);
+		for (int corner = 0; corner < 4; corner++)
+			ground = std::min(ground, groundHeight(pivot.x + ((corner & 1) ? 3.0f : -3.0f), pivot.z + ((corner & 2) ? 3.0f : -3.0f)));
+		pivot.y = ground - floorY;
+	}
+}
+
+AnimatedRides::AnimatedRides()
+	: vertexBuffer(0), culling(false){
+	for (int i = 0; i < RIDE_TYPE_COUNT; i++) {
+		firstInstance[i] = 0;
+		visibleOffset[i] = 0;
+		visibleCount[i] = 0;
+	}
+	for (int i = 0; i < 2; i++)
+		locations[i] = findLocations(0);
+}
+
+AnimatedRides::~AnimatedRides(){
+	shutdown();
+}
+
+AnimatedRides::Locations AnimatedRides::findLocations(GLuint program){
+	Locations result;
+	result.time = program != 0 ? glGetUniformLocation(program, "time") : -1;
+	result.motion = program != 0 ? glGetUniformLocation(program, "partMotion") : -1;
+	result.rotation = program != 0 ? glGetUniformLocation(program, "partRotation") : -1;
+	result.bob = program != 0 ? glGetUniformLocation(program, "partBob") : -1;
+	result.base = program != 0 ? glGetUniformLocation(program, "partBase") : -1;
+	result.local = program != 0 ? glGetUniformLocation(program, "partLocal") : -1;
+	return result;
+}
+
+bool AnimatedRides::init(const Scene & scene, const ShaderProgram * programs, const std::vector<RideInstance> * instances){
+	shutdown();
+	std::vector<RidePart> typeParts[RIDE_TYPE_COUNT];
+	vikingRideParts(typeParts[RIDE_TYPE_VIKING]);
+	merryGoRoundRideParts(typeParts[RIDE_TYPE_MERRY_GO_ROUND]);
+
+	std::vector<RideInstance> all;
+	for (int type = 0; type < RIDE_TYPE_COUNT; type++) {
+		this->instances[type] = instances[type];
+		firstInstance[type] = all.size();
+		all.insert(all.end(), instances[type].begin(), instances[type].end());
+		for (size_t i = 0; i < typeParts[type].size(); i++) {
+			PartDraw draw;
+			draw.type = (RideType)type;
+			draw.part = typeParts[type][i];
+			draw.mesh = findSceneMesh(scene, draw.part.mesh);
+			if (draw.mesh == NULL) {
+				printf("Scene has no mesh named %s for the animated rides\n", draw.part.mesh);
+				parts.clear();
+				return false;
+			}
+			parts.push_back(draw);
+		}
+	}
+	vertexBuffer = scene.vertexBuffer;
+	locations[0] = findLocations(programs[SHADER_RIDE_ANIMATION].program);
+	locations[1] = findLocations(programs[SHADER_RIDE_ANIMATION | SHADER_TEXTURED].program);
+	if (all.empty())
+		return true;
+
+	// The rides don't move, so the instances are written once
+	instanceBuffer.create("ride animation", "instances");
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, all.size() * sizeof(RideInstance), &all[0], GL_STATIC_DRAW);
+	instanceBuffer.setSize(all.size() * sizeof(RideInstance));
+	return true;
+}
+
+void AnimatedRides::shutdown(){
+	parts.clear();
+	for (int i = 0; i < RIDE_TYPE_COUNT; i++)
+		instances[i].clear();
+	instanceBuffer.reset();
+	visibleBuffer.shutdown();
+	culling = false;
+	vertexBuffer = 0;
+}
+
+int AnimatedRides::instanceCount() const{
+	int count = 0;
+	for (int i = 0; i < RIDE_TYPE_COUNT; i++)
+		count += (int)instances[i].size();
+	return count;
+}
+
+int AnimatedRides::drawnCount() const{
+	if (!culling)
+		return instanceCount();
+	int count = 0;
+	for (int i = 0; i < RIDE_TYPE_COUNT; i++)
+		count += visibleCount[i];
+	return count;
+}
+
+void AnimatedRides::rideReach(float * reach, float * bobReach) const{
+	// Whatever the angle about its axis, a part stays within a sphere around its base's origin,
+	// and the base's origin turns with the yaw around the pivot; so a sphere around the pivot
+	// holds the ride, with the bob added for the parts that bob
+	for (int type = 0; type < RIDE_TYPE_COUNT; type++) {
+		reach[type] = 0.0f;
+		bobReach[type] = 0.0f;
+	}
+	for (size_t i = 0; i < parts.size(); i++) {
+		const PartDraw & draw = parts[i];
+		const SceneMesh & mesh = *draw.mesh;
+		Aabb local = transformAabb(glm::vec3(mesh.boundsMin[0], mesh.boundsMin[1], mesh.boundsMin[2]),
+			glm::vec3(mesh.boundsMax[0], mesh.boundsMax[1], mesh.boundsMax[2]), draw.part.local);
+		float localReach = glm::length(glm::max(glm::abs(local.min), glm::abs(local.max)));
+		const glm::mat4 & base = draw.part.base;
+		float scale = std::max(glm::length(glm::vec3(base[0])), std::max(glm::length(glm::vec3(base[1])), glm::length(glm::vec3(base[2]))));
+		reach[draw.type] = std::max(reach[draw.type], glm::length(glm::vec3(base[3])) + scale * localReach);
+		if (draw.part.motion == RIDE_MOTION_SPIN)
+			bobReach[draw.type] = std::max(bobReach[draw.type], scale * glm::length(draw.part.bobDirection));
+	}
+}
+
+void AnimatedRides::rideBounds(std::vector<Aabb> & bounds) const{
+	float reach[RIDE_TYPE_COUNT], bobReach[RIDE_TYPE_COUNT];
+	rideReach(reach, bobReach);
+	bounds.clear();
+	for (int type = 0; type < RIDE_TYPE_COUNT; type++) {
+		for (size_t i = 0; i < instances[type].size(); i++) {
+			const RideInstance & ride = instances[type][i];
+			float radius = reach[type] + bobReach[type] * fabsf(ride.motion.x);
+			Aabb box;
+			box.min = glm::vec3(ride.pivot) - glm::vec3(radius);
+			box.max = glm::vec3(ride.pivot) + glm::vec3(radius);
+			bounds.push_back(box);
+		}
+	}
+}
+
+size_t AnimatedRides::setVisible(const uint32_t * rides, size_t count){
+	if (instanceBuffer == 0)
+		return 0;
+	size_t total = (size_t)instanceCount();
+	if (visibleBuffer.buffer() == 0
+		&& !visibleBuffer.init(GL_ARRAY_BUFFER, total * sizeof(RideInstance), 3, "ride animation", "visible instances"))
+		return 0;
+	size_t bytes = count * sizeof(RideInstance);
+	size_t offset = 0;
+	visibleBuffer.beginFrame(bytes);
+	RideInstance * dst = count > 0 ? (RideInstance *)visibleBuffer.map(bytes, sizeof(RideInstance), offset) : NULL;
+	if (count > 0 && dst == NULL) {
+		// Draw everything from the static buffer this frame
+		visibleBuffer.endFrame();
+		culling = false;
+		return 0;
+	}
+	// The list is in instance order, so each type's rides are one run
+	size_t next = 0;
+	for (int type = 0; type < RIDE_TYPE_COUNT; type++) {
+		visibleOffset[type] = offset + next * sizeof(RideInstance);
+		size_t end = firstInstance[type] + instances[type].size();
+		size_t begin = next;
+		for (; next < count && rides[next] < end; next++)
+			dst[next] = instances[type][rides[next] - firstInstance[type]];
+		visibleCount[type] = (GLsizei)(next - begin);
+	}
+	if (count > 0)
+		visibleBuffer.unmap();
+	culling = true;
+	return bytes;
+}
+
+void AnimatedRides::endFrame(){
+	if (culling)
+		visibleBuffer.endFrame();
+}
+
+void AnimatedRides::setPartUniforms(const Locations & locations, const RidePart & part, float time){
+	glUniform1f(locations.time, time);
+	glUniform1i(locations.motion, part.motion);
+	glUniform4f(locations.rotation, part.axis.x, part.axis.y, part.axis.z, part.angleOffset);
+	glUniform4f(locations.bob, part.bobDirection.x, part.bobDirection.y, part.bobDirection.z, part.bobPhase);
+	glUniformMatrix4fv(locations.base, 1, GL_FALSE, &part.base[0][0]);
+	glUniformMatrix4fv(locations.local, 1, GL_FALSE, &part.local[0][0]);
+}
+
+// The type's rides in the instance buffer, or its visible ones
+RideRun AnimatedRides::ownRun(RideType type, bool visibleOnly) const{
+	RideRun run;
+	if (visibleOnly) {
+		run.buffer = visibleBuffer.buffer();
+		run.offset = visibleOffset[type];
+		run.count = visibleCount[type];
+	} else {
+		run.buffer = instanceBuffer;
+		run.offset = firstInstance[type] * sizeof(RideInstance);
+		run.count = (GLsizei)instances[type].size();
+	}
+	return run;
+}
+
+// Attributes 3 and 4 step once per instance, from the run's first ride
+void AnimatedRides::bindInstances(const RideRun & run){
+	size_t offset = run.offset;
+	glBindBuffer(GL_ARRAY_BUFFER, run.buffer);
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(RideInstance), (void*)(offset + offsetof(RideInstance, pivot)));
+	glVertexAttribDivisor(3, 1);
+	glEnableVertexAttribArray(4);
+	glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(RideInstance), (void*)(offset + offsetof(RideInstance, motion)));
+	glVertexAttribDivisor(4, 1);
+}
+
+void AnimatedRides::draw(RenderStateCache & renderState, const glm::mat4 & viewProjection, float time, const GLuint * textures,
+	bool depthOnly, const std::vector<RideRun> * runs){
+	for (size_t i = 0; i < parts.size(); i++) {
+		const PartDraw & draw = parts[i];
+		RideRun own = ownRun(draw.type, culling);
+		GLsizei count = own.count;
+		size_t runCount = own.count > 0 ? 1 : 0;
+		if (runs != NULL) {
+			for (size_t r = 0; r < runs[draw.type].size(); r++)
+				count += runs[draw.type][r].count;
+			runCount += runs[draw.type].size();
+		}
+		if (count == 0)
+			continue;
+		const SceneMesh & sceneMesh = *draw.mesh;
+		GLuint texture = depthOnly ? 0 : textures[draw.part.texture];
+		unsigned int features = SHADER_RIDE_ANIMATION | (texture != 0 ? SHADER_TEXTURED : 0);
+		const ShaderProgram & program = renderState.apply(makeRenderStateKey(features, texture));
+		glUniformMatrix4fv(program.mvpLocation, 1, GL_FALSE, &viewProjection[0][0]);
+		setPartUniforms(locations[texture != 0 ? 1 : 0], draw.part, time);
+
+		if (FrameStats *stats = renderState.stats()) {
+			stats->drawCalls += runCount;
+			stats->triangles += sceneMesh.indexCount / 3 * count;
+			stats->vertices += sceneMesh.vertexCount * count;
+			stats->bufferBinds += 1 + runCount;
+			stats->uniformUploads += 7;
+		}
+
+		// Same attributes as drawMesh, plus the instances
+		bool hasColor = !depthOnly && (sceneMesh.attributes & SCENE_ATTRIB_COLOR) != 0;
+		bool hasUV = !depthOnly && (sceneMesh.attributes & SCENE_ATTRIB_UV) != 0;
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)sceneMesh.positionOffset);
+		if (hasColor) {
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void*)sceneMesh.colorOffset);
+		}
+		if (hasUV) {
+			glEnableVertexAttribArray(2);
+			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, (void*)sceneMesh.uvOffset);
+		}
+		if (own.count > 0) {
+			bindInstances(own);
+			glDrawElementsInstanced(GL_TRIANGLES, sceneMesh.indexCount, sceneMesh.indexType, (void*)sceneMesh.indexOffset, own.count);
+		}
+		for (size_t r = 0; runs != NULL && r < runs[draw.type].size(); r++) {
+			const RideRun & run = runs[draw.type][r];
+			if (run.count == 0)
+				continue;
+			bindInstances(run);
+			glDrawElementsInstanced(GL_TRIANGLES, sceneMesh.indexCount, sceneMesh.indexType, (void*)sceneMesh.indexOffset, run.count);
+		}
+
+		glDisableVertexAttribArray(0);
+		if (hasColor)
+			glDisableVertexAttribArray(1);
+		if (hasUV)
+			glDisableVertexAttribArray(2);
+		glDisableVertexAttribArray(3);
+		glDisableVertexAttribArray(4);
+	}
+}
+
+bool AnimatedRides::verify(const std::string & vertexSource, const float * times, int timeCount, float tolerance, float & maxError){
+	maxError = 0.0f;
+	if (parts.empty() || instanceBuffer == 0)
+		return true;
+
+	static const char * varyings[] = { "rideModel0", "rideModel1", "rideModel2", "rideModel3" };
+	std::string source = injectShaderDefines(vertexSource, SHADER_RIDE_ANIMATION);
+	GLProgram program;
+	program.adopt(compileCaptureProgram(source.c_str(), varyings, 4), "ride animation", "verify capture");
+	if (program == 0) {
+		printf("Ride animation capture program failed to build\n");
+		return false;
+	}
+	Locations captureLocations = findLocations(program);
+	glUseProgram(program);
+
+	size_t capacity = 0;
+	for (int type = 0; type < RIDE_TYPE_COUNT; type++)
+		capacity = std::max(capacity, std::min(instances[type].size(), (size_t)RIDE_VERIFY_INSTANCES));
+	GLBuffer captureBuffer;
+	captureBuffer.create("ride animation", "verify capture");
+	glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, captureBuffer);
+	glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, capacity * sizeof(glm::mat4), NULL, GL_STREAM_READ);
+	captureBuffer.setSize(capacity * sizeof(glm::mat4));
+	std::vector<glm::mat4> captured(capacity);
+
+	// Position is unused; the instance attributes alone drive the capture
+	glEnable(GL_RASTERIZER_DISCARD);
+	for (int t = 0; t < timeCount; t++) {
+		for (size_t i = 0; i < parts.size(); i++) {
+			const PartDraw & draw = parts[i];
+			size_t count = std::min(instances[draw.type].size(), (size_t)RIDE_VERIFY_INSTANCES);
+			if (count == 0)
+				continue;
+			setPartUniforms(captureLocations, draw.part, times[t]);
+			bindInstances(ownRun(draw.type, false));
+			glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, captureBuffer);
+			glBeginTransformFeedback(GL_POINTS);
+			glDrawArraysInstanced(GL_POINTS, 0, 1, (GLsizei)count);
+			glEndTransformFeedback();
+			glDisableVertexAttribArray(3);
+			glDisableVertexAttribArray(4);
+
+			glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, captureBuffer);
+			glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, count * sizeof(glm::mat4), &captured[0]);
+			for (size_t n = 0; n < count; n++) {
+				glm::mat4 expected = rideModel(draw.part, instances[draw.type][n], times[t]);
+				for (int column = 0; column < 4; column++) {
+					for (int row = 0; row < 4; row++) {
+						float difference = fabsf(captured[n][column][row] - expected[column][row]);
+						maxError = std::max(maxError, difference / std::max(1.0f, fabsf(expected[column][row])));
+					}
+				}
+			}
+		}
+	}
+	glDisable(GL_RASTERIZER_DISCARD);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	glUseProgram(0);
+	return maxError <= tolerance;
+}
@@ -0,0 +1,122 @@
+#ifndef RIDEANIMATION_HPP
+#define RIDEANIMATION_HPP
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "glresource.hpp"
+#include "renderstate.hpp"
+#include "scene.hpp"
+#include "rides.hpp"
+#include "streambuffer.hpp"
+#include "bvh.hpp"
+
+// Ride animation evaluated on the GPU. The swing of a viking ship and the turn of a
+// merry-go-round with its bobbing poles are closed-form functions of time (RideInstance,
+// RidePart in rides.hpp), so every ride is an instance carrying a few parameters, and the vertex
+// shader (the RIDE_ANIMATION permutation of TransformVertexShader) builds each part's model
+// matrix from them and one time uniform. Nothing is computed or uploaded per ride per frame: a
+// park with thousands of flat rides costs the CPU one instanced draw per part of each ride type.
+//
+// rideModel() is the CPU reference of the shader code; AnimatedRides::verify compares the two.
+//
+// For culling, rideBounds() gives every ride a box that holds it at any time; setVisible()
+// then narrows the draws to a list of rides, copied into a StreamBuffer once per frame.
+
+// Distance between flat rides; the park itself fills the rings up to RIDE_PARK_RINGS
+#define RIDE_GRID_SPACING 10.0f
+#define RIDE_PARK_RINGS 2
+
+// Places count rides (alternately viking ships and merry-go-rounds, with varied yaw, phase,
+// speed and amplitude) on a grid in square rings around the park, appending each to
+// instances[its RideType]. The same count always gives the same park.
+void layoutFlatRides(int count, std::vector<RideInstance> * instances);
+// Only the rides of layoutFlatRides(count) on grid positions (world position / RIDE_GRID_SPACING)
+// minX..maxX, minZ..maxZ, without laying out the rest of the park
+void layoutFlatRideArea(int count, int minX, int minZ, int maxX, int maxZ, std::vector<RideInstance> * instances);
+// Lifts each ride onto the ground: pivot.y becomes the lowest groundHeight under its base,
+// 3 units around the pivot, less floorY, the height the rides are built on
+void standRidesOnGround(std::vector<RideInstance> & rides, float (*groundHeight)(float x, float z), float floorY);
+
+// count instances from offset bytes into buffer, laid out as RideInstance; rides kept outside
+// AnimatedRides (RideCells) are handed to draw() as runs
+struct RideRun {
+	GLuint buffer;
+	size_t offset;
+	GLsizei count;
+};
+
+// The instanced ride parts with their instance buffer. GL thread only.
+class AnimatedRides {
+public:
+	AnimatedRides();
+	~AnimatedRides();
+
+	// instances[type] are the rides of each RideType. Finds the part meshes in scene and uploads
+	// the instances once. programs are the shader permutations, already built.
+	bool init(const Scene & scene, const ShaderProgram * programs, const std::vector<RideInstance> * instances);
+	void shutdown();
+
+	// One instanced draw per part, every ride at time. textures is indexed by RideTexture.
+	// depthOnly as in drawMesh. runs, if given, holds more rides of each RideType, drawn with
+	// one more instanced draw per run.
+	void draw(RenderStateCache & renderState, const glm::mat4 & viewProjection, float time, const GLuint * textures,
+		bool depthOnly = false, const std::vector<RideRun> * runs = NULL);
+
+	// Builds the model matrices of every part of (up to RIDE_VERIFY_INSTANCES of) each ride type
+	// at each of times on the GPU, from vertexSource with RIDE_ANIMATION and read back with
+	// transform feedback, and compares them with rideModel(). maxError is the largest difference
+	// of a matrix element, relative to the element when that is above 1. false if it is above
+	// tolerance or the capture program doesn't build.
+	bool verify(const std::string & vertexSource, const float * times, int timeCount, float tolerance, float & maxError);
+
+	// Every part of a ride of each type stays within reach + bobReach * |amplitude| of its pivot
+	void rideReach(float * reach, float * bobReach) const;
+	// One box per ride, in instance order (the rides of each RideType in turn), holding every
+	// part whatever its swing, turn or bob
+	void rideBounds(std::vector<Aabb> & bounds) const;
+	// Until the next call, draw only rides (instance order indices, increasing). Call once a
+	// frame before the draws, and endFrame() after them. Returns the bytes written.
+	size_t setVisible(const uint32_t * rides, size_t count);
+	void endFrame();
+
+	int instanceCount() const;
+	int instanceCount(RideType type) const { return (int)instances[type].size(); }
+	// Rides drawn by draw(): all of them, or the last setVisible()'s
+	int drawnCount() const;
+	int partCount() const { return (int)parts.size(); }
+
+private:
+	struct Locations {
+		GLint time;
+		GLint motion;
+		GLint rotation;
+		GLint bob;
+		GLint base;
+		GLint local;
+	};
+	struct PartDraw {
+		RideType type;
+		RidePart part;
+		const SceneMesh * mesh;
+	};
+	static Locations findLocations(GLuint program);
+	static void setPartUniforms(const Locations & locations, const RidePart & part, float time);
+	RideRun ownRun(RideType type, bool visibleOnly) const;
+	static void bindInstances(const RideRun & run);
+
+	std::vector<PartDraw> parts;
+	std::vector<RideInstance> instances[RIDE_TYPE_COUNT]; // kept for verify
+	size_t firstInstance[RIDE_TYPE_COUNT];                // index in instanceBuffer
+	GLuint vertexBuffer;
+	GLBuffer instanceBuffer;
+	StreamBuffer visibleBuffer;                           // created by the first setVisible
+	bool culling;
+	size_t visibleOffset[RIDE_TYPE_COUNT];                // bytes into visibleBuffer
+	GLsizei visibleCount[RIDE_TYPE_COUNT];
+	Locations locations[2]; // of the animated permutations, untextured and textured
+};
+
+#endif
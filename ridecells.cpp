@@ -0,0 +1,363 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include "ridecells.hpp"
+
+// Loaded cells not wanted for this many selections are dropped instead of uploaded
+#define RIDE_CELL_STALE_FRAMES 30
+
+static const size_t s_slotBytes = RIDE_CELL_CAPACITY * sizeof(RideInstance);
+
+static uint64_t cellKey(int x, int z){
+	return ((uint64_t)(uint32_t)x << 32) | (uint64_t)(uint32_t)z;
+}
+
+static int cellX(uint64_t key){
+	return (int)(uint32_t)(key >> 32);
+}
+
+static int cellZ(uint64_t key){
+	return (int)(uint32_t)key;
+}
+
+// Distance from 0 to the nearest of first..last
+static int nearestToZero(int first, int last){
+	return first > 0 ? first : (last < 0 ? -last : 0);
+}
+
+static bool boxInFrustum(const Aabb & box, const glm::vec4 * planes){
+	for (int p = 0; p < 6; p++) {
+		const glm::vec4 & plane = planes[p];
+		glm::vec3 corner(plane.x >= 0.0f ? box.max.x : box.min.x, plane.y >= 0.0f ? box.max.y : box.min.y,
+			plane.z >= 0.0f ? box.max.z : box.min.z);
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+RideCells::RideCells()
+	: capacity(0), rideCount(0), lastRing(0), groundHeight(NULL), floorY(0.0f), camera(0.0f), frame(0), drawnCells(0),
+	drawnRideCount(0), missing(0), resident(0), quit(false){
+	memset(&counters, 0, sizeof(counters));
+	for (int type = 0; type < RIDE_TYPE_COUNT; type++) {
+		reach[type] = 0.0f;
+		bobReach[type] = 0.0f;
+	}
+}
+
+RideCells::~RideCells(){
+	shutdown();
+}
+
+void RideCells::init(int rideCount, float (*groundHeight)(float x, float z), float floorY, const float * reach,
+	const float * bobReach, size_t memoryBytes){
+	this->rideCount = rideCount;
+	this->groundHeight = groundHeight;
+	this->floorY = floorY;
+	for (int type = 0; type < RIDE_TYPE_COUNT; type++) {
+		this->reach[type] = reach[type];
+		this->bobReach[type] = bobReach[type];
+	}
+	// Ring r holds 8r rides, the first around the park's own rings
+	lastRing = RIDE_PARK_RINGS;
+	for (long long placed = 0; placed < rideCount; placed += 8LL * lastRing)
+		lastRing++;
+
+	// Room for every cell the load radius can touch, so the cells in range never evict each other
+	int window = 2 * (int)ceilf(RIDE_CELL_LOAD_RADIUS / RIDE_CELL_SIZE) + 1;
+	capacity = memoryBytes / s_slotBytes;
+	if (capacity < (size_t)(window * window))
+		capacity = (size_t)(window * window);
+	freeSlots.clear();
+	for (size_t i = capacity; i > 0; i--)
+		freeSlots.push_back((int)(i - 1));
+	instanceBuffer.create("ride cells", "instance pool");
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, capacity * s_slotBytes, NULL, GL_DYNAMIC_DRAW);
+	instanceBuffer.setSize(capacity * s_slotBytes);
+
+	quit = false;
+	loader = std::thread(&RideCells::loaderMain, this);
+}
+
+void RideCells::shutdown(){
+	if (loader.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		wake.notify_all();
+		loader.join();
+	}
+	pending.clear();
+	for (size_t i = 0; i < finished.size(); i++)
+		delete finished[i];
+	finished.clear();
+	for (size_t i = 0; i < ready.size(); i++)
+		delete ready[i];
+	ready.clear();
+	cells.clear();
+	for (int type = 0; type < RIDE_TYPE_COUNT; type++)
+		drawRuns[type].clear();
+	freeSlots.clear();
+	resident = 0;
+	drawnCells = 0;
+	drawnRideCount = 0;
+	instanceBuffer.reset();
+}
+
+void RideCells::loaderMain(){
+	for (;;) {
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this] { return quit || !pending.empty(); });
+			if (quit)
+				return;
+			request = pending.front();
+			pending.pop_front();
+		}
+		Job * job = new Job;
+		job->key = request.key;
+		job->created = request.created;
+		int minX = request.x * RIDE_CELL_SLOTS, minZ = request.z * RIDE_CELL_SLOTS;
+		layoutFlatRideArea(rideCount, minX, minZ, minX + RIDE_CELL_SLOTS - 1, minZ + RIDE_CELL_SLOTS - 1, job->rides);
+		job->bounds.min = glm::vec3(1e30f);
+		job->bounds.max = glm::vec3(-1e30f);
+		for (int type = 0; type < RIDE_TYPE_COUNT; type++) {
+			std::vector<RideInstance> & rides = job->rides[type];
+			if (groundHeight != NULL)
+				standRidesOnGround(rides, groundHeight, floorY);
+			for (size_t i = 0; i < rides.size(); i++) {
+				float radius = reach[type] + bobReach[type] * fabsf(rides[i].motion.x);
+				job->bounds.min = glm::min(job->bounds.min, glm::vec3(rides[i].pivot) - glm::vec3(radius));
+				job->bounds.max = glm::max(job->bounds.max, glm::vec3(rides[i].pivot) + glm::vec3(radius));
+			}
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			finished.push_back(job);
+		}
+		done.notify_all();
+	}
+}
+
+// Along the ground, from the camera to the cell's square of grid positions
+float RideCells::cellDistance(int x, int z) const{
+	float minX = x * RIDE_CELL_SIZE - 0.5f * RIDE_GRID_SPACING, minZ = z * RIDE_CELL_SIZE - 0.5f * RIDE_GRID_SPACING;
+	float dx = std::max(std::max(minX - camera.x, camera.x - (minX + RIDE_CELL_SIZE)), 0.0f);
+	float dz = std::max(std::max(minZ - camera.z, camera.z - (minZ + RIDE_CELL_SIZE)), 0.0f);
+	return sqrtf(dx * dx + dz * dz);
+}
+
+// Whether any of the cell's grid positions is on a ring with rides
+bool RideCells::cellHasRides(int x, int z) const{
+	int firstX = x * RIDE_CELL_SLOTS, lastX = firstX + RIDE_CELL_SLOTS - 1;
+	int firstZ = z * RIDE_CELL_SLOTS, lastZ = firstZ + RIDE_CELL_SLOTS - 1;
+	int innerRing = std::max(nearestToZero(firstX, lastX), nearestToZero(firstZ, lastZ));
+	int outerRing = std::max(std::max(abs(firstX), abs(lastX)), std::max(abs(firstZ), abs(lastZ)));
+	return outerRing > RIDE_PARK_RINGS && innerRing <= lastRing;
+}
+
+int RideCells::allocateSlot(){
+	if (!freeSlots.empty()) {
+		int slot = freeSlots.back();
+		freeSlots.pop_back();
+		return slot;
+	}
+	// The least recently wanted resident cell that the last selection didn't want
+	std::unordered_map<uint64_t, Cell>::iterator oldest = cells.end();
+	for (std::unordered_map<uint64_t, Cell>::iterator it = cells.begin(); it != cells.end(); ++it) {
+		const Cell & cell = it->second;
+		if (cell.slot < 0 || cell.lastUsed >= frame)
+			continue;
+		if (oldest == cells.end() || cell.lastUsed < oldest->second.lastUsed)
+			oldest = it;
+	}
+	if (oldest == cells.end())
+		return -1;
+	int slot = oldest->second.slot;
+	cells.erase(oldest);
+	resident--;
+	counters.evicted++;
+	return slot;
+}
+
+size_t RideCells::update(size_t byteBudget){
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		while (!finished.empty()) {
+			ready.push_back(finished.front());
+			finished.pop_front();
+			counters.loaded++;
+		}
+	}
+	size_t bytes = 0;
+	if (!ready.empty())
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	while (!ready.empty()) {
+		Job * job = ready.front();
+		std::unordered_map<uint64_t, Cell>::iterator it = cells.find(job->key);
+		// A cell unloaded and wanted again while its first load was in flight gets two; only
+		// a load for the current entry counts against its loads, so select() queues another
+		// only once none is left
+		bool current = it != cells.end() && it->second.created == job->created;
+		if (it == cells.end() || it->second.loaded || frame - it->second.lastUsed > RIDE_CELL_STALE_FRAMES) {
+			if (current)
+				it->second.loads--;
+			ready.pop_front();
+			delete job;
+			counters.dropped++;
+			continue;
+		}
+		Cell & cell = it->second;
+		size_t cellBytes = 0;
+		for (int type = 0; type < RIDE_TYPE_COUNT; type++)
+			cellBytes += job->rides[type].size() * sizeof(RideInstance);
+		if (cellBytes > 0) {
+			if (bytes + cellBytes > byteBudget)
+				break;
+			// Eviction only erases resident cells, so it leaves this one alone
+			int slot = allocateSlot();
+			if (slot < 0)
+				break;
+			size_t offset = slot * s_slotBytes;
+			for (int type = 0; type < RIDE_TYPE_COUNT; type++) {
+				size_t typeBytes = job->rides[type].size() * sizeof(RideInstance);
+				if (typeBytes > 0)
+					glBufferSubData(GL_ARRAY_BUFFER, offset, typeBytes, &job->rides[type][0]);
+				offset += typeBytes;
+			}
+			cell.slot = slot;
+			resident++;
+			counters.uploaded++;
+			bytes += cellBytes;
+		}
+		for (int type = 0; type < RIDE_TYPE_COUNT; type++)
+			cell.counts[type] = (int)job->rides[type].size();
+		cell.bounds = job->bounds;
+		cell.loaded = true;
+		if (current)
+			cell.loads--;
+		ready.pop_front();
+		delete job;
+	}
+	counters.uploadedBytes += bytes;
+	return bytes;
+}
+
+void RideCells::select(const glm::vec3 & camera, const glm::mat4 & viewProjection){
+	frame++;
+	this->camera = camera;
+	glm::vec4 planes[6];
+	frustumPlanes(viewProjection, planes);
+
+	// Out of range cells give their slot back; loads still in flight are dropped by update()
+	for (std::unordered_map<uint64_t, Cell>::iterator it = cells.begin(); it != cells.end();) {
+		if (cellDistance(cellX(it->first), cellZ(it->first)) <= RIDE_CELL_UNLOAD_RADIUS) {
+			++it;
+			continue;
+		}
+		if (it->second.slot >= 0) {
+			freeSlots.push_back(it->second.slot);
+			resident--;
+			counters.unloaded++;
+		}
+		it = cells.erase(it);
+	}
+
+	wanted.clear();
+	std::vector<std::pair<float, const Cell *> > visible;
+	int reachCells = (int)ceilf(RIDE_CELL_LOAD_RADIUS / RIDE_CELL_SIZE);
+	int centerX = (int)floorf((camera.x + 0.5f * RIDE_GRID_SPACING) / RIDE_CELL_SIZE);
+	int centerZ = (int)floorf((camera.z + 0.5f * RIDE_GRID_SPACING) / RIDE_CELL_SIZE);
+	for (int z = centerZ - reachCells; z <= centerZ + reachCells; z++) {
+		for (int x = centerX - reachCells; x <= centerX + reachCells; x++) {
+			float distance = cellDistance(x, z);
+			if (distance > RIDE_CELL_LOAD_RADIUS || !cellHasRides(x, z))
+				continue;
+			uint64_t key = cellKey(x, z);
+			std::unordered_map<uint64_t, Cell>::iterator it = cells.find(key);
+			if (it == cells.end()) {
+				Cell cell;
+				cell.slot = -1;
+				cell.loaded = false;
+				cell.loads = 0;
+				cell.created = frame;
+				for (int type = 0; type < RIDE_TYPE_COUNT; type++)
+					cell.counts[type] = 0;
+				it = cells.insert(std::make_pair(key, cell)).first;
+			}
+			Cell & cell = it->second;
+			cell.lastUsed = frame;
+			if (!cell.loaded) {
+				Request request = { key, cell.created, x, z, distance };
+				wanted.push_back(request);
+			} else if (cell.slot >= 0 && boxInFrustum(cell.bounds, planes)) {
+				visible.push_back(std::make_pair(distance, &cell));
+			}
+		}
+	}
+	missing = (int)wanted.size();
+
+	// Nearest cells first, for the depth test
+	std::sort(visible.begin(), visible.end(),
+		[](const std::pair<float, const Cell *> & a, const std::pair<float, const Cell *> & b) { return a.first < b.first; });
+	for (int type = 0; type < RIDE_TYPE_COUNT; type++)
+		drawRuns[type].clear();
+	drawnCells = (int)visible.size();
+	drawnRideCount = 0;
+	for (size_t i = 0; i < visible.size(); i++) {
+		const Cell & cell = *visible[i].second;
+		size_t offset = cell.slot * s_slotBytes;
+		for (int type = 0; type < RIDE_TYPE_COUNT; type++) {
+			if (cell.counts[type] > 0) {
+				RideRun run = { instanceBuffer, offset, (GLsizei)cell.counts[type] };
+				drawRuns[type].push_back(run);
+			}
+			offset += cell.counts[type] * sizeof(RideInstance);
+			drawnRideCount += cell.counts[type];
+		}
+	}
+
+	std::sort(wanted.begin(), wanted.end(), [](const Request & a, const Request & b) { return a.distance < b.distance; });
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		// Requests nobody started yet go back in behind this selection's
+		for (size_t i = 0; i < pending.size(); i++) {
+			std::unordered_map<uint64_t, Cell>::iterator it = cells.find(pending[i].key);
+			if (it != cells.end() && it->second.created == pending[i].created)
+				it->second.loads--;
+		}
+		pending.clear();
+		for (size_t i = 0; i < wanted.size(); i++) {
+			Cell & cell = cells[wanted[i].key];
+			if (cell.loads > 0)
+				continue;
+			cell.loads++;
+			pending.push_back(wanted[i]);
+		}
+	}
+	wake.notify_all();
+}
+
+size_t RideCells::selectResident(const glm::vec3 & camera, const glm::mat4 & viewProjection){
+	// Whatever the last update() had no budget for first, so anything left is for want of room
+	size_t bytes = update((size_t)-1);
+	for (;;) {
+		select(camera, viewProjection);
+		if (missing == 0 || !ready.empty()) // done, or the pool is full
+			break;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [this] { return !finished.empty(); });
+		}
+		bytes += update((size_t)-1);
+	}
+	return bytes;
+}
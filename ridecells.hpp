@@ -0,0 +1,149 @@
+#ifndef RIDECELLS_HPP
+#define RIDECELLS_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "glresource.hpp"
+#include "rides.hpp"
+#include "rideanimation.hpp"
+#include "bvh.hpp"
+
+// Grid positions along each side of a world cell
+#define RIDE_CELL_SLOTS 4
+#define RIDE_CELL_SIZE (RIDE_CELL_SLOTS * RIDE_GRID_SPACING)
+#define RIDE_CELL_CAPACITY (RIDE_CELL_SLOTS * RIDE_CELL_SLOTS)
+// Cells nearer the camera than this are loaded; resident ones are unloaded past the second,
+// so a camera going back and forth over a border doesn't reload the same cells
+#define RIDE_CELL_LOAD_RADIUS 120.0f
+#define RIDE_CELL_UNLOAD_RADIUS 180.0f
+
+struct RideCellStats {
+	long long loaded;       // cells the loader thread laid out
+	long long uploaded;
+	long long unloaded;     // resident cells dropped for being out of range
+	long long evicted;      // resident cells dropped for room in the pool
+	long long dropped;      // loaded cells no longer wanted when their upload came up
+	size_t uploadedBytes;
+};
+
+// The flat rides around the park, streamed by world cell so only those near the camera hold
+// memory, whatever the size of the park.
+//
+// The ground is cut into square cells of RIDE_CELL_SLOTS grid positions a side. select() wants
+// every cell within RIDE_CELL_LOAD_RADIUS of the camera, nearest first, and lays the missing
+// ones out on a loader thread that needs no GL context (layoutFlatRideArea, standing the rides
+// on the ground). update(), on the GL thread, copies at most byteBudget bytes of loaded cells
+// a frame into slots of one instance buffer sized by the memory cap; when it is full the least
+// recently wanted cells are evicted. The rides of the resident cells in the frustum are handed
+// to AnimatedRides::draw as one run per cell and RideType.
+//
+// The part meshes and textures are the same for every ride, so they stay in the scene's
+// buffers; what a cell holds is its rides' instances.
+class RideCells {
+public:
+	RideCells();
+	~RideCells();
+
+	// rideCount rides as layoutFlatRides places them, stood on groundHeight (as in
+	// standRidesOnGround) unless it is NULL. reach and bobReach are AnimatedRides::rideReach's,
+	// for the cells' bounds. Creates the pool (memoryBytes of cells, at least the cells within
+	// the load radius) and starts the loader thread. Needs a current GL context.
+	void init(int rideCount, float (*groundHeight)(float x, float z), float floorY, const float * reach,
+		const float * bobReach, size_t memoryBytes);
+	// Joins the loader thread and deletes the pool.
+	void shutdown();
+
+	// Uploads loaded cells. Never waits on the loader. Returns the bytes handed to GL.
+	size_t update(size_t byteBudget);
+	// Unloads the cells out of range, picks the resident ones to draw for this camera and
+	// queues the missing ones. Only the unload radius erases the entries of cells that turn
+	// out to have no rides, or that were wanted but never loaded.
+	void select(const glm::vec3 & camera, const glm::mat4 & viewProjection);
+	// select(), then waits for and uploads every cell it asked for, so a frame looks the same
+	// however fast the loader is. Returns the bytes.
+	size_t selectResident(const glm::vec3 & camera, const glm::mat4 & viewProjection);
+
+	// runs()[type] are the selected rides of each RideType, for AnimatedRides::draw
+	const std::vector<RideRun> * runs() const { return drawRuns; }
+
+	// In the last selection
+	int drawnCount() const { return drawnCells; }
+	int drawnRides() const { return drawnRideCount; }
+	int missingCount() const { return missing; }
+	int residentCount() const { return resident; }
+	int poolCapacity() const { return (int)capacity; }
+	size_t poolBytes() const { return capacity * RIDE_CELL_CAPACITY * sizeof(RideInstance); }
+	const RideCellStats & stats() const { return counters; }
+
+private:
+	struct Cell {
+		int slot;                        // in the pool, -1 while not resident or empty
+		bool loaded;                     // resident, or laid out and found empty
+		int loads;                       // this entry's requests queued, being laid out or waiting for upload
+		long long created;               // selection that made this entry
+		long long lastUsed;              // selection that last wanted it
+		int counts[RIDE_TYPE_COUNT];     // rides of each type, in RideType order in the slot
+		Aabb bounds;
+	};
+	// created is the cell entry's, so a load for an entry since unloaded isn't counted in the
+	// loads of the one that replaced it
+	struct Request {
+		uint64_t key;
+		long long created;
+		int x, z;
+		float distance;
+	};
+	struct Job {
+		uint64_t key;
+		long long created;
+		std::vector<RideInstance> rides[RIDE_TYPE_COUNT];
+		Aabb bounds;
+	};
+
+	void loaderMain();
+	float cellDistance(int x, int z) const;
+	bool cellHasRides(int x, int z) const;
+	int allocateSlot();
+
+	GLBuffer instanceBuffer;
+	size_t capacity;                     // slots in the pool
+	std::vector<int> freeSlots;
+	int rideCount;
+	int lastRing;                        // outermost ring of grid positions with rides
+	float (*groundHeight)(float x, float z);
+	float floorY;
+	float reach[RIDE_TYPE_COUNT];
+	float bobReach[RIDE_TYPE_COUNT];
+
+	// GL thread only
+	std::unordered_map<uint64_t, Cell> cells;
+	std::vector<Request> wanted;
+	std::deque<Job *> ready;             // laid out, waiting for upload budget
+	std::vector<RideRun> drawRuns[RIDE_TYPE_COUNT];
+	glm::vec3 camera;
+	long long frame;
+	int drawnCells;
+	int drawnRideCount;
+	int missing;
+	int resident;
+	RideCellStats counters;
+
+	std::thread loader;
+	std::mutex mutex;
+	std::condition_variable wake;        // a request was queued
+	std::condition_variable done;        // a job finished
+	std::deque<Request> pending;         // waiting for the loader
+	std::deque<Job *> finished;          // waiting for update()
+	bool quit;
+};
+
+#endif
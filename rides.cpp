@@ -0,0 +1,373 @@
+#include <math.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/euler_angles.hpp>
+using namespace glm;
+
+#include "rides.hpp"
+
+// float, as it has always been: the track and the support positions are computed from it
+static const float doublePi = 2.0 * 3.141592f;
+
+//***************************
+// 1. Viking
+//***************************
+
+static const vec3 vikingArmOffset(0.0f, 1.0f, 0.0f);
+static const vec3 vikingBoatOffset(0.0f, 2.0f, 0.0f);
+static const vec3 vikingLegOffset(1.1f, 1.5f, 1.1f);
+static const vec3 vikingLegAngles(3.14f / 5.0f, 3.14f / 5.0f, 0.0f);
+
+void initViking(VikingRide & ride){
+	ride.orientation = vec3(0.0f, 0.0f, 0.0f);
+	ride.flag = 0;
+
+	// The top beam and the four legs never move
+	glm::mat4 transMatForVikeAll = translate(mat4(), vec3(-2.0f, 0.0f, 2.0f));
+	glm::mat4 transMatForVike2 = translate(mat4(), vec3(vikingArmOffset.x, vikingArmOffset.y - 0.15, vikingArmOffset.z));
+	glm::mat4 scalMatForVike2 = scale(mat4(), vec3(0.6f, 0.1f, 0.6f));
+	ride.models[VIKING_TOP_BEAM] = glm::mat4(1.0f) * transMatForVikeAll * scalMatForVike2 * transMatForVike2;
+
+	glm::mat4 scalMatForVike6 = scale(mat4(), vec3(0.1f, 2.0f, 0.1f));
+	const vec3 & p = vikingLegOffset;
+	const vec3 & o = vikingLegAngles;
+	ride.models[VIKING_LEG_1] = transMatForVikeAll * translate(mat4(), vec3(-p.x, -p.y, -p.z))
+		* eulerAngleYXZ(o.y, o.x, o.z) * scalMatForVike6 * glm::mat4(1.0f);
+	ride.models[VIKING_LEG_2] = transMatForVikeAll * translate(mat4(), vec3(-p.x, -p.y, p.z))
+		* eulerAngleYXZ(3.14f - o.y, o.x, o.z) * scalMatForVike6 * glm::mat4(1.0f);
+	ride.models[VIKING_LEG_3] = transMatForVikeAll * translate(mat4(), vec3(p.x, -p.y, -p.z))
+		* eulerAngleYXZ(3.14f - o.y, 3.14f - o.x, o.z) * scalMatForVike6 * glm::mat4(1.0f);
+	ride.models[VIKING_LEG_4] = transMatForVikeAll * translate(mat4(), vec3(p.x, -p.y, p.z))
+		* eulerAngleYXZ(o.y, 3.14f - o.x, o.z) * scalMatForVike6 * glm::mat4(1.0f);
+
+	updateViking(ride, 0.0f);
+}
+
+void updateViking(VikingRide & ride, float deltaTime){
+	vec3 & orientation = ride.orientation;
+	orientation.x = 3.14f;
+	orientation.y = 0.0f;
+
+	// Swing back once past +-1.2, slowing down towards the ends
+	if (orientation.z > 1.2f)
+		ride.flag = 1;
+	else if (orientation.z < -1.2f)
+		ride.flag = 0;
+
+	if (ride.flag == 1)
+		orientation.z -= 3.14159f / 2.0f * deltaTime * (cos(orientation.z) * cos(orientation.z));
+	else
+		orientation.z += 3.14159f / 2.0f * deltaTime * (cos(orientation.z) * cos(orientation.z));
+
+	glm::mat4 transMatForVikeAll = translate(mat4(), vec3(-2.0f, 0.0f, 2.0f));
+	glm::mat4 transMatForVike1 = translate(mat4(), vikingArmOffset);
+	glm::mat4 rotMatForVike1 = eulerAngleYXZ(orientation.y, orientation.x, orientation.z);
+	glm::mat4 scalMatForVike1 = scale(mat4(), vec3(0.1f, 1.15f, 0.1f));
+	ride.models[VIKING_ARM] = glm::mat4(1.0f) * transMatForVikeAll * rotMatForVike1 * transMatForVike1 * scalMatForVike1;
+
+	glm::mat4 transMatForVike3 = translate(mat4(), vikingBoatOffset);
+	glm::mat4 scalMatForVike3 = scale(mat4(), vec3(1.5f, 0.3f, 0.3f));
+	ride.models[VIKING_BOAT] = glm::mat4(1.0f) * transMatForVikeAll * rotMatForVike1 * transMatForVike3 * scalMatForVike3;
+
+	glm::mat4 rotMatForVike4 = eulerAngleYXZ(orientation.y, orientation.x, 3.14f / 8.0f + orientation.z);
+	ride.models[VIKING_ARM_LEFT] = glm::mat4(1.0f) * transMatForVikeAll * rotMatForVike4 * transMatForVike1 * scalMatForVike1;
+
+	glm::mat4 rotMatForVike5 = eulerAngleYXZ(orientation.y, orientation.x, -(3.14f / 8.0f) + orientation.z);
+	ride.models[VIKING_ARM_RIGHT] = glm::mat4(1.0f) * transMatForVikeAll * rotMatForVike5 * transMatForVike1 * scalMatForVike1;
+}
+
+//***************************
+// 2. Merry-go-round
+//***************************
+
+void initMerryGoRound(MerryGoRoundRide & ride){
+	ride.rotation = 0.0f;
+	ride.subPolePositions[0] = vec3(0.0f, 2.0f, -1.0f);
+	ride.subPolePositions[1] = vec3(0.0f, -2.0f, 1.0f);
+	ride.subPolePositions[2] = vec3(2.0f, 0.0f, -0.5f);
+	ride.subPolePositions[3] = vec3(-2.0f, 0.0f, 0.5f);
+	for (int i = 0; i < 4; i++)
+		ride.subPoleFlags[i] = 0;
+	updateMerryGoRound(ride, 0.0f);
+}
+
+void updateMerryGoRound(MerryGoRoundRide & ride, float deltaTime){
+	glm::mat4 transMatForMGRAll = translate(mat4(), vec3(6.0f, 0.0f, 6.0f));
+	ride.rotation += 3.141592f / 2.0f * deltaTime;
+
+	glm::mat4 transMatForMGR1 = translate(mat4(), vec3(0.0f, -2.0f, 0.0f));
+	glm::mat4 rotMatForMGR1 = eulerAngleYXZ(ride.rotation, 0.0f, 0.0f);
+	glm::mat4 scalMatForMGR1 = scale(mat4(), vec3(3.0f, 1.0f, 3.0f));
+	ride.models[MGR_TOP] = glm::mat4(1.0f) * transMatForMGRAll * scalMatForMGR1 * rotMatForMGR1 * transMatForMGR1;
+
+	glm::mat4 transMatForMGR3 = translate(mat4(), vec3(0.0f, -3.0f, 0.0f));
+	ride.models[MGR_BOTTOM] = glm::mat4(1.0f) * transMatForMGRAll * scalMatForMGR1 * transMatForMGR3 * rotMatForMGR1;
+
+	glm::mat4 transMatForMGR4 = translate(mat4(), vec3(0.0f, -2.5f, 0.0f));
+	glm::mat4 rotMatForMGR4 = rotMatForMGR1;
+	ride.models[MGR_SIDE] = glm::mat4(1.0f) * transMatForMGRAll * scalMatForMGR1 * rotMatForMGR4 * transMatForMGR4;
+
+	glm::mat4 transMatForMGR5 = translate(mat4(), vec3(0.0f, 0.0f, 0.0f));
+	glm::mat4 scalMatForMGR5 = scale(mat4(), vec3(0.1f, 4.0f, 0.1f));
+	ride.models[MGR_POLE] = glm::mat4(1.0f) * transMatForMGRAll * scalMatForMGR5 * rotMatForMGR4 * transMatForMGR5;
+
+	glm::mat4 transMatForMGR6 = translate(mat4(), vec3(0.0f, 1.5f, 0.0f));
+	glm::mat4 scalMatForMGR6 = scale(mat4(), vec3(2.0f, 1.0f, 2.0f));
+	ride.models[MGR_UMBRELLA] = glm::mat4(1.0f) * transMatForMGRAll * scalMatForMGR6 * rotMatForMGR4 * transMatForMGR6;
+
+	// Sub poles go up and down between z -2 and -1 of their (rotated) frame, seats sit on top
+	glm::mat4 transMatForY = translate(mat4(), vec3(0.0f, -3.0f, 0.0f));
+	glm::mat4 rotMatForMGR7 = eulerAngleYXZ(0.0f, 1.57f, 0.0f);
+	glm::mat4 scalMatForMGR7 = scale(mat4(), vec3(0.4f, 1.6f, 0.4f));
+	glm::mat4 transMatForMGR11 = translate(mat4(), vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 scalMatForMGR11 = scale(mat4(), vec3(0.5f, 0.5f, 0.5f));
+	for (int i = 0; i < 4; i++) {
+		vec3 & position = ride.subPolePositions[i];
+		if (position.z < -2.0f)
+			ride.subPoleFlags[i] = 1;
+		else if (position.z > -1.0f)
+			ride.subPoleFlags[i] = 0;
+
+		if (ride.subPoleFlags[i] == 1)
+			position.z += 1.0f*deltaTime;
+		else
+			position.z -= 1.0f*deltaTime;
+
+		glm::mat4 transMatForSub = translate(mat4(), position);
+		ride.models[MGR_SUB_POLE_1 + i] = glm::mat4(1.0f) * transMatForMGRAll * rotMatForMGR4 * transMatForY
+			* rotMatForMGR7 * transMatForSub * rotMatForMGR7 * scalMatForMGR7;
+		ride.models[MGR_SEAT_1 + i] = glm::mat4(1.0f) * transMatForMGR11 * transMatForMGRAll * rotMatForMGR4 * transMatForY
+			* rotMatForMGR7 * transMatForSub * rotMatForMGR7 * scalMatForMGR11;
+	}
+}
+
+//***************************
+// GPU animation parts
+//***************************
+
+// The shader's PI
+static const float ridePi = 3.14159265f;
+
+// 0 at x = 0, up to 1 at 0.25, down to -1 at 0.75, period 1
+static float triangleWave(float x){
+	return 1.0f - 4.0f * fabsf((x + 0.25f) - floorf(x + 0.25f) - 0.5f);
+}
+
+static glm::mat4 rotation(const glm::vec3 & axis, float angle){
+	float c = cosf(angle);
+	float s = sinf(angle);
+	glm::vec3 t = (1.0f - c) * axis;
+	return glm::mat4(
+		glm::vec4(c + t.x * axis.x, t.x * axis.y + s * axis.z, t.x * axis.z - s * axis.y, 0.0f),
+		glm::vec4(t.y * axis.x - s * axis.z, c + t.y * axis.y, t.y * axis.z + s * axis.x, 0.0f),
+		glm::vec4(t.z * axis.x + s * axis.y, t.z * axis.y - s * axis.x, c + t.z * axis.z, 0.0f),
+		glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+static glm::mat4 translation(const glm::vec3 & offset){
+	glm::mat4 result(1.0f);
+	result[3] = glm::vec4(offset, 1.0f);
+	return result;
+}
+
+glm::mat4 rideModel(const RidePart & part, const RideInstance & ride, float time){
+	float amplitude = ride.motion.x;
+	float phase = ride.motion.y;
+	float speed = ride.motion.z;
+	float angle = 0.0f;
+	float bob = 0.0f;
+	if (part.motion == RIDE_MOTION_SWING) {
+		float extent = tanf(amplitude);
+		angle = atanf(extent * triangleWave(time * speed / (4.0f * extent) + phase));
+	} else if (part.motion == RIDE_MOTION_SPIN) {
+		angle = speed * time + 2.0f * ridePi * phase;
+		bob = amplitude * triangleWave(speed * time / ridePi + phase + part.bobPhase);
+	}
+	return translation(glm::vec3(ride.pivot)) * rotation(glm::vec3(0.0f, 1.0f, 0.0f), ride.pivot.w) * part.base
+		* rotation(part.axis, angle + part.angleOffset) * translation(part.bobDirection * bob) * part.local;
+}
+
+static RidePart ridePart(const char * mesh, RideTexture texture, RideMotion motion, const glm::mat4 & base,
+	const vec3 & axis = vec3(0.0f, 1.0f, 0.0f), float angleOffset = 0.0f, const glm::mat4 & local = glm::mat4(1.0f)){
+	RidePart part;
+	part.mesh = mesh;
+	part.texture = texture;
+	part.motion = motion;
+	part.axis = axis;
+	part.angleOffset = angleOffset;
+	part.bobDirection = vec3(0.0f);
+	part.bobPhase = 0.0f;
+	part.base = base;
+	part.local = local;
+	return part;
+}
+
+void vikingRideParts(std::vector<RidePart> & parts){
+	glm::mat4 transMatForVike2 = translate(mat4(), vec3(vikingArmOffset.x, vikingArmOffset.y - 0.15, vikingArmOffset.z));
+	glm::mat4 scalMatForVike2 = scale(mat4(), vec3(0.6f, 0.1f, 0.6f));
+	parts.push_back(ridePart("cube", RIDE_TEXTURE_YELLOW, RIDE_MOTION_STATIC, scalMatForVike2 * transMatForVike2));
+
+	glm::mat4 scalMatForVike6 = scale(mat4(), vec3(0.1f, 2.0f, 0.1f));
+	const vec3 & p = vikingLegOffset;
+	const vec3 & o = vikingLegAngles;
+	parts.push_back(ridePart("cube", RIDE_TEXTURE_WOOD, RIDE_MOTION_STATIC,
+		translate(mat4(), vec3(-p.x, -p.y, -p.z)) * eulerAngleYXZ(o.y, o.x, o.z) * scalMatForVike6));
+	parts.push_back(ridePart("cube", RIDE_TEXTURE_WOOD, RIDE_MOTION_STATIC,
+		translate(mat4(), vec3(-p.x, -p.y, p.z)) * eulerAngleYXZ(3.14f - o.y, o.x, o.z) * scalMatForVike6));
+	parts.push_back(ridePart("cube", RIDE_TEXTURE_WOOD, RIDE_MOTION_STATIC,
+		translate(mat4(), vec3(p.x, -p.y, -p.z)) * eulerAngleYXZ(3.14f - o.y, 3.14f - o.x, o.z) * scalMatForVike6));
+	parts.push_back(ridePart("cube", RIDE_TEXTURE_WOOD, RIDE_MOTION_STATIC,
+		translate(mat4(), vec3(p.x, -p.y, p.z)) * eulerAngleYXZ(o.y, 3.14f - o.x, o.z) * scalMatForVike6));
+
+	// eulerAngleYXZ(0, 3.14, angle) is this frame followed by the swing around z
+	glm::mat4 swingFrame = eulerAngleYXZ(0.0f, 3.14f, 0.0f);
+	const vec3 swingAxis(0.0f, 0.0f, 1.0f);
+	glm::mat4 transMatForVike1 = translate(mat4(), vikingArmOffset);
+	glm::mat4 scalMatForVike1 = scale(mat4(), vec3(0.1f, 1.15f, 0.1f));
+	glm::mat4 transMatForVike3 = translate(mat4(), vikingBoatOffset);
+	glm::mat4 scalMatForVike3 = scale(mat4(), vec3(1.5f, 0.3f, 0.3f));
+	parts.push_back(ridePart("cube", RIDE_TEXTURE_WOOD, RIDE_MOTION_SWING, swingFrame, swingAxis, 0.0f,
+		transMatForVike3 * scalMatForVike3));
+	parts.push_back(ridePart("cube", RIDE_TEXTURE_WOOD, RIDE_MOTION_SWING, swingFrame, swingAxis, 3.14f / 8.0f,
+		transMatForVike1 * scalMatForVike1));
+	parts.push_back(ridePart("cube", RIDE_TEXTURE_WOOD, RIDE_MOTION_SWING, swingFrame, swingAxis, -(3.14f / 8.0f),
+		transMatForVike1 * scalMatForVike1));
+}
+
+void merryGoRoundRideParts(std::vector<RidePart> & parts){
+	const vec3 spinAxis(0.0f, 1.0f, 0.0f);
+	glm::mat4 scalMatForMGR1 = scale(mat4(), vec3(3.0f, 1.0f, 3.0f));
+	parts.push_back(ridePart("circle", RIDE_TEXTURE_YELLOW, RIDE_MOTION_SPIN, scalMatForMGR1, spinAxis, 0.0f,
+		translate(mat4(), vec3(0.0f, -2.0f, 0.0f))));
+	parts.push_back(ridePart("circle", RIDE_TEXTURE_YELLOW, RIDE_MOTION_SPIN,
+		scalMatForMGR1 * translate(mat4(), vec3(0.0f, -3.0f, 0.0f)), spinAxis));
+	parts.push_back(ridePart("cylinderSide", RIDE_TEXTURE_WOOD, RIDE_MOTION_SPIN, scalMatForMGR1, spinAxis, 0.0f,
+		translate(mat4(), vec3(0.0f, -2.5f, 0.0f))));
+	parts.push_back(ridePart("cylinderSide", RIDE_TEXTURE_WOOD, RIDE_MOTION_SPIN, scale(mat4(), vec3(0.1f, 4.0f, 0.1f)), spinAxis));
+	parts.push_back(ridePart("umbrella", RIDE_TEXTURE_YELLOW, RIDE_MOTION_SPIN, scale(mat4(), vec3(2.0f, 1.0f, 2.0f)), spinAxis, 0.0f,
+		translate(mat4(), vec3(0.0f, 1.5f, 0.0f))));
+
+	// Sub poles and seats bob around the middle (z -1.5) of their range in updateMerryGoRound,
+	// a quarter of a cycle apart
+	glm::mat4 transMatForY = translate(mat4(), vec3(0.0f, -3.0f, 0.0f));
+	glm::mat4 rotMatForMGR7 = eulerAngleYXZ(0.0f, 1.57f, 0.0f);
+	glm::mat4 scalMatForMGR7 = scale(mat4(), vec3(0.4f, 1.6f, 0.4f));
+	glm::mat4 transMatForMGR11 = translate(mat4(), vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 scalMatForMGR11 = scale(mat4(), vec3(0.5f, 0.5f, 0.5f));
+	vec3 bobDirection = vec3(transMatForY * rotMatForMGR7 * vec4(0.0f, 0.0f, 1.0f, 0.0f));
+	const vec3 subPoleCenters[4] = {
+		vec3(0.0f, 2.0f, -1.5f), vec3(0.0f, -2.0f, -1.5f), vec3(2.0f, 0.0f, -1.5f), vec3(-2.0f, 0.0f, -1.5f)
+	};
+	const float bobPhases[4] = { 0.0f, 0.5f, 0.25f, 0.75f };
+	for (int i = 0; i < 4; i++) {
+		glm::mat4 subFrame = transMatForY * rotMatForMGR7 * translate(mat4(), subPoleCenters[i]) * rotMatForMGR7;
+		RidePart pole = ridePart("cylinderSide", RIDE_TEXTURE_WOOD, RIDE_MOTION_SPIN, glm::mat4(1.0f), spinAxis, 0.0f,
+			subFrame * scalMatForMGR7);
+		RidePart seat = ridePart("cube", RIDE_TEXTURE_STRIP, RIDE_MOTION_SPIN, transMatForMGR11, spinAxis, 0.0f,
+			subFrame * scalMatForMGR11);
+		pole.bobDirection = seat.bobDirection = bobDirection;
+		pole.bobPhase = seat.bobPhase = bobPhases[i];
+		parts.push_back(pole);
+		parts.push_back(seat);
+	}
+}
+
+RideInstance parkVikingInstance(){
+	RideInstance ride;
+	ride.pivot = vec4(-2.0f, 0.0f, 2.0f, 0.0f);
+	ride.motion = vec4(1.2f, 0.0f, 3.14159f / 2.0f, 0.0f);
+	return ride;
+}
+
+RideInstance parkMerryGoRoundInstance(){
+	RideInstance ride;
+	ride.pivot = vec4(6.0f, 0.0f, 6.0f, 0.0f);
+	ride.motion = vec4(0.5f, 0.0f, 3.141592f / 2.0f, 0.0f);
+	return ride;
+}
+
+//***************************
+// 3. Roller coaster
+//***************************
+
+float coasterTrackHeight(float angle){
+	float result = doublePi - angle * 2.0f;
+	return 2.0f * (3.0f * sin(result) / result + 2.0f * cos(result));
+}
+
+void advanceCoasterCar(CoasterCar & car, float deltaTime){
+	if (car.angle <= 0.0f) car.angle = doublePi;
+
+	// Trial step at the base speed to measure the slope
+	car.angle -= 0.5f * deltaTime;
+	float trialY = coasterTrackHeight(car.angle);
+	float angVel = atan(((trialY - car.lastY) / (0.5f * deltaTime) / 8.0f));
+	car.lastY = trialY;
+	car.angle += 0.5f * deltaTime;
+
+	// Slower uphill, faster downhill
+	car.angle -= (0.5f - (0.25f * (angVel))) * deltaTime;
+	car.height = coasterTrackHeight(car.angle);
+	float yDiff = car.height - car.lastY;
+
+	if (angVel > 0.0f) // climbing
+		car.pitch = -atan(yDiff / ((0.5f - (0.25f * (angVel))) * deltaTime) / 8.0f);
+	else // descending
+		car.pitch = atan(yDiff / ((0.5f - (0.25f * (angVel))) * deltaTime) / 4.0f);
+	car.lastY = car.height;
+}
+
+void initRollerCoaster(RollerCoasterRide & ride){
+	// Initial angles of the four cars, a quarter of the track apart
+	ride.cars[0].angle = 2.0 * 3.141592f;
+	ride.cars[1].angle = 2.0 * 3.141592f - (3.141592f / 2.0f);
+	ride.cars[2].angle = 3.141592f;
+	ride.cars[3].angle = 3.141592f / 2.0f;
+	for (int i = 0; i < COASTER_CAR_COUNT; i++) {
+		ride.cars[i].height = 0.0f;
+		ride.cars[i].lastY = 0.0f;
+		ride.cars[i].pitch = 0.0f;
+	}
+
+	// The rail and its supports never move
+	glm::mat4 transMatAllForRC = translate(mat4(), vec3(4.0f, 4.0f, 4.0f));
+
+	glm::mat4 transMatForRC1 = translate(mat4(), vec3(0.0f, 0.15f, 0.0f));
+	glm::mat4 scalMatForRC1 = scale(mat4(), vec3(10.0f, 2.0f, 10.0f));
+	ride.models[COASTER_RAIL] = glm::mat4(1.0f) * transMatAllForRC * transMatForRC1 * scalMatForRC1;
+
+	glm::mat4 transMatForRC4 = translate(mat4(), vec3(10.0f * cos(doublePi),
+		2 * (3.0f * sin(doublePi) / doublePi + 2.0f * cos(doublePi)) - 6.0f, 10 * sin(doublePi)));
+	glm::mat4 scalMatForRC4 = scale(mat4(), vec3(0.5f, 6.0f, 0.5f));
+	ride.models[COASTER_SUPPORT_1] = glm::mat4(1.0f) * transMatAllForRC * transMatForRC4 * scalMatForRC4;
+
+	glm::mat4 transMatForRC5 = translate(mat4(), vec3(10.0f * cos(doublePi / 2.0f),
+		1.0f, 10 * sin(doublePi / 2.0f)));
+	glm::mat4 scalMatForRC5 = scale(mat4(), vec3(0.5f, 9.0f, 0.5f));
+	ride.models[COASTER_SUPPORT_2] = glm::mat4(1.0f) * transMatAllForRC * transMatForRC5 * scalMatForRC5;
+
+	glm::mat4 transMatForRC6 = translate(mat4(), vec3(10.0f * cos(doublePi / 4.0f - 0.125f),
+		2 * (3.0f * sin(-doublePi / 2.0f) / (-doublePi / 2.0f) + 2.0f * cos(-doublePi / 2.0f)) - 6.15f, 10 * sin((doublePi / 4.0f) - 0.125f)));
+	ride.models[COASTER_SUPPORT_3] = glm::mat4(1.0f) * transMatAllForRC * transMatForRC6 * scalMatForRC4;
+
+	glm::mat4 transMatForRC7 = translate(mat4(), vec3(10.0f * cos(doublePi / 4.0f * 3.0f + 0.125f),
+		2 * (3.0f * sin(doublePi / 2.0f) / (doublePi / 2.0f) + 2.0f * cos(doublePi / 2.0f)) - 6.15f, 10 * sin(doublePi / 4.0f * 3.0f + 0.125f)));
+	ride.models[COASTER_SUPPORT_4] = glm::mat4(1.0f) * transMatAllForRC * transMatForRC7 * scalMatForRC4;
+
+	for (int i = 0; i < COASTER_CAR_COUNT; i++)
+		ride.models[COASTER_CAR_1 + i] = glm::mat4(1.0f);
+}
+
+void updateRollerCoaster(RollerCoasterRide & ride, float deltaTime){
+	glm::mat4 transMatAllForRC = translate(mat4(), vec3(4.0f, 4.0f, 4.0f));
+	glm::mat4 scalMatForRC2 = scale(mat4(), vec3(0.5f, 0.5f, 1.0f));
+	for (int i = 0; i < COASTER_CAR_COUNT; i++) {
+		CoasterCar & car = ride.cars[i];
+		advanceCoasterCar(car, deltaTime);
+
+		glm::mat4 transMatForCar = translate(mat4(), vec3(10 * cos(car.angle), car.height + 0.75f, 10 * sin(car.angle)));
+		glm::mat4 rotMatForCar = eulerAngleYXZ(0.0f - car.angle, car.pitch, 0.0f);
+		ride.models[COASTER_CAR_1 + i] = glm::mat4(1.0f) * transMatAllForRC * transMatForCar * rotMatForCar * scalMatForRC2;
+	}
+}
@@ -0,0 +1,164 @@
+#ifndef RIDES_HPP
+#define RIDES_HPP
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Per-frame animation of the three rides, moved out of the render loop so it can be timed and
+// reused without a window. Each update advances the ride by deltaTime and rewrites its model
+// matrices; the caller only multiplies them by the view-projection. The math (including float
+// precision and the order of operations) is the same as the code it replaced, so rendered
+// frames are unchanged.
+
+// Model matrices of the viking ship, in the order they were numbered in playground.cpp.
+enum VikingPart {
+	VIKING_ARM,          // swinging arm, not drawn
+	VIKING_TOP_BEAM,
+	VIKING_BOAT,
+	VIKING_ARM_LEFT,
+	VIKING_ARM_RIGHT,
+	VIKING_LEG_1,
+	VIKING_LEG_2,
+	VIKING_LEG_3,
+	VIKING_LEG_4,
+	VIKING_PART_COUNT
+};
+
+enum MerryGoRoundPart {
+	MGR_TOP,
+	MGR_BOTTOM,
+	MGR_SIDE,
+	MGR_POLE,
+	MGR_UMBRELLA,
+	MGR_SUB_POLE_1,
+	MGR_SUB_POLE_2,
+	MGR_SUB_POLE_3,
+	MGR_SUB_POLE_4,
+	MGR_SEAT_1,
+	MGR_SEAT_2,
+	MGR_SEAT_3,
+	MGR_SEAT_4,
+	MGR_PART_COUNT
+};
+
+#define COASTER_CAR_COUNT 4
+
+enum RollerCoasterPart {
+	COASTER_RAIL,
+	COASTER_CAR_1,
+	COASTER_CAR_2,
+	COASTER_CAR_3,
+	COASTER_CAR_4,
+	COASTER_SUPPORT_1,
+	COASTER_SUPPORT_2,
+	COASTER_SUPPORT_3,
+	COASTER_SUPPORT_4,
+	COASTER_PART_COUNT
+};
+
+struct VikingRide {
+	glm::vec3 orientation; // z is the swing angle
+	int flag;              // 1 while swinging back
+	glm::mat4 models[VIKING_PART_COUNT];
+};
+
+struct MerryGoRoundRide {
+	float rotation;
+	glm::vec3 subPolePositions[4]; // z moves the sub poles up and down
+	int subPoleFlags[4];
+	glm::mat4 models[MGR_PART_COUNT];
+};
+
+struct CoasterCar {
+	float angle;  // position on the track, counting down from 2 pi
+	float height;
+	float lastY;  // track height of the previous frame
+	float pitch;
+};
+
+struct RollerCoasterRide {
+	CoasterCar cars[COASTER_CAR_COUNT];
+	glm::mat4 models[COASTER_PART_COUNT];
+};
+
+void initViking(VikingRide & ride);
+void updateViking(VikingRide & ride, float deltaTime);
+
+void initMerryGoRound(MerryGoRoundRide & ride);
+void updateMerryGoRound(MerryGoRoundRide & ride, float deltaTime);
+
+void initRollerCoaster(RollerCoasterRide & ride);
+void updateRollerCoaster(RollerCoasterRide & ride, float deltaTime);
+
+// Track height at a car angle (the rail's 3 sin(r) / r + 2 cos(r) profile, doubled).
+float coasterTrackHeight(float angle);
+// Moves one car along the track and sets its height and pitch. The speed depends on the slope,
+// which is estimated by a trial step first.
+void advanceCoasterCar(CoasterCar & car, float deltaTime);
+
+// Closed-form versions of the viking ship and the merry-go-round, for animating them on the GPU
+// (rideanimation.hpp). Time replaces the state that the update functions above integrate.
+
+enum RideMotion {
+	RIDE_MOTION_STATIC, // frame, legs
+	RIDE_MOTION_SWING,  // pendulum, like the viking ship
+	RIDE_MOTION_SPIN    // turning, like the merry-go-round, with bobbing parts
+};
+
+enum RideType {
+	RIDE_TYPE_VIKING,
+	RIDE_TYPE_MERRY_GO_ROUND,
+	RIDE_TYPE_COUNT
+};
+
+enum RideTexture {
+	RIDE_TEXTURE_YELLOW,
+	RIDE_TEXTURE_WOOD,
+	RIDE_TEXTURE_STRIP,
+	RIDE_TEXTURE_COUNT
+};
+
+// One ride in the park, laid out as the shader's per-instance attributes.
+//
+// Swinging rides: amplitude is the largest swing angle (radians, below pi / 2) and speed the
+// angular speed at the bottom of the swing, which slows down towards the ends as
+// speed * cos(angle)^2. Spinning rides: speed is the turn rate in radians per second and
+// amplitude how far the bobbing parts move from their middle (they go up and down twice per
+// turn). phase is a fraction of a cycle, to keep neighbouring rides out of step.
+struct RideInstance {
+	glm::vec4 pivot;  // position xyz, yaw in w
+	glm::vec4 motion; // amplitude, phase, speed, unused
+};
+
+// One mesh of a ride type. Its model matrix at time t is
+//   translate(pivot) * rotateY(yaw) * base * rotate(axis, angle(t) + angleOffset)
+//     * translate(bobDirection * bob(t)) * local
+// where angle(t) is 0 for static parts and bob(t) is 0 for all but spinning ones.
+struct RidePart {
+	const char * mesh; // scene mesh name
+	RideTexture texture;
+	RideMotion motion;
+	glm::vec3 axis;    // unit length
+	float angleOffset;
+	glm::vec3 bobDirection; // zero if the part doesn't bob
+	float bobPhase;
+	glm::mat4 base;
+	glm::mat4 local;
+};
+
+// The part's model matrix for one ride at time. The CPU reference of the RIDE_ANIMATION shader
+// code (rideanimation.hpp), computed the same way step by step.
+glm::mat4 rideModel(const RidePart & part, const RideInstance & ride, float time);
+
+// The viking ship and the merry-go-round as RideParts, appended to parts. The matrices are the
+// ones of the update functions with the ride's position left to the instance pivot and the
+// swing / turn / bob to the shader.
+void vikingRideParts(std::vector<RidePart> & parts);
+void merryGoRoundRideParts(std::vector<RidePart> & parts);
+// The park's own viking ship and merry-go-round as instances: their positions and the speeds of
+// updateViking and updateMerryGoRound.
+RideInstance parkVikingInstance();
+RideInstance parkMerryGoRoundInstance();
+
+#endif
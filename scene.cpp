@@ -0,0 +1,160 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <GL/glew.h>
+
+#include "glresource.hpp"
+#include "scene.hpp"
+
+static bool isRangeValid(uint64_t offset, uint64_t size, uint64_t limit){
+	return offset <= limit && size <= limit - offset;
+}
+
+static bool isSceneRecordValid(const SceneMeshRecord & record, const SceneFileHeader & header){
+	if (record.name[SCENE_NAME_LENGTH - 1] != '\0' || !(record.attributes & SCENE_ATTRIB_POSITION))
+		return false;
+	if (record.indexSize != 2 && record.indexSize != 4)
+		return false;
+	uint64_t vertexCount = record.vertexCount;
+	if (!isRangeValid(record.positionOffset, vertexCount * 3 * sizeof(float), header.vertexDataSize))
+		return false;
+	if ((record.attributes & SCENE_ATTRIB_COLOR) && !isRangeValid(record.colorOffset, vertexCount * 3 * sizeof(float), header.vertexDataSize))
+		return false;
+	if ((record.attributes & SCENE_ATTRIB_UV) && !isRangeValid(record.uvOffset, vertexCount * 2 * sizeof(float), header.vertexDataSize))
+		return false;
+	if (record.vertexCount > INT32_MAX || record.indexCount > INT32_MAX || record.indexOffset % record.indexSize != 0)
+		return false;
+	return isRangeValid(record.indexOffset, (uint64_t)record.indexCount * record.indexSize, header.indexDataSize);
+}
+
+// Every index must name one of the mesh's own vertices, or a draw reads past its attributes.
+// indices is the record's index range in the mapping, already checked to be inside the file.
+static bool areSceneIndicesValid(const unsigned char * indices, const SceneMeshRecord & record){
+	uint32_t largest = 0;
+	for (uint32_t i = 0; i < record.indexCount; i++) {
+		uint32_t index;
+		if (record.indexSize == 2) {
+			uint16_t shortIndex;
+			memcpy(&shortIndex, indices + i * 2, 2);
+			index = shortIndex;
+		}
+		else {
+			memcpy(&index, indices + i * 4, 4);
+		}
+		largest = index > largest ? index : largest;
+	}
+	return record.indexCount == 0 || largest < record.vertexCount;
+}
+
+bool openScene(const char * path, uint32_t contentRevision, MappedFile & file, SceneFileHeader & header, Scene & scene){
+	scene.meshes.clear();
+
+	if (!mapFile(path, file))
+		return false;
+
+	bool valid = file.size >= sizeof(header);
+	if (valid) {
+		memcpy(&header, file.data, sizeof(header));
+		valid = header.magic == SCENE_FILE_MAGIC && header.version == SCENE_FILE_VERSION
+			&& isRangeValid(sizeof(header), (uint64_t)header.meshCount * sizeof(SceneMeshRecord), file.size)
+			&& isRangeValid(header.vertexDataOffset, header.vertexDataSize, file.size)
+			&& isRangeValid(header.indexDataOffset, header.indexDataSize, file.size);
+	}
+	if (!valid) {
+		printf("%s is not a valid scene file, ignoring it\n", path);
+		unmapFile(file);
+		return false;
+	}
+	if (header.contentRevision != contentRevision) {
+		printf("%s was baked from revision %u of the geometry, expected %u\n", path, header.contentRevision, contentRevision);
+		unmapFile(file);
+		return false;
+	}
+
+	for (uint32_t i = 0; i < header.meshCount; i++) {
+		SceneMeshRecord record;
+		memcpy(&record, file.data + sizeof(header) + i * sizeof(SceneMeshRecord), sizeof(record));
+		if (!isSceneRecordValid(record, header)
+			|| !areSceneIndicesValid(file.data + header.indexDataOffset + record.indexOffset, record)) {
+			printf("%s: mesh %u is damaged\n", path, i);
+			scene.meshes.clear();
+			unmapFile(file);
+			return false;
+		}
+
+		SceneMesh mesh;
+		memcpy(mesh.name, record.name, SCENE_NAME_LENGTH);
+		mesh.attributes = record.attributes;
+		mesh.vertexCount = (GLsizei)record.vertexCount;
+		mesh.indexCount = (GLsizei)record.indexCount;
+		mesh.indexType = record.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		mesh.positionOffset = (size_t)record.positionOffset;
+		mesh.colorOffset = (size_t)record.colorOffset;
+		mesh.uvOffset = (size_t)record.uvOffset;
+		mesh.indexOffset = (size_t)record.indexOffset;
+		memcpy(mesh.boundsMin, record.boundsMin, sizeof(mesh.boundsMin));
+		memcpy(mesh.boundsMax, record.boundsMax, sizeof(mesh.boundsMax));
+		scene.meshes.push_back(mesh);
+	}
+
+	// Fault the pages in here so the upload never waits on the disk
+	volatile unsigned char sink = 0;
+	for (size_t offset = 0; offset < file.size; offset += 4096)
+		sink ^= file.data[offset];
+	(void)sink;
+	return true;
+}
+
+void uploadScene(const MappedFile & file, const SceneFileHeader & header, Scene & scene){
+	// Upload each block with one call, straight out of the page cache
+	scene.vertexBuffer.create("scene", "scene vertices");
+	glBindBuffer(GL_ARRAY_BUFFER, scene.vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)header.vertexDataSize, file.data + header.vertexDataOffset, GL_STATIC_DRAW);
+	scene.vertexBuffer.setSize((size_t)header.vertexDataSize);
+
+	// GL_ELEMENT_ARRAY_BUFFER is VAO state; the caller binds it into its VAO.
+	// Going through GL_COPY_WRITE_BUFFER here leaves whatever VAO is bound untouched.
+	scene.indexBuffer.create("scene", "scene indices");
+	glBindBuffer(GL_COPY_WRITE_BUFFER, scene.indexBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)header.indexDataSize, file.data + header.indexDataOffset, GL_STATIC_DRAW);
+	scene.indexBuffer.setSize((size_t)header.indexDataSize);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+bool loadScene(const char * path, uint32_t contentRevision, Scene & scene){
+	MappedFile file;
+	SceneFileHeader header;
+	if (!openScene(path, contentRevision, file, header, scene))
+		return false;
+	uploadScene(file, header, scene);
+	unmapFile(file);
+	return true;
+}
+
+const SceneMesh * findSceneMesh(const Scene & scene, const char * name){
+	for (size_t i = 0; i < scene.meshes.size(); i++) {
+		if (strcmp(scene.meshes[i].name, name) == 0)
+			return &scene.meshes[i];
+	}
+	return NULL;
+}
+
+size_t sceneMeshVertexBytes(const SceneMesh & mesh){
+	size_t floats = 3;
+	if (mesh.attributes & SCENE_ATTRIB_COLOR)
+		floats += 3;
+	if (mesh.attributes & SCENE_ATTRIB_UV)
+		floats += 2;
+	return (size_t)mesh.vertexCount * floats * sizeof(float);
+}
+
+size_t sceneMeshIndexBytes(const SceneMesh & mesh){
+	return (size_t)mesh.indexCount * (mesh.indexType == GL_UNSIGNED_SHORT ? 2 : 4);
+}
+
+void deleteScene(Scene & scene){
+	scene.vertexBuffer.reset();
+	scene.indexBuffer.reset();
+	scene.meshes.clear();
+}
@@ -0,0 +1,54 @@
+#ifndef SCENE_HPP
+#define SCENE_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include "glresource.hpp"
+#include "mappedfile.hpp"
+#include "scenefile.hpp"
+
+// One mesh of a loaded scene. Offsets are bytes into the scene's vertex and index buffers.
+struct SceneMesh {
+	char name[SCENE_NAME_LENGTH];
+	unsigned int attributes; // SceneAttribute bits
+	GLsizei vertexCount;
+	GLsizei indexCount;
+	GLenum indexType;        // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	size_t positionOffset;
+	size_t colorOffset;
+	size_t uvOffset;
+	size_t indexOffset;
+	float boundsMin[3];
+	float boundsMax[3];
+};
+
+// All meshes share one vertex buffer and one index buffer.
+struct Scene {
+	GLBuffer vertexBuffer;
+	GLBuffer indexBuffer;
+	std::vector<SceneMesh> meshes;
+};
+
+// Maps a baked .scene file, uploads its vertex and index data straight from the mapping and
+// unmaps it again, so no CPU copy of the geometry stays around. Returns false if the file is
+// missing, damaged or baked with a different contentRevision.
+bool loadScene(const char * path, uint32_t contentRevision, Scene & scene);
+
+// The two halves of loadScene, for loading off the GL thread. openScene maps and validates the
+// file, fills in scene.meshes and touches every page so the upload won't wait on the disk; it
+// makes no GL calls. uploadScene creates the buffers from the mapping on the GL thread. The
+// caller unmaps the file afterwards.
+bool openScene(const char * path, uint32_t contentRevision, MappedFile & file, SceneFileHeader & header, Scene & scene);
+void uploadScene(const MappedFile & file, const SceneFileHeader & header, Scene & scene);
+
+// NULL if the scene has no mesh with that name.
+const SceneMesh * findSceneMesh(const Scene & scene, const char * name);
+
+// Bytes of the shared vertex / index buffer that belong to one mesh.
+size_t sceneMeshVertexBytes(const SceneMesh & mesh);
+size_t sceneMeshIndexBytes(const SceneMesh & mesh);
+
+void deleteScene(Scene & scene);
+
+#endif
@@ -0,0 +1,27 @@
+// Offline bake step for the park geometry.
+//
+//   scenebaker [output.scene]
+//
+// Runs the mesh generators once, welds each mesh into an indexed triangle list with bounds
+// and writes everything to one .scene file (park.scene by default) that playground maps at
+// startup. Only GL types and enums are used, no context is needed.
+
+#include <stdio.h>
+
+#include <GL/glew.h>
+
+#include "scenebuilder.hpp"
+#include "parkgeometry.hpp"
+
+int main(int argc, char ** argv){
+	if (argc > 2) {
+		fprintf(stderr, "usage: %s [output.scene]\n", argv[0]);
+		return 1;
+	}
+	const char * outputPath = argc == 2 ? argv[1] : PARK_SCENE_PATH;
+
+	if (!bakeParkScene(outputPath))
+		return 1;
+	printf("%s : revision %d\n", outputPath, PARK_SCENE_REVISION);
+	return 0;
+}
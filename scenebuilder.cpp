@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <string.h>
+#include <float.h>
+#include <map>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "scenebuilder.hpp"
+
+// position, color, uv of one vertex, compared bit for bit when welding
+struct WeldVertex {
+	float v[8];
+	bool operator<(const WeldVertex & other) const {
+		return memcmp(v, other.v, sizeof(v)) < 0;
+	}
+};
+
+SceneBuilder::SceneBuilder(){
+}
+
+void SceneBuilder::addMesh(const char * name, GLenum mode, const float * positions,
+	const float * colors, const float * uvs, int vertexCount, bool doubleSided){
+	// triangle list of source vertex numbers
+	std::vector<int> corners;
+	if (mode == GL_TRIANGLE_FAN) {
+		for (int i = 1; i + 1 < vertexCount; i++) {
+			corners.push_back(0);
+			corners.push_back(i);
+			corners.push_back(i + 1);
+		}
+	}
+	else {
+		for (int i = 0; i + 2 < vertexCount; i += 3) {
+			corners.push_back(i);
+			corners.push_back(i + 1);
+			corners.push_back(i + 2);
+		}
+	}
+
+	BakedMesh mesh;
+	memset(&mesh.record, 0, sizeof(mesh.record));
+	strncpy(mesh.record.name, name, SCENE_NAME_LENGTH - 1);
+	mesh.record.attributes = SCENE_ATTRIB_POSITION
+		| (colors != NULL ? SCENE_ATTRIB_COLOR : 0)
+		| (uvs != NULL ? SCENE_ATTRIB_UV : 0);
+	for (int k = 0; k < 3; k++) {
+		mesh.record.boundsMin[k] = FLT_MAX;
+		mesh.record.boundsMax[k] = -FLT_MAX;
+	}
+
+	std::map<WeldVertex, uint32_t> welded;
+	for (size_t c = 0; c < corners.size(); c++) {
+		int i = corners[c];
+		WeldVertex vertex;
+		memset(&vertex, 0, sizeof(vertex));
+		memcpy(&vertex.v[0], &positions[3 * i], 3 * sizeof(float));
+		if (colors != NULL)
+			memcpy(&vertex.v[3], &colors[3 * i], 3 * sizeof(float));
+		if (uvs != NULL)
+			memcpy(&vertex.v[6], &uvs[2 * i], 2 * sizeof(float));
+
+		std::map<WeldVertex, uint32_t>::iterator found = welded.find(vertex);
+		if (found != welded.end()) {
+			mesh.indices.push_back(found->second);
+			continue;
+		}
+
+		uint32_t index = (uint32_t)(mesh.positions.size() / 3);
+		welded[vertex] = index;
+		mesh.indices.push_back(index);
+		mesh.positions.insert(mesh.positions.end(), &vertex.v[0], &vertex.v[3]);
+		if (colors != NULL)
+			mesh.colors.insert(mesh.colors.end(), &vertex.v[3], &vertex.v[6]);
+		if (uvs != NULL)
+			mesh.uvs.insert(mesh.uvs.end(), &vertex.v[6], &vertex.v[8]);
+		for (int k = 0; k < 3; k++) {
+			if (vertex.v[k] < mesh.record.boundsMin[k]) mesh.record.boundsMin[k] = vertex.v[k];
+			if (vertex.v[k] > mesh.record.boundsMax[k]) mesh.record.boundsMax[k] = vertex.v[k];
+		}
+	}
+
+	if (doubleSided) {
+		size_t frontCount = mesh.indices.size();
+		for (size_t i = 0; i < frontCount; i += 3) {
+			mesh.indices.push_back(mesh.indices[i]);
+			mesh.indices.push_back(mesh.indices[i + 2]);
+			mesh.indices.push_back(mesh.indices[i + 1]);
+		}
+	}
+
+	mesh.record.vertexCount = (uint32_t)(mesh.positions.size() / 3);
+	mesh.record.indexCount = (uint32_t)mesh.indices.size();
+	mesh.record.indexSize = mesh.record.vertexCount <= 0xffff ? 2 : 4;
+	meshes.push_back(mesh);
+}
+
+bool SceneBuilder::write(const char * path, uint32_t contentRevision) const{
+	std::vector<SceneMeshRecord> records;
+	std::vector<unsigned char> vertexData, indexData;
+
+	for (size_t m = 0; m < meshes.size(); m++) {
+		const BakedMesh & mesh = meshes[m];
+		SceneMeshRecord record = mesh.record;
+
+		record.positionOffset = vertexData.size();
+		vertexData.insert(vertexData.end(), (const unsigned char *)&mesh.positions[0],
+			(const unsigned char *)&mesh.positions[0] + mesh.positions.size() * sizeof(float));
+		record.colorOffset = vertexData.size();
+		if (!mesh.colors.empty())
+			vertexData.insert(vertexData.end(), (const unsigned char *)&mesh.colors[0],
+				(const unsigned char *)&mesh.colors[0] + mesh.colors.size() * sizeof(float));
+		record.uvOffset = vertexData.size();
+		if (!mesh.uvs.empty())
+			vertexData.insert(vertexData.end(), (const unsigned char *)&mesh.uvs[0],
+				(const unsigned char *)&mesh.uvs[0] + mesh.uvs.size() * sizeof(float));
+
+		// keep every index block 4 byte aligned
+		while (indexData.size() % 4 != 0)
+			indexData.push_back(0);
+		record.indexOffset = indexData.size();
+		for (size_t i = 0; i < mesh.indices.size(); i++) {
+			if (record.indexSize == 2) {
+				uint16_t index = (uint16_t)mesh.indices[i];
+				indexData.insert(indexData.end(), (const unsigned char *)&index, (const unsigned char *)&index + 2);
+			}
+			else {
+				indexData.insert(indexData.end(), (const unsigned char *)&mesh.indices[i], (const unsigned char *)&mesh.indices[i] + 4);
+			}
+		}
+		records.push_back(record);
+	}
+
+	SceneFileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = SCENE_FILE_MAGIC;
+	header.version = SCENE_FILE_VERSION;
+	header.contentRevision = contentRevision;
+	header.meshCount = (uint32_t)records.size();
+	header.vertexDataOffset = sizeof(header) + records.size() * sizeof(SceneMeshRecord);
+	header.vertexDataSize = vertexData.size();
+	header.indexDataOffset = header.vertexDataOffset + vertexData.size();
+	header.indexDataSize = indexData.size();
+
+	FILE * file = fopen(path, "wb");
+	if (file == NULL) {
+		printf("Could not write %s\n", path);
+		return false;
+	}
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	if (!records.empty())
+		ok = ok && fwrite(&records[0], sizeof(SceneMeshRecord), records.size(), file) == records.size();
+	if (!vertexData.empty())
+		ok = ok && fwrite(&vertexData[0], 1, vertexData.size(), file) == vertexData.size();
+	if (!indexData.empty())
+		ok = ok && fwrite(&indexData[0], 1, indexData.size(), file) == indexData.size();
+	ok = fclose(file) == 0 && ok;
+	if (!ok) {
+		printf("Failed writing %s\n", path);
+		remove(path);
+	}
+	return ok;
+}
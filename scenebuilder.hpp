@@ -0,0 +1,37 @@
+#ifndef SCENEBUILDER_HPP
+#define SCENEBUILDER_HPP
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "scenefile.hpp"
+
+// Collects generated meshes and writes them as a .scene file (see scenefile.hpp).
+// Bake time only: nothing here is needed to load a scene.
+class SceneBuilder {
+public:
+	SceneBuilder();
+
+	// Adds a mesh from unindexed arrays as the generators produce them. colors and uvs may be
+	// NULL. mode is GL_TRIANGLES or GL_TRIANGLE_FAN; fans are turned into triangle lists.
+	// Identical vertices are welded and the mesh gets an index buffer. A doubleSided mesh also
+	// gets every triangle with the opposite winding (sharing the same vertices), for surfaces
+	// that are seen from both sides while back faces are culled.
+	void addMesh(const char * name, GLenum mode, const float * positions,
+		const float * colors, const float * uvs, int vertexCount, bool doubleSided = false);
+
+	bool write(const char * path, uint32_t contentRevision) const;
+
+private:
+	struct BakedMesh {
+		SceneMeshRecord record;
+		std::vector<float> positions;
+		std::vector<float> colors;
+		std::vector<float> uvs;
+		std::vector<uint32_t> indices;
+	};
+	std::vector<BakedMesh> meshes;
+};
+
+#endif
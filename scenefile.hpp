@@ -0,0 +1,53 @@
+#ifndef SCENEFILE_HPP
+#define SCENEFILE_HPP
+
+#include <stdint.h>
+
+// On-disk layout of a baked scene (.scene), written by scenebaker and mapped as is at runtime.
+//
+//   SceneFileHeader
+//   SceneMeshRecord[meshCount]
+//   vertex data : per mesh positions (3 floats), then colors (3 floats), then uvs (2 floats)
+//   index data  : per mesh 16 or 32 bit indices, GL_TRIANGLES
+//
+// The vertex data and the index data are each uploaded with a single glBufferData straight
+// from the mapping, so every offset in a SceneMeshRecord is relative to the start of its
+// block, i.e. it is already the offset into the GL buffer. All fields are little endian.
+
+#define SCENE_FILE_MAGIC   0x4e435350u // "PSCN"
+#define SCENE_FILE_VERSION 1u
+#define SCENE_NAME_LENGTH  32
+
+enum SceneAttribute {
+	SCENE_ATTRIB_POSITION = 1 << 0, // layout 0
+	SCENE_ATTRIB_COLOR    = 1 << 1, // layout 1
+	SCENE_ATTRIB_UV       = 1 << 2  // layout 2
+};
+
+struct SceneFileHeader {
+	uint32_t magic;
+	uint32_t version;
+	// Bumped by whoever changes the generators, so an old bake is rejected instead of drawn.
+	uint32_t contentRevision;
+	uint32_t meshCount;
+	uint64_t vertexDataOffset; // from the start of the file
+	uint64_t vertexDataSize;
+	uint64_t indexDataOffset;
+	uint64_t indexDataSize;
+};
+
+struct SceneMeshRecord {
+	char name[SCENE_NAME_LENGTH]; // NUL terminated
+	uint32_t attributes;          // SceneAttribute bits
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t indexSize;           // 2 or 4 bytes
+	uint64_t positionOffset;      // into the vertex data
+	uint64_t colorOffset;
+	uint64_t uvOffset;
+	uint64_t indexOffset;         // into the index data
+	float boundsMin[3];           // model space axis aligned bounds
+	float boundsMax[3];
+};
+
+#endif
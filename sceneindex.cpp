@@ -0,0 +1,88 @@
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#include "sceneindex.hpp"
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start){
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+SceneIndex::SceneIndex()
+	: needsBuild(true){
+	memset(&counters, 0, sizeof(counters));
+}
+
+uint32_t SceneIndex::add(const SceneObject & object){
+	uint32_t index = (uint32_t)objects.size();
+	objects.push_back(object);
+	bounds.push_back(Aabb());
+	if (object.moving)
+		movingObjects.push_back(index);
+	needsBuild = true;
+	return index;
+}
+
+void SceneIndex::updateBounds(uint32_t index){
+	const SceneObject & object = objects[index];
+	if (object.model != NULL) {
+		bounds[index] = transformAabb(object.localMin, object.localMax, *object.model);
+	} else {
+		bounds[index].min = object.localMin;
+		bounds[index].max = object.localMax;
+	}
+}
+
+void SceneIndex::update(){
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (needsBuild) {
+		for (uint32_t i = 0; i < objects.size(); i++)
+			updateBounds(i);
+		bvh.build(bounds.empty() ? NULL : &bounds[0], bounds.size());
+		needsBuild = false;
+		counters.builds++;
+		counters.buildMs += millisecondsSince(start);
+		return;
+	}
+	if (movingObjects.empty())
+		return;
+	for (size_t i = 0; i < movingObjects.size(); i++)
+		updateBounds(movingObjects[i]);
+	bvh.refit(&bounds[0], &movingObjects[0], movingObjects.size());
+	counters.refits++;
+	counters.refitMs += millisecondsSince(start);
+}
+
+void SceneIndex::cull(const glm::mat4 & viewProjection, std::vector<uint32_t> & visible) const{
+	glm::vec4 planes[6];
+	frustumPlanes(viewProjection, planes);
+	visible.clear();
+	bvh.cull(planes, visible);
+	std::sort(visible.begin(), visible.end());
+}
+
+ScenePick SceneIndex::pick(const glm::vec3 & origin, const glm::vec3 & direction, float maxDistance) const{
+	ScenePick result;
+	result.object = -1;
+	result.distance = maxDistance;
+	BvhRayTest test = [&](uint32_t index, float limit, float & distance) {
+		const SceneObject & object = objects[index];
+		if (object.model == NULL)
+			return rayHitsAabb(origin, glm::vec3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z), bounds[index],
+				limit, distance);
+		// The same ray parameter in model space, where the box is axis aligned
+		glm::mat4 toModel = glm::inverse(*object.model);
+		glm::vec3 localOrigin(toModel * glm::vec4(origin, 1.0f));
+		glm::vec3 localDirection(toModel * glm::vec4(direction, 0.0f));
+		Aabb box = { object.localMin, object.localMax };
+		return rayHitsAabb(localOrigin, glm::vec3(1.0f / localDirection.x, 1.0f / localDirection.y, 1.0f / localDirection.z),
+			box, limit, distance);
+	};
+	float distance;
+	result.object = bvh.raycast(origin, direction, maxDistance, test, distance);
+	if (result.object >= 0) {
+		result.distance = distance;
+		result.point = origin + direction * distance;
+	}
+	return result;
+}
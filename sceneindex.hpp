@@ -0,0 +1,75 @@
+#ifndef SCENEINDEX_HPP
+#define SCENEINDEX_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bvh.hpp"
+
+// The park's ride parts in a Bvh, for frustum culling and picking. GL-free.
+//
+// Each object is a box in model space (its mesh's bounds) placed by a model matrix that the
+// index reads through a pointer, so the rides keep writing their matrices where they always
+// have. Static objects are read when the tree is built, moving ones at every update(), which
+// only refits the paths from their leaves up. Adding objects or calling staticChanged() makes
+// the next update() build the tree again.
+
+struct SceneObject {
+	const char * ride;        // shown when picked
+	const char * part;
+	glm::vec3 localMin;       // the box in model space
+	glm::vec3 localMax;
+	const glm::mat4 * model;  // NULL if the box is already in world space
+	bool moving;
+};
+
+struct ScenePick {
+	int object;               // -1 if nothing was hit
+	float distance;           // along the ray, in units of its direction's length
+	glm::vec3 point;
+};
+
+// Summed over updates
+struct SceneIndexStats {
+	long long builds;
+	long long refits;
+	double buildMs;
+	double refitMs;
+};
+
+class SceneIndex {
+public:
+	SceneIndex();
+
+	uint32_t add(const SceneObject & object);
+	void staticChanged() { needsBuild = true; }
+	// Builds the tree if it is missing or a static object changed, otherwise refits the moving
+	// objects
+	void update();
+
+	// The objects in the frustum of viewProjection, in the order they were added
+	void cull(const glm::mat4 & viewProjection, std::vector<uint32_t> & visible) const;
+	// The nearest object along the ray. Candidates are tested against their box in model space,
+	// so a tilted part is hit where it is, not anywhere in its world box.
+	ScenePick pick(const glm::vec3 & origin, const glm::vec3 & direction, float maxDistance) const;
+
+	size_t size() const { return objects.size(); }
+	const SceneObject & object(uint32_t index) const { return objects[index]; }
+	const Aabb & worldBounds(uint32_t index) const { return bounds[index]; }
+	const Bvh & tree() const { return bvh; }
+	const SceneIndexStats & stats() const { return counters; }
+
+private:
+	void updateBounds(uint32_t index);
+
+	std::vector<SceneObject> objects;
+	std::vector<Aabb> bounds;
+	std::vector<uint32_t> movingObjects;
+	Bvh bvh;
+	bool needsBuild;
+	SceneIndexStats counters;
+};
+
+#endif
@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include <GL/glew.h>
+
+#include "hash.hpp"
+#include "shadercache.hpp"
+
+#define PROGRAM_CACHE_MAGIC   0x42485350u // "PSHB"
+#define PROGRAM_CACHE_VERSION 1u
+
+struct ProgramCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	uint32_t binaryFormat;
+	uint32_t binaryLength;
+};
+
+bool readTextFile(const char * path, std::string & text){
+	std::ifstream stream(path, std::ios::in);
+	if (!stream.is_open())
+		return false;
+	std::stringstream sstr;
+	sstr << stream.rdbuf();
+	text = sstr.str();
+	return true;
+}
+
+static bool compileShader(GLuint shaderID, const char * source){
+	glShaderSource(shaderID, 1, &source, NULL);
+	glCompileShader(shaderID);
+
+	GLint result = GL_FALSE;
+	int infoLogLength;
+	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &result);
+	glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &infoLogLength);
+	if (infoLogLength > 1) {
+		std::vector<char> message(infoLogLength + 1);
+		glGetShaderInfoLog(shaderID, infoLogLength, NULL, &message[0]);
+		printf("%s\n", &message[0]);
+	}
+	return result == GL_TRUE;
+}
+
+// Only link status matters here; the caller decides what to do with a failed program
+static bool checkLinkStatus(GLuint programID, bool printLog){
+	GLint result = GL_FALSE;
+	int infoLogLength;
+	glGetProgramiv(programID, GL_LINK_STATUS, &result);
+	glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &infoLogLength);
+	if (printLog && infoLogLength > 1) {
+		std::vector<char> message(infoLogLength + 1);
+		glGetProgramInfoLog(programID, infoLogLength, NULL, &message[0]);
+		printf("%s\n", &message[0]);
+	}
+	return result == GL_TRUE;
+}
+
+GLuint compileProgram(const char * vertexSource, const char * fragmentSource, bool retrievable){
+	GLuint vertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+	GLuint fragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+
+	bool compiled = compileShader(vertexShaderID, vertexSource);
+	compiled = compileShader(fragmentShaderID, fragmentSource) && compiled;
+
+	GLuint programID = 0;
+	if (compiled) {
+		programID = glCreateProgram();
+		glAttachShader(programID, vertexShaderID);
+		glAttachShader(programID, fragmentShaderID);
+		if (retrievable)
+			glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glLinkProgram(programID);
+
+		bool linked = checkLinkStatus(programID, true);
+		glDetachShader(programID, vertexShaderID);
+		glDetachShader(programID, fragmentShaderID);
+		if (!linked) {
+			glDeleteProgram(programID);
+			programID = 0;
+		}
+	}
+
+	glDeleteShader(vertexShaderID);
+	glDeleteShader(fragmentShaderID);
+	return programID;
+}
+
+GLuint compileCaptureProgram(const char * vertexSource, const char * const * varyings, int varyingCount){
+	GLuint vertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+	GLuint programID = 0;
+	if (compileShader(vertexShaderID, vertexSource)) {
+		programID = glCreateProgram();
+		glAttachShader(programID, vertexShaderID);
+		// Has to be set before linking
+		glTransformFeedbackVaryings(programID, varyingCount, varyings, GL_INTERLEAVED_ATTRIBS);
+		glLinkProgram(programID);
+
+		bool linked = checkLinkStatus(programID, true);
+		glDetachShader(programID, vertexShaderID);
+		if (!linked) {
+			glDeleteProgram(programID);
+			programID = 0;
+		}
+	}
+	glDeleteShader(vertexShaderID);
+	return programID;
+}
+
+static bool hasProgramBinarySupport(){
+	if (!GLEW_ARB_get_program_binary && !GLEW_VERSION_4_1)
+		return false;
+	// Some drivers expose the entry points but no formats to save to
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	return formats > 0;
+}
+
+static uint64_t programCacheKey(const char * vertexSource, const char * fragmentSource){
+	uint64_t key = hashString(vertexSource);
+	key = hashBytes("\0", 1, key); // keep "ab"+"c" and "a"+"bc" apart
+	key = hashString(fragmentSource, key);
+	const GLubyte * strings[] = { glGetString(GL_VENDOR), glGetString(GL_RENDERER), glGetString(GL_VERSION) };
+	for (int i = 0; i < 3; i++) {
+		key = hashBytes("\0", 1, key);
+		if (strings[i] != NULL)
+			key = hashString((const char *)strings[i], key);
+	}
+	return key;
+}
+
+static GLuint loadProgramBinary(const char * path, uint64_t key){
+	FILE * file = fopen(path, "rb");
+	if (file == NULL)
+		return 0;
+
+	ProgramCacheHeader header;
+	std::vector<unsigned char> binary;
+	bool ok = fread(&header, sizeof(header), 1, file) == 1
+		&& header.magic == PROGRAM_CACHE_MAGIC
+		&& header.version == PROGRAM_CACHE_VERSION
+		&& header.key == key
+		&& header.binaryLength > 0;
+	if (ok) {
+		binary.resize(header.binaryLength);
+		ok = fread(&binary[0], 1, binary.size(), file) == binary.size();
+	}
+	fclose(file);
+	if (!ok)
+		return 0;
+
+	GLuint programID = glCreateProgram();
+	glProgramBinary(programID, header.binaryFormat, &binary[0], header.binaryLength);
+	// A driver update can reject a binary even with an unchanged version string
+	if (!checkLinkStatus(programID, false)) {
+		glDeleteProgram(programID);
+		return 0;
+	}
+	return programID;
+}
+
+static void saveProgramBinary(const char * path, uint64_t key, GLuint programID){
+	GLint length = 0;
+	glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	std::vector<unsigned char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(programID, length, &length, &format, &binary[0]);
+
+	ProgramCacheHeader header;
+	header.magic = PROGRAM_CACHE_MAGIC;
+	header.version = PROGRAM_CACHE_VERSION;
+	header.key = key;
+	header.binaryFormat = format;
+	header.binaryLength = (uint32_t)length;
+
+	FILE * file = fopen(path, "wb");
+	if (file == NULL) {
+		printf("Could not write program cache %s\n", path);
+		return;
+	}
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(&binary[0], 1, length, file);
+	fclose(file);
+}
+
+GLuint loadProgramCached(const char * vertexSource, const char * fragmentSource, const char * cacheDir){
+	if (!hasProgramBinarySupport())
+		return compileProgram(vertexSource, fragmentSource, false);
+
+	uint64_t key = programCacheKey(vertexSource, fragmentSource);
+	char path[1024];
+	snprintf(path, sizeof(path), "%s/%016llx.bin", cacheDir, (unsigned long long)key);
+
+	GLuint programID = loadProgramBinary(path, key);
+	if (programID != 0) {
+		printf("Program cache hit : %s\n", path);
+		return programID;
+	}
+
+	printf("Program cache miss, compiling : %s\n", path);
+	programID = compileProgram(vertexSource, fragmentSource, true);
+	if (programID == 0)
+		return 0;
+
+#ifdef _WIN32
+	_mkdir(cacheDir);
+#else
+	mkdir(cacheDir, 0755);
+#endif
+	saveProgramBinary(path, key, programID);
+	return programID;
+}
+
+GLuint LoadShadersCached(const char * vertex_file_path, const char * fragment_file_path, const char * cacheDir){
+	std::string vertexSource, fragmentSource;
+	if (!readTextFile(vertex_file_path, vertexSource)) {
+		printf("Impossible to open %s. Are you in the right directory ?\n", vertex_file_path);
+		return 0;
+	}
+	if (!readTextFile(fragment_file_path, fragmentSource)) {
+		printf("Impossible to open %s. Are you in the right directory ?\n", fragment_file_path);
+		return 0;
+	}
+	return loadProgramCached(vertexSource.c_str(), fragmentSource.c_str(), cacheDir);
+}
@@ -0,0 +1,27 @@
+#ifndef SHADERCACHE_HPP
+#define SHADERCACHE_HPP
+
+#include <string>
+
+// Reads a whole text file. Returns false if it can't be opened.
+bool readTextFile(const char * path, std::string & text);
+
+// Compiles and links a program from source. Returns 0 (after printing the info logs) on failure.
+// With retrievable set, the program is linked so that glGetProgramBinary can be called on it.
+GLuint compileProgram(const char * vertexSource, const char * fragmentSource, bool retrievable);
+
+// Vertex shader only program whose varyings are captured with transform feedback, interleaved
+// in the given order, for reading shader results back (draw with GL_RASTERIZER_DISCARD).
+// Not cached. Returns 0 (after printing the info logs) on failure.
+GLuint compileCaptureProgram(const char * vertexSource, const char * const * varyings, int varyingCount);
+
+// Same as compileProgram, but first looks for a program binary saved by an earlier run.
+// The cache key covers both sources and the GL vendor, renderer and version strings, so a new
+// driver or an edited shader simply misses. Binaries the driver rejects are recompiled and
+// overwritten. Without program binary support this is compileProgram.
+GLuint loadProgramCached(const char * vertexSource, const char * fragmentSource, const char * cacheDir);
+
+// LoadShaders replacement that goes through loadProgramCached.
+GLuint LoadShadersCached(const char * vertex_file_path, const char * fragment_file_path, const char * cacheDir = "shadercache");
+
+#endif
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "shadercache.hpp"
+#include "shaderpermutation.hpp"
+
+static const char * s_featureDefines[SHADER_FEATURE_COUNT] = {
+	"USE_TEXTURE", "RIDE_ANIMATION"
+};
+
+static const char * s_permutationNames[SHADER_PERMUTATION_COUNT] = {
+	"vertex color", "textured", "animated vertex color", "animated textured"
+};
+
+// Closest thing to a program's memory use that GL will tell us
+static size_t programBinarySize(GLuint program){
+	if (!GLEW_ARB_get_program_binary && !GLEW_VERSION_4_1)
+		return 0;
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	return length > 0 ? (size_t)length : 0;
+}
+
+std::string injectShaderDefines(const std::string & source, unsigned int features){
+	std::string defines;
+	for (int i = 0; i < SHADER_FEATURE_COUNT; i++) {
+		if (features & (1u << i))
+			defines += std::string("#define ") + s_featureDefines[i] + "\n";
+	}
+
+	// #version has to stay the first statement
+	size_t insertAt = 0;
+	size_t version = source.find("#version");
+	if (version != std::string::npos) {
+		size_t lineEnd = source.find('\n', version);
+		insertAt = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+	}
+	std::string result = source;
+	if (insertAt == result.size() && !result.empty() && result[result.size() - 1] != '\n') {
+		result += '\n';
+		insertAt++;
+	}
+	result.insert(insertAt, defines);
+	return result;
+}
+
+bool loadShaderPermutations(const char * vertex_file_path, const char * fragment_file_path,
+	ShaderProgram * programs, const char * cacheDir){
+	std::string vertexSource, fragmentSource;
+	if (!readTextFile(vertex_file_path, vertexSource)) {
+		printf("Impossible to open %s. Are you in the right directory ?\n", vertex_file_path);
+		return false;
+	}
+	if (!readTextFile(fragment_file_path, fragmentSource)) {
+		printf("Impossible to open %s. Are you in the right directory ?\n", fragment_file_path);
+		return false;
+	}
+	return buildShaderPermutations(vertexSource, fragmentSource, programs, cacheDir);
+}
+
+bool buildShaderPermutations(const std::string & vertexSource, const std::string & fragmentSource,
+	ShaderProgram * programs, const char * cacheDir){
+	bool ok = true;
+	for (unsigned int features = 0; features < SHADER_PERMUTATION_COUNT; features++) {
+		std::string vertex = injectShaderDefines(vertexSource, features);
+		std::string fragment = injectShaderDefines(fragmentSource, features);
+
+		ShaderProgram & program = programs[features];
+		program.program.adopt(loadProgramCached(vertex.c_str(), fragment.c_str(), cacheDir), "shaders", s_permutationNames[features]);
+		if (program.program == 0) {
+			printf("Shader permutation %u failed to build\n", features);
+			program.mvpLocation = -1;
+			ok = false;
+			continue;
+		}
+		program.mvpLocation = glGetUniformLocation(program.program, "MVP");
+		program.program.setSize(programBinarySize(program.program));
+
+		// The sampler always reads unit 0, so it is set once here instead of per draw
+		if (features & SHADER_TEXTURED) {
+			glUseProgram(program.program);
+			glUniform1i(glGetUniformLocation(program.program, "myTextureSampler"), 0);
+		}
+	}
+	glUseProgram(0);
+	return ok;
+}
+
+void deleteShaderPermutations(ShaderProgram * programs){
+	for (int i = 0; i < SHADER_PERMUTATION_COUNT; i++)
+		programs[i].program.reset();
+}
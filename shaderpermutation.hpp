@@ -0,0 +1,39 @@
+#ifndef SHADERPERMUTATION_HPP
+#define SHADERPERMUTATION_HPP
+
+#include <string>
+
+#include "glresource.hpp"
+
+// Feature bits of a shader permutation. Every combination is built from the same two source
+// files, with one #define per set bit, so the shaders have no runtime branches on these.
+// Adding a feature (e.g. lighting) only needs a new bit, its define name in
+// shaderpermutation.cpp, and a bump of SHADER_FEATURE_COUNT.
+enum ShaderFeature {
+	SHADER_TEXTURED = 1 << 0,      // USE_TEXTURE: sample myTextureSampler instead of the vertex color
+	SHADER_RIDE_ANIMATION = 1 << 1 // RIDE_ANIMATION: instanced rides moved by the time uniform (rideanimation.hpp)
+};
+
+#define SHADER_FEATURE_COUNT 2
+#define SHADER_PERMUTATION_COUNT (1 << SHADER_FEATURE_COUNT)
+
+struct ShaderProgram {
+	GLProgram program;
+	GLint mvpLocation;
+};
+
+// Returns source with the feature defines inserted right after its #version line.
+std::string injectShaderDefines(const std::string & source, unsigned int features);
+
+// Builds all SHADER_PERMUTATION_COUNT programs up front, through the program binary cache.
+// programs is indexed by the feature bits. Returns false if any permutation fails.
+bool loadShaderPermutations(const char * vertex_file_path, const char * fragment_file_path,
+	ShaderProgram * programs, const char * cacheDir = "shadercache");
+
+// Same, from sources already in memory (e.g. read on another thread).
+bool buildShaderPermutations(const std::string & vertexSource, const std::string & fragmentSource,
+	ShaderProgram * programs, const char * cacheDir = "shadercache");
+
+void deleteShaderPermutations(ShaderProgram * programs);
+
+#endif
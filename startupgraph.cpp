@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <string>
+#include <thread>
+
+#include "startupgraph.hpp"
+
+#define TIMELINE_BAR_WIDTH 40
+
+StartupGraph::StartupGraph()
+	: origin(std::chrono::steady_clock::now()){
+}
+
+int StartupGraph::addTask(const char * name, StartupThread thread, std::function<bool()> work,
+	std::initializer_list<int> dependencies){
+	Task task;
+	task.name = name;
+	task.thread = thread;
+	task.work = work;
+	task.dependencies.assign(dependencies.begin(), dependencies.end());
+	task.state = TASK_WAITING;
+	task.threadIndex = -1;
+	task.startMs = 0.0;
+	task.endMs = 0.0;
+	tasks.push_back(task);
+	return (int)tasks.size() - 1;
+}
+
+double StartupGraph::elapsedMs() const{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - origin).count();
+}
+
+int StartupGraph::takeReadyTask(StartupThread thread, int threadIndex){
+	for (size_t i = 0; i < tasks.size(); i++) {
+		Task & task = tasks[i];
+		if (task.state != TASK_WAITING)
+			continue;
+
+		bool ready = true, skip = false;
+		for (size_t d = 0; d < task.dependencies.size(); d++) {
+			TaskState dependency = tasks[task.dependencies[d]].state;
+			if (dependency == TASK_FAILED || dependency == TASK_SKIPPED)
+				skip = true;
+			else if (dependency != TASK_DONE)
+				ready = false;
+		}
+		if (skip) {
+			// Nobody runs it, so it may be settled from any thread
+			task.state = TASK_SKIPPED;
+			changed.notify_all();
+			continue;
+		}
+		if (ready && task.thread == thread) {
+			task.state = TASK_RUNNING;
+			task.threadIndex = threadIndex;
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+bool StartupGraph::allFinished() const{
+	for (size_t i = 0; i < tasks.size(); i++) {
+		if (tasks[i].state == TASK_WAITING || tasks[i].state == TASK_RUNNING)
+			return false;
+	}
+	return true;
+}
+
+void StartupGraph::runTask(int id){
+	// The task itself runs unlocked; only its bookkeeping is shared
+	std::function<bool()> work = tasks[id].work;
+	double start = elapsedMs();
+	bool ok = work();
+	double end = elapsedMs();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	tasks[id].startMs = start;
+	tasks[id].endMs = end;
+	tasks[id].state = ok ? TASK_DONE : TASK_FAILED;
+	if (!ok)
+		printf("Startup task \"%s\" failed\n", tasks[id].name);
+	changed.notify_all();
+}
+
+void StartupGraph::workerMain(int threadIndex){
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		int id = takeReadyTask(STARTUP_WORKER_THREAD, threadIndex);
+		if (id >= 0) {
+			lock.unlock();
+			runTask(id);
+			lock.lock();
+			continue;
+		}
+		if (allFinished())
+			return;
+		changed.wait(lock);
+	}
+}
+
+bool StartupGraph::run(int workerCount){
+	std::vector<std::thread> workers;
+	for (int i = 0; i < workerCount; i++)
+		workers.push_back(std::thread(&StartupGraph::workerMain, this, i + 1));
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;) {
+			int id = takeReadyTask(STARTUP_MAIN_THREAD, 0);
+			if (id >= 0) {
+				lock.unlock();
+				runTask(id);
+				lock.lock();
+				continue;
+			}
+			if (allFinished())
+				break;
+			changed.wait(lock);
+		}
+	}
+	changed.notify_all();
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+
+	for (size_t i = 0; i < tasks.size(); i++) {
+		if (tasks[i].state != TASK_DONE)
+			return false;
+	}
+	return true;
+}
+
+void StartupGraph::printTimeline() const{
+	double total = 0.0;
+	for (size_t i = 0; i < tasks.size(); i++) {
+		if (tasks[i].endMs > total)
+			total = tasks[i].endMs;
+	}
+
+	printf("Startup timeline (%.1f ms)\n", total);
+	printf("  %-22s %-8s %9s %9s %9s\n", "task", "thread", "start", "end", "ms");
+	for (size_t i = 0; i < tasks.size(); i++) {
+		const Task & task = tasks[i];
+		char thread[16] = "main";
+		if (task.threadIndex > 0)
+			snprintf(thread, sizeof(thread), "worker%d", task.threadIndex);
+
+		if (task.state != TASK_DONE && task.state != TASK_FAILED) {
+			printf("  %-22s %-8s %29s\n", task.name, thread, "skipped");
+			continue;
+		}
+
+		char bar[TIMELINE_BAR_WIDTH + 1];
+		int from = total > 0.0 ? (int)(task.startMs / total * TIMELINE_BAR_WIDTH) : 0;
+		int to = total > 0.0 ? (int)(task.endMs / total * TIMELINE_BAR_WIDTH + 0.5) : 0;
+		if (to <= from)
+			to = from + 1;
+		for (int c = 0; c < TIMELINE_BAR_WIDTH; c++)
+			bar[c] = c >= from && c < to ? '#' : '.';
+		bar[TIMELINE_BAR_WIDTH] = '\0';
+
+		printf("  %-22s %-8s %9.1f %9.1f %9.1f |%s|%s\n", task.name, thread, task.startMs, task.endMs,
+			task.endMs - task.startMs, bar, task.state == TASK_FAILED ? " failed" : "");
+	}
+}
+
+bool StartupGraph::writeTimeline(const char * path) const{
+	FILE * file = fopen(path, "w");
+	if (file == NULL) {
+		printf("Could not write %s\n", path);
+		return false;
+	}
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+	for (size_t i = 0; i < tasks.size(); i++) {
+		const Task & task = tasks[i];
+		if (task.state != TASK_DONE && task.state != TASK_FAILED)
+			continue;
+		// Chrome trace timestamps are in microseconds
+		fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"startup\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.1f,\"dur\":%.1f}",
+			first ? "" : ",\n", task.name, task.threadIndex, task.startMs * 1000.0, (task.endMs - task.startMs) * 1000.0);
+		first = false;
+	}
+	fprintf(file, "\n]}\n");
+	return fclose(file) == 0;
+}
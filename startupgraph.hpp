@@ -0,0 +1,68 @@
+#ifndef STARTUPGRAPH_HPP
+#define STARTUPGRAPH_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <vector>
+
+// Which thread a startup task may run on. GL and GLFW calls have to stay on the thread that
+// owns the context; everything else (file I/O, decoding, generation) can go to a worker.
+enum StartupThread {
+	STARTUP_MAIN_THREAD,
+	STARTUP_WORKER_THREAD
+};
+
+// Startup work as a dependency graph.
+//
+// Tasks are added in any order that lists dependencies before dependents. run() starts a few
+// worker threads for the worker tasks and executes the main-thread tasks itself, each as soon
+// as its dependencies are done, so disk and CPU work overlaps with context creation and
+// shader compilation. A task that returns false fails the run, and its dependents are skipped.
+// Every task is timed for the startup timeline.
+class StartupGraph {
+public:
+	StartupGraph();
+
+	// Returns the task id to use in later dependency lists.
+	int addTask(const char * name, StartupThread thread, std::function<bool()> work,
+		std::initializer_list<int> dependencies = {});
+
+	// Runs every task. Returns false if any of them failed.
+	bool run(int workerCount = 2);
+
+	// Per-task start/end in ms since the graph was created, with a bar chart.
+	void printTimeline() const;
+	// Same data as a Chrome trace (chrome://tracing, Perfetto).
+	bool writeTimeline(const char * path) const;
+
+private:
+	enum TaskState { TASK_WAITING, TASK_RUNNING, TASK_DONE, TASK_FAILED, TASK_SKIPPED };
+
+	struct Task {
+		const char * name;
+		StartupThread thread;
+		std::function<bool()> work;
+		std::vector<int> dependencies;
+		TaskState state;
+		int threadIndex; // 0 = main thread, 1.. = workers
+		double startMs;
+		double endMs;
+	};
+
+	// Next task this thread can start, or -1. Marks tasks with failed dependencies skipped.
+	int takeReadyTask(StartupThread thread, int threadIndex);
+	bool allFinished() const;
+	void runTask(int id);
+	void workerMain(int threadIndex);
+	double elapsedMs() const;
+
+	std::vector<Task> tasks;
+	std::chrono::steady_clock::time_point origin;
+	std::mutex mutex;
+	std::condition_variable changed;
+};
+
+#endif
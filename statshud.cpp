@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "statshud.hpp"
+
+#define HUD_MARGIN 8.0f
+#define HUD_PIXEL 2.0f         // size of one font pixel on screen
+#define HUD_LINE_HEIGHT 14.0f
+#define HUD_GRAPH_HEIGHT 60.0f
+#define HUD_GRAPH_MAX_MS 50.0f
+#define HUD_CROSSHAIR 8.0f     // length of each arm, in pixels
+
+// 3x5 glyphs, one byte per row from the top, bit 2 is the left column
+struct HudGlyph {
+	char c;
+	unsigned char rows[5];
+};
+
+static const HudGlyph hudFont[] = {
+	{ '0', { 7, 5, 5, 5, 7 } }, { '1', { 2, 6, 2, 2, 7 } }, { '2', { 7, 1, 7, 4, 7 } },
+	{ '3', { 7, 1, 7, 1, 7 } }, { '4', { 5, 5, 7, 1, 1 } }, { '5', { 7, 4, 7, 1, 7 } },
+	{ '6', { 7, 4, 7, 5, 7 } }, { '7', { 7, 1, 1, 1, 1 } }, { '8', { 7, 5, 7, 5, 7 } },
+	{ '9', { 7, 5, 7, 1, 7 } },
+	{ 'A', { 2, 5, 7, 5, 5 } }, { 'B', { 6, 5, 6, 5, 6 } }, { 'C', { 3, 4, 4, 4, 3 } },
+	{ 'D', { 6, 5, 5, 5, 6 } }, { 'E', { 7, 4, 6, 4, 7 } }, { 'F', { 7, 4, 6, 4, 4 } },
+	{ 'G', { 3, 4, 5, 5, 3 } }, { 'H', { 5, 5, 7, 5, 5 } }, { 'I', { 7, 2, 2, 2, 7 } },
+	{ 'J', { 1, 1, 1, 5, 2 } }, { 'K', { 5, 5, 6, 5, 5 } }, { 'L', { 4, 4, 4, 4, 7 } },
+	{ 'M', { 5, 7, 7, 5, 5 } }, { 'N', { 6, 5, 5, 5, 5 } }, { 'O', { 2, 5, 5, 5, 2 } },
+	{ 'P', { 6, 5, 6, 4, 4 } }, { 'Q', { 2, 5, 5, 6, 3 } }, { 'R', { 6, 5, 6, 5, 5 } },
+	{ 'S', { 3, 4, 2, 1, 6 } }, { 'T', { 7, 2, 2, 2, 2 } }, { 'U', { 5, 5, 5, 5, 7 } },
+	{ 'V', { 5, 5, 5, 5, 2 } }, { 'W', { 5, 5, 7, 7, 5 } }, { 'X', { 5, 5, 2, 5, 5 } },
+	{ 'Y', { 5, 5, 2, 2, 2 } }, { 'Z', { 7, 1, 2, 4, 7 } },
+	{ '.', { 0, 0, 0, 0, 2 } }, { ':', { 0, 2, 0, 2, 0 } }, { '/', { 1, 1, 2, 4, 4 } },
+	{ '-', { 0, 0, 7, 0, 0 } },
+};
+
+static const HudGlyph * findGlyph(char c){
+	if (c >= 'a' && c <= 'z')
+		c = c - 'a' + 'A';
+	for (size_t i = 0; i < sizeof(hudFont) / sizeof(hudFont[0]); i++) {
+		if (hudFont[i].c == c)
+			return &hudFont[i];
+	}
+	return NULL; // space and anything unknown
+}
+
+StatsHud::StatsHud()
+	: crosshair(false){
+}
+
+StatsHud::~StatsHud(){
+	shutdown();
+}
+
+void StatsHud::init(){
+	// A few frames in flight; the text usually needs well under 256 KB
+	vertexBuffer.init(GL_ARRAY_BUFFER, 256 * 1024, 3, "hud", "hud vertices");
+}
+
+void StatsHud::shutdown(){
+	vertexBuffer.shutdown();
+}
+
+void StatsHud::addQuad(float x, float y, float w, float h, float r, float g, float b){
+	// Counter-clockwise once y is flipped to point up, so the quads survive back face culling
+	const float corners[6][2] = { { x, y }, { x, y + h }, { x + w, y + h }, { x, y }, { x + w, y + h }, { x + w, y } };
+	for (int i = 0; i < 6; i++) {
+		const float vertex[6] = { corners[i][0], corners[i][1], 0.0f, r, g, b };
+		vertices.insert(vertices.end(), vertex, vertex + 6);
+	}
+}
+
+void StatsHud::addText(const char * text, float x, float y, float pixel, float r, float g, float b){
+	for (const char * c = text; *c != '\0'; c++, x += 4.0f * pixel) {
+		const HudGlyph * glyph = findGlyph(*c);
+		if (glyph == NULL)
+			continue;
+		for (int row = 0; row < 5; row++) {
+			for (int column = 0; column < 3; column++) {
+				if (glyph->rows[row] & (4 >> column))
+					addQuad(x + column * pixel, y + row * pixel, pixel, pixel, r, g, b);
+			}
+		}
+	}
+}
+
+void StatsHud::draw(RenderStateCache & renderState, const RenderStats * stats, int width, int height){
+	if (vertexBuffer.buffer() == 0 || width <= 0 || height <= 0)
+		return;
+
+	vertices.clear();
+	if (stats != NULL) {
+		const FrameStats & frame = stats->lastFrame();
+		char lines[5][96];
+		snprintf(lines[0], sizeof(lines[0]), "FRAME MS P50 %.1f P95 %.1f P99 %.1f",
+			stats->percentile(50.0), stats->percentile(95.0), stats->percentile(99.0));
+		snprintf(lines[1], sizeof(lines[1]), "DRAWS %u TRIS %u VERTS %u", frame.drawCalls, frame.triangles, frame.vertices);
+		snprintf(lines[2], sizeof(lines[2]), "BINDS PROG %u BUF %u TEX %u UNIFORMS %u",
+			frame.programBinds, frame.bufferBinds, frame.textureBinds, frame.uniformUploads);
+		snprintf(lines[3], sizeof(lines[3]), "UPLOAD %.1f KB OVERDRAW %.2f", frame.uploadBytes / 1024.0, overdraw(frame));
+		snprintf(lines[4], sizeof(lines[4]), "GPU MEM %.1f MB PEAK %.1f MB",
+			glResources().liveBytes() / (1024.0 * 1024.0), glResources().peakBytes() / (1024.0 * 1024.0));
+
+		int graphBars = stats->frameTimeCount();
+		float panelWidth = 300.0f;
+		if (graphBars * 1.0f > panelWidth)
+			panelWidth = (float)graphBars;
+		float panelHeight = 5 * HUD_LINE_HEIGHT + HUD_GRAPH_HEIGHT + 3 * HUD_MARGIN;
+		addQuad(HUD_MARGIN, HUD_MARGIN, panelWidth + 2 * HUD_MARGIN, panelHeight, 0.0f, 0.0f, 0.0f);
+
+		float y = 2 * HUD_MARGIN;
+		for (int i = 0; i < 5; i++, y += HUD_LINE_HEIGHT)
+			addText(lines[i], 2 * HUD_MARGIN, y, HUD_PIXEL, 1.0f, 1.0f, 1.0f);
+
+		// One bar per frame in the window, green under 60 fps budget, yellow under 30, red above
+		float graphBottom = y + HUD_MARGIN + HUD_GRAPH_HEIGHT;
+		float msToPixels = HUD_GRAPH_HEIGHT / HUD_GRAPH_MAX_MS;
+		for (int i = 0; i < graphBars; i++) {
+			float ms = (float)stats->frameTime(i);
+			float barHeight = (ms < HUD_GRAPH_MAX_MS ? ms : HUD_GRAPH_MAX_MS) * msToPixels;
+			float r = ms > 16.7f ? 1.0f : 0.2f;
+			float g = ms > 33.3f ? 0.2f : 1.0f;
+			addQuad(2 * HUD_MARGIN + i, graphBottom - barHeight, 1.0f, barHeight, r, g, 0.2f);
+		}
+		addQuad(2 * HUD_MARGIN, graphBottom - 16.7f * msToPixels, panelWidth, 1.0f, 0.5f, 0.5f, 0.5f);
+		addQuad(2 * HUD_MARGIN, graphBottom - 33.3f * msToPixels, panelWidth, 1.0f, 0.5f, 0.5f, 0.5f);
+	}
+
+	if (!info.empty()) {
+		// As wide as the longest line, 4 font pixels per character
+		size_t longest = 0;
+		for (size_t i = 0; i < info.size(); i++)
+			longest = info[i].size() > longest ? info[i].size() : longest;
+		float panelWidth = longest * 4.0f * HUD_PIXEL;
+		float panelHeight = info.size() * HUD_LINE_HEIGHT + HUD_MARGIN;
+		float top = height - HUD_MARGIN - panelHeight;
+		addQuad(HUD_MARGIN, top, panelWidth + 2 * HUD_MARGIN, panelHeight, 0.0f, 0.0f, 0.0f);
+		float y = top + HUD_MARGIN;
+		for (size_t i = 0; i < info.size(); i++, y += HUD_LINE_HEIGHT)
+			addText(info[i].c_str(), 2 * HUD_MARGIN, y, HUD_PIXEL, 1.0f, i == 0 ? 0.9f : 1.0f, i == 0 ? 0.3f : 1.0f);
+	}
+	if (crosshair) {
+		// White on a dark outline, so it shows over the sky and the ground alike
+		float x = (float)(width / 2), y = (float)(height / 2);
+		addQuad(x - HUD_CROSSHAIR - 1.0f, y - 2.0f, 2.0f * HUD_CROSSHAIR + 2.0f, 4.0f, 0.0f, 0.0f, 0.0f);
+		addQuad(x - 2.0f, y - HUD_CROSSHAIR - 1.0f, 4.0f, 2.0f * HUD_CROSSHAIR + 2.0f, 0.0f, 0.0f, 0.0f);
+		addQuad(x - HUD_CROSSHAIR, y - 1.0f, 2.0f * HUD_CROSSHAIR, 2.0f, 1.0f, 1.0f, 1.0f);
+		addQuad(x - 1.0f, y - HUD_CROSSHAIR, 2.0f, 2.0f * HUD_CROSSHAIR, 1.0f, 1.0f, 1.0f);
+	}
+	if (vertices.empty())
+		return;
+
+	// Pixels (y down) to normalized device coordinates
+	for (size_t i = 0; i < vertices.size(); i += 6) {
+		vertices[i] = vertices[i] / width * 2.0f - 1.0f;
+		vertices[i + 1] = 1.0f - vertices[i + 1] / height * 2.0f;
+	}
+
+	const ShaderProgram & program = renderState.apply(makeRenderStateKey(0, 0));
+	glm::mat4 identity(1.0f);
+	glUniformMatrix4fv(program.mvpLocation, 1, GL_FALSE, &identity[0][0]);
+
+	size_t bytes = vertices.size() * sizeof(float);
+	size_t offset = 0;
+	vertexBuffer.beginFrame(bytes);
+	void * dst = vertexBuffer.map(bytes, sizeof(float), offset);
+	if (dst == NULL)
+		return;
+	memcpy(dst, &vertices[0], bytes);
+	vertexBuffer.unmap();
+
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer.buffer());
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)offset);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(offset + 3 * sizeof(float)));
+
+	glDisable(GL_DEPTH_TEST);
+	glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(vertices.size() / 6));
+	glEnable(GL_DEPTH_TEST);
+	vertexBuffer.endFrame();
+
+	glDisableVertexAttribArray(0);
+	glDisableVertexAttribArray(1);
+
+	FrameStats * counters = renderState.stats();
+	if (counters != NULL) {
+		counters->drawCalls++;
+		counters->triangles += (unsigned int)(vertices.size() / 18);
+		counters->vertices += (unsigned int)(vertices.size() / 6);
+		counters->bufferBinds++;
+		counters->uniformUploads++;
+		counters->uploadBytes += vertices.size() * sizeof(float);
+	}
+}
@@ -0,0 +1,50 @@
+#ifndef STATSHUD_HPP
+#define STATSHUD_HPP
+
+#include <string>
+#include <vector>
+
+#include "glresource.hpp"
+#include "renderstate.hpp"
+#include "renderstats.hpp"
+#include "streambuffer.hpp"
+
+// On-screen overlay for RenderStats: the last frame's counters and the live GL memory from
+// glResources() as text, and a bar graph of the frame times in the window with marks at 16.7
+// and 33.3 ms. Below it, an info panel shows whatever lines were last given to setInfo (the
+// picked ride), and a crosshair marks the centre of the screen, where a click picks.
+//
+// Text uses a built-in 3x5 pixel font and, like the graph, is built as colored quads into one
+// vertex buffer, so the whole overlay is a single draw with the untextured permutation. The
+// vertices are rewritten every frame through a StreamBuffer. The overlay's own draw is counted
+// in the stats like any other.
+class StatsHud {
+public:
+	StatsHud();
+	~StatsHud();
+
+	// Needs a current GL context.
+	void init();
+	void shutdown();
+
+	// Lines for the info panel at the bottom left; none hides it
+	void setInfo(const std::vector<std::string> & lines) { info = lines; }
+	bool hasInfo() const { return !info.empty(); }
+	// Crosshair at the centre of the screen
+	void setCrosshair(bool shown) { crosshair = shown; }
+
+	// Draws on top of the frame for a width x height framebuffer: the stats panel unless stats
+	// is NULL, the info panel and the crosshair. Depth testing is off while drawing and back on afterwards.
+	void draw(RenderStateCache & renderState, const RenderStats * stats, int width, int height);
+
+private:
+	void addQuad(float x, float y, float w, float h, float r, float g, float b);
+	void addText(const char * text, float x, float y, float pixel, float r, float g, float b);
+
+	StreamBuffer vertexBuffer;
+	std::vector<float> vertices; // x y z r g b, in pixels until draw() converts them
+	std::vector<std::string> info;
+	bool crosshair;
+};
+
+#endif
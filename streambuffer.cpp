@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#include <GL/glew.h>
+
+#include "streambuffer.hpp"
+
+static std::vector<StreamBuffer *> s_streamBuffers;
+static bool s_persistentAllowed = true;
+
+const std::vector<StreamBuffer *> & streamBuffers(){
+	return s_streamBuffers;
+}
+
+void allowPersistentMapping(bool allowed){
+	s_persistentAllowed = allowed;
+}
+
+void printStreamBufferStats(){
+	for (size_t i = 0; i < s_streamBuffers.size(); i++) {
+		const StreamBuffer & buffer = *s_streamBuffers[i];
+		const StreamBufferStats & stats = buffer.stats();
+		printf("Stream buffer %s: %s, %d x %.1f KB, peak %.1f KB/frame | %lld frames, %lld stalls, %.2f ms waited (max %.2f), %d overflows, %d grows\n",
+			buffer.label(), buffer.persistent() ? "persistent" : "unsynchronized", buffer.frameCount(),
+			buffer.bytesPerFrame() / 1024.0, stats.peakFrameBytes / 1024.0, stats.frames, stats.stalls,
+			stats.waitMs, stats.maxWaitMs, stats.overflows, stats.grows);
+	}
+}
+
+StreamBuffer::StreamBuffer()
+	: target(GL_ARRAY_BUFFER), owner(""), name(""), persistentMapping(false), mapped(NULL), mappedRange(false),
+	regionSize(0), region(0), used(0), wanted(0){
+	memset(&counters, 0, sizeof(counters));
+}
+
+StreamBuffer::~StreamBuffer(){
+	shutdown();
+}
+
+bool StreamBuffer::init(GLenum target, size_t bytesPerFrame, int frameCount, const char * owner, const char * label){
+	shutdown();
+	this->target = target;
+	this->owner = owner;
+	name = label;
+	persistentMapping = s_persistentAllowed && (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage);
+	fences.assign(frameCount > 0 ? frameCount : 1, (GLsync)0);
+	memset(&counters, 0, sizeof(counters));
+	region = (int)fences.size() - 1; // so the first beginFrame uses region 0
+	used = 0;
+	wanted = 0;
+	if (!allocate(bytesPerFrame)) {
+		shutdown();
+		return false;
+	}
+	s_streamBuffers.push_back(this);
+	return true;
+}
+
+void StreamBuffer::shutdown(){
+	release();
+	fences.clear();
+	regionSize = 0;
+	std::vector<StreamBuffer *>::iterator found = std::find(s_streamBuffers.begin(), s_streamBuffers.end(), this);
+	if (found != s_streamBuffers.end())
+		s_streamBuffers.erase(found);
+}
+
+void StreamBuffer::release(){
+	if (mappedRange || mapped != NULL) {
+		glBindBuffer(target, handle);
+		glUnmapBuffer(target);
+		mapped = NULL;
+		mappedRange = false;
+	}
+	for (size_t i = 0; i < fences.size(); i++) {
+		if (fences[i])
+			glDeleteSync(fences[i]);
+		fences[i] = 0;
+	}
+	handle.reset();
+}
+
+bool StreamBuffer::allocate(size_t regionBytes){
+	release();
+	size_t total = regionBytes * fences.size();
+	handle.create(owner, name);
+	glBindBuffer(target, handle);
+	// Errors left over from earlier calls would be taken for the storage failing. A lost
+	// context reports an error on every call, so stop there, and after a few in any case.
+	for (int i = 0; i < 8; i++) {
+		GLenum error = glGetError();
+		if (error == GL_NO_ERROR || error == GL_CONTEXT_LOST)
+			break;
+	}
+	if (persistentMapping) {
+		// Coherent, so writes need no flush and become visible to draws issued after them
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(target, total, NULL, flags);
+		if (glGetError() == GL_NO_ERROR)
+			mapped = (unsigned char *)glMapBufferRange(target, 0, total, flags);
+		if (mapped == NULL) {
+			printf("Could not map stream buffer %s persistently (%.1f KB)\n", name, total / 1024.0);
+			// No buffer at all rather than one without a mapping, so map() returns NULL
+			handle.reset();
+			regionSize = 0;
+			return false;
+		}
+	} else {
+		glBufferData(target, total, NULL, GL_STREAM_DRAW);
+		if (glGetError() != GL_NO_ERROR) {
+			printf("Could not allocate stream buffer %s (%.1f KB)\n", name, total / 1024.0);
+			handle.reset();
+			regionSize = 0;
+			return false;
+		}
+	}
+	handle.setSize(total);
+	regionSize = regionBytes;
+	return true;
+}
+
+void StreamBuffer::beginFrame(size_t frameBytes){
+	if (handle == 0)
+		return;
+	size_t needed = std::max(frameBytes, wanted);
+	if (needed > regionSize) {
+		// A new buffer: nothing queued reads it yet, so no fences to wait for
+		if (allocate(std::max(needed, regionSize * 2)))
+			counters.grows++;
+		wanted = 0;
+	}
+
+	region = (region + 1) % (int)fences.size();
+	used = 0;
+	counters.frames++;
+	GLsync & fence = fences[region];
+	if (!fence)
+		return;
+	if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+		// The GPU is still reading this region from frameCount frames ago
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		GLenum result;
+		do {
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		} while (result == GL_TIMEOUT_EXPIRED);
+		double waited = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		counters.stalls++;
+		counters.waitMs += waited;
+		counters.maxWaitMs = std::max(counters.maxWaitMs, waited);
+	}
+	glDeleteSync(fence);
+	fence = 0;
+}
+
+void * StreamBuffer::map(size_t bytes, size_t alignment, size_t & offset){
+	if (handle == 0)
+		return NULL;
+	size_t start = alignment > 1 ? (used + alignment - 1) / alignment * alignment : used;
+	if (start + bytes > regionSize) {
+		counters.overflows++;
+		wanted = std::max(wanted, start + bytes);
+		return NULL;
+	}
+	used = start + bytes;
+	counters.peakFrameBytes = std::max(counters.peakFrameBytes, used);
+	offset = region * regionSize + start;
+	if (persistentMapping)
+		return mapped + offset;
+
+	glBindBuffer(target, handle);
+	void * pointer = glMapBufferRange(target, offset, bytes,
+		GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	mappedRange = pointer != NULL;
+	return pointer;
+}
+
+void StreamBuffer::unmap(){
+	if (!mappedRange)
+		return;
+	glBindBuffer(target, handle);
+	glUnmapBuffer(target);
+	mappedRange = false;
+}
+
+void StreamBuffer::endFrame(){
+	if (handle == 0 || used == 0)
+		return;
+	GLsync & fence = fences[region];
+	if (fence)
+		glDeleteSync(fence);
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
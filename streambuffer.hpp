@@ -0,0 +1,93 @@
+#ifndef STREAMBUFFER_HPP
+#define STREAMBUFFER_HPP
+
+#include <stddef.h>
+#include <vector>
+
+#include "glresource.hpp"
+
+// Counters for sizing a StreamBuffer's ring. A stall is a beginFrame that had to wait for the
+// GPU to finish with the region it was about to reuse: stalls mean more frames in the ring,
+// overflows and grows mean more bytes per frame.
+struct StreamBufferStats {
+	long long frames;
+	long long stalls;
+	double waitMs;      // total time spent waiting in stalls
+	double maxWaitMs;
+	int overflows;      // map() calls that didn't fit in their region
+	int grows;          // times the buffer was reallocated with larger regions
+	size_t peakFrameBytes;
+};
+
+// Buffer for data that is rewritten every frame (vertex data, uniform blocks, instance data),
+// replacing glBufferData orphaning. The buffer is a ring of frameCount regions; each frame
+// writes into its own region and a glFenceSync at endFrame marks when the GPU is done with it,
+// so the CPU never writes over data a queued draw still reads and the driver never has to
+// rename the buffer.
+//
+// With GL 4.4 or ARB_buffer_storage the whole buffer is mapped once, persistent and coherent,
+// and map() just returns a pointer into it. On plain 3.3 each map() is a glMapBufferRange of
+// the allocation with GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT (the fences do the
+// synchronizing) and unmap() unmaps it, which must happen before drawing from it.
+//
+// Every live StreamBuffer is listed by streamBuffers() for reports. GL thread only.
+class StreamBuffer {
+public:
+	StreamBuffer();
+	~StreamBuffer();
+
+	// target is the binding point map() uses, e.g. GL_ARRAY_BUFFER. owner and label are for
+	// glResources() and the reports. Needs a current GL context.
+	bool init(GLenum target, size_t bytesPerFrame, int frameCount, const char * owner, const char * label);
+	void shutdown();
+
+	// Moves to the next region, waiting for the GPU if it still uses it. If frameBytes (what
+	// the caller knows it will map this frame) or an earlier overflow doesn't fit a region, the
+	// buffer is first reallocated with larger regions; that replaces buffer(). If that fails
+	// there is no buffer left and map() returns NULL from then on.
+	void beginFrame(size_t frameBytes = 0);
+	// Reserves bytes (aligned to alignment) in this frame's region and returns where to write
+	// them, with offset set to their position in buffer(). NULL if they don't fit (the regions
+	// grow at the next beginFrame) or mapping fails.
+	void * map(size_t bytes, size_t alignment, size_t & offset);
+	// Ends the write started by map(). Leaves the buffer bound to its target on 3.3.
+	void unmap();
+	// Fences the region after the draws that read it have been issued.
+	void endFrame();
+
+	GLuint buffer() const { return handle; }
+	bool persistent() const { return persistentMapping; }
+	const char * label() const { return name; }
+	size_t bytesPerFrame() const { return regionSize; }
+	int frameCount() const { return (int)fences.size(); }
+	const StreamBufferStats & stats() const { return counters; }
+
+private:
+	bool allocate(size_t regionBytes);
+	void release();
+
+	GLenum target;
+	const char * owner;
+	const char * name;
+	GLBuffer handle;
+	bool persistentMapping;
+	unsigned char * mapped;   // the persistent mapping, NULL on 3.3
+	bool mappedRange;         // a 3.3 map() waiting for its unmap()
+	size_t regionSize;
+	std::vector<GLsync> fences;
+	int region;
+	size_t used;              // bytes taken in the current region
+	size_t wanted;            // region size asked for by an overflow, 0 if none
+	StreamBufferStats counters;
+};
+
+// false makes StreamBuffers initialized afterwards take the 3.3 path even where persistent
+// mapping is available, to compare the two.
+void allowPersistentMapping(bool allowed);
+
+// Every StreamBuffer between init and shutdown, in creation order.
+const std::vector<StreamBuffer *> & streamBuffers();
+// One line per stream buffer with its mode, ring size and StreamBufferStats.
+void printStreamBufferStats();
+
+#endif
@@ -0,0 +1,390 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include "shadercache.hpp"
+#include "bvh.hpp"
+#include "terrain.hpp"
+
+// A node is split while the camera is closer than this many of its children's sizes; at 6 the
+// levels of neighbouring chunks never differ by more than one and morphing finishes before a
+// coarser neighbour starts its own
+#define TERRAIN_LOD_RANGE 6.0f
+// Vertices start morphing to the coarser level at this fraction of their level's range
+#define TERRAIN_MORPH_START 0.8f
+// Generated chunks not selected for this many selections are dropped instead of uploaded
+#define TERRAIN_STALE_FRAMES 30
+
+static const size_t s_chunkBytes = sizeof(TerrainVertex) * TERRAIN_CHUNK_VERTICES;
+
+static float nodeSize(int level){
+	return TERRAIN_LEAF_SIZE * (float)(1 << level);
+}
+
+// Distance within which a node of this level is split into its children
+static float lodRange(int level){
+	return TERRAIN_LOD_RANGE * nodeSize(level);
+}
+
+static uint64_t nodeKey(int level, int x, int z){
+	return ((uint64_t)level << 48) | ((uint64_t)(uint32_t)x << 24) | (uint64_t)(uint32_t)z;
+}
+
+static const uint64_t s_rootKey = nodeKey(TERRAIN_LEVELS - 1, 0, 0);
+
+Terrain::Terrain()
+	: viewProjectionLocation(-1), cameraLocation(-1), morphLocation(-1), indexCount(0), capacity(0), camera(0.0f),
+	frame(0), missing(0), resident(0), quit(false){
+	memset(&counters, 0, sizeof(counters));
+}
+
+Terrain::~Terrain(){
+	shutdown();
+}
+
+bool Terrain::init(size_t memoryBytes){
+	program.adopt(LoadShadersCached("TerrainVertexShader.vertexshader", "TerrainFragmentShader.fragmentshader"),
+		"terrain", "terrain program");
+	if (program == 0) {
+		printf("Terrain shaders failed to build\n");
+		return false;
+	}
+	viewProjectionLocation = glGetUniformLocation(program, "VP");
+	cameraLocation = glGetUniformLocation(program, "camera");
+	morphLocation = glGetUniformLocation(program, "morphRange");
+
+	// Room for at least every node along one path from the root, so there is always a chunk to evict
+	capacity = memoryBytes / s_chunkBytes;
+	if (capacity < TERRAIN_LEVELS * 4)
+		capacity = TERRAIN_LEVELS * 4;
+	freeSlots.clear();
+	for (size_t i = capacity; i > 0; i--)
+		freeSlots.push_back((int)(i - 1));
+	vertexBuffer.create("terrain", "chunk pool");
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, capacity * s_chunkBytes, NULL, GL_DYNAMIC_DRAW);
+	vertexBuffer.setSize(capacity * s_chunkBytes);
+
+	// Every chunk's quads, split along the same diagonal as generateTerrainChunk assumes,
+	// counter-clockwise seen from above
+	std::vector<unsigned short> indices;
+	const int row = TERRAIN_CHUNK_QUADS + 1;
+	for (int j = 0; j < TERRAIN_CHUNK_QUADS; j++) {
+		for (int i = 0; i < TERRAIN_CHUNK_QUADS; i++) {
+			unsigned short a = (unsigned short)(j * row + i), b = (unsigned short)(a + 1);
+			unsigned short c = (unsigned short)(a + row + 1), d = (unsigned short)(a + row);
+			const unsigned short quad[6] = { a, c, b, a, d, c };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+	indexCount = (int)indices.size();
+
+	// Its own vertex array, so the scene's keeps its index buffer
+	GLint previousArray = 0;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousArray);
+	vertexArray.create("terrain", "vertex array");
+	glBindVertexArray(vertexArray);
+	indexBuffer.create("terrain", "chunk indices");
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), &indices[0], GL_STATIC_DRAW);
+	indexBuffer.setSize(indices.size() * sizeof(unsigned short));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)offsetof(TerrainVertex, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)offsetof(TerrainVertex, coarseHeight));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)offsetof(TerrainVertex, normal));
+	glBindVertexArray(previousArray);
+
+	// The root right away, so there is ground from the first frame
+	std::vector<TerrainVertex> vertices(TERRAIN_CHUNK_VERTICES);
+	float minY, maxY;
+	generateTerrainChunk(-0.5f * TERRAIN_SIZE, -0.5f * TERRAIN_SIZE, TERRAIN_SIZE, &vertices[0], minY, maxY);
+	Chunk root = { allocateSlot(), false, 0 };
+	glBufferSubData(GL_ARRAY_BUFFER, root.slot * s_chunkBytes, s_chunkBytes, &vertices[0]);
+	chunks[s_rootKey] = root;
+	resident = 1;
+	counters.generated++;
+	counters.uploaded++;
+	counters.uploadedBytes += s_chunkBytes;
+
+	quit = false;
+	for (int i = 0; i < TERRAIN_GENERATOR_THREADS; i++)
+		generators.push_back(std::thread(&Terrain::generatorMain, this));
+	return true;
+}
+
+void Terrain::shutdown(){
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (size_t i = 0; i < generators.size(); i++)
+		generators[i].join();
+	generators.clear();
+	pending.clear();
+	for (size_t i = 0; i < finished.size(); i++)
+		delete finished[i];
+	finished.clear();
+	for (size_t i = 0; i < ready.size(); i++)
+		delete ready[i];
+	ready.clear();
+	chunks.clear();
+	drawList.clear();
+	freeSlots.clear();
+	resident = 0;
+	vertexArray.reset();
+	indexBuffer.reset();
+	vertexBuffer.reset();
+	program.reset();
+}
+
+void Terrain::generatorMain(){
+	for (;;) {
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this] { return quit || !pending.empty(); });
+			if (quit)
+				return;
+			request = pending.front();
+			pending.pop_front();
+		}
+		Job * job = new Job;
+		job->key = request.key;
+		job->vertices.resize(TERRAIN_CHUNK_VERTICES);
+		float size = nodeSize(request.level);
+		float minY, maxY;
+		generateTerrainChunk(-0.5f * TERRAIN_SIZE + request.x * size, -0.5f * TERRAIN_SIZE + request.z * size, size,
+			&job->vertices[0], minY, maxY);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			finished.push_back(job);
+		}
+		done.notify_all();
+	}
+}
+
+int Terrain::allocateSlot(){
+	if (!freeSlots.empty()) {
+		int slot = freeSlots.back();
+		freeSlots.pop_back();
+		return slot;
+	}
+	// The least recently selected resident chunk that the last selection didn't use
+	std::unordered_map<uint64_t, Chunk>::iterator oldest = chunks.end();
+	for (std::unordered_map<uint64_t, Chunk>::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+		const Chunk & chunk = it->second;
+		if (chunk.slot < 0 || chunk.lastUsed >= frame || it->first == s_rootKey)
+			continue;
+		if (oldest == chunks.end() || chunk.lastUsed < oldest->second.lastUsed)
+			oldest = it;
+	}
+	if (oldest == chunks.end())
+		return -1;
+	int slot = oldest->second.slot;
+	chunks.erase(oldest);
+	resident--;
+	counters.evicted++;
+	return slot;
+}
+
+size_t Terrain::update(size_t byteBudget){
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		while (!finished.empty()) {
+			ready.push_back(finished.front());
+			finished.pop_front();
+			counters.generated++;
+		}
+	}
+	size_t bytes = 0;
+	if (!ready.empty())
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	while (!ready.empty()) {
+		Job * job = ready.front();
+		std::unordered_map<uint64_t, Chunk>::iterator it = chunks.find(job->key);
+		if (it == chunks.end() || frame - it->second.lastUsed > TERRAIN_STALE_FRAMES) {
+			if (it != chunks.end())
+				it->second.queued = false;
+			ready.pop_front();
+			delete job;
+			counters.dropped++;
+			continue;
+		}
+		if (bytes + s_chunkBytes > byteBudget)
+			break;
+		// Eviction only erases resident chunks, so it leaves it alone
+		int slot = allocateSlot();
+		if (slot < 0)
+			break;
+		glBufferSubData(GL_ARRAY_BUFFER, slot * s_chunkBytes, s_chunkBytes, &job->vertices[0]);
+		it->second.slot = slot;
+		it->second.queued = false;
+		resident++;
+		counters.uploaded++;
+		bytes += s_chunkBytes;
+		ready.pop_front();
+		delete job;
+	}
+	counters.uploadedBytes += bytes;
+	return bytes;
+}
+
+bool Terrain::nodeVisible(int level, int x, int z, float & distance) const{
+	float size = nodeSize(level);
+	Aabb box;
+	box.min.x = -0.5f * TERRAIN_SIZE + x * size;
+	box.min.z = -0.5f * TERRAIN_SIZE + z * size;
+	box.max.x = box.min.x + size;
+	box.max.z = box.min.z + size;
+	terrainHeightRange(box.min.x, box.min.z, box.max.x, box.max.z, box.min.y, box.max.y);
+	for (int p = 0; p < 6; p++) {
+		const glm::vec4 & plane = planes[p];
+		glm::vec3 corner(plane.x >= 0.0f ? box.max.x : box.min.x, plane.y >= 0.0f ? box.max.y : box.min.y,
+			plane.z >= 0.0f ? box.max.z : box.min.z);
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+			return false;
+	}
+	glm::vec3 nearest = glm::min(glm::max(camera, box.min), box.max);
+	distance = glm::length(nearest - camera);
+	return true;
+}
+
+Terrain::Chunk & Terrain::touch(int level, int x, int z, float distance){
+	uint64_t key = nodeKey(level, x, z);
+	std::unordered_map<uint64_t, Chunk>::iterator it = chunks.find(key);
+	if (it == chunks.end()) {
+		Chunk chunk = { -1, false, frame };
+		it = chunks.insert(std::make_pair(key, chunk)).first;
+	}
+	it->second.lastUsed = frame;
+	if (it->second.slot < 0) {
+		Request request = { key, level, x, z, distance };
+		wanted.push_back(request);
+	}
+	return it->second;
+}
+
+void Terrain::selectNode(int level, int x, int z, int slot, float distance){
+	if (level > 0 && distance < lodRange(level - 1)) {
+		// Split only once every visible child can be drawn; until then this node covers them
+		int children[4][2];
+		float childDistances[4];
+		int childSlots[4];
+		int count = 0;
+		bool complete = true;
+		for (int c = 0; c < 4; c++) {
+			int cx = 2 * x + (c & 1), cz = 2 * z + (c >> 1);
+			float childDistance;
+			if (!nodeVisible(level - 1, cx, cz, childDistance))
+				continue;
+			int childSlot = touch(level - 1, cx, cz, childDistance).slot;
+			complete = complete && childSlot >= 0;
+			children[count][0] = cx;
+			children[count][1] = cz;
+			childDistances[count] = childDistance;
+			childSlots[count] = childSlot;
+			count++;
+		}
+		if (complete) {
+			for (int c = 0; c < count; c++)
+				selectNode(level - 1, children[c][0], children[c][1], childSlots[c], childDistances[c]);
+			return;
+		}
+	}
+	Draw draw = { slot, level };
+	drawList.push_back(draw);
+}
+
+void Terrain::select(const glm::vec3 & camera, const glm::mat4 & viewProjection){
+	frame++;
+	this->camera = camera;
+	frustumPlanes(viewProjection, planes);
+	wanted.clear();
+	drawList.clear();
+	chunks[s_rootKey].lastUsed = frame;
+	float distance;
+	if (nodeVisible(TERRAIN_LEVELS - 1, 0, 0, distance))
+		selectNode(TERRAIN_LEVELS - 1, 0, 0, chunks[s_rootKey].slot, distance);
+	missing = (int)wanted.size();
+	// One morph range per level
+	std::sort(drawList.begin(), drawList.end(), [](const Draw & a, const Draw & b) { return a.level < b.level; });
+
+	// Coarse levels first, since they fill in for the finer ones, then nearest first
+	std::sort(wanted.begin(), wanted.end(), [](const Request & a, const Request & b) {
+		return a.level != b.level ? a.level > b.level : a.distance < b.distance;
+	});
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		// Requests nobody started yet go back in behind this selection's
+		for (size_t i = 0; i < pending.size(); i++)
+			chunks[pending[i].key].queued = false;
+		pending.clear();
+		for (size_t i = 0; i < wanted.size(); i++) {
+			Chunk & chunk = chunks[wanted[i].key];
+			if (chunk.queued)
+				continue;
+			chunk.queued = true;
+			pending.push_back(wanted[i]);
+		}
+	}
+	wake.notify_all();
+}
+
+size_t Terrain::selectResident(const glm::vec3 & camera, const glm::mat4 & viewProjection){
+	size_t bytes = 0;
+	for (;;) {
+		select(camera, viewProjection);
+		if (missing == 0 || !ready.empty()) // done, or the pool is full
+			break;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [this] { return !finished.empty(); });
+		}
+		bytes += update((size_t)-1);
+	}
+	return bytes;
+}
+
+void Terrain::draw(RenderStateCache & renderState, const glm::mat4 & viewProjection, GLuint texture){
+	if (program == 0 || drawList.empty())
+		return;
+	GLint previousArray = 0;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousArray);
+	glUseProgram(program);
+	glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, &viewProjection[0][0]);
+	glUniform3f(cameraLocation, camera.x, camera.y, camera.z);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glBindVertexArray(vertexArray);
+	int level = -1;
+	int uniforms = 2;
+	for (size_t i = 0; i < drawList.size(); i++) {
+		const Draw & draw = drawList[i];
+		if (draw.level != level) {
+			// The root has no coarser level to morph to
+			level = draw.level;
+			float end = level + 1 < TERRAIN_LEVELS ? lodRange(level) : 1e30f;
+			glUniform2f(morphLocation, TERRAIN_MORPH_START * end, end);
+			uniforms++;
+		}
+		glDrawElementsBaseVertex(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, (void*)0, draw.slot * TERRAIN_CHUNK_VERTICES);
+	}
+	glBindVertexArray(previousArray);
+	renderState.invalidate();
+
+	if (FrameStats * stats = renderState.stats()) {
+		int count = (int)drawList.size();
+		stats->drawCalls += count;
+		stats->triangles += count * (indexCount / 3);
+		stats->vertices += count * TERRAIN_CHUNK_VERTICES;
+		stats->programBinds++;
+		stats->textureBinds++;
+		stats->uniformUploads += uniforms;
+	}
+}
@@ -0,0 +1,137 @@
+#ifndef TERRAIN_HPP
+#define TERRAIN_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "glresource.hpp"
+#include "renderstate.hpp"
+#include "heightfield.hpp"
+
+// Levels of the quadtree; level 0 chunks are TERRAIN_LEAF_SIZE wide, the root covers the
+// whole terrain
+#define TERRAIN_LEVELS 9
+#define TERRAIN_LEAF_SIZE 8.0f
+#define TERRAIN_SIZE (TERRAIN_LEAF_SIZE * (1 << (TERRAIN_LEVELS - 1)))
+#define TERRAIN_GENERATOR_THREADS 2
+
+struct TerrainStats {
+	long long generated;    // chunks the generator threads built
+	long long uploaded;
+	long long evicted;      // resident chunks dropped for room in the pool
+	long long dropped;      // generated chunks no longer wanted when their upload came up
+	size_t uploadedBytes;
+};
+
+// Ground of the park: a CDLOD quadtree of chunks over heightfield.hpp's terrainHeight.
+//
+// select() walks the quadtree from the root, splitting a node while the camera is within
+// its level's range (TERRAIN_LOD_RANGE node sizes) and dropping nodes outside the frustum.
+// Every chunk is the same TERRAIN_CHUNK_QUADS grid, so a level has half the detail of the one
+// below it; vertices morph to the coarser level's surface as they near the end of their
+// range, which keeps neighbouring levels crack free without stitching. A node whose children
+// aren't resident yet is drawn itself, so the root, generated at init and never evicted,
+// always covers the ground.
+//
+// Missing chunks are queued, nearest of the coarsest level first, for generator threads that
+// need no GL context. update(), on the GL thread, copies at most byteBudget bytes of finished
+// chunks a frame into slots of one vertex buffer sized by the memory cap; when it is full the
+// least recently drawn chunks are evicted. Tiled with one texture, lit by the vertex normals.
+class Terrain {
+public:
+	Terrain();
+	~Terrain();
+
+	// Starts the generator threads and creates the pool (memoryBytes of chunks), the shared
+	// index buffer and the shader. Needs a current GL context; false (after printing why) if
+	// the shader doesn't build.
+	bool init(size_t memoryBytes);
+	// Joins the generator threads and deletes the GL objects.
+	void shutdown();
+
+	// Uploads finished chunks. Never waits on the generators. Returns the bytes handed to GL.
+	size_t update(size_t byteBudget);
+	// Picks the chunks to draw for this camera and queues the missing ones.
+	void select(const glm::vec3 & camera, const glm::mat4 & viewProjection);
+	// select(), then waits for and uploads every chunk it asked for until the selection is
+	// complete, so a frame looks the same however fast the generators are. Returns the bytes.
+	size_t selectResident(const glm::vec3 & camera, const glm::mat4 & viewProjection);
+	// Draws the selected chunks. Changes the bound program and vertex array (restoring the
+	// latter), so renderState is invalidated; counted in its stats.
+	void draw(RenderStateCache & renderState, const glm::mat4 & viewProjection, GLuint texture);
+
+	// In the last selection
+	int drawnCount() const { return (int)drawList.size(); }
+	int missingCount() const { return missing; }
+	int residentCount() const { return resident; }
+	int poolCapacity() const { return (int)capacity; }
+	size_t poolBytes() const { return capacity * sizeof(TerrainVertex) * TERRAIN_CHUNK_VERTICES; }
+	const TerrainStats & stats() const { return counters; }
+
+private:
+	struct Chunk {
+		int slot;            // in the pool, -1 while not resident
+		bool queued;         // asked of the generators and not uploaded yet
+		long long lastUsed;  // selection that last touched it
+	};
+	struct Request {
+		uint64_t key;
+		int level, x, z;
+		float distance;
+	};
+	struct Job {
+		uint64_t key;
+		std::vector<TerrainVertex> vertices;
+	};
+	struct Draw {
+		int slot;
+		int level;
+	};
+
+	void generatorMain();
+	void selectNode(int level, int x, int z, int slot, float distance);
+	Chunk & touch(int level, int x, int z, float distance);
+	bool nodeVisible(int level, int x, int z, float & distance) const;
+	int allocateSlot();
+
+	GLProgram program;
+	GLint viewProjectionLocation;
+	GLint cameraLocation;
+	GLint morphLocation;
+	GLBuffer vertexBuffer;
+	GLBuffer indexBuffer;
+	GLVertexArray vertexArray;
+	int indexCount;
+	size_t capacity;                 // slots in the pool
+	std::vector<int> freeSlots;
+
+	// GL thread only
+	std::unordered_map<uint64_t, Chunk> chunks;
+	std::vector<Request> wanted;
+	std::deque<Job *> ready;         // generated, waiting for upload budget
+	std::vector<Draw> drawList;
+	glm::vec3 camera;
+	glm::vec4 planes[6];
+	long long frame;
+	int missing;
+	int resident;
+	TerrainStats counters;
+
+	std::vector<std::thread> generators;
+	std::mutex mutex;
+	std::condition_variable wake;    // a request was queued
+	std::condition_variable done;    // a job finished
+	std::deque<Request> pending;     // waiting for a generator
+	std::deque<Job *> finished;      // waiting for update()
+	bool quit;
+};
+
+#endif
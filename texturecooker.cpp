@@ -0,0 +1,422 @@
+// Offline texture cooker.
+//
+// Converts the park BMPs into .ptex files (see cookedformat.hpp) holding the full mip chain,
+// so the game never decodes a BMP or asks the driver to build mipmaps at startup.
+//
+//   texturecooker [--bc1 | --bc3] [--force] image.bmp [image.bmp ...]
+//
+// Each image.bmp produces image.ptex next to it. Files whose recorded source hash still matches
+// are skipped, so this can run as a build step on every build.
+//
+// Only needs mappedfile.cpp, bmpimage.cpp and hash.cpp; no GL.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COOKER_USE_SSE2
+#endif
+
+#include "mappedfile.hpp"
+#include "bmpimage.hpp"
+#include "hash.hpp"
+#include "cookedformat.hpp"
+
+//******************************************
+// sRGB <-> linear conversion tables
+//******************************************
+
+#define LINEAR_TO_SRGB_STEPS 4096
+
+static float s_srgbToLinear[256];
+static unsigned char s_linearToSrgb[LINEAR_TO_SRGB_STEPS];
+
+static void initGammaTables(){
+	for (int i = 0; i < 256; i++) {
+		float c = i / 255.0f;
+		s_srgbToLinear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+	}
+	for (int i = 0; i < LINEAR_TO_SRGB_STEPS; i++) {
+		float l = i / (float)(LINEAR_TO_SRGB_STEPS - 1);
+		float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+		s_linearToSrgb[i] = (unsigned char)(c * 255.0f + 0.5f);
+	}
+}
+
+// One mip level kept in linear space so every level is filtered from full precision data.
+struct LinearLevel {
+	unsigned int width;
+	unsigned int height;
+	std::vector<float> rgba; // 4 floats per pixel, alpha is not gamma encoded
+};
+
+static void decodeToLinear(const unsigned char * srgba, LinearLevel & level){
+	size_t count = (size_t)level.width * level.height;
+	level.rgba.resize(count * 4);
+	for (size_t i = 0; i < count; i++) {
+		level.rgba[4 * i]     = s_srgbToLinear[srgba[4 * i]];
+		level.rgba[4 * i + 1] = s_srgbToLinear[srgba[4 * i + 1]];
+		level.rgba[4 * i + 2] = s_srgbToLinear[srgba[4 * i + 2]];
+		level.rgba[4 * i + 3] = srgba[4 * i + 3] / 255.0f;
+	}
+}
+
+static void encodeToSrgb(const LinearLevel & level, unsigned char * srgba){
+	size_t count = (size_t)level.width * level.height;
+	const float * src = level.rgba.data();
+	size_t i = 0;
+#ifdef COOKER_USE_SSE2
+	const __m128 scale = _mm_setr_ps(LINEAR_TO_SRGB_STEPS - 1, LINEAR_TO_SRGB_STEPS - 1, LINEAR_TO_SRGB_STEPS - 1, 255.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (; i < count; i++) {
+		__m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + 4 * i), zero), one);
+		__m128i index = _mm_cvtps_epi32(_mm_mul_ps(v, scale));
+		int lanes[4];
+		_mm_storeu_si128((__m128i *)lanes, index);
+		srgba[4 * i]     = s_linearToSrgb[lanes[0]];
+		srgba[4 * i + 1] = s_linearToSrgb[lanes[1]];
+		srgba[4 * i + 2] = s_linearToSrgb[lanes[2]];
+		srgba[4 * i + 3] = (unsigned char)lanes[3];
+	}
+#endif
+	for (; i < count; i++) {
+		for (int c = 0; c < 3; c++) {
+			float v = src[4 * i + c];
+			v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+			srgba[4 * i + c] = s_linearToSrgb[(int)(v * (LINEAR_TO_SRGB_STEPS - 1) + 0.5f)];
+		}
+		float a = src[4 * i + 3];
+		a = a < 0.0f ? 0.0f : (a > 1.0f ? 1.0f : a);
+		srgba[4 * i + 3] = (unsigned char)(a * 255.0f + 0.5f);
+	}
+}
+
+// 2x2 box filter in linear space. Odd sizes clamp the last row/column.
+static void downsample(const LinearLevel & src, LinearLevel & dst){
+	dst.width = src.width > 1 ? src.width / 2 : 1;
+	dst.height = src.height > 1 ? src.height / 2 : 1;
+	dst.rgba.resize((size_t)dst.width * dst.height * 4);
+
+	for (unsigned int y = 0; y < dst.height; y++) {
+		unsigned int y0 = 2 * y < src.height ? 2 * y : src.height - 1;
+		unsigned int y1 = y0 + 1 < src.height ? y0 + 1 : y0;
+		const float * row0 = src.rgba.data() + (size_t)y0 * src.width * 4;
+		const float * row1 = src.rgba.data() + (size_t)y1 * src.width * 4;
+		float * out = dst.rgba.data() + (size_t)y * dst.width * 4;
+
+		for (unsigned int x = 0; x < dst.width; x++) {
+			unsigned int x0 = 2 * x < src.width ? 2 * x : src.width - 1;
+			unsigned int x1 = x0 + 1 < src.width ? x0 + 1 : x0;
+#ifdef COOKER_USE_SSE2
+			__m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(row0 + 4 * x0), _mm_loadu_ps(row0 + 4 * x1)),
+				_mm_add_ps(_mm_loadu_ps(row1 + 4 * x0), _mm_loadu_ps(row1 + 4 * x1)));
+			_mm_storeu_ps(out + 4 * x, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+			for (int c = 0; c < 4; c++)
+				out[4 * x + c] = 0.25f * (row0[4 * x0 + c] + row0[4 * x1 + c] + row1[4 * x0 + c] + row1[4 * x1 + c]);
+#endif
+		}
+	}
+}
+
+//******************************************
+// BC1 / BC3 block compression
+//******************************************
+
+static unsigned short packRGB565(const unsigned char * c){
+	return (unsigned short)(((c[0] >> 3) << 11) | ((c[1] >> 2) << 5) | (c[2] >> 3));
+}
+
+static void unpackRGB565(unsigned short v, int * c){
+	int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+	c[0] = (r << 3) | (r >> 2);
+	c[1] = (g << 2) | (g >> 4);
+	c[2] = (b << 3) | (b >> 2);
+}
+
+// Gathers a 4x4 block, clamping at the right/top edge for sizes that aren't a multiple of 4.
+static void fetchBlock(const unsigned char * rgba, unsigned int width, unsigned int height,
+	unsigned int bx, unsigned int by, unsigned char block[16][4]){
+	for (int j = 0; j < 4; j++) {
+		unsigned int y = by * 4 + j < height ? by * 4 + j : height - 1;
+		for (int i = 0; i < 4; i++) {
+			unsigned int x = bx * 4 + i < width ? bx * 4 + i : width - 1;
+			memcpy(block[j * 4 + i], rgba + ((size_t)y * width + x) * 4, 4);
+		}
+	}
+}
+
+// Bounding box endpoints with a small inset, then nearest palette entry per pixel.
+static void encodeColorBlock(const unsigned char block[16][4], unsigned char * out){
+	unsigned char minColor[3] = { 255, 255, 255 };
+	unsigned char maxColor[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < 3; c++) {
+			if (block[i][c] < minColor[c]) minColor[c] = block[i][c];
+			if (block[i][c] > maxColor[c]) maxColor[c] = block[i][c];
+		}
+	}
+	for (int c = 0; c < 3; c++) {
+		int inset = (maxColor[c] - minColor[c]) >> 4;
+		minColor[c] = (unsigned char)(minColor[c] + inset);
+		maxColor[c] = (unsigned char)(maxColor[c] - inset);
+	}
+
+	unsigned short color0 = packRGB565(maxColor);
+	unsigned short color1 = packRGB565(minColor);
+	if (color0 < color1) {
+		unsigned short t = color0; color0 = color1; color1 = t;
+	}
+
+	int palette[4][3];
+	unpackRGB565(color0, palette[0]);
+	unpackRGB565(color1, palette[1]);
+	for (int c = 0; c < 3; c++) {
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	unsigned int indices = 0;
+	if (color0 != color1) {
+		for (int i = 0; i < 16; i++) {
+			int best = 0, bestDistance = 0x7fffffff;
+			for (int p = 0; p < 4; p++) {
+				int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+				int distance = dr * dr + dg * dg + db * db;
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					best = p;
+				}
+			}
+			indices |= (unsigned int)best << (2 * i);
+		}
+	}
+
+	out[0] = (unsigned char)(color0 & 0xff);
+	out[1] = (unsigned char)(color0 >> 8);
+	out[2] = (unsigned char)(color1 & 0xff);
+	out[3] = (unsigned char)(color1 >> 8);
+	out[4] = (unsigned char)(indices & 0xff);
+	out[5] = (unsigned char)((indices >> 8) & 0xff);
+	out[6] = (unsigned char)((indices >> 16) & 0xff);
+	out[7] = (unsigned char)(indices >> 24);
+}
+
+// 8 interpolated alpha values between the block's min and max.
+static void encodeAlphaBlock(const unsigned char block[16][4], unsigned char * out){
+	unsigned char alpha0 = 0, alpha1 = 255;
+	for (int i = 0; i < 16; i++) {
+		if (block[i][3] > alpha0) alpha0 = block[i][3];
+		if (block[i][3] < alpha1) alpha1 = block[i][3];
+	}
+
+	int palette[8];
+	palette[0] = alpha0;
+	palette[1] = alpha1;
+	for (int p = 1; p < 7; p++)
+		palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+
+	unsigned long long indices = 0;
+	if (alpha0 != alpha1) {
+		for (int i = 0; i < 16; i++) {
+			int best = 0, bestDistance = 256;
+			for (int p = 0; p < 8; p++) {
+				int distance = abs(block[i][3] - palette[p]);
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					best = p;
+				}
+			}
+			indices |= (unsigned long long)best << (3 * i);
+		}
+	}
+
+	out[0] = alpha0;
+	out[1] = alpha1;
+	for (int i = 0; i < 6; i++)
+		out[2 + i] = (unsigned char)((indices >> (8 * i)) & 0xff);
+}
+
+static void compressLevel(const unsigned char * rgba, unsigned int width, unsigned int height,
+	CookedTextureFormat format, std::vector<unsigned char> & out){
+	unsigned int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	size_t blockSize = format == COOKED_FORMAT_BC1 ? 8 : 16;
+	out.resize((size_t)blocksX * blocksY * blockSize);
+
+	unsigned char block[16][4];
+	unsigned char * dst = out.data();
+	for (unsigned int by = 0; by < blocksY; by++) {
+		for (unsigned int bx = 0; bx < blocksX; bx++) {
+			fetchBlock(rgba, width, height, bx, by, block);
+			if (format == COOKED_FORMAT_BC3) {
+				encodeAlphaBlock(block, dst);
+				dst += 8;
+			}
+			encodeColorBlock(block, dst);
+			dst += 8;
+		}
+	}
+}
+
+//******************************************
+// Cooking one file
+//******************************************
+
+static bool isUpToDate(const char * outputPath, uint64_t sourceHash, CookedTextureFormat format){
+	FILE * file = fopen(outputPath, "rb");
+	if (file == NULL)
+		return false;
+	CookedTextureHeader header;
+	bool current = fread(&header, sizeof(header), 1, file) == 1
+		&& header.magic == COOKED_TEXTURE_MAGIC
+		&& header.version == COOKED_TEXTURE_VERSION
+		&& header.format == (uint32_t)format
+		&& header.sourceHash == sourceHash;
+	fclose(file);
+	return current;
+}
+
+static bool cookTexture(const char * inputPath, const char * outputPath, CookedTextureFormat format, bool force){
+	MappedFile source;
+	if (!mapFile(inputPath, source)) {
+		fprintf(stderr, "%s could not be opened\n", inputPath);
+		return false;
+	}
+
+	uint64_t sourceHash = hashBytes(source.data, source.size);
+	if (!force && isUpToDate(outputPath, sourceHash, format)) {
+		printf("%s is up to date\n", outputPath);
+		unmapFile(source);
+		return true;
+	}
+
+	BMPImage image;
+	if (!parseBMP(source.data, source.size, image)) {
+		fprintf(stderr, "%s is not a supported BMP file\n", inputPath);
+		unmapFile(source);
+		return false;
+	}
+
+	std::vector<unsigned char> level0((size_t)image.width * image.height * 4);
+	convertBMPToRGBA(image, level0.data());
+
+	CookedTextureHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = COOKED_TEXTURE_MAGIC;
+	header.version = COOKED_TEXTURE_VERSION;
+	header.format = format;
+	header.width = image.width;
+	header.height = image.height;
+	header.sourceHash = sourceHash;
+	header.sourceSize = source.size;
+	struct stat st;
+	if (stat(inputPath, &st) == 0)
+		header.sourceMTime = (int64_t)st.st_mtime;
+	unmapFile(source);
+
+	// Build every level: level 0 is the source, the rest are filtered in linear space
+	std::vector< std::vector<unsigned char> > levels;
+	LinearLevel linear;
+	linear.width = image.width;
+	linear.height = image.height;
+	decodeToLinear(level0.data(), linear);
+
+	std::vector<unsigned char> srgba = level0;
+	for (;;) {
+		CookedMipLevel & info = header.levels[header.levelCount];
+		info.width = linear.width;
+		info.height = linear.height;
+
+		levels.push_back(std::vector<unsigned char>());
+		if (format == COOKED_FORMAT_RGBA8)
+			levels.back() = srgba;
+		else
+			compressLevel(srgba.data(), linear.width, linear.height, format, levels.back());
+		header.levelCount++;
+
+		if ((linear.width == 1 && linear.height == 1) || header.levelCount == COOKED_MAX_LEVELS)
+			break;
+
+		LinearLevel next;
+		downsample(linear, next);
+		linear.width = next.width;
+		linear.height = next.height;
+		linear.rgba.swap(next.rgba);
+		srgba.resize((size_t)linear.width * linear.height * 4);
+		encodeToSrgb(linear, srgba.data());
+	}
+
+	uint32_t offset = (sizeof(CookedTextureHeader) + 15) & ~15u;
+	for (uint32_t i = 0; i < header.levelCount; i++) {
+		header.levels[i].offset = offset;
+		header.levels[i].size = (uint32_t)levels[i].size();
+		offset = (offset + header.levels[i].size + 15) & ~15u;
+	}
+
+	FILE * file = fopen(outputPath, "wb");
+	if (file == NULL) {
+		fprintf(stderr, "%s could not be written\n", outputPath);
+		return false;
+	}
+	static const unsigned char padding[16] = { 0 };
+	fwrite(&header, sizeof(header), 1, file);
+	long written = sizeof(header);
+	for (uint32_t i = 0; i < header.levelCount; i++) {
+		fwrite(padding, 1, header.levels[i].offset - written, file);
+		fwrite(levels[i].data(), 1, levels[i].size(), file);
+		written = header.levels[i].offset + header.levels[i].size;
+	}
+	bool ok = ferror(file) == 0;
+	fclose(file);
+
+	static const char * formatNames[] = { "RGBA8", "BC1", "BC3" };
+	printf("%s -> %s: %ux%u, %u levels, %s, %ld bytes\n", inputPath, outputPath,
+		header.width, header.height, header.levelCount, formatNames[format], written);
+	return ok;
+}
+
+int main(int argc, char ** argv){
+	CookedTextureFormat format = COOKED_FORMAT_RGBA8;
+	bool force = false;
+	int inputCount = 0;
+
+	initGammaTables();
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--bc1") == 0)
+			format = COOKED_FORMAT_BC1;
+		else if (strcmp(argv[i], "--bc3") == 0)
+			format = COOKED_FORMAT_BC3;
+		else if (strcmp(argv[i], "--force") == 0)
+			force = true;
+	}
+
+	bool ok = true;
+	for (int i = 1; i < argc; i++) {
+		if (argv[i][0] == '-')
+			continue;
+		inputCount++;
+
+		std::string outputPath(argv[i]);
+		size_t dot = outputPath.find_last_of('.');
+		if (dot != std::string::npos && outputPath.find_first_of("/\\", dot) == std::string::npos)
+			outputPath.erase(dot);
+		outputPath += ".ptex";
+
+		ok = cookTexture(argv[i], outputPath.c_str(), format, force) && ok;
+	}
+
+	if (inputCount == 0) {
+		fprintf(stderr, "usage: %s [--bc1 | --bc3] [--force] image.bmp [image.bmp ...]\n", argv[0]);
+		return 1;
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,422 @@
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+#include <GL/glew.h>
+
+#include "mappedfile.hpp"
+#include "bmpimage.hpp"
+#include "cookedtexture.hpp"
+#include "glresource.hpp"
+#include "texturestreamer.hpp"
+
+// One mip level as it will be sent to GL. For compressed formats a "row" is a row of 4x4 blocks.
+struct StreamedLevel {
+	unsigned int width;
+	unsigned int height;
+	unsigned int rows;
+	size_t rowBytes;
+	const unsigned char * data;
+};
+
+struct StreamedTexture {
+	std::string path;
+	GLTexture texture;
+	size_t allocatedBytes; // levels allocated so far, for the resource tracker
+	bool resident;
+	bool failed;
+	bool done; // resident or given up on; only touched on the GL thread
+	bool skipCooked; // decode the BMP even if a cooked file exists
+
+	// Filled in by the worker
+	bool compressed;
+	bool generateMipmaps;
+	GLenum internalFormat;
+	std::vector<StreamedLevel> levels;
+	MappedFile cooked;                 // kept mapped until the upload is done
+	std::vector<unsigned char> pixels; // decoded BMP
+
+	// Upload progress, owned by update()
+	unsigned int level;
+	unsigned int row;
+	std::chrono::steady_clock::time_point requestTime;
+};
+
+TextureStreamer::TextureStreamer()
+	: pboSize(0), nextPbo(0), quit(false), uploading(NULL){
+}
+
+TextureStreamer::~TextureStreamer(){
+	stop();
+}
+
+void TextureStreamer::start(int pboCount, size_t size){
+	// Mid grey, so untextured rides don't flash white or black while loading
+	static const unsigned char grey[4] = { 128, 128, 128, 255 };
+	placeholder.create("textures", "placeholder");
+	glBindTexture(GL_TEXTURE_2D, placeholder);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+	placeholder.setSize(sizeof(grey));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	pboSize = size;
+	pbos.resize(pboCount);
+	fences.assign(pboCount, (GLsync)0);
+	for (int i = 0; i < pboCount; i++) {
+		pbos[i].create("textures", "upload buffer");
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[i]);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, pboSize, NULL, GL_STREAM_DRAW);
+		pbos[i].setSize(pboSize);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	startWorker();
+}
+
+void TextureStreamer::startWorker(){
+	if (worker.joinable())
+		return;
+	quit = false;
+	worker = std::thread(&TextureStreamer::workerMain, this);
+}
+
+void TextureStreamer::stop(){
+	if (worker.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		wake.notify_all();
+		worker.join();
+	}
+
+	for (size_t i = 0; i < textures.size(); i++) {
+		StreamedTexture * t = textures[i];
+		t->texture.reset();
+		unmapFile(t->cooked);
+		delete t;
+	}
+	textures.clear();
+	pending.clear();
+	decoded.clear();
+	uploading = NULL;
+
+	for (size_t i = 0; i < fences.size(); i++) {
+		if (fences[i])
+			glDeleteSync(fences[i]);
+	}
+	fences.clear();
+	pbos.clear();
+	placeholder.reset();
+}
+
+int TextureStreamer::request(const char * bmpPath){
+	StreamedTexture * t = new StreamedTexture();
+	t->path = bmpPath;
+	t->allocatedBytes = 0;
+	t->resident = false;
+	t->failed = false;
+	t->done = false;
+	t->skipCooked = false;
+	t->compressed = false;
+	t->generateMipmaps = false;
+	t->internalFormat = GL_RGBA8;
+	memset(&t->cooked, 0, sizeof(t->cooked));
+	t->level = 0;
+	t->row = 0;
+	t->requestTime = std::chrono::steady_clock::now();
+
+	textures.push_back(t);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending.push_back(t);
+	}
+	wake.notify_one();
+	return (int)textures.size() - 1;
+}
+
+GLuint TextureStreamer::texture(int handle) const{
+	if (handle < 0 || handle >= (int)textures.size() || !textures[handle]->resident)
+		return placeholder;
+	return textures[handle]->texture;
+}
+
+bool TextureStreamer::isResident(int handle) const{
+	return handle >= 0 && handle < (int)textures.size() && textures[handle]->resident;
+}
+
+bool TextureStreamer::isIdle() const{
+	for (size_t i = 0; i < textures.size(); i++) {
+		if (!textures[i]->done)
+			return false;
+	}
+	return true;
+}
+
+//******************************************
+// Worker thread: file I/O and decoding only, no GL
+//******************************************
+
+static bool decodeCooked(StreamedTexture & t){
+	char cookedPath[1024];
+	CookedTextureHeader header;
+	if (!cookedPathForBMP(t.path.c_str(), cookedPath, sizeof(cookedPath))
+		|| !openCookedTexture(cookedPath, t.path.c_str(), t.cooked, header))
+		return false;
+
+	t.compressed = header.format != COOKED_FORMAT_RGBA8;
+	t.generateMipmaps = false;
+	if (header.format == COOKED_FORMAT_BC1)
+		t.internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	else if (header.format == COOKED_FORMAT_BC3)
+		t.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	else
+		t.internalFormat = GL_RGBA8;
+
+	for (uint32_t i = 0; i < header.levelCount; i++) {
+		const CookedMipLevel & info = header.levels[i];
+		StreamedLevel level;
+		level.width = info.width;
+		level.height = info.height;
+		if (t.compressed) {
+			level.rows = (info.height + 3) / 4;
+			level.rowBytes = (size_t)((info.width + 3) / 4) * (header.format == COOKED_FORMAT_BC1 ? 8 : 16);
+		}
+		else {
+			level.rows = info.height;
+			level.rowBytes = (size_t)info.width * 4;
+		}
+		level.data = t.cooked.data + info.offset;
+		t.levels.push_back(level);
+	}
+
+	// Fault the pages in here so the copy on the GL thread never waits on the disk
+	volatile unsigned char sink = 0;
+	for (size_t offset = 0; offset < t.cooked.size; offset += 4096)
+		sink ^= t.cooked.data[offset];
+	(void)sink;
+	return true;
+}
+
+static bool decodeBMP(StreamedTexture & t){
+	MappedFile file;
+	if (!mapFile(t.path.c_str(), file))
+		return false;
+
+	BMPImage image;
+	if (!parseBMP(file.data, file.size, image)) {
+		unmapFile(file);
+		return false;
+	}
+
+	t.pixels.resize((size_t)image.width * image.height * 4);
+	convertBMPToRGBA(image, t.pixels.data());
+	unmapFile(file);
+
+	StreamedLevel level;
+	level.width = image.width;
+	level.height = image.height;
+	level.rows = image.height;
+	level.rowBytes = (size_t)image.width * 4;
+	level.data = t.pixels.data();
+	t.levels.push_back(level);
+
+	t.compressed = false;
+	t.generateMipmaps = true;
+	t.internalFormat = GL_RGBA8;
+	return true;
+}
+
+void TextureStreamer::workerMain(){
+	for (;;) {
+		StreamedTexture * t;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this]{ return quit || !pending.empty(); });
+			if (quit)
+				return;
+			t = pending.front();
+			pending.pop_front();
+		}
+
+		bool ok = !t->skipCooked && decodeCooked(*t);
+		if (!ok)
+			ok = decodeBMP(*t);
+		if (!ok)
+			t->failed = true;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		decoded.push_back(t);
+	}
+}
+
+//******************************************
+// GL thread: PBO ring uploads
+//******************************************
+
+size_t TextureStreamer::update(size_t byteBudget){
+	size_t budget = byteBudget;
+	size_t uploaded = 0;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	while (budget > 0) {
+		if (uploading == NULL) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (decoded.empty())
+				break;
+			uploading = decoded.front();
+			decoded.pop_front();
+		}
+
+		if (uploading->failed) {
+			printf("%s could not be loaded, keeping the placeholder\n", uploading->path.c_str());
+			uploading->done = true;
+			uploading = NULL;
+			continue;
+		}
+
+		// Decoding may have started before the context existed, so S3TC support is checked here
+		if (uploading->compressed && !GLEW_EXT_texture_compression_s3tc) {
+			printf("%s is cooked as S3TC but the driver has no S3TC support, using the BMP\n", uploading->path.c_str());
+			StreamedTexture * t = uploading;
+			uploading = NULL;
+			t->levels.clear();
+			unmapFile(t->cooked);
+			t->compressed = false;
+			t->skipCooked = true;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				pending.push_back(t);
+			}
+			wake.notify_one();
+			continue;
+		}
+
+		if (!uploadSlice(*uploading, budget, uploaded))
+			break;
+
+		if (uploading->level == uploading->levels.size()) {
+			finishTexture(*uploading);
+			uploading = NULL;
+		}
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	return uploaded;
+}
+
+// Uploads one band of rows through the next PBO and adds its bytes to uploaded. The band is at
+// least one row, so it can be larger than what is left of the budget. Returns false if nothing
+// could be done this frame.
+bool TextureStreamer::uploadSlice(StreamedTexture & t, size_t & budget, size_t & uploaded){
+	const StreamedLevel & level = t.levels[t.level];
+	if (level.rowBytes > pboSize) {
+		printf("%s has rows larger than the upload buffers\n", t.path.c_str());
+		t.failed = true;
+		t.level = (unsigned int)t.levels.size();
+		return true;
+	}
+
+	// The GPU may still be reading this PBO from a few frames ago; try again next frame
+	GLsync & fence = fences[nextPbo];
+	if (fence) {
+		if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+			return false;
+		glDeleteSync(fence);
+		fence = 0;
+	}
+
+	if (t.texture == 0)
+		t.texture.create("textures", t.path.c_str());
+	glBindTexture(GL_TEXTURE_2D, t.texture);
+
+	if (t.row == 0) {
+		// Allocate the level; with no PBO bound the NULL really means "no data"
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		if (t.compressed)
+			glCompressedTexImage2D(GL_TEXTURE_2D, t.level, t.internalFormat, level.width, level.height, 0,
+				(GLsizei)(level.rows * level.rowBytes), NULL);
+		else
+			glTexImage2D(GL_TEXTURE_2D, t.level, t.internalFormat, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		t.allocatedBytes += level.rows * level.rowBytes;
+		t.texture.setSize(t.allocatedBytes);
+	}
+
+	// Always make progress by at least one row, even with a tiny budget
+	size_t rows = level.rows - t.row;
+	size_t fitPbo = pboSize / level.rowBytes;
+	size_t fitBudget = budget / level.rowBytes > 0 ? budget / level.rowBytes : 1;
+	if (rows > fitPbo) rows = fitPbo;
+	if (rows > fitBudget) rows = fitBudget;
+	size_t bytes = rows * level.rowBytes;
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[nextPbo]);
+	void * dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (dst == NULL)
+		return false;
+	memcpy(dst, level.data + t.row * level.rowBytes, bytes);
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	if (t.compressed) {
+		GLint y = t.row * 4;
+		GLsizei height = (GLsizei)(rows * 4);
+		if (y + height > (GLint)level.height)
+			height = level.height - y;
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, t.level, 0, y, level.width, height, t.internalFormat, (GLsizei)bytes, (void *)0);
+	}
+	else {
+		glTexSubImage2D(GL_TEXTURE_2D, t.level, 0, t.row, level.width, (GLsizei)rows, GL_RGBA, GL_UNSIGNED_BYTE, (void *)0);
+	}
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	nextPbo = (nextPbo + 1) % (int)pbos.size();
+
+	t.row += (unsigned int)rows;
+	if (t.row == level.rows) {
+		t.level++;
+		t.row = 0;
+	}
+	budget = budget > bytes ? budget - bytes : 0;
+	uploaded += bytes;
+	return true;
+}
+
+void TextureStreamer::finishTexture(StreamedTexture & t){
+	if (t.failed) {
+		t.texture.reset();
+	}
+	else {
+		glBindTexture(GL_TEXTURE_2D, t.texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		if (t.generateMipmaps) {
+			// The PBO upload has to land before the mips can be built; the driver orders that for us
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glGenerateMipmap(GL_TEXTURE_2D);
+			// Uncompressed levels are 4 bytes per texel
+			unsigned int width = t.levels[0].width, height = t.levels[0].height;
+			while (width > 1 || height > 1) {
+				width = width > 1 ? width / 2 : 1;
+				height = height > 1 ? height / 2 : 1;
+				t.allocatedBytes += (size_t)width * height * 4;
+			}
+			t.texture.setSize(t.allocatedBytes);
+		}
+		else {
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)t.levels.size() - 1);
+		}
+		t.resident = true;
+		printf("Streamed %s in %.1f ms\n", t.path.c_str(), std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t.requestTime).count());
+	}
+
+	// The GL copy is made; the source bytes are no longer needed
+	t.done = true;
+	t.levels.clear();
+	unmapFile(t.cooked);
+	std::vector<unsigned char>().swap(t.pixels);
+}
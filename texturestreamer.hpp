@@ -0,0 +1,74 @@
+#ifndef TEXTURESTREAMER_HPP
+#define TEXTURESTREAMER_HPP
+
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "glresource.hpp"
+
+struct StreamedTexture;
+
+// Loads textures without stalling the render loop.
+//
+// request() returns immediately with a handle whose texture is a shared 1x1 placeholder.
+// A worker thread maps and decodes the file (cooked .ptex when current, BMP otherwise), and
+// update(), called once per frame on the GL thread, copies at most byteBudget bytes into a
+// ring of pixel buffer objects and issues the texture uploads from them. Large images are
+// uploaded a band of rows at a time across several frames, and a PBO whose previous upload
+// has not finished yet is skipped instead of waited on. Once every level is in, texture()
+// starts returning the real texture.
+class TextureStreamer {
+public:
+	TextureStreamer();
+	~TextureStreamer();
+
+	// Starts only the worker thread. Needs no GL context, so requests can start decoding
+	// while the window is still being created.
+	void startWorker();
+	// Creates the placeholder and the PBO ring, and the worker if startWorker wasn't called.
+	// Needs a current GL context.
+	void start(int pboCount = 3, size_t pboSize = 4 * 1024 * 1024);
+	// Joins the worker and deletes every GL object the streamer created.
+	void stop();
+
+	// Queues a BMP for loading. The returned handle is valid right away.
+	int request(const char * bmpPath);
+
+	// Pumps decoded data to GL. Never blocks on the worker or on the GPU.
+	// Returns the number of bytes handed to GL, which can go past byteBudget by up to one row.
+	size_t update(size_t byteBudget);
+
+	// The real texture once resident, the placeholder before that.
+	GLuint texture(int handle) const;
+	bool isResident(int handle) const;
+	// True when every requested texture is resident.
+	bool isIdle() const;
+
+private:
+	void workerMain();
+	bool uploadSlice(StreamedTexture & texture, size_t & budget, size_t & uploaded);
+	void finishTexture(StreamedTexture & texture);
+
+	GLTexture placeholder;
+	std::vector<GLBuffer> pbos;
+	std::vector<GLsync> fences;
+	size_t pboSize;
+	int nextPbo;
+
+	std::vector<StreamedTexture *> textures;
+
+	std::thread worker;
+	mutable std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<StreamedTexture *> pending; // waiting for the worker
+	std::deque<StreamedTexture *> decoded; // waiting for update()
+	bool quit;
+	StreamedTexture * uploading;
+};
+
+#endif
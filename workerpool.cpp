@@ -0,0 +1,92 @@
+#include "workerpool.hpp"
+
+WorkerPool::WorkerPool()
+	: quit(false), generation(0), busy(0), job(NULL), jobCount(0), jobChunkSize(0), jobChunks(0), nextChunk(0){
+}
+
+WorkerPool::~WorkerPool(){
+	stop();
+}
+
+void WorkerPool::start(int workerCount){
+	stop();
+	quit = false;
+	for (int i = 0; i < workerCount; i++)
+		threads.push_back(std::thread(&WorkerPool::workerMain, this));
+}
+
+void WorkerPool::stop(){
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+	threads.clear();
+}
+
+void WorkerPool::parallelFor(size_t count, size_t chunkSize, const std::function<void(size_t chunk, size_t begin, size_t end)> & work){
+	size_t chunks = chunkCount(count, chunkSize);
+	if (chunks == 0)
+		return;
+	if (threads.empty() || chunks == 1) {
+		for (size_t chunk = 0; chunk < chunks; chunk++) {
+			size_t begin = chunk * chunkSize;
+			work(chunk, begin, begin + chunkSize < count ? begin + chunkSize : count);
+		}
+		return;
+	}
+
+	{
+		// A worker that woke up late for the previous loop may still be looking for a chunk
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this]{ return busy == 0; });
+		job = &work;
+		jobCount = count;
+		jobChunkSize = chunkSize;
+		jobChunks = chunks;
+		nextChunk.store(0);
+		generation++;
+	}
+	wake.notify_all();
+	runChunks();
+
+	// Every chunk is taken; wait for the workers still running theirs. A worker that wakes up
+	// only after this finds nothing left to take.
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this]{ return busy == 0; });
+	job = NULL;
+}
+
+void WorkerPool::runChunks(){
+	for (;;) {
+		size_t chunk = nextChunk.fetch_add(1);
+		if (chunk >= jobChunks)
+			return;
+		size_t begin = chunk * jobChunkSize;
+		(*job)(chunk, begin, begin + jobChunkSize < jobCount ? begin + jobChunkSize : jobCount);
+	}
+}
+
+void WorkerPool::workerMain(){
+	unsigned seen = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;) {
+		wake.wait(lock, [&]{ return quit || generation != seen; });
+		if (quit)
+			return;
+		seen = generation;
+		busy++;
+		lock.unlock();
+		runChunks();
+		lock.lock();
+		if (--busy == 0)
+			done.notify_all();
+	}
+}
+
+int defaultWorkerCount(){
+	int hardware = (int)std::thread::hardware_concurrency();
+	return hardware > 1 ? hardware - 1 : 0;
+}
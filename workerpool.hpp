@@ -0,0 +1,61 @@
+#ifndef WORKERPOOL_HPP
+#define WORKERPOOL_HPP
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent threads for splitting a per-frame loop (particles, crowds) into chunks.
+//
+// parallelFor cuts [0, count) into chunks of chunkSize and hands them out to the workers and
+// the calling thread, which works on chunks too and returns once every chunk is done. A pool
+// without workers (or a loop of one chunk) just runs inline, so callers need no serial path.
+// Chunks are always cut the same way for the same count and chunkSize, whatever thread runs
+// them, so per-chunk results can be kept in arrays indexed by chunk.
+//
+// Nothing is allocated per call. One parallelFor at a time, from one thread.
+class WorkerPool {
+public:
+	WorkerPool();
+	~WorkerPool();
+
+	// Starts workerCount threads (0 is allowed) after stopping any earlier ones.
+	void start(int workerCount);
+	void stop();
+
+	// Workers plus the calling thread.
+	int threadCount() const { return (int)threads.size() + 1; }
+
+	// Calls work(chunk, begin, end) for every chunk, chunk counting from 0 in order of begin.
+	void parallelFor(size_t count, size_t chunkSize, const std::function<void(size_t chunk, size_t begin, size_t end)> & work);
+
+	static size_t chunkCount(size_t count, size_t chunkSize){ return chunkSize > 0 ? (count + chunkSize - 1) / chunkSize : 0; }
+
+private:
+	void workerMain();
+	void runChunks();
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	bool quit;
+	unsigned generation; // bumped for every parallelFor the workers join
+	int busy;            // workers inside runChunks
+
+	// The current loop. Only changed while no worker is inside runChunks.
+	const std::function<void(size_t, size_t, size_t)> * job;
+	size_t jobCount;
+	size_t jobChunkSize;
+	size_t jobChunks;
+	std::atomic<size_t> nextChunk;
+};
+
+// Threads worth starting besides the main one: one per other hardware thread, at least 0.
+int defaultWorkerCount();
+
+#endif